@@ -0,0 +1,6 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : require
+
+#define DEFERRED_SUBPASS
+#include "deferred.glsl"
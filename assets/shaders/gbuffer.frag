@@ -15,13 +15,20 @@ layout (location = 0) out vec4 outGBufferA; // RGB: Albedo, A: Metallic
 layout (location = 1) out vec4 outGBufferB; // RG: Normal, BA: Motion Vector
 layout (location = 2) out vec4 outGBufferC; // R: Roughness, G: Curvature, B: Mesh ID, A: Linear Z
 
-layout(set = 2, binding = 0) uniform ubo_material
+layout(push_constant) uniform PushConstants
+{
+    mat4 model;
+    uint material_index;
+    uint mesh_id;
+} u_PushConstants;
+
+layout(set = 1, binding = 0) uniform ubo_material
 {
     vec4 materialFactors; // x: alphaCutoff, y: metallicFactor, z: roughnessFactor, w: reserved
 	vec4 baseColorFactor;
 } materialUBO;
 
-layout (set = 2, binding = 1) uniform sampler2D textureAlbedo;
+layout (set = 1, binding = 1) uniform sampler2D textureAlbedo;
 
 // A simple utility to convert a float to a 2-component octohedral representation
 vec2 direction_to_octohedral(vec3 normal)
@@ -71,7 +78,7 @@ void main()
     float roughness = materialUBO.materialFactors.z;
     float linear_z  = gl_FragCoord.z / gl_FragCoord.w;
     float curvature = compute_curvature(linear_z);
-    float mesh_id   = 1.0f;// float(u_PushConstants.mesh_id);
+    float mesh_id   = float(u_PushConstants.mesh_id);
 
     outGBufferC = vec4(roughness, curvature, mesh_id, linear_z);
 }
\ No newline at end of file
@@ -31,18 +31,20 @@ layout(set = 0, binding = 0) uniform PerFrameUBO
     uint inverse_scale;
 } globalUBO;
 
-layout(set = 1, binding = 0) uniform ubo_mesh
+layout(push_constant) uniform PushConstants
 {
     mat4 model;
-} meshUBO;
+    uint material_index;
+    uint mesh_id;
+} u_PushConstants;
 
 void main()
 {
     // Transform position into world space
-    vec4 world_pos = meshUBO.model * vec4(inPosition, 1.0);
+    vec4 world_pos = u_PushConstants.model * vec4(inPosition, 1.0);
 
     // Since this demo has static scenes we can use the current Model matrix as the previous one
-    vec4 prev_world_pos = meshUBO.model * vec4(inPosition, 1.0);
+    vec4 prev_world_pos = u_PushConstants.model * vec4(inPosition, 1.0);
 
     // Transform world position into clip space
     gl_Position = globalUBO.view_proj * world_pos;
@@ -58,7 +60,7 @@ void main()
     outUV = inUV;
 
     // Transform vertex normal into world space
-    mat3 normal_mat = mat3(meshUBO.model);
+    mat3 normal_mat = mat3(u_PushConstants.model);
 
     outNormal    = normal_mat * inNormal;
     outTangent   = normal_mat * inTangent;
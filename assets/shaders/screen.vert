@@ -17,11 +17,6 @@ layout(set = 0, binding = 0) uniform PerFrameUBO
     uint inverse_scale;
 } globalUBO;
 
-layout(set = 1, binding = 0) uniform ubo_mesh
-{
-    mat4 model;
-} ubo_mesh_0;
-
 layout(location = 0) in vec2 inPosition;
 layout(location = 1) in vec2 inUV;
 layout(location = 0) out vec2 outUV;
@@ -1,23 +1,54 @@
 #include "application.h"
+#include "null/context.h"
+#include "platform/profiler.h"
 #include "scene/basicScene.h"
+#include "scene/cameraPath.h"
 #include "scene/scene.h"
 #include "scene/transition.h"
 #include "vulkan/context.h"
 
+#if ENABLE_BENCHMARK
+const size_t kBenchmarkFrames = 1200;
+const uint32_t kBenchmarkWarmupFrames = 120;
+#endif
+
 bool Application::init(platform::Window* window, platform::AssetManager* assetManager, platform::InputHandler* inputHandler)
 {
     LOGD("Start application");
+    PROFILE_BEGIN_PHASE("Startup");
+
+#if USE_NULL_RHI
+    context = new null::Context();
+#else
     context = new vk::Context();
+#endif
     
     if (!context->init(window))
     {
+        PROFILE_END_PHASE();
         return false;
     }
 
     sceneTransition = new scene::Transition();
 
     scene::Scene* scene = new scene::BasicScene();
-    sceneTransition->registerScene(scene, 10000);
+#if ENABLE_BENCHMARK
+    // A path recorded by an earlier run is replayed, otherwise this run records one
+    scene::CameraPath* cameraPath = new scene::CameraPath();
+    if (!cameraPath->load("benchmark_camera0.txt"))
+    {
+#if PLATFORM_LINUX
+        // Headless runs have no input to record, they fly a scripted path instead
+        cameraPath->addKeyframe(0, glm::vec3(1.0f, 0.75f, 0.0f), glm::vec3(0.0f, 90.0f, 0.0f));
+        cameraPath->addKeyframe(kBenchmarkFrames / 2, glm::vec3(-1.0f, 0.75f, 0.0f), glm::vec3(0.0f, 180.0f, 0.0f));
+        cameraPath->addKeyframe(kBenchmarkFrames, glm::vec3(1.0f, 0.75f, 0.0f), glm::vec3(0.0f, 270.0f, 0.0f));
+#endif
+    }
+    sceneTransition->enableBenchmark(kBenchmarkWarmupFrames, "benchmark.json");
+    sceneTransition->registerScene(scene, kBenchmarkFrames, cameraPath);
+#else
+    sceneTransition->registerScene(scene, 0);
+#endif
 
     const bool bRunReverse = false;
     
@@ -25,12 +56,21 @@ bool Application::init(platform::Window* window, platform::AssetManager* assetMa
 
     inputHandler->registerInputAdapter(scene->getSceneViewInputAdapter());
 
+    PROFILE_END_PHASE();
+
     return true;
 }
 
 bool Application::update(platform::AssetManager* assetManager, Tick tick)
 {
-    return sceneTransition->update(context, assetManager, tick);
+    bool running = false;
+    {
+        PROFILE_ZONE("Application::update");
+        running = sceneTransition->update(context, assetManager, tick);
+    }
+    PROFILE_FRAME();
+
+    return running;
 }
 
 bool Application::resume()
@@ -48,5 +88,7 @@ bool Application::terminate()
     sceneTransition->destroy(context);
     context->terminate();
     delete context;
+
+    PROFILE_WRITE_TRACE("cpu_trace.json");
     return true;
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "platform/linux/context.h"
+
+// Usage: launcher [--width N] [--height N] [--frames N] [--readback-interval N] [--readback-dir PATH]
+int main(int argc, char** argv)
+{
+	long width = 1024;
+	long height = 1024;
+	uint32_t frameCount = 0;
+	uint32_t readbackInterval = 0;
+	std::string readbackDirectory = ".";
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const char* option = argv[i];
+		const char* value = argv[i + 1];
+
+		if (strcmp(option, "--width") == 0)
+		{
+			width = strtol(value, nullptr, 10);
+		}
+		else if (strcmp(option, "--height") == 0)
+		{
+			height = strtol(value, nullptr, 10);
+		}
+		else if (strcmp(option, "--frames") == 0)
+		{
+			frameCount = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+		}
+		else if (strcmp(option, "--readback-interval") == 0)
+		{
+			readbackInterval = static_cast<uint32_t>(strtoul(value, nullptr, 10));
+		}
+		else if (strcmp(option, "--readback-dir") == 0)
+		{
+			readbackDirectory = value;
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option %s\n", option);
+			return 1;
+		}
+	}
+
+	platform::HeadlessContext context;
+	context.init(width, height, frameCount, readbackInterval, readbackDirectory);
+	context.update();
+	context.destroy();
+
+	return 0;
+}
@@ -4,51 +4,27 @@
 #include "rhi/resources.h"
 #include "rhi/pipeline.h"
 #include "model/object.h"
+#include "model/material.h"
 
 namespace model
 {
 Instance::Instance(Object* object, Instance* instance,
 		uint32_t firstIndex, uint32_t indexCount,
 		uint32_t firstVertex, uint32_t vertexCount,
-		glm::mat4 transform)
+		glm::mat4 transform, uint32_t objectId)
 	: object(object)
 	, prevInstance(instance)
 	, firstIndex(firstIndex)
 	, indexCount(indexCount)
 	, firstVertex(firstVertex)
 	, vertexCount(vertexCount)
-	, ubo({transform})
-	, instanceUniformBuffer(nullptr)
-	, instanceDescriptorSet(nullptr)
-	, materialDescriptorSet(nullptr)
+	, pushConstants({ transform, 0, objectId })
+	, material(nullptr)
 {
 }
 
-void Instance::init(rhi::Context* context)
-{
-	instanceUniformBuffer = context->createUniformBuffer(rhi::BufferType::HostCoherent);
-	instanceUniformBuffer->set<InstanceUniformBlock>(1, &ubo);
-
-	instanceDescriptorSet = context->createDescriptorSet();
-	instanceDescriptorSet->registerDescriptor(rhi::ShaderStage::Vertex, rhi::DescriptorType::Uniform_Buffer, instanceUniformBuffer);
-}
-
 void Instance::destroy(rhi::Context* context)
 {
-	if (instanceUniformBuffer != nullptr)
-	{
-		instanceUniformBuffer->destroy(context);
-		delete instanceUniformBuffer;
-		instanceUniformBuffer = nullptr;
-	}
-
-	if (instanceDescriptorSet != nullptr)
-	{
-		instanceDescriptorSet->destroy(context);
-		delete instanceDescriptorSet;
-		instanceDescriptorSet = nullptr;
-	}
-
 	if (prevInstance != nullptr)
 	{
 		prevInstance->destroy(context);
@@ -57,27 +33,21 @@ void Instance::destroy(rhi::Context* context)
 	}
 }
 
-void Instance::build(rhi::Context* context)
+void Instance::draw(rhi::Context* context, rhi::GraphicsPipeline* pipeline)
 {
-	ASSERT(instanceUniformBuffer);
-	ASSERT(instanceDescriptorSet);
-
-	instanceUniformBuffer->build(context);
-	instanceDescriptorSet->build(context);
-
-	object->udpateLocalDescriptorSet(instanceDescriptorSet);
+	ASSERT(material);
 
-	if (prevInstance != nullptr)
+	const rhi::ShaderStageFlags pushConstantStages = object->getInstancePushConstantStages();
+	if (pushConstantStages != 0)
 	{
-		prevInstance->build(context);
+		pipeline->pushConstants(context, pushConstantStages, pushConstants);
 	}
-}
-
-void Instance::draw(rhi::Context* context, rhi::GraphicsPipeline* pipeline)
-{
-	instanceDescriptorSet->bind(context, pipeline, 1);
-	materialDescriptorSet->bind(context, pipeline, 2);
 
+	// Bindless materials are read from the table bound with the object, at the pushed material index
+	if (!material->isBindless())
+	{
+		material->bind(context, pipeline, 1);
+	}
 	context->drawIndexed(indexCount, 1, firstIndex, 0, 0);
 
 	if (prevInstance != nullptr)
@@ -86,8 +56,9 @@ void Instance::draw(rhi::Context* context, rhi::GraphicsPipeline* pipeline)
 	}
 }
 
-void Instance::updateMaterialDescriptorSet(rhi::DescriptorSet* descriptorSet)
+void Instance::updateMaterial(Material* material)
 {
-	materialDescriptorSet = descriptorSet;
+	this->material = material;
+	pushConstants.materialIndex = material->isBindless() ? material->getIndex() : 0;
 }
 }
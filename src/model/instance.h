@@ -5,8 +5,6 @@
 namespace rhi
 {
 	class Context;
-	class DescriptorSet;
-	class UniformBuffer;
 	class Pipeline;
 	class GraphicsPipeline;
 }
@@ -14,7 +12,15 @@ namespace rhi
 namespace model
 {
 class Object;
-struct Material;
+class Material;
+
+// Pushed for every draw of an instance, read by the vertex and fragment stages of graphics objects
+struct InstancePushConstants
+{
+	glm::mat4 transform;
+	uint32_t materialIndex;
+	uint32_t objectId;
+};
 
 class Instance
 {
@@ -22,17 +28,13 @@ public:
 	Instance(Object* object, Instance* instance,
 			uint32_t firstIndex, uint32_t indexCount,
 			uint32_t firstVertex, uint32_t vertexCount,
-			glm::mat4 transform);
-
-	void init(rhi::Context* context);
+			glm::mat4 transform, uint32_t objectId);
 
 	void destroy(rhi::Context* context);
 
-	void build(rhi::Context* context);
-
 	void draw(rhi::Context* context, rhi::GraphicsPipeline* pipeline);
 
-	void updateMaterialDescriptorSet(rhi::DescriptorSet* descriptorSet);
+	void updateMaterial(Material* material);
 private:
 	Object* object;
 	Instance* prevInstance;
@@ -42,15 +44,7 @@ private:
 	uint32_t firstVertex;
 	uint32_t vertexCount;
 
-	struct InstanceUniformBlock
-	{
-		glm::mat4 transform;
-	} ubo;
-
-	rhi::UniformBuffer* instanceUniformBuffer;
-	rhi::DescriptorSet* instanceDescriptorSet;
-
-	// shared
-	rhi::DescriptorSet* materialDescriptorSet;
+	InstancePushConstants pushConstants;
+	Material* material;
 };
 }
\ No newline at end of file
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "model/material.h"
 #include "rhi/context.h"
 #include "rhi/texture.h"
@@ -40,6 +41,8 @@ Material::Material()
 	, diffuseTexture(nullptr)
 	, materialUniformBuffer(nullptr)
 	, materialDescriptorSet(nullptr)
+	, bindless(false)
+	, index(0)
 {
 }
 
@@ -48,10 +51,19 @@ void Material::init(rhi::Context* context)
 	ASSERT(materialUniformBuffer == nullptr);
 	ASSERT(materialDescriptorSet == nullptr);
 
-	materialUniformBuffer = context->createUniformBuffer(rhi::BufferType::HostCoherent);
+	materialUniformBuffer = context->createUniformBuffer(rhi::BufferType::Dynamic);
 	materialDescriptorSet = context->createDescriptorSet();
 }
 
+void Material::initBindless(uint32_t index)
+{
+	ASSERT(materialUniformBuffer == nullptr);
+	ASSERT(materialDescriptorSet == nullptr);
+
+	bindless = true;
+	this->index = index;
+}
+
 void Material::destroy(rhi::Context* context)
 {
 	if (materialUniformBuffer != nullptr)
@@ -71,13 +83,18 @@ void Material::destroy(rhi::Context* context)
 
 void Material::build(rhi::Context* context)
 {
+	if (bindless)
+	{
+		return;
+	}
+
 	ASSERT(materialUniformBuffer);
 	ASSERT(materialDescriptorSet);
 
 	materialUniformBuffer->set<MaterialUniformBlock>(1, &materialUBO);
 	materialUniformBuffer->build(context);
 
-	materialDescriptorSet->registerDescriptor(rhi::ShaderStage::Fragment, rhi::DescriptorType::Uniform_Buffer, materialUniformBuffer);
+	materialDescriptorSet->registerDescriptor(rhi::ShaderStage::Fragment, rhi::DescriptorType::Uniform_Buffer_Dynamic, materialUniformBuffer);
 
 	if (baseColorTexture)
 	{
@@ -116,6 +133,13 @@ void Material::build(rhi::Context* context)
 	materialDescriptorSet->build(context);
 }
 
+void Material::bind(rhi::Context* context, rhi::GraphicsPipeline* pipeline, uint32_t binding)
+{
+	// The block only changes on set, instances sharing the material reuse this frame's copy
+	materialUniformBuffer->update(context);
+	materialDescriptorSet->bind(context, pipeline, binding);
+}
+
 Material::MaterialUniformBlock& Material::getMaterialUniform()
 {
 	return materialUBO;
@@ -175,4 +199,34 @@ rhi::DescriptorSet* Material::getDescriptorSet()
 	ASSERT(materialDescriptorSet);
 	return materialDescriptorSet;
 }
+
+bool Material::isBindless()
+{
+	return bindless;
+}
+
+uint32_t Material::getIndex()
+{
+	return index;
+}
+
+MaterialTableEntry Material::getTableEntry(const std::vector<rhi::Texture*>& textures)
+{
+	auto getTextureIndex = [&textures](rhi::Texture* texture)
+	{
+		auto found = std::find(textures.begin(), textures.end(), texture);
+		return texture == nullptr || found == textures.end() ? kNoMaterialTexture : static_cast<uint32_t>(found - textures.begin());
+	};
+
+	MaterialTableEntry entry = {};
+	entry.materialFactors = materialUBO.materialFactors;
+	entry.baseColorFactor = materialUBO.baseColorFactor;
+	entry.alphaMode = static_cast<uint32_t>(materialUBO.alphaMode);
+	entry.baseColorTexture = getTextureIndex(baseColorTexture);
+	entry.metallicRoughnessTexture = getTextureIndex(metallicRoughnessTexture);
+	entry.normalTexture = getTextureIndex(normalTexture);
+	entry.occlusionTexture = getTextureIndex(occlusionTexture);
+	entry.emissiveTexture = getTextureIndex(emissiveTexture);
+	return entry;
+}
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #pragma once
+#include <vector>
 #include "platform/utils.h"
 #include "rhi/resources.h"
 
@@ -8,6 +9,7 @@ namespace rhi
 	class Context;
 	class UniformBuffer;
 	class DescriptorSet;
+	class GraphicsPipeline;
 }
 
 namespace model
@@ -19,6 +21,24 @@ enum class AlphaMode
 	ALPHAMODE_BLEND
 };
 
+// Texture index of a material entry without that texture
+const uint32_t kNoMaterialTexture = 0xFFFFFFFF;
+
+// Entry of the material table read by bindless shaders, std430 layout
+struct MaterialTableEntry
+{
+	glm::vec4 materialFactors;
+	glm::vec4 baseColorFactor;
+	uint32_t alphaMode;
+	// Indices into the texture array of the object
+	uint32_t baseColorTexture;
+	uint32_t metallicRoughnessTexture;
+	uint32_t normalTexture;
+	uint32_t occlusionTexture;
+	uint32_t emissiveTexture;
+	uint32_t padding[2];
+};
+
 class Material
 {
 private:
@@ -43,10 +63,16 @@ public:
 
 	void init(rhi::Context* context);
 
+	// The material lives in the table of its object at the index, no per-material set is created
+	void initBindless(uint32_t index);
+
 	void destroy(rhi::Context * context);
 
 	void build(rhi::Context* context);
 
+	// Writes the uniform block for this frame if needed and binds the descriptor set
+	void bind(rhi::Context* context, rhi::GraphicsPipeline* pipeline, uint32_t binding);
+
 	MaterialUniformBlock& getMaterialUniform();
 
 	void updateTexture(rhi::MaterialFlag materialFlag, rhi::Texture* texture);
@@ -54,6 +80,12 @@ public:
 	rhi::Texture* getTexture(rhi::MaterialFlag materialFlag);
 
 	rhi::DescriptorSet* getDescriptorSet();
+
+	bool isBindless();
+
+	uint32_t getIndex();
+
+	MaterialTableEntry getTableEntry(const std::vector<rhi::Texture*>& textures);
 private:
 	MaterialUniformBlock materialUBO;
 	rhi::Texture* baseColorTexture;
@@ -66,5 +98,8 @@ private:
 
 	rhi::UniformBuffer* materialUniformBuffer;
 	rhi::DescriptorSet* materialDescriptorSet;
+
+	bool bindless;
+	uint32_t index;
 };
 }
\ No newline at end of file
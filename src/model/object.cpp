@@ -1,4 +1,5 @@
 #include "platform/utils.h"
+#include "platform/profiler.h"
 #include "model/instance.h"
 #include "model/material.h"
 #include "rhi/context.h"
@@ -61,10 +62,12 @@ Object::Object()
 	, indexBuffer(nullptr)
 	, globalDescriptorSet(nullptr)
 	, pipeline(nullptr)
-	, localDescriptorSet(nullptr)
 	, shaderModuleContainer(nullptr)
 	, pipelineState(nullptr)
 	, materialDescriptorSet(nullptr)
+	, materialTableBuffer(nullptr)
+	, bindlessMaterials(false)
+	, instancePushConstantStages(0)
 {
 
 }
@@ -159,6 +162,20 @@ void Object::destroy(rhi::Context* context)
 		delete material;
 	}
 
+	if (bindlessMaterials && materialDescriptorSet != nullptr)
+	{
+		materialDescriptorSet->destroy(context);
+		delete materialDescriptorSet;
+		materialDescriptorSet = nullptr;
+	}
+
+	if (materialTableBuffer != nullptr)
+	{
+		materialTableBuffer->destroy(context);
+		delete materialTableBuffer;
+		materialTableBuffer = nullptr;
+	}
+
 	for (auto& node : linearNodes)
 	{
 		delete node;
@@ -195,20 +212,35 @@ void GraphicsObject::build(rhi::Context* context, rhi::RenderTarget* renderTarge
 		material->build(context);
 	}
 
-	ASSERT(!instances.empty());
-	for (auto& instance: instances)
+	if (bindlessMaterials)
 	{
-		instance.first->build(context);
+		std::vector<MaterialTableEntry> materialTable;
+		materialTable.reserve(materials.size());
+		for (auto& material : materials)
+		{
+			materialTable.push_back(material->getTableEntry(textures));
+		}
+
+		materialTableBuffer->set<MaterialTableEntry>(materialTable.size(), materialTable.data());
+		materialTableBuffer->build(context);
+		materialDescriptorSet->build(context);
 	}
-	ASSERT(localDescriptorSet);
+
+	ASSERT(!instances.empty());
 
 	globalDescriptorSet->build(context);
 	shaderModuleContainer->build(context);
+
+	// Screen and post passes don't read the instance data, their draws push nothing
+	instancePushConstantStages = shaderModuleContainer->getPushConstantStages();
+	if (instancePushConstantStages != 0 && pipeline->getPushConstantRanges().empty())
+	{
+		pipeline->registerPushConstantRange(instancePushConstantStages, 0, sizeof(InstancePushConstants));
+	}
 	
 	std::vector<rhi::DescriptorSet*> descriptorSets =
 	{
 		globalDescriptorSet,
-		localDescriptorSet,
 		materialDescriptorSet
 	};
 
@@ -226,6 +258,21 @@ rhi::Texture* Object::getTexture(uint32_t index)
 	return textures[index];
 }
 
+Material* Object::createMaterial(rhi::Context* context)
+{
+	Material* material = new Material();
+	if (bindlessMaterials)
+	{
+		material->initBindless(static_cast<uint32_t>(materials.size()));
+	}
+	else
+	{
+		material->init(context);
+	}
+	materials.push_back(material);
+	return material;
+}
+
 void Object::loadTextures(rhi::Context* context, platform::AssetManager* assetManager, tinygltf::Model& gltfModel, std::string path)
 {
 	for (tinygltf::Image& image : gltfModel.images)
@@ -253,9 +300,7 @@ void Object::loadMaterials(rhi::Context* context, tinygltf::Model& gltfModel, rh
 {
 	for (tinygltf::Material& mat : gltfModel.materials)
 	{
-		Material* material = new Material();
-		materials.push_back(material);
-		material->init(context);
+		Material* material = createMaterial(context);
 
 		if ((materialFlags & rhi::MaterialFlag::BaseColorTexture) != 0 
 			&& mat.values.find("baseColorTexture") != mat.values.end())
@@ -315,20 +360,33 @@ void Object::loadMaterials(rhi::Context* context, tinygltf::Model& gltfModel, rh
 			material->getMaterialUniform().setAlphaCutoff(static_cast<float>(mat.additionalValues["alphaCutoff"].Factor()));
 		}
 
-		materialDescriptorSet = material->getDescriptorSet();
+		if (!bindlessMaterials)
+		{
+			materialDescriptorSet = material->getDescriptorSet();
+		}
 	}
 
 	// empty material
 	{
-		Material* material = new Material();
-		materials.push_back(material);
-		material->init(context);
+		Material* material = createMaterial(context);
 
-		if (materialDescriptorSet == nullptr)
+		if (!bindlessMaterials && materialDescriptorSet == nullptr)
 		{
 			materialDescriptorSet = material->getDescriptorSet();
 		}
 	}
+
+	if (bindlessMaterials)
+	{
+		// The entries are written at build, the materials can still change until then
+		materialTableBuffer = context->createStorageBuffer(rhi::BufferType::DeviceLocal, rhi::BufferUsage::BUFFER_STORAGE_BUFFER);
+
+		std::vector<rhi::Descriptor*> textureDescriptors(textures.begin(), textures.end());
+		materialDescriptorSet = context->createDescriptorSet();
+		materialDescriptorSet->registerDescriptor(rhi::ShaderStage::Fragment, rhi::DescriptorType::Storage_Buffer, materialTableBuffer);
+		materialDescriptorSet->registerDescriptorArray(rhi::ShaderStage::Fragment, rhi::DescriptorType::Combined_Image_Sampler,
+			textureDescriptors, std::max<uint32_t>(static_cast<uint32_t>(textures.size()), 1));
+	}
 }
 
 void Object::loadNode(Node* parent, const tinygltf::Node& node, uint32_t nodeIndex, const tinygltf::Model& model, float globalscale, rhi::VertexChannelFlags desiredVertexChannelFlags)
@@ -587,14 +645,6 @@ void Object::enableVertexChannel(rhi::VertexChannelFlags vertexChannelFlags)
 	vertexBuffer->updateVertexDescriptions(vertexChannelFlags);
 }
 
-void Object::udpateLocalDescriptorSet(rhi::DescriptorSet* descriptorSet)
-{
-	if (localDescriptorSet == nullptr)
-	{
-		localDescriptorSet = descriptorSet;
-	}
-}
-
 void Object::updateShaderCode(platform::AssetManager* assetManager, rhi::ShaderStage shaderStage, std::string path)
 {
 	ASSERT(shaderModuleContainer);
@@ -613,6 +663,9 @@ void Object::registerDescriptor(rhi::DescriptorType descriptorType, rhi::ShaderS
 
 Instance* Object::instantiate(rhi::Context* context, glm::mat4 transform)
 {
+	// The primitives of an instance share its ID, the mesh ID of the G-buffer
+	const uint32_t objectId = static_cast<uint32_t>(instances.size());
+
 	Instance* prevInstance = nullptr;
 	for (Node* node : linearNodes)
 	{
@@ -621,10 +674,9 @@ Instance* Object::instantiate(rhi::Context* context, glm::mat4 transform)
 			const glm::mat4 localMatrix = transform * node->getMatrix();
 			for (Primitive* primitive : node->mesh->primitives)
 			{
-				Instance* newInstance = new Instance(this, prevInstance, primitive->firstIndex, primitive->indexCount, primitive->firstVertex, primitive->vertexCount, localMatrix);
+				Instance* newInstance = new Instance(this, prevInstance, primitive->firstIndex, primitive->indexCount, primitive->firstVertex, primitive->vertexCount, localMatrix, objectId);
 				prevInstance = newInstance;
-				newInstance->init(context);
-				newInstance->updateMaterialDescriptorSet(primitive->material->getDescriptorSet());
+				newInstance->updateMaterial(primitive->material);
 			}
 		}
 	}
@@ -649,8 +701,20 @@ rhi::IndexBuffer* Object::getIndexBuffer()
 	return indexBuffer;
 }
 
+rhi::ShaderStageFlags Object::getInstancePushConstantStages()
+{
+	return instancePushConstantStages;
+}
+
+bool Object::hasBindlessMaterials()
+{
+	return bindlessMaterials;
+}
+
 void Object::loadGltfModel(rhi::Context* context, platform::AssetManager* assetManager, std::string path, std::string filename, GltfLoadingFlags loadFlags, rhi::VertexChannelFlags desiredVertexChannelFlags, rhi::MaterialFlags materialFlags)
 {
+	PROFILE_ZONE("Object::loadGltfModel");
+
 	tinygltf::Model gltfModel;
 	tinygltf::TinyGLTF gltfContext;
 	vertexBuffer->updateVertexDescriptions(desiredVertexChannelFlags);
@@ -666,7 +730,7 @@ void Object::loadGltfModel(rhi::Context* context, platform::AssetManager* assetM
 	std::string error, warning;
 
 	std::string fullFileName = path + filename;
-#if PLATFORM_WINDOW
+#if PLATFORM_WINDOW || PLATFORM_LINUX
 	bool fileLoaded = gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, assetManager->getAssetPath() + "/" + fullFileName);
 #else
 	bool fileLoaded = gltfContext.LoadASCIIFromFile(&gltfModel, &error, &warning, fullFileName);
@@ -679,6 +743,10 @@ void Object::loadGltfModel(rhi::Context* context, platform::AssetManager* assetM
 		loadTextures(context, assetManager, gltfModel, path);
 	}
 
+	const uint32_t bindlessTextureCapacity = context->getBindlessTextureCapacity();
+	bindlessMaterials = (loadFlags & GltfLoadingFlag::BindlessMaterials) != 0
+		&& bindlessTextureCapacity != 0 && textures.size() <= bindlessTextureCapacity;
+
 	loadMaterials(context, gltfModel, materialFlags);
 
 	const tinygltf::Scene& scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
@@ -759,6 +827,11 @@ void GraphicsObject::draw(rhi::Context* context)
 	rhi::GraphicsPipeline* graphicsPipeline = reinterpret_cast<rhi::GraphicsPipeline*>(pipeline);
 	globalDescriptorSet->bind(context, graphicsPipeline, 0);
 
+	if (bindlessMaterials)
+	{
+		materialDescriptorSet->bind(context, graphicsPipeline, 1);
+	}
+
 	for (auto& instance : instances)
 	{
 		instance.first->draw(context, graphicsPipeline);
@@ -790,6 +863,11 @@ void ComputeObject::draw(rhi::Context* context)
 	rhi::ComputePipeline* computePipeline = reinterpret_cast<rhi::ComputePipeline*>(pipeline);
 	globalDescriptorSet->bind(context, computePipeline, 0);
 
+	if (!pushConstantData.empty())
+	{
+		pipeline->pushConstants(context, rhi::ShaderStage::Compute, 0, static_cast<uint32_t>(pushConstantData.size()), pushConstantData.data());
+	}
+
 	if (bIndirect)
 	{
 		context->dispatchIndirect(indirectStorageBuffer);
@@ -834,6 +912,21 @@ void ComputeObject::setIndirect(rhi::StorageBuffer* storageBuffer)
 	indirectStorageBuffer = storageBuffer;
 }
 
+void ComputeObject::setPushConstants(const void* data, uint32_t size)
+{
+	ASSERT(pipeline);
+
+	// The range is part of the pipeline layout, it is registered with the first block
+	if (pushConstantData.empty())
+	{
+		pipeline->registerPushConstantRange(rhi::ShaderStage::Compute, 0, size);
+	}
+	ASSERT(pushConstantData.empty() || pushConstantData.size() == size);
+
+	const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+	pushConstantData.assign(bytes, bytes + size);
+}
+
 void RayTracingObject::initPipeline(rhi::Context* context)
 {
 	if (pipeline == nullptr)
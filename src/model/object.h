@@ -38,7 +38,10 @@ enum GltfLoadingFlag
 	PreTransformVertices = 0x00000001,
 	PreMultiplyVertexColors = 0x00000002,
 	FlipY = 0x00000004,
-	DontLoadImages = 0x00000008
+	DontLoadImages = 0x00000008,
+	// Materials go into one table with the textures in a partially bound array, shaders index it per draw.
+	// Falls back to a set per material when the device can't hold the textures in such an array
+	BindlessMaterials = 0x00000010
 };
 typedef uint32_t GltfLoadingFlags;
 
@@ -113,8 +116,6 @@ public:
 
 	void registerDescriptor(rhi::DescriptorType descriptorType, rhi::ShaderStageFlags stage, rhi::Descriptor* descriptor);
 
-	void udpateLocalDescriptorSet(rhi::DescriptorSet* descriptorSet);
-
 	void updateShaderCode(platform::AssetManager* assetManager, rhi::ShaderStage shaderStage, std::string path);
 
 	std::vector<std::pair<Instance*, glm::mat4>>& getInstances();
@@ -127,16 +128,26 @@ public:
 
 	rhi::IndexBuffer* getIndexBuffer();
 
+	// Set once the model is loaded, the shaders must read the material table then
+	bool hasBindlessMaterials();
+
+	// Stages of the graphics shaders that read InstancePushConstants, 0 when none does and nothing is pushed
+	rhi::ShaderStageFlags getInstancePushConstantStages();
+
 private:
 	rhi::Texture* getTexture(uint32_t index);
 
+	Material* createMaterial(rhi::Context* context);
+
 protected:
 	rhi::VertexBuffer* vertexBuffer;
 	rhi::IndexBuffer* indexBuffer;
 	rhi::Pipeline* pipeline;
-	rhi::DescriptorSet* globalDescriptorSet; // Per-object
-	rhi::DescriptorSet* localDescriptorSet; // Per-instance
-	rhi::DescriptorSet* materialDescriptorSet; // Per-material
+	rhi::DescriptorSet* globalDescriptorSet; // Per-object, instances push their own data
+	rhi::DescriptorSet* materialDescriptorSet; // Per-material, or the material table owned by the object when bindless
+	rhi::StorageBuffer* materialTableBuffer;
+	bool bindlessMaterials;
+	rhi::ShaderStageFlags instancePushConstantStages;
 
 	rhi::ShaderModuleContainer* shaderModuleContainer;
 	rhi::PipelineState* pipelineState;
@@ -178,12 +189,22 @@ public:
 	void setGroupCount(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
 
 	void setIndirect(rhi::StorageBuffer* storageBuffer);
+
+	// Pushed before every dispatch, the block must stay the same size once the object is built
+	template<typename T>
+	void setPushConstants(const T& block)
+	{
+		setPushConstants(&block, static_cast<uint32_t>(sizeof(T)));
+	}
+
+	void setPushConstants(const void* data, uint32_t size);
 private:
 	bool bIndirect;
 	uint32_t groupCountX;
 	uint32_t groupCountY;
 	uint32_t groupCountZ;
 	rhi::StorageBuffer* indirectStorageBuffer;
+	std::vector<uint8_t> pushConstantData;
 };
 
 class RayTracingObject : public Object
@@ -0,0 +1,78 @@
+#include "null/accelerationStructure.h"
+#include "null/context.h"
+#include "rhi/buffer.h"
+
+namespace null
+{
+// Size of a VkAccelerationStructureInstanceKHR
+const uint64_t kInstanceSize = 64;
+
+BottomLevelAccStructure::BottomLevelAccStructure()
+    : geometrySize(0)
+    , memoryId(0)
+{
+
+}
+
+void BottomLevelAccStructure::destroy(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->release(memoryId);
+    memoryId = 0;
+}
+
+void BottomLevelAccStructure::registerGeometry(rhi::Context* context, rhi::VertexBuffer* vertexBuffer, rhi::IndexBuffer* indexBuffer)
+{
+    geometrySize = static_cast<uint64_t>(vertexBuffer->size()) * vertexBuffer->unitSize() + static_cast<uint64_t>(indexBuffer->size()) * sizeof(uint32_t);
+}
+
+void BottomLevelAccStructure::build(rhi::Context* context)
+{
+    Context* contextNull = reinterpret_cast<Context*>(context);
+
+    // The structure is assumed to be as large as the geometry it is built from
+    memoryId = contextNull->allocate(rhi::MemoryCategory::AccelerationStructure, "Bottom level acceleration structure", geometrySize);
+    contextNull->record(CommandType::BuildAccelerationStructure, geometrySize);
+}
+
+AccStructureManager::AccStructureManager()
+    : instanceCount(0)
+    , memoryId(0)
+{
+
+}
+
+void AccStructureManager::destroy(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->release(memoryId);
+    memoryId = 0;
+
+    rhi::AccStructureManager::destroy(context);
+}
+
+void AccStructureManager::buildBottomLevelAccStructure(rhi::Context* context)
+{
+    for (auto& bottomLevelAccStructure : bottomLevelAccStructures)
+    {
+        reinterpret_cast<BottomLevelAccStructure*>(bottomLevelAccStructure.second)->build(context);
+    }
+}
+
+void AccStructureManager::buildAccInstance(rhi::Context* context,
+                                           rhi::BottomLevelAccStructure* blas,
+                                           const glm::mat4& transform,
+                                           const uint32_t instanceId,
+                                           const uint32_t hitGroupId)
+{
+    instanceCount++;
+}
+
+void AccStructureManager::buildTopLevelAccStructure(rhi::Context* context)
+{
+    Context* contextNull = reinterpret_cast<Context*>(context);
+
+    const uint64_t instancesSize = instanceCount * kInstanceSize;
+    memoryId = contextNull->allocate(rhi::MemoryCategory::AccelerationStructure, "Top level acceleration structure", instancesSize);
+    contextNull->upload(instancesSize);
+    contextNull->record(CommandType::BuildAccelerationStructure, instancesSize);
+}
+}
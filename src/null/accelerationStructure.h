@@ -0,0 +1,46 @@
+#pragma once
+
+#include "rhi/accelerationStructure.h"
+
+namespace null
+{
+class BottomLevelAccStructure : public rhi::BottomLevelAccStructure
+{
+public:
+    BottomLevelAccStructure();
+
+    void destroy(rhi::Context* context) override;
+
+    void registerGeometry(rhi::Context* context, rhi::VertexBuffer* vertexBuffer, rhi::IndexBuffer* indexBuffer) override;
+
+    void build(rhi::Context* context);
+private:
+    uint64_t geometrySize;
+    uint32_t memoryId;
+};
+
+class AccStructureManager : public rhi::AccStructureManager
+{
+public:
+    AccStructureManager();
+
+    void destroy(rhi::Context* context) override;
+
+    void buildBottomLevelAccStructure(rhi::Context* context) override;
+
+    void buildTopLevelAccStructure(rhi::Context* context) override;
+
+    void postBuild(rhi::Context* context) override {}
+
+    void buildAccInstance(rhi::Context* context,
+                          rhi::BottomLevelAccStructure* blas,
+                          const glm::mat4& transform,
+                          const uint32_t instanceId,
+                          const uint32_t hitGroupId) override;
+
+    void* getDescriptorData(rhi::DescriptorType type) override { return this; }
+private:
+    uint32_t instanceCount;
+    uint32_t memoryId;
+};
+}
@@ -0,0 +1,196 @@
+#include "null/buffer.h"
+#include "null/context.h"
+
+namespace null
+{
+VertexBuffer::VertexBuffer()
+    : rhi::VertexBuffer()
+    , memoryId(0)
+    , built(false)
+{
+
+}
+
+void VertexBuffer::destroy(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->release(memoryId);
+    memoryId = 0;
+
+    rhi::VertexBuffer::destroy(context);
+}
+
+void VertexBuffer::build(rhi::Context* rhiContext)
+{
+    if (built)
+    {
+        return;
+    }
+
+    Context* context = reinterpret_cast<Context*>(rhiContext);
+    const uint64_t bufferSize = static_cast<uint64_t>(sizeof(rhi::VertexData)) * vertices.size();
+
+    // Suballocated vertices live in the scratch buffer, only the copy into it is left
+    if (subAllocateInfo == nullptr)
+    {
+        memoryId = context->allocate(rhi::MemoryCategory::Geometry, "Vertex buffer", bufferSize);
+    }
+    context->upload(bufferSize);
+
+    built = true;
+}
+
+void VertexBuffer::bind(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->record(CommandType::BindVertexBuffer);
+}
+
+IndexBuffer::IndexBuffer(rhi::IndexSize indexSize)
+    : rhi::IndexBuffer()
+    , indexSize(indexSize)
+    , memoryId(0)
+    , built(false)
+{
+
+}
+
+void IndexBuffer::destroy(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->release(memoryId);
+    memoryId = 0;
+
+    rhi::IndexBuffer::destroy(context);
+}
+
+void IndexBuffer::build(rhi::Context* rhiContext)
+{
+    if (built || indexSize == rhi::IndexSize::None)
+    {
+        return;
+    }
+
+    Context* context = reinterpret_cast<Context*>(rhiContext);
+    const uint64_t bufferSize = static_cast<uint64_t>(sizeof(uint32_t)) * indices.size();
+
+    if (subAllocateInfo == nullptr)
+    {
+        memoryId = context->allocate(rhi::MemoryCategory::Geometry, "Index buffer", bufferSize);
+    }
+    context->upload(bufferSize);
+
+    built = true;
+}
+
+void IndexBuffer::bind(rhi::Context* context)
+{
+    if (indexSize == rhi::IndexSize::None)
+    {
+        return;
+    }
+
+    reinterpret_cast<Context*>(context)->record(CommandType::BindIndexBuffer);
+}
+
+UniformBuffer::UniformBuffer(rhi::BufferType bufferType)
+    : bufferType(bufferType)
+    , memoryId(0)
+    , writtenVersion(0)
+{
+
+}
+
+void UniformBuffer::destroy(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->release(memoryId);
+    memoryId = 0;
+}
+
+void UniformBuffer::build(rhi::Context* rhiContext)
+{
+    Context* context = reinterpret_cast<Context*>(rhiContext);
+
+    // Dynamic uniforms are written into the per frame arena and own no memory
+    if (bufferType != rhi::BufferType::Dynamic)
+    {
+        memoryId = context->allocate(rhi::MemoryCategory::Uniform, "Uniform buffer", size());
+    }
+    update(rhiContext);
+}
+
+void UniformBuffer::update(rhi::Context* rhiContext)
+{
+    // Dynamic uniforms are rewritten every frame, the others only when the data changed
+    if (bufferType != rhi::BufferType::Dynamic && writtenVersion == version)
+    {
+        return;
+    }
+
+    reinterpret_cast<Context*>(rhiContext)->upload(size());
+    writtenVersion = version;
+}
+
+void UniformBuffer::bind(rhi::Context* context)
+{
+}
+
+StorageBuffer::StorageBuffer(rhi::BufferType bufferType, rhi::BufferUsageFlags usage)
+    : bufferType(bufferType)
+    , usage(usage)
+    , memoryId(0)
+{
+
+}
+
+void StorageBuffer::destroy(rhi::Context* context)
+{
+    Context* contextNull = reinterpret_cast<Context*>(context);
+    contextNull->release(memoryId);
+    contextNull->forget(this);
+    memoryId = 0;
+}
+
+void StorageBuffer::build(rhi::Context* rhiContext)
+{
+    Context* context = reinterpret_cast<Context*>(rhiContext);
+    memoryId = context->allocate(rhi::MemoryCategory::Storage, "Storage buffer", size());
+    if (size() != 0)
+    {
+        context->upload(size());
+    }
+}
+
+void StorageBuffer::update(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->upload(size());
+}
+
+void StorageBuffer::bind(rhi::Context* context)
+{
+}
+
+ScratchBuffer::ScratchBuffer(rhi::BufferUsageFlags bufferUsage)
+    : bufferUsage(bufferUsage)
+    , size(0)
+    , memoryId(0)
+{
+
+}
+
+void ScratchBuffer::destroy(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->release(memoryId);
+    memoryId = 0;
+    size = 0;
+}
+
+size_t ScratchBuffer::preSuballocate(uint32_t suballocationSize)
+{
+    const size_t offset = size;
+    size += suballocationSize;
+    return offset;
+}
+
+void ScratchBuffer::build(rhi::Context* context)
+{
+    memoryId = reinterpret_cast<Context*>(context)->allocate(rhi::MemoryCategory::Geometry, "Scratch buffer", size);
+}
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "rhi/buffer.h"
+
+namespace null
+{
+class Context;
+
+// Buffers only keep their size for the memory accounting, the data stays on the CPU side
+class VertexBuffer : public rhi::VertexBuffer
+{
+public:
+    VertexBuffer();
+
+    void destroy(rhi::Context* context) override;
+
+    void build(rhi::Context* context) override;
+
+    void bind(rhi::Context* context) override;
+private:
+    uint32_t memoryId;
+    bool built;
+};
+
+class IndexBuffer : public rhi::IndexBuffer
+{
+public:
+    IndexBuffer(rhi::IndexSize indexSize);
+
+    void destroy(rhi::Context* context) override;
+
+    void build(rhi::Context* context) override;
+
+    void bind(rhi::Context* context) override;
+private:
+    rhi::IndexSize indexSize;
+    uint32_t memoryId;
+    bool built;
+};
+
+class UniformBuffer : public rhi::UniformBuffer
+{
+public:
+    UniformBuffer(rhi::BufferType bufferType);
+
+    void destroy(rhi::Context* context) override;
+
+    void build(rhi::Context* context) override;
+
+    void update(rhi::Context* context) override;
+
+    void bind(rhi::Context* context) override;
+
+    void* getDescriptorData(rhi::DescriptorType type) override { return this; }
+private:
+    rhi::BufferType bufferType;
+    uint32_t memoryId;
+    uint32_t writtenVersion;
+};
+
+class StorageBuffer : public rhi::StorageBuffer
+{
+public:
+    StorageBuffer(rhi::BufferType bufferType, rhi::BufferUsageFlags usage);
+
+    void destroy(rhi::Context* context) override;
+
+    void build(rhi::Context* context) override;
+
+    void update(rhi::Context* context) override;
+
+    void bind(rhi::Context* context) override;
+
+    void* getDescriptorData(rhi::DescriptorType type) override { return this; }
+private:
+    rhi::BufferType bufferType;
+    rhi::BufferUsageFlags usage;
+    uint32_t memoryId;
+};
+
+class ScratchBuffer : public rhi::ScratchBuffer
+{
+public:
+    ScratchBuffer(rhi::BufferUsageFlags bufferUsage);
+
+    void destroy(rhi::Context* context) override;
+
+    size_t preSuballocate(uint32_t size) override;
+
+    void build(rhi::Context* context) override;
+
+    uint64_t getDeviceAddress(rhi::Context* context) override { return 0; }
+
+    void* getDescriptorData(rhi::DescriptorType type) override { return this; }
+private:
+    rhi::BufferUsageFlags bufferUsage;
+    size_t size;
+    uint32_t memoryId;
+};
+}
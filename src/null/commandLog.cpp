@@ -0,0 +1,142 @@
+#include <fstream>
+#include "null/commandLog.h"
+#include "platform/utils.h"
+
+namespace null
+{
+CommandLog::CommandLog()
+    : frameCount(0)
+{
+    frameCounts.fill(0);
+    lastFrameCounts.fill(0);
+    intervalCounts.fill(0);
+    totalCounts.fill(0);
+}
+
+void CommandLog::record(CommandType type, uint64_t argument)
+{
+    commands.push_back({ type, argument });
+    frameCounts[static_cast<size_t>(type)]++;
+    totalCounts[static_cast<size_t>(type)]++;
+}
+
+void CommandLog::endFrame()
+{
+    lastFrameCommands.swap(commands);
+    commands.clear();
+
+    lastFrameCounts = frameCounts;
+    for (size_t i = 0; i < frameCounts.size(); i++)
+    {
+        intervalCounts[i] += frameCounts[i];
+    }
+    frameCounts.fill(0);
+    frameCount++;
+
+    if (frameCount % kCommandSummaryInterval == 0)
+    {
+        LOGD("Commands per frame over the last %u frames", kCommandSummaryInterval);
+        for (size_t i = 0; i < intervalCounts.size(); i++)
+        {
+            if (intervalCounts[i] != 0)
+            {
+                LOGD("  %-28s %10.1f", getName(static_cast<CommandType>(i)), static_cast<double>(intervalCounts[i]) / kCommandSummaryInterval);
+            }
+        }
+        intervalCounts.fill(0);
+    }
+}
+
+bool CommandLog::writeJson(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        LOGE("Failed to open %s for the command log", path.c_str());
+        return false;
+    }
+
+    // Command names are fixed identifiers, nothing needs escaping
+    file << "{\n";
+    file << "  \"frames\": " << frameCount << ",\n";
+    file << "  \"commands\": [\n";
+    for (size_t i = 0; i < totalCounts.size(); i++)
+    {
+        file << "    { \"name\": \"" << getName(static_cast<CommandType>(i)) << "\", "
+            << "\"lastFrame\": " << lastFrameCounts[i] << ", "
+            << "\"total\": " << totalCounts[i] << " }"
+            << (i + 1 < totalCounts.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n";
+    file << "}\n";
+
+    return true;
+}
+
+void CommandLog::log() const
+{
+    LOGD("Commands after %llu frames, last frame and total", static_cast<unsigned long long>(frameCount));
+    for (size_t i = 0; i < totalCounts.size(); i++)
+    {
+        if (totalCounts[i] != 0)
+        {
+            LOGD("  %-28s %10llu %12llu", getName(static_cast<CommandType>(i)),
+                static_cast<unsigned long long>(lastFrameCounts[i]), static_cast<unsigned long long>(totalCounts[i]));
+        }
+    }
+}
+
+const char* CommandLog::getName(CommandType type)
+{
+    switch (type)
+    {
+    case CommandType::Draw:
+        return "Draw";
+    case CommandType::DrawIndexed:
+        return "DrawIndexed";
+    case CommandType::Dispatch:
+        return "Dispatch";
+    case CommandType::DispatchIndirect:
+        return "DispatchIndirect";
+    case CommandType::TraceRays:
+        return "TraceRays";
+    case CommandType::BindPipeline:
+        return "BindPipeline";
+    case CommandType::BindDescriptorSet:
+        return "BindDescriptorSet";
+    case CommandType::BindVertexBuffer:
+        return "BindVertexBuffer";
+    case CommandType::BindIndexBuffer:
+        return "BindIndexBuffer";
+    case CommandType::PushConstants:
+        return "PushConstants";
+    case CommandType::BeginRenderPass:
+        return "BeginRenderPass";
+    case CommandType::NextSubpass:
+        return "NextSubpass";
+    case CommandType::EndRenderPass:
+        return "EndRenderPass";
+    case CommandType::Barrier:
+        return "Barrier";
+    case CommandType::Upload:
+        return "Upload";
+    case CommandType::CopyImage:
+        return "CopyImage";
+    case CommandType::ClearImage:
+        return "ClearImage";
+    case CommandType::BuildAccelerationStructure:
+        return "BuildAccelerationStructure";
+    case CommandType::Allocate:
+        return "Allocate";
+    case CommandType::Free:
+        return "Free";
+    case CommandType::Submit:
+        return "Submit";
+    case CommandType::Present:
+        return "Present";
+    default:
+        UNREACHABLE();
+        return "Unknown";
+    }
+}
+}
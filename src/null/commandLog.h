@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace null
+{
+// Frames between two summaries in the log
+const uint32_t kCommandSummaryInterval = 600;
+
+enum class CommandType : uint8_t
+{
+    Draw,
+    DrawIndexed,
+    Dispatch,
+    DispatchIndirect,
+    TraceRays,
+    BindPipeline,
+    BindDescriptorSet,
+    BindVertexBuffer,
+    BindIndexBuffer,
+    PushConstants,
+    BeginRenderPass,
+    NextSubpass,
+    EndRenderPass,
+    Barrier,
+    Upload,
+    CopyImage,
+    ClearImage,
+    BuildAccelerationStructure,
+    Allocate,
+    Free,
+    Submit,
+    Present,
+    Count
+};
+
+// The argument depends on the type: vertex, index or group counts for the draws and dispatches,
+// bytes for uploads, allocations and push constants, transitions for barriers
+struct Command
+{
+    CommandType type;
+    uint64_t argument;
+};
+
+typedef std::array<uint64_t, static_cast<size_t>(CommandType::Count)> CommandCounts;
+
+// Everything the null backend would have sent to a GPU, counted per frame. The commands of the
+// frame being recorded and of the last finished one are kept so they can be inspected.
+class CommandLog
+{
+public:
+    CommandLog();
+
+    void record(CommandType type, uint64_t argument = 0);
+
+    // Closes the frame being recorded, commands recorded while loading count towards the next frame
+    void endFrame();
+
+    const std::vector<Command>& getLastFrameCommands() const { return lastFrameCommands; }
+
+    const CommandCounts& getLastFrameCounts() const { return lastFrameCounts; }
+
+    // Over every command recorded since the log was created, loading included
+    const CommandCounts& getTotalCounts() const { return totalCounts; }
+
+    uint64_t getFrameCount() const { return frameCount; }
+
+    bool writeJson(const std::string& path) const;
+
+    void log() const;
+
+    static const char* getName(CommandType type);
+
+private:
+    std::vector<Command> commands;
+    std::vector<Command> lastFrameCommands;
+
+    CommandCounts frameCounts;
+    CommandCounts lastFrameCounts;
+    CommandCounts intervalCounts;
+    CommandCounts totalCounts;
+
+    uint64_t frameCount;
+};
+}
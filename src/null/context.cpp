@@ -0,0 +1,226 @@
+#include "null/context.h"
+#include "platform/window.h"
+#include "vulkan/destructionQueue.h"
+#include "vulkan/memoryTracker.h"
+
+namespace null
+{
+Context::Context()
+    : gpuName("Null")
+    , memoryTracker(nullptr)
+    , destructionQueue(nullptr)
+    , pendingUploads(0)
+    , pendingBarriers(0)
+{
+
+}
+
+bool Context::init(platform::Window* window)
+{
+    // The trackers don't touch the device, the Vulkan backend's ones serve both
+    if (memoryTracker == nullptr)
+    {
+        memoryTracker = new vk::MemoryTracker();
+    }
+    memoryTracker->init(VK_NULL_HANDLE, false);
+
+    if (destructionQueue == nullptr)
+    {
+        destructionQueue = new vk::DestructionQueue();
+    }
+    destructionQueue->init(framesInFlight);
+
+    renderTargetWidth = static_cast<uint32_t>(window->getWidth());
+    renderTargetHeight = static_cast<uint32_t>(window->getHeight());
+
+    LOGD("Null rhi %ux%u, commands are recorded but never executed", renderTargetWidth, renderTargetHeight);
+    return true;
+}
+
+bool Context::terminate()
+{
+    if (destructionQueue != nullptr)
+    {
+        destructionQueue->destroy();
+        delete destructionQueue;
+        destructionQueue = nullptr;
+    }
+
+    commandLog.log();
+
+    if (memoryTracker != nullptr)
+    {
+        memoryTracker->destroy();
+        delete memoryTracker;
+        memoryTracker = nullptr;
+    }
+
+    resourceUsages.clear();
+    return true;
+}
+
+bool Context::present()
+{
+    flushUploads();
+    flushBarriers();
+    record(CommandType::Submit);
+    record(CommandType::Present);
+    commandLog.endFrame();
+
+    frameIndex = (frameIndex + 1) % framesInFlight;
+    destructionQueue->retire(frameIndex);
+    memoryTracker->update();
+    return true;
+}
+
+bool Context::submit()
+{
+    flushUploads();
+    flushBarriers();
+    record(CommandType::Submit);
+    return true;
+}
+
+void Context::wait()
+{
+    // Nothing is in flight, what the frames still hold can go
+    destructionQueue->retireAll();
+}
+
+void Context::flushUploads()
+{
+    if (pendingUploads == 0)
+    {
+        return;
+    }
+
+    record(CommandType::Submit);
+    pendingUploads = 0;
+}
+
+void Context::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
+{
+    record(CommandType::Draw, static_cast<uint64_t>(vertexCount) * instanceCount);
+}
+
+void Context::drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t vertexOffset, uint32_t firstInstance)
+{
+    record(CommandType::DrawIndexed, static_cast<uint64_t>(indexCount) * instanceCount);
+}
+
+void Context::dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    record(CommandType::Dispatch, static_cast<uint64_t>(groupCountX) * groupCountY * groupCountZ);
+}
+
+void Context::dispatchIndirect(rhi::StorageBuffer* buffer)
+{
+    record(CommandType::DispatchIndirect);
+}
+
+bool Context::dumpPassTrace(const std::string& path)
+{
+    LOGE("The null rhi has no GPU passes to trace, %s is not written", path.c_str());
+    return false;
+}
+
+rhi::CommandStats Context::getCommandStats()
+{
+    const CommandCounts& counts = commandLog.getLastFrameCounts();
+    auto count = [&counts](CommandType type) { return static_cast<uint32_t>(counts[static_cast<size_t>(type)]); };
+
+    rhi::CommandStats stats;
+    stats.draws = count(CommandType::Draw) + count(CommandType::DrawIndexed);
+    stats.dispatches = count(CommandType::Dispatch) + count(CommandType::DispatchIndirect);
+    stats.traceRays = count(CommandType::TraceRays);
+    stats.pipelineBinds = count(CommandType::BindPipeline);
+    stats.descriptorSetBinds = count(CommandType::BindDescriptorSet);
+    stats.vertexBufferBinds = count(CommandType::BindVertexBuffer);
+    stats.indexBufferBinds = count(CommandType::BindIndexBuffer);
+    stats.pushConstants = count(CommandType::PushConstants);
+    stats.barriers = count(CommandType::Barrier);
+    stats.renderPasses = count(CommandType::BeginRenderPass);
+    stats.submits = count(CommandType::Submit);
+    // Every bind is recorded, the filtered counts stay zero
+    return stats;
+}
+
+rhi::MemoryBudgetStats Context::getMemoryBudgetStats()
+{
+    return memoryTracker->getStats();
+}
+
+bool Context::dumpMemoryReport(const std::string& path)
+{
+    return memoryTracker->writeJson(path);
+}
+
+void Context::deferDestruction(std::function<void(rhi::Context*)>&& destruction)
+{
+    // Keeps the timing of the Vulkan backend, the destruction runs framesInFlight frames later
+    destructionQueue->push(frameIndex, [this, destruction = std::move(destruction)]()
+    {
+        destruction(this);
+    });
+}
+
+void Context::upload(uint64_t size)
+{
+    record(CommandType::Upload, size);
+    pendingUploads++;
+}
+
+uint32_t Context::allocate(rhi::MemoryCategory category, const std::string& owner, uint64_t size)
+{
+    record(CommandType::Allocate, size);
+    return memoryTracker->track(category, owner, size);
+}
+
+void Context::release(uint32_t id)
+{
+    if (id == 0)
+    {
+        return;
+    }
+
+    record(CommandType::Free);
+    memoryTracker->untrack(id);
+}
+
+void Context::transition(const void* resource, rhi::ResourceUsage usage)
+{
+    auto resourceUsage = resourceUsages.find(resource);
+    if (resourceUsage == resourceUsages.end())
+    {
+        resourceUsages.emplace(resource, usage);
+        pendingBarriers++;
+        return;
+    }
+
+    const bool write = usage == rhi::ResourceUsage::StorageWrite ||
+        usage == rhi::ResourceUsage::ColorAttachment ||
+        usage == rhi::ResourceUsage::DepthStencilAttachment;
+
+    if (resourceUsage->second != usage || write)
+    {
+        resourceUsage->second = usage;
+        pendingBarriers++;
+    }
+}
+
+void Context::flushBarriers()
+{
+    if (pendingBarriers == 0)
+    {
+        return;
+    }
+
+    record(CommandType::Barrier, pendingBarriers);
+    pendingBarriers = 0;
+}
+
+void Context::forget(const void* resource)
+{
+    resourceUsages.erase(resource);
+}
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include "rhi/context.h"
+#include "null/commandLog.h"
+
+namespace platform
+{
+class Window;
+}
+
+namespace vk
+{
+class MemoryTracker;
+class DestructionQueue;
+}
+
+namespace null
+{
+// Implements the rhi without a device. Every command a backend would record or submit goes
+// into a command log instead, so the CPU cost of the scene, model and render graph code can be
+// measured on any machine and optimizations can be checked against the command counts.
+class Context : public rhi::Context
+{
+public:
+    Context();
+
+    bool init(platform::Window* window) override;
+
+    bool terminate() override;
+
+    bool present() override;
+
+    bool submit() override;
+
+    void wait() override;
+
+    void flushUploads() override;
+
+    void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) override;
+
+    void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t vertexOffset, uint32_t firstInstance) override;
+
+    void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) override;
+
+    void dispatchIndirect(rhi::StorageBuffer* buffer) override;
+
+    // Everything stays on the one queue, like the Vulkan backend without a compute queue
+    inline bool hasAsyncCompute() override { return false; }
+
+    void beginAsyncCompute(const std::vector<rhi::Transition>& ownershipTransfers) override {}
+
+    void endAsyncCompute(const std::vector<rhi::Transition>& ownershipTransfers) override {}
+
+    void waitAsyncCompute(const std::vector<rhi::Transition>& ownershipTransfers, rhi::RenderTarget* consumer,
+        const std::vector<rhi::Transition>& consumerUsages) override {}
+
+    rhi::AsyncComputeStats getAsyncComputeStats() override { return {}; }
+
+    // There is no GPU time to measure
+    void beginPassTiming(const std::string& name) override {}
+
+    void endPassTiming() override {}
+
+    std::vector<rhi::PassTimingStats> getPassTimingStats() override { return {}; }
+
+    bool dumpPassTrace(const std::string& path) override;
+
+    // From the command log, barriers are not split into image and buffer barriers
+    rhi::CommandStats getCommandStats() override;
+
+    // Nothing is sampled, the bindless path records the same commands as on a device with descriptor indexing
+    inline uint32_t getBindlessTextureCapacity() override { return rhi::kMaxBindlessTextures; }
+
+    // Only what every device offers, so scenes that fit here fit on a device as well
+    inline uint32_t getMaxPushConstantsSize() override { return rhi::kMinPushConstantsSize; }
+
+    rhi::MemoryBudgetStats getMemoryBudgetStats() override;
+
+    bool dumpMemoryReport(const std::string& path) override;
+
+    // Transient textures get memory of their own, aliasing would not change any command count
+    void aliasTransientTextures(const std::vector<rhi::TransientTextureLifetime>& lifetimes) override {}
+
+    void deferDestruction(std::function<void(rhi::Context*)>&& destruction) override;
+
+    inline const std::string& getGpuName() override { return gpuName; }
+
+// Factory
+public:
+    rhi::RenderTarget* createRenderTarget(rhi::RenderTargetType type, uint16_t width, uint16_t height) override;
+
+    rhi::Pipeline* createPipeline(rhi::PipelineType type) override;
+
+    rhi::ShaderModuleContainer* createShaderModule() override;
+
+    rhi::VertexBuffer* createVertexBuffer() override;
+
+    rhi::IndexBuffer* createIndexBuffer(rhi::IndexSize indexSize = rhi::IndexSize::UINT32) override;
+
+    rhi::UniformBuffer* createUniformBuffer(rhi::BufferType bufferType) override;
+
+    rhi::StorageBuffer* createStorageBuffer(rhi::BufferType bufferType, rhi::BufferUsageFlags usage) override;
+
+    rhi::DescriptorSet* createDescriptorSet() override;
+
+    rhi::Texture* createTexture(rhi::Format format, uint32_t width, uint32_t height, rhi::ImageLayout initialLayout, uint32_t usage) override;
+
+    rhi::Texture* createTexture(rhi::Format format, uint32_t width, uint32_t height, uint32_t depth, uint32_t samples, uint32_t mipLevels,
+        uint32_t layers, rhi::ImageLayout initialLayout, uint32_t usage) override;
+
+    rhi::ScratchBuffer* createScratchBuffer(rhi::BufferUsageFlags bufferUsage) override;
+
+    rhi::AccStructureManager* createAccStructureManager() override;
+
+    rhi::BottomLevelAccStructure* createBottomLevelAccStructure() override;
+
+// Recording
+public:
+    CommandLog* getCommandLog() { return &commandLog; }
+
+    inline void record(CommandType type, uint64_t argument = 0) { commandLog.record(type, argument); }
+
+    // Counted as an upload, submitted with the next flushUploads
+    void upload(uint64_t size);
+
+    // Returns the id to free the allocation with
+    uint32_t allocate(rhi::MemoryCategory category, const std::string& owner, uint64_t size);
+
+    void release(uint32_t id);
+
+    // A barrier is counted when the usage of a resource changes or when it is written again,
+    // the pending ones go out as one barrier command on flushBarriers
+    void transition(const void* resource, rhi::ResourceUsage usage);
+
+    void flushBarriers();
+
+    // The next transition of the resource needs no barrier against what happened before
+    void forget(const void* resource);
+
+private:
+    std::string gpuName;
+    CommandLog commandLog;
+    vk::MemoryTracker* memoryTracker;
+    vk::DestructionQueue* destructionQueue;
+
+    uint32_t pendingUploads;
+    uint32_t pendingBarriers;
+    std::unordered_map<const void*, rhi::ResourceUsage> resourceUsages;
+};
+}
@@ -0,0 +1,20 @@
+#include "null/context.h"
+#include "null/descriptor.h"
+
+namespace null
+{
+void DescriptorSet::bind(rhi::Context* context, rhi::GraphicsPipeline* pipeline, uint32_t binding)
+{
+    reinterpret_cast<Context*>(context)->record(CommandType::BindDescriptorSet, binding);
+}
+
+void DescriptorSet::bind(rhi::Context* context, rhi::ComputePipeline* pipeline, uint32_t binding)
+{
+    reinterpret_cast<Context*>(context)->record(CommandType::BindDescriptorSet, binding);
+}
+
+void DescriptorSet::bind(rhi::Context* context, rhi::RayTracingPipeline* pipeline, uint32_t binding)
+{
+    reinterpret_cast<Context*>(context)->record(CommandType::BindDescriptorSet, binding);
+}
+}
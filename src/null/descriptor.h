@@ -0,0 +1,20 @@
+#pragma once
+
+#include "rhi/descriptor.h"
+
+namespace null
+{
+class DescriptorSet : public rhi::DescriptorSet
+{
+public:
+    void destroy(rhi::Context* context) override {}
+
+    void build(rhi::Context* context) override {}
+
+    void bind(rhi::Context* context, rhi::GraphicsPipeline* pipeline, uint32_t binding) override;
+
+    void bind(rhi::Context* context, rhi::ComputePipeline* pipeline, uint32_t binding) override;
+
+    void bind(rhi::Context* context, rhi::RayTracingPipeline* pipeline, uint32_t binding) override;
+};
+}
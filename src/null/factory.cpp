@@ -0,0 +1,87 @@
+#include "null/context.h"
+#include "null/accelerationStructure.h"
+#include "null/buffer.h"
+#include "null/descriptor.h"
+#include "null/pipeline.h"
+#include "null/rendertarget.h"
+#include "null/texture.h"
+
+namespace null
+{
+rhi::RenderTarget* Context::createRenderTarget(rhi::RenderTargetType type, uint16_t width, uint16_t height)
+{
+    return new RenderTarget(type, width, height);
+}
+
+rhi::Pipeline* Context::createPipeline(rhi::PipelineType type)
+{
+    switch (type)
+    {
+    case rhi::PipelineType::Graphics:
+        return new GraphicsPipeline();
+    case rhi::PipelineType::RayTracing:
+        return new RayTracingPipeline();
+    case rhi::PipelineType::Compute:
+        return new ComputePipeline();
+    default:
+        UNREACHABLE();
+        return nullptr;
+    }
+}
+
+rhi::ShaderModuleContainer* Context::createShaderModule()
+{
+    return new ShaderModuleContainer();
+}
+
+rhi::VertexBuffer* Context::createVertexBuffer()
+{
+    return new VertexBuffer();
+}
+
+rhi::IndexBuffer* Context::createIndexBuffer(rhi::IndexSize indexSize)
+{
+    return new IndexBuffer(indexSize);
+}
+
+rhi::UniformBuffer* Context::createUniformBuffer(rhi::BufferType bufferType)
+{
+    return new UniformBuffer(bufferType);
+}
+
+rhi::StorageBuffer* Context::createStorageBuffer(rhi::BufferType bufferType, rhi::BufferUsageFlags usage)
+{
+    return new StorageBuffer(bufferType, usage);
+}
+
+rhi::DescriptorSet* Context::createDescriptorSet()
+{
+    return new DescriptorSet();
+}
+
+rhi::Texture* Context::createTexture(rhi::Format format, uint32_t width, uint32_t height, rhi::ImageLayout initialLayout, uint32_t usage)
+{
+    return new Texture(format, width, height, initialLayout, usage);
+}
+
+rhi::Texture* Context::createTexture(rhi::Format format, uint32_t width, uint32_t height, uint32_t depth, uint32_t samples, uint32_t mipLevels,
+                                     uint32_t layers, rhi::ImageLayout initialLayout, uint32_t usage)
+{
+    return new Texture(format, width, height, depth, samples, mipLevels, layers, initialLayout, usage);
+}
+
+rhi::ScratchBuffer* Context::createScratchBuffer(rhi::BufferUsageFlags bufferUsage)
+{
+    return new ScratchBuffer(bufferUsage);
+}
+
+rhi::AccStructureManager* Context::createAccStructureManager()
+{
+    return new AccStructureManager();
+}
+
+rhi::BottomLevelAccStructure* Context::createBottomLevelAccStructure()
+{
+    return new BottomLevelAccStructure();
+}
+}
@@ -0,0 +1,37 @@
+#include "null/context.h"
+#include "null/pipeline.h"
+
+namespace null
+{
+void GraphicsPipeline::bind(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->record(CommandType::BindPipeline);
+}
+
+void ComputePipeline::bind(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->record(CommandType::BindPipeline);
+}
+
+void RayTracingPipeline::bind(rhi::Context* rhiContext)
+{
+    Context* context = reinterpret_cast<Context*>(rhiContext);
+    context->record(CommandType::BindPipeline);
+    context->record(CommandType::TraceRays);
+}
+
+void GraphicsPipeline::pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data)
+{
+    reinterpret_cast<Context*>(context)->record(CommandType::PushConstants, size);
+}
+
+void ComputePipeline::pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data)
+{
+    reinterpret_cast<Context*>(context)->record(CommandType::PushConstants, size);
+}
+
+void RayTracingPipeline::pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data)
+{
+    reinterpret_cast<Context*>(context)->record(CommandType::PushConstants, size);
+}
+}
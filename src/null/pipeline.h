@@ -0,0 +1,53 @@
+#pragma once
+
+#include "rhi/pipeline.h"
+
+namespace null
+{
+// Shaders are read from the assets like on a device, they are just never compiled
+class ShaderModuleContainer : public rhi::ShaderModuleContainer
+{
+public:
+    void destroy(rhi::Context* context) override {}
+
+    void build(rhi::Context* context) override {}
+};
+
+class GraphicsPipeline : public rhi::GraphicsPipeline
+{
+public:
+    void destroy(rhi::Context* context) override {}
+
+    void buildGraphics(rhi::Context* context, rhi::PipelineState& pipelineState, rhi::ShaderModuleContainer* shaderModule, rhi::VertexBuffer* vertexBuffer,
+        std::vector<rhi::DescriptorSet*>& descriptorSet, rhi::RenderTarget* renderTarget) override {}
+
+    void bind(rhi::Context* context) override;
+
+    void pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data) override;
+};
+
+class ComputePipeline : public rhi::ComputePipeline
+{
+public:
+    void destroy(rhi::Context* context) override {}
+
+    void buildCompute(rhi::Context* context, rhi::ShaderModuleContainer* shaderModule, std::vector<rhi::DescriptorSet*>& descriptorSet) override {}
+
+    void bind(rhi::Context* context) override;
+
+    void pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data) override;
+};
+
+// Binding traces the rays, as in the Vulkan backend
+class RayTracingPipeline : public rhi::RayTracingPipeline
+{
+public:
+    void destroy(rhi::Context* context) override {}
+
+    void buildRayTracing(rhi::Context* context, rhi::ShaderModuleContainer* shaderModule, rhi::DescriptorSet* descriptorSet) override {}
+
+    void bind(rhi::Context* context) override;
+
+    void pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data) override;
+};
+}
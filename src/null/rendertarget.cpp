@@ -0,0 +1,90 @@
+#include "null/context.h"
+#include "null/rendertarget.h"
+
+namespace null
+{
+RenderTarget::RenderTarget(rhi::RenderTargetType type, uint16_t width, uint16_t height)
+    : rhi::RenderTarget(width, height)
+    , type(type)
+    , currentSubpass(0)
+{
+
+}
+
+void RenderTarget::addTransition(rhi::Context* context, rhi::Transition* transition)
+{
+    Context* contextNull = reinterpret_cast<Context*>(context);
+
+    if (transition->getTexture() != nullptr)
+    {
+        contextNull->transition(transition->getTexture(), transition->getUsage());
+    }
+
+    if (transition->getBuffer() != nullptr)
+    {
+        contextNull->transition(transition->getBuffer(), transition->getUsage());
+    }
+}
+
+void RenderTarget::flushTransition(rhi::Context* context)
+{
+    reinterpret_cast<Context*>(context)->flushBarriers();
+}
+
+bool RenderTarget::begin(rhi::Context* context)
+{
+    Context* contextNull = reinterpret_cast<Context*>(context);
+
+    if (!hasRenderPass())
+    {
+        contextNull->flushBarriers();
+        return true;
+    }
+
+    // Attachments without a texture are the swapchain image
+    for (auto& attachment : attachments)
+    {
+        if (attachment->getTexture() != nullptr)
+        {
+            contextNull->transition(attachment->getTexture(), rhi::ResourceUsage::ColorAttachment);
+        }
+    }
+
+    if (depthStencilAttachment != nullptr && depthStencilAttachment->getTexture() != nullptr)
+    {
+        contextNull->transition(depthStencilAttachment->getTexture(), rhi::ResourceUsage::DepthStencilAttachment);
+    }
+
+    contextNull->flushBarriers();
+    contextNull->record(CommandType::BeginRenderPass);
+    currentSubpass = 0;
+    return true;
+}
+
+bool RenderTarget::nextSubpass(rhi::Context* context)
+{
+    if (!hasRenderPass() || currentSubpass + 1 >= getSubpassCount())
+    {
+        return false;
+    }
+
+    reinterpret_cast<Context*>(context)->record(CommandType::NextSubpass);
+    currentSubpass++;
+    return true;
+}
+
+bool RenderTarget::end(rhi::Context* context)
+{
+    if (!hasRenderPass())
+    {
+        return true;
+    }
+
+    while (nextSubpass(context))
+    {
+    }
+
+    reinterpret_cast<Context*>(context)->record(CommandType::EndRenderPass);
+    return true;
+}
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "rhi/rendertarget.h"
+
+namespace null
+{
+class Context;
+
+class RenderTarget : public rhi::RenderTarget
+{
+public:
+    RenderTarget(rhi::RenderTargetType type, uint16_t width, uint16_t height);
+
+    void build(rhi::Context* context) override {}
+
+    void addTransition(rhi::Context* context, rhi::Transition* transition) override;
+
+    void flushTransition(rhi::Context* context) override;
+
+    bool begin(rhi::Context* context) override;
+
+    bool nextSubpass(rhi::Context* context) override;
+
+    bool end(rhi::Context* context) override;
+private:
+    // Compute and ray tracing passes have no render pass, only their transitions are recorded
+    bool hasRenderPass() const { return type == rhi::RenderTargetType::Graphics || type == rhi::RenderTargetType::Surface; }
+
+    rhi::RenderTargetType type;
+    uint32_t currentSubpass;
+};
+}
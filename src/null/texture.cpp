@@ -0,0 +1,68 @@
+#include "platform/profiler.h"
+#include "null/context.h"
+#include "null/texture.h"
+
+namespace null
+{
+// Texel size assumed for the memory accounting of textures without loaded data
+const uint64_t kAssumedTexelSize = 4;
+
+Texture::Texture(rhi::Format format, uint32_t width, uint32_t height, rhi::ImageLayout initialLayout, uint32_t usage)
+    : rhi::Texture(format, width, height, initialLayout, usage)
+    , memoryId(0)
+{
+
+}
+
+Texture::Texture(rhi::Format format, uint32_t width, uint32_t height, uint32_t depth, uint32_t samples, uint32_t mipLevels, uint32_t layers, rhi::ImageLayout initialLayout, uint32_t usage)
+    : rhi::Texture(format, width, height, depth, samples, mipLevels, layers, initialLayout, usage)
+    , memoryId(0)
+{
+
+}
+
+void Texture::destroy(rhi::Context* context)
+{
+    Context* contextNull = reinterpret_cast<Context*>(context);
+    contextNull->release(memoryId);
+    contextNull->forget(this);
+    memoryId = 0;
+}
+
+void Texture::build(rhi::Context* rhiContext)
+{
+    PROFILE_ZONE("Texture::build");
+
+    Context* context = reinterpret_cast<Context*>(rhiContext);
+
+    const uint32_t attachmentUsage = rhi::COLOR_ATTACHMENT | rhi::DEPTH_STENCIL_ATTACHMENT | rhi::INPUT_ATTACHMENT | rhi::STORAGE;
+    const rhi::MemoryCategory category = (usage & attachmentUsage) ? rhi::MemoryCategory::RenderTarget : rhi::MemoryCategory::Texture;
+    const uint64_t textureSize = textureLoaded ? memoryBuffer.size() :
+        static_cast<uint64_t>(width) * height * depth * layers * samples * kAssumedTexelSize;
+
+    memoryId = context->allocate(category, name, textureSize);
+
+    if (textureLoaded)
+    {
+        context->upload(memoryBuffer.size());
+    }
+
+    clear();
+}
+
+void Texture::clearColor(rhi::Context* context, float r, float g, float b, float a)
+{
+    reinterpret_cast<Context*>(context)->record(CommandType::ClearImage);
+}
+
+void Texture::CopyTo(rhi::Context* rhiContext, rhi::Texture* dstTexture, uint32_t srcMipLevel, uint32_t dstMipLevel)
+{
+    Context* context = reinterpret_cast<Context*>(rhiContext);
+
+    // Both move to transfer layouts, which the render graph usages don't track
+    context->record(CommandType::Barrier, 2);
+    context->record(CommandType::CopyImage);
+    context->forget(this);
+    context->forget(dstTexture);
+}
+}
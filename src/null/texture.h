@@ -0,0 +1,30 @@
+#pragma once
+
+#include "rhi/texture.h"
+
+namespace null
+{
+class Context;
+
+class Texture : public rhi::Texture
+{
+public:
+    Texture(rhi::Format format, uint32_t width, uint32_t height, rhi::ImageLayout initialLayout, uint32_t usage);
+
+    Texture(rhi::Format format, uint32_t width, uint32_t height, uint32_t depth, uint32_t samples, uint32_t mipLevels, uint32_t layers, rhi::ImageLayout initialLayout, uint32_t usage);
+
+    void destroy(rhi::Context* context) override;
+
+    void build(rhi::Context* context) override;
+
+    void* getDescriptorData(rhi::DescriptorType type) override { return this; }
+
+    void clearColor(rhi::Context* context, float r, float g, float b, float a) override;
+
+    void CopyTo(rhi::Context* context, rhi::Texture* dstTexture, uint32_t srcMipLevel, uint32_t dstMipLevel) override;
+
+    void discardContents() override {}
+private:
+    uint32_t memoryId;
+};
+}
@@ -1,6 +1,10 @@
+#include "platform/utils.h"
+
+// Desktop platforms read assets from ASSET_PATH, Android goes through its asset manager
+#if PLATFORM_WINDOW || PLATFORM_LINUX
+#include <cstring>
 #include <fstream>
 #include <string>
-#include "platform/utils.h"
 #include "platform/assetManager.h"
 
 #define STB_IMAGE_IMPLEMENTATION
@@ -78,7 +82,7 @@ void AssetManager::readImageSTB(std::string path, util::MemoryBuffer* buffer, ui
     }
     ASSERT(data);
     
-    // TODO: set channel from Format
+    // Always expanded to four channels, the textures loaded from images are RGBA8
     *width = static_cast<uint32_t>(texWidth);
     *height = static_cast<uint32_t>(texHeight);
     *mipLevels = 1;
@@ -121,3 +125,4 @@ void AssetManager::readImageKTX(std::string path, util::MemoryBuffer* buffer, ui
     ktxTexture_Destroy(ktxTexture);
 }
 }
+#endif
@@ -24,7 +24,7 @@ public:
     AssetManager(AAssetManager* assetManager);
 #endif
 
-#if PLATFORM_WINDOW
+#if PLATFORM_WINDOW || PLATFORM_LINUX
     void init();
     void destroy();
     std::string getAssetPath();
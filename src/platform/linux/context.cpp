@@ -0,0 +1,86 @@
+#include <algorithm>
+#include "platform/linux/context.h"
+
+namespace platform
+{
+HeadlessContext::HeadlessContext()
+	: Context()
+	, platformWindow(nullptr)
+	, frameCount(0)
+{
+
+}
+
+void HeadlessContext::init(long width, long height, uint32_t frameCount, uint32_t readbackInterval, const std::string& readbackDirectory)
+{
+	this->frameCount = frameCount;
+	application = new Application();
+	platformWindow = new HeadlessWindow();
+	platformWindow->updateWindowSize(width, height);
+	platformWindow->setReadback(readbackInterval, readbackDirectory);
+	assetManager = new AssetManager();
+	assetManager->init();
+	initApplication();
+}
+
+void HeadlessContext::destroy()
+{
+	if (assetManager != nullptr)
+	{
+		assetManager->destroy();
+		delete assetManager;
+		assetManager = nullptr;
+	}
+
+	if (platformWindow != nullptr)
+	{
+		delete platformWindow;
+		platformWindow = nullptr;
+	}
+
+	Context::destroy();
+}
+
+void HeadlessContext::initApplication()
+{
+	application->init(platformWindow, assetManager, getInputHandler());
+	initialized = true;
+}
+
+void HeadlessContext::update()
+{
+	double totalTime = 0.0;
+	double minTime = 0.0;
+	double maxTime = 0.0;
+	uint32_t measuredFrames = 0;
+
+	for (uint32_t frame = 0; frameCount == 0 || frame < frameCount; frame++)
+	{
+		auto before = std::chrono::steady_clock::now();
+		bool running = updateApplication();
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - before;
+
+		if (!running)
+		{
+			break;
+		}
+
+		// The first frame builds pipelines and uploads, it would skew the numbers
+		if (frame == 0)
+		{
+			LOGD("First frame time: %.3f ms", elapsed.count());
+			continue;
+		}
+
+		minTime = measuredFrames == 0 ? elapsed.count() : std::min(minTime, elapsed.count());
+		maxTime = std::max(maxTime, elapsed.count());
+		totalTime += elapsed.count();
+		measuredFrames++;
+	}
+
+	if (measuredFrames != 0)
+	{
+		LOGD("Frame time over %u frames: avg %.3f ms, min %.3f ms, max %.3f ms", measuredFrames, totalTime / measuredFrames, minTime, maxTime);
+	}
+}
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include "platform/context.h"
+#include "platform/linux/window.h"
+
+namespace platform
+{
+// Runs the application without a window system, frames are rendered offscreen so it can run
+// on a software rasterizer in CI
+class HeadlessContext : public Context
+{
+public:
+	HeadlessContext();
+
+	void init(long width, long height, uint32_t frameCount, uint32_t readbackInterval, const std::string& readbackDirectory);
+
+	void destroy() override;
+
+	void initApplication();
+
+	// Ticks the application until it quits or frameCount frames were rendered, 0 runs until it quits
+	void update();
+private:
+	platform::HeadlessWindow* platformWindow;
+	uint32_t frameCount;
+};
+}
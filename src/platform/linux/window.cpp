@@ -0,0 +1,18 @@
+#include "platform/linux/window.h"
+
+namespace platform
+{
+HeadlessWindow::HeadlessWindow()
+    : Window()
+    , readbackInterval(0)
+    , readbackDirectory(".")
+{
+
+}
+
+void HeadlessWindow::setReadback(uint32_t interval, const std::string& directory)
+{
+    readbackInterval = interval;
+    readbackDirectory = directory;
+}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include "platform/window.h"
+
+namespace platform
+{
+// Only carries the size of the offscreen target and where presented frames are read back to
+class HeadlessWindow : public Window
+{
+public:
+    HeadlessWindow();
+    void setReadback(uint32_t interval, const std::string& directory);
+    uint32_t getReadbackInterval() { return readbackInterval; }
+    const std::string& getReadbackDirectory() { return readbackDirectory; }
+private:
+    uint32_t readbackInterval;
+    std::string readbackDirectory;
+};
+}
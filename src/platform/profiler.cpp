@@ -0,0 +1,224 @@
+#include "platform/profiler.h"
+
+#if ENABLE_CPU_PROFILER
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include "platform/utils.h"
+
+namespace platform
+{
+ProfileThreadBuffer::ProfileThreadBuffer(uint32_t threadId)
+    : threadId(threadId)
+    , ring(kProfileZoneCapacity)
+    , head(0)
+    , tail(0)
+    , dropped(0)
+{
+
+}
+
+void ProfileThreadBuffer::push(const ProfileZoneRecord& record)
+{
+    const uint64_t currentHead = head.load(std::memory_order_relaxed);
+    if (currentHead - tail.load(std::memory_order_acquire) == ring.size())
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring[currentHead % ring.size()] = record;
+    head.store(currentHead + 1, std::memory_order_release);
+}
+
+void ProfileThreadBuffer::drain(std::vector<ProfileZoneRecord>* records)
+{
+    const uint64_t currentTail = tail.load(std::memory_order_relaxed);
+    const uint64_t currentHead = head.load(std::memory_order_acquire);
+
+    for (uint64_t i = currentTail; i < currentHead; i++)
+    {
+        records->push_back(ring[i % ring.size()]);
+    }
+    tail.store(currentHead, std::memory_order_release);
+}
+
+Profiler* Profiler::get()
+{
+    static Profiler profiler;
+    return &profiler;
+}
+
+uint64_t Profiler::now()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Profiler::Profiler()
+    : phaseName(nullptr)
+    , phaseBegin(0)
+    , frameBegin(now())
+    , frameTime(0)
+    , frameCount(0)
+{
+
+}
+
+ProfileThreadBuffer* Profiler::getThreadBuffer()
+{
+    thread_local ProfileThreadBuffer* threadBuffer = nullptr;
+    if (threadBuffer == nullptr)
+    {
+        // Buffers live as long as the profiler, zones of finished threads are still collected
+        std::lock_guard<std::mutex> lock(mutex);
+        threadBuffers.push_back(std::make_unique<ProfileThreadBuffer>(static_cast<uint32_t>(threadBuffers.size())));
+        threadBuffer = threadBuffers.back().get();
+    }
+    return threadBuffer;
+}
+
+void Profiler::beginPhase(const char* name)
+{
+    // Frame zones recorded so far still belong to the frame
+    collect();
+
+    ASSERT(phaseName == nullptr);
+    phaseName = name;
+    phaseBegin = now();
+    phaseTotals.clear();
+}
+
+void Profiler::endPhase()
+{
+    if (phaseName == nullptr)
+    {
+        return;
+    }
+
+    collect();
+
+    LOGD("CPU phase %s took %.3f ms", phaseName, (now() - phaseBegin) / 1000.0);
+    logTotals(phaseTotals, 1.0);
+
+    phaseName = nullptr;
+    phaseTotals.clear();
+
+    // Loading is not part of the next frame
+    frameBegin = now();
+}
+
+void Profiler::endFrame()
+{
+    collect();
+
+    const uint64_t frameEnd = now();
+    frameTime += frameEnd - frameBegin;
+    frameBegin = frameEnd;
+    frameCount++;
+
+    if (frameCount == kProfileSummaryInterval)
+    {
+        LOGD("CPU frame time %.3f ms on average over %u frames", frameTime / 1000.0 / frameCount, frameCount);
+        logTotals(frameTotals, frameCount);
+
+        frameTime = 0;
+        frameCount = 0;
+        frameTotals.clear();
+    }
+}
+
+void Profiler::collect()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::map<std::string, ZoneTotal>& totals = phaseName != nullptr ? phaseTotals : frameTotals;
+
+    for (auto& threadBuffer : threadBuffers)
+    {
+        drained.clear();
+        threadBuffer->drain(&drained);
+
+        for (auto& record : drained)
+        {
+            ZoneTotal& total = totals[record.name];
+            total.time += record.end - record.begin;
+            total.count++;
+
+            zones.push_back({ record.name, threadBuffer->getThreadId(), record.begin, record.end });
+        }
+    }
+
+    while (zones.size() > kProfileTraceZones)
+    {
+        zones.pop_front();
+    }
+}
+
+void Profiler::logTotals(const std::map<std::string, ZoneTotal>& totals, double divisor)
+{
+    std::vector<std::pair<std::string, ZoneTotal>> sorted(totals.begin(), totals.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.second.time > b.second.time; });
+
+    for (auto& entry : sorted)
+    {
+        LOGD("  %-32s %10.3f ms, %.1f calls", entry.first.c_str(), entry.second.time / 1000.0 / divisor, entry.second.count / divisor);
+    }
+}
+
+bool Profiler::writeTrace(const std::string& path)
+{
+    collect();
+
+    std::ofstream file(path);
+    if (!file.is_open())
+    {
+        LOGE("Failed to open %s for the CPU trace", path.c_str());
+        return false;
+    }
+
+    const uint64_t origin = zones.empty() ? 0 : std::min_element(zones.begin(), zones.end(),
+        [](const Zone& a, const Zone& b) { return a.begin < b.begin; })->begin;
+
+    uint64_t dropped = 0;
+    for (auto& threadBuffer : threadBuffers)
+    {
+        dropped += threadBuffer->getDroppedCount();
+    }
+    if (dropped != 0)
+    {
+        LOGE("CPU trace is missing %llu zones, the thread buffers overflowed", static_cast<unsigned long long>(dropped));
+    }
+
+    // Zone names are identifiers, only quotes and backslashes need escaping
+    file << "{\n";
+    file << "  \"displayTimeUnit\": \"ms\",\n";
+    file << "  \"traceEvents\": [\n";
+    size_t index = 0;
+    for (auto& zone : zones)
+    {
+        std::string name;
+        for (const char* c = zone.name; *c != '\0'; c++)
+        {
+            if (*c == '"' || *c == '\\')
+            {
+                name.push_back('\\');
+            }
+            name.push_back(*c);
+        }
+
+        file << "    { \"name\": \"" << name << "\", \"cat\": \"cpu\", \"ph\": \"X\", "
+            << "\"pid\": 0, \"tid\": " << zone.threadId << ", "
+            << "\"ts\": " << zone.begin - origin << ", "
+            << "\"dur\": " << zone.end - zone.begin << " }"
+            << (++index < zones.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n";
+    file << "}\n";
+
+    return true;
+}
+}
+
+#endif // ENABLE_CPU_PROFILER
@@ -0,0 +1,158 @@
+#pragma once
+
+// Scoped CPU zones, compiled in with ENABLE_CPU_PROFILER. Without it every macro expands to nothing.
+//
+//   PROFILE_ZONE("Scene::update");       times the enclosing scope
+//   PROFILE_FRAME();                     closes a frame, the zones since the last one belong to it
+//   PROFILE_BEGIN_PHASE("Startup");      zones until PROFILE_END_PHASE are reported as a load phase
+//   PROFILE_WRITE_TRACE("cpu.json");     writes the zones kept so far as Chrome trace events
+//
+// Zone names must outlive the profiler, string literals or __FUNCTION__.
+
+#if ENABLE_CPU_PROFILER
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace platform
+{
+// Zones a thread can have in flight before the collector catches up, the rest are dropped
+const uint32_t kProfileZoneCapacity = 16384;
+// Zones kept for the trace, the oldest are dropped first
+const uint32_t kProfileTraceZones = 262144;
+// Frames between two summaries in the log
+const uint32_t kProfileSummaryInterval = 600;
+
+struct ProfileZoneRecord
+{
+    const char* name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// Ring buffer with the owning thread as the only producer and the collector as the only consumer
+class ProfileThreadBuffer
+{
+public:
+    explicit ProfileThreadBuffer(uint32_t threadId);
+
+    void push(const ProfileZoneRecord& record);
+
+    void drain(std::vector<ProfileZoneRecord>* records);
+
+    uint32_t getThreadId() const { return threadId; }
+
+    uint64_t getDroppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    const uint32_t threadId;
+    std::vector<ProfileZoneRecord> ring;
+    std::atomic<uint64_t> head;
+    std::atomic<uint64_t> tail;
+    std::atomic<uint64_t> dropped;
+};
+
+class Profiler
+{
+public:
+    static Profiler* get();
+
+    // Microseconds of a monotonic clock
+    static uint64_t now();
+
+    // Registers the calling thread on first use
+    ProfileThreadBuffer* getThreadBuffer();
+
+    void beginPhase(const char* name);
+
+    void endPhase();
+
+    void endFrame();
+
+    bool writeTrace(const std::string& path);
+
+private:
+    Profiler();
+
+    struct Zone
+    {
+        const char* name;
+        uint32_t threadId;
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    struct ZoneTotal
+    {
+        uint64_t time = 0;
+        uint32_t count = 0;
+    };
+
+    // Moves the zones of every thread into the trace and the totals of the current frame or phase
+    void collect();
+
+    void logTotals(const std::map<std::string, ZoneTotal>& totals, double divisor);
+
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ProfileThreadBuffer>> threadBuffers;
+    std::vector<ProfileZoneRecord> drained;
+
+    std::deque<Zone> zones;
+
+    const char* phaseName;
+    uint64_t phaseBegin;
+    std::map<std::string, ZoneTotal> phaseTotals;
+
+    uint64_t frameBegin;
+    uint64_t frameTime;
+    uint32_t frameCount;
+    std::map<std::string, ZoneTotal> frameTotals;
+};
+
+class ProfileZone
+{
+public:
+    explicit ProfileZone(const char* name)
+        : buffer(Profiler::get()->getThreadBuffer())
+        , name(name)
+        , begin(Profiler::now())
+    {
+
+    }
+
+    ~ProfileZone()
+    {
+        buffer->push({ name, begin, Profiler::now() });
+    }
+
+private:
+    ProfileThreadBuffer* buffer;
+    const char* name;
+    uint64_t begin;
+};
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+#define PROFILE_ZONE(name) platform::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FRAME() platform::Profiler::get()->endFrame()
+#define PROFILE_BEGIN_PHASE(name) platform::Profiler::get()->beginPhase(name)
+#define PROFILE_END_PHASE() platform::Profiler::get()->endPhase()
+#define PROFILE_WRITE_TRACE(path) platform::Profiler::get()->writeTrace(path)
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_FRAME()
+#define PROFILE_BEGIN_PHASE(name)
+#define PROFILE_END_PHASE()
+#define PROFILE_WRITE_TRACE(path)
+
+#endif // ENABLE_CPU_PROFILER
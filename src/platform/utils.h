@@ -10,6 +10,8 @@
 
 #if PLATFORM_WINDOW
 #include "platform/win/util.h"
+#elif PLATFORM_LINUX
+#include "platform/linux/util.h"
 #else
 #include "platform/android/util.h"
 #endif
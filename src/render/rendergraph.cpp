@@ -1,11 +1,82 @@
+#include <algorithm>
+#include <map>
+#include "platform/profiler.h"
 #include "render/renderpass.h"
 #include "render/rendergraph.h"
 #include "rhi/context.h"
+#include "rhi/rendertarget.h"
+#include "rhi/texture.h"
 
 namespace render
 {
+namespace
+{
+const void* getResource(const rhi::Transition& transition)
+{
+    if (transition.getTexture() != nullptr)
+    {
+        return transition.getTexture();
+    }
+    return transition.getBuffer();
+}
+
+bool isWrite(const rhi::Transition& usage)
+{
+    switch (usage.getUsage())
+    {
+    case rhi::ResourceUsage::StorageWrite:
+    case rhi::ResourceUsage::ColorAttachment:
+    case rhi::ResourceUsage::DepthStencilAttachment:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool dependsOnAny(const std::set<size_t>& dependencies, const std::set<size_t>& passes)
+{
+    for (auto& pass : passes)
+    {
+        if (dependencies.count(pass) != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool usesResource(Renderpass* renderpass, const void* resource)
+{
+    for (auto& usage : renderpass->getUsages())
+    {
+        if (getResource(usage) == resource)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool usesAnyResource(Renderpass* renderpass, const std::set<const void*>& resources)
+{
+    for (auto& usage : renderpass->getUsages())
+    {
+        if (resources.count(getResource(usage)) != 0)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+}
+
 RenderGraph::RenderGraph()
     : surfaceRenderpass(nullptr)
+    , topologyVersion(0)
+    , compiledTopologyVersion(0)
+    , enableAsyncCompute(true)
+    , pendingAsyncComputeSection(nullptr)
+    , enableTransientAliasing(true)
 {
 }
 
@@ -24,6 +95,13 @@ void RenderGraph::destroy(rhi::Context* context)
         delete surfaceRenderpass;
         surfaceRenderpass = nullptr;
     }
+
+    exportedResources.clear();
+    schedule.clear();
+    asyncComputeSections.clear();
+    computeResources.clear();
+    transientLifetimes.clear();
+    transientFirstUses.clear();
 }
 
 Renderpass* RenderGraph::allocateRenderpass(std::string name, rhi::RenderTargetType type)
@@ -65,12 +143,358 @@ Renderpass* RenderGraph::allocateRenderpass(std::string name, rhi::RenderTargetT
 void RenderGraph::registerRenderpass(Renderpass* renderpass)
 {
     renderpasses.push_back(renderpass);
+    topologyVersion++;
 }
 
 void RenderGraph::registerSurfaceRenderpass(Renderpass* renderpass)
 {
     ASSERT(surfaceRenderpass == nullptr);
     surfaceRenderpass = renderpass;
+    topologyVersion++;
+}
+
+void RenderGraph::exportResource(rhi::Texture* texture)
+{
+    exportedResources.insert(texture);
+    topologyVersion++;
+}
+
+void RenderGraph::exportResource(rhi::StorageBuffer* storageBuffer)
+{
+    exportedResources.insert(storageBuffer);
+    topologyVersion++;
+}
+
+bool RenderGraph::compile()
+{
+    uint64_t version = topologyVersion;
+    for (auto& renderpass : renderpasses)
+    {
+        version += renderpass->getTopologyVersion();
+    }
+    if (surfaceRenderpass != nullptr)
+    {
+        version += surfaceRenderpass->getTopologyVersion();
+    }
+
+    // Versions only ever grow, so any change shows up in the sum
+    if (version == compiledTopologyVersion)
+    {
+        return false;
+    }
+
+    buildSchedule();
+    compiledTopologyVersion = version;
+    return true;
+}
+
+void RenderGraph::buildSchedule()
+{
+    const size_t passCount = renderpasses.size();
+
+    // Producers are the passes whose writes a pass uses, dependencies add the readers a write has to wait for
+    std::vector<std::set<size_t>> producers(passCount);
+    std::vector<std::set<size_t>> dependencies(passCount);
+    std::map<const void*, size_t> lastWriters;
+    std::map<const void*, std::vector<size_t>> readers;
+
+    for (size_t i = 0; i < passCount; i++)
+    {
+        auto& usages = renderpasses[i]->getUsages();
+        for (auto& usage : usages)
+        {
+            const void* resource = getResource(usage);
+
+            // Storage writes may read the previous contents, so every use waits for the last write
+            auto lastWriter = lastWriters.find(resource);
+            if (lastWriter != lastWriters.end() && lastWriter->second != i)
+            {
+                producers[i].insert(lastWriter->second);
+                dependencies[i].insert(lastWriter->second);
+            }
+
+            if (isWrite(usage))
+            {
+                for (auto& reader : readers[resource])
+                {
+                    if (reader != i)
+                    {
+                        dependencies[i].insert(reader);
+                    }
+                }
+            }
+        }
+
+        for (auto& usage : usages)
+        {
+            const void* resource = getResource(usage);
+            if (isWrite(usage))
+            {
+                lastWriters[resource] = i;
+                readers[resource].clear();
+            }
+            else
+            {
+                readers[resource].push_back(i);
+            }
+        }
+    }
+
+    // Walk back from what leaves the graph
+    std::vector<bool> alive(passCount, false);
+    std::vector<size_t> pending;
+    std::set<const void*> outputs = exportedResources;
+    if (surfaceRenderpass != nullptr)
+    {
+        for (auto& usage : surfaceRenderpass->getUsages())
+        {
+            outputs.insert(getResource(usage));
+        }
+    }
+    for (auto& output : outputs)
+    {
+        auto lastWriter = lastWriters.find(output);
+        if (lastWriter != lastWriters.end())
+        {
+            pending.push_back(lastWriter->second);
+        }
+    }
+    for (size_t i = 0; i < passCount; i++)
+    {
+        if (renderpasses[i]->getUsages().empty())
+        {
+            pending.push_back(i);
+        }
+    }
+
+    while (!pending.empty())
+    {
+        const size_t i = pending.back();
+        pending.pop_back();
+        if (alive[i])
+        {
+            continue;
+        }
+        alive[i] = true;
+        pending.insert(pending.end(), producers[i].begin(), producers[i].end());
+    }
+
+    // List scheduling, the ready pass is picked by staying on the same queue, then by not waiting on
+    // the last async compute run so graphics work overlaps it, then by not waiting on the pass
+    // scheduled last so its barrier has work in between, then by registration order
+    std::vector<size_t> remaining(passCount, 0);
+    for (size_t i = 0; i < passCount; i++)
+    {
+        for (auto& dependency : dependencies[i])
+        {
+            remaining[i] += alive[dependency] ? 1 : 0;
+        }
+    }
+
+    std::vector<bool> scheduled(passCount, false);
+    schedule.clear();
+    size_t last = passCount;
+    // Async compute passes the graphics queue doesn't wait on yet
+    std::set<size_t> asyncRun;
+    size_t culledCount = 0;
+
+    for (size_t i = 0; i < passCount; i++)
+    {
+        if (!alive[i])
+        {
+            LOGD("Render graph: culled pass %s, nothing uses its outputs", renderpasses[i]->getName().c_str());
+            culledCount++;
+        }
+    }
+
+    while (schedule.size() + culledCount < passCount)
+    {
+        size_t best = passCount;
+        uint32_t bestScore = 0;
+        for (size_t i = 0; i < passCount; i++)
+        {
+            if (!alive[i] || scheduled[i] || remaining[i] != 0)
+            {
+                continue;
+            }
+
+            uint32_t score = 1;
+            if (last != passCount)
+            {
+                score += renderpasses[i]->isAsyncCompute() == renderpasses[last]->isAsyncCompute() ? 8 : 0;
+                score += dependencies[i].count(last) == 0 ? 2 : 0;
+            }
+            if (!renderpasses[i]->isAsyncCompute() && !dependsOnAny(dependencies[i], asyncRun))
+            {
+                score += 4;
+            }
+
+            if (score > bestScore)
+            {
+                best = i;
+                bestScore = score;
+            }
+        }
+        ASSERT(best != passCount);
+
+        scheduled[best] = true;
+        schedule.push_back(renderpasses[best]);
+        if (renderpasses[best]->isAsyncCompute())
+        {
+            // The graphics queue waits on the previous run before a new one begins
+            if (last != passCount && !renderpasses[last]->isAsyncCompute())
+            {
+                asyncRun.clear();
+            }
+            asyncRun.insert(best);
+        }
+        else if (dependsOnAny(dependencies[best], asyncRun))
+        {
+            asyncRun.clear();
+        }
+        last = best;
+
+        for (size_t i = 0; i < passCount; i++)
+        {
+            if (alive[i] && dependencies[i].count(best) != 0)
+            {
+                remaining[i]--;
+            }
+        }
+    }
+
+    LOGD("Render graph: %zu of %zu passes scheduled", schedule.size(), passCount);
+}
+
+void RenderGraph::aliasTransientTextures(rhi::Context* context)
+{
+    compile();
+
+    transientLifetimes.clear();
+    transientFirstUses.clear();
+    if (!enableTransientAliasing)
+    {
+        return;
+    }
+
+    collectTransientLifetimes(&transientLifetimes);
+
+    if (!transientLifetimes.empty())
+    {
+        context->aliasTransientTextures(transientLifetimes);
+    }
+}
+
+void RenderGraph::collectTransientLifetimes(std::vector<rhi::TransientTextureLifetime>* lifetimes)
+{
+    std::vector<Renderpass*> passes = schedule;
+    if (surfaceRenderpass != nullptr)
+    {
+        passes.push_back(surfaceRenderpass);
+    }
+
+    // An async compute run overlaps the graphics passes up to the first one that waits for it, the
+    // textures the run uses stay live until then
+    std::vector<uint32_t> liveUntil(passes.size());
+    for (uint32_t passIndex = 0; passIndex < passes.size(); passIndex++)
+    {
+        liveUntil[passIndex] = passIndex;
+    }
+    for (uint32_t begin = 0; enableAsyncCompute && begin < schedule.size();)
+    {
+        if (!schedule[begin]->isAsyncCompute())
+        {
+            begin++;
+            continue;
+        }
+
+        uint32_t end = begin;
+        std::set<const void*> resources;
+        for (; end < schedule.size() && schedule[end]->isAsyncCompute(); end++)
+        {
+            for (auto& usage : schedule[end]->getUsages())
+            {
+                resources.insert(getResource(usage));
+            }
+        }
+
+        uint32_t wait = end;
+        while (wait < schedule.size() && !schedule[wait]->isAsyncCompute() && !usesAnyResource(schedule[wait], resources))
+        {
+            wait++;
+        }
+
+        for (uint32_t passIndex = begin; passIndex < end; passIndex++)
+        {
+            liveUntil[passIndex] = std::min(wait, static_cast<uint32_t>(passes.size() - 1));
+        }
+        begin = end;
+    }
+
+    for (uint32_t passIndex = 0; passIndex < passes.size(); passIndex++)
+    {
+        for (auto& usage : passes[passIndex]->getUsages())
+        {
+            rhi::Texture* texture = usage.getTexture();
+            if (texture == nullptr || !texture->isTransient())
+            {
+                continue;
+            }
+
+            auto lifetime = std::find_if(lifetimes->begin(), lifetimes->end(), [texture](const rhi::TransientTextureLifetime& entry)
+            {
+                return entry.texture == texture;
+            });
+
+            if (lifetime == lifetimes->end())
+            {
+                lifetime = lifetimes->insert(lifetimes->end(), rhi::TransientTextureLifetime());
+                lifetime->texture = texture;
+                lifetime->firstPass = passIndex;
+            }
+            lifetime->lastPass = std::max(lifetime->lastPass, liveUntil[passIndex]);
+        }
+    }
+
+    transientFirstUses.clear();
+    transientFirstUses.resize(passes.size());
+    for (auto& lifetime : *lifetimes)
+    {
+        transientFirstUses[lifetime.firstPass].push_back(lifetime.texture);
+    }
+}
+
+void RenderGraph::validateTransientLifetimes()
+{
+    // Memory was placed for the old schedule, ranges that stay inside the old ones still can't overlap
+    std::vector<rhi::TransientTextureLifetime> lifetimes;
+    collectTransientLifetimes(&lifetimes);
+
+    for (auto& lifetime : lifetimes)
+    {
+        for (auto& aliasedLifetime : transientLifetimes)
+        {
+            if (aliasedLifetime.texture == lifetime.texture &&
+                (lifetime.firstPass < aliasedLifetime.firstPass || lifetime.lastPass > aliasedLifetime.lastPass))
+            {
+                LOGE("Render graph: %s is used outside the passes its memory was aliased for",
+                    lifetime.texture->getName().c_str());
+            }
+        }
+    }
+}
+
+void RenderGraph::discardTransientTextures(size_t passIndex)
+{
+    if (passIndex >= transientFirstUses.size())
+    {
+        return;
+    }
+
+    for (auto& texture : transientFirstUses[passIndex])
+    {
+        texture->discardContents();
+    }
 }
 
 void RenderGraph::preBuild(rhi::Context* context)
@@ -88,6 +512,10 @@ void RenderGraph::preBuild(rhi::Context* context)
 
 void RenderGraph::build(rhi::Context* context)
 {
+    // The ops end up in the render passes the render targets create
+    compile();
+    inferAttachmentOps();
+
     for (auto& renderpass : renderpasses)
     {
         renderpass->build(context);
@@ -97,13 +525,261 @@ void RenderGraph::build(rhi::Context* context)
     {
         surfaceRenderpass->build(context);
     }
+
+    buildAsyncComputeSections(context);
+
+    context->flushUploads();
+}
+
+void RenderGraph::inferAttachmentOps()
+{
+    for (size_t i = 0; i < schedule.size(); i++)
+    {
+        rhi::RenderTarget* renderTarget = schedule[i]->getRenderTarget();
+        if (renderTarget == nullptr)
+        {
+            continue;
+        }
+
+        for (auto& attachment : renderTarget->getColorAttachments())
+        {
+            inferAttachmentOps(i, attachment);
+        }
+
+        if (renderTarget->getDepthStencilAttachment() != nullptr)
+        {
+            inferAttachmentOps(i, renderTarget->getDepthStencilAttachment());
+        }
+    }
+}
+
+void RenderGraph::inferAttachmentOps(size_t passIndex, rhi::Attachment* attachment)
+{
+    rhi::Texture* texture = attachment->getTexture();
+    if (texture == nullptr)
+    {
+        // Swapchain image, it is always presented
+        return;
+    }
+
+    // Sampling a depth texture only reads depth, stencil contents only matter to depth stencil attachments
+    bool written = false;
+    bool stencilWritten = false;
+    bool consumed = exportedResources.count(texture) != 0 || (surfaceRenderpass != nullptr && usesResource(surfaceRenderpass, texture));
+    bool stencilConsumed = exportedResources.count(texture) != 0;
+    bool writtenInFrame = false;
+
+    for (size_t i = 0; i < schedule.size(); i++)
+    {
+        for (auto& usage : schedule[i]->getUsages())
+        {
+            if (usage.getTexture() != texture)
+            {
+                continue;
+            }
+
+            const bool isDepthStencil = usage.getUsage() == rhi::ResourceUsage::DepthStencilAttachment;
+            if (i < passIndex)
+            {
+                written |= isWrite(usage);
+                stencilWritten |= isDepthStencil;
+
+                // Reading ahead of every write of the frame takes the contents of the previous frame
+                consumed |= !writtenInFrame && !isWrite(usage) && !texture->isTransient();
+            }
+            else if (i > passIndex)
+            {
+                consumed = true;
+                stencilConsumed |= isDepthStencil;
+            }
+            writtenInFrame |= isWrite(usage);
+        }
+    }
+
+    auto inferLoadOp = [&](rhi::AttachmentOp loadOp, bool contentsWritten)
+    {
+        if (attachment->hasInferredOps())
+        {
+            return contentsWritten ? rhi::AttachmentOp::Load : rhi::AttachmentOp::Clear;
+        }
+        // Transient contents don't survive the frame, there is nothing to load before the first write
+        if (loadOp == rhi::AttachmentOp::Load && !contentsWritten && texture->isTransient())
+        {
+            return rhi::AttachmentOp::Pass;
+        }
+        return loadOp;
+    };
+
+    auto inferStoreOp = [](rhi::AttachmentOp storeOp, bool contentsConsumed)
+    {
+        return storeOp == rhi::AttachmentOp::Store && !contentsConsumed ? rhi::AttachmentOp::Pass : storeOp;
+    };
+
+    const rhi::AttachmentOp loadOp = inferLoadOp(attachment->getLoadOp(), written);
+    const rhi::AttachmentOp storeOp = inferStoreOp(attachment->getStoreOp(), consumed);
+    const rhi::AttachmentOp subLoadOp = inferLoadOp(attachment->getSubLoadOp(), stencilWritten);
+    const rhi::AttachmentOp subStoreOp = inferStoreOp(attachment->getSubStoreOp(), stencilConsumed);
+
+    if (loadOp != attachment->getLoadOp() || storeOp != attachment->getStoreOp() ||
+        subLoadOp != attachment->getSubLoadOp() || subStoreOp != attachment->getSubStoreOp())
+    {
+        LOGD("Render graph: %s in %s loads %s/%s and stores %s/%s", texture->getName().c_str(), schedule[passIndex]->getName().c_str(),
+            rhi::toString(loadOp).c_str(), rhi::toString(subLoadOp).c_str(), rhi::toString(storeOp).c_str(), rhi::toString(subStoreOp).c_str());
+    }
+    attachment->setOps(loadOp, storeOp, subLoadOp, subStoreOp);
+}
+
+void RenderGraph::buildAsyncComputeSections(rhi::Context* context)
+{
+    asyncComputeSections.clear();
+    if (!enableAsyncCompute || !context->hasAsyncCompute())
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < schedule.size(); i++)
+    {
+        if (!schedule[i]->isAsyncCompute())
+        {
+            continue;
+        }
+
+        AsyncComputeSection section;
+        section.begin = i;
+        section.end = i;
+        while (section.end < schedule.size() && schedule[section.end]->isAsyncCompute())
+        {
+            section.end++;
+        }
+
+        std::set<const void*> visited;
+        for (size_t j = section.begin; j < section.end; j++)
+        {
+            for (auto& usage : schedule[j]->getUsages())
+            {
+                if (visited.insert(getResource(usage)).second)
+                {
+                    section.resources.push_back(usage);
+                }
+            }
+        }
+
+        for (auto& transition : section.resources)
+        {
+            const void* resource = getResource(transition);
+            bool shared = surfaceRenderpass != nullptr && usesResource(surfaceRenderpass, resource);
+            for (size_t j = 0; j < schedule.size() && !shared; j++)
+            {
+                shared = (j < section.begin || j >= section.end) && usesResource(schedule[j], resource);
+            }
+
+            if (shared)
+            {
+                section.sharedResources.push_back(transition);
+            }
+        }
+
+        asyncComputeSections.push_back(section);
+        i = section.end - 1;
+    }
+}
+
+void RenderGraph::beginAsyncComputeSection(rhi::Context* context, const AsyncComputeSection& section)
+{
+    // Resources only the section uses stay with the compute queue after the first frame
+    std::vector<rhi::Transition> ownershipTransfers;
+    for (auto& transition : section.resources)
+    {
+        if (computeResources.insert(getResource(transition)).second)
+        {
+            ownershipTransfers.push_back(transition);
+        }
+    }
+
+    context->beginAsyncCompute(ownershipTransfers);
+}
+
+void RenderGraph::endAsyncComputeSection(rhi::Context* context, const AsyncComputeSection& section)
+{
+    for (auto& transition : section.sharedResources)
+    {
+        computeResources.erase(getResource(transition));
+    }
+
+    context->endAsyncCompute(section.sharedResources);
+    pendingAsyncComputeSection = &section;
+}
+
+void RenderGraph::waitAsyncComputeSection(rhi::Context* context, Renderpass* consumer)
+{
+    if (pendingAsyncComputeSection == nullptr)
+    {
+        return;
+    }
+
+    std::vector<rhi::Transition> consumerUsages;
+    if (consumer != nullptr)
+    {
+        for (auto& usage : consumer->getUsages())
+        {
+            for (auto& transition : pendingAsyncComputeSection->sharedResources)
+            {
+                if (getResource(usage) == getResource(transition))
+                {
+                    consumerUsages.push_back(usage);
+                    break;
+                }
+            }
+        }
+    }
+
+    context->waitAsyncCompute(pendingAsyncComputeSection->sharedResources, consumer != nullptr ? consumer->getRenderTarget() : nullptr, consumerUsages);
+    pendingAsyncComputeSection = nullptr;
 }
 
 bool RenderGraph::render(rhi::Context* context)
 {
-    for (auto& renderpass : renderpasses)
+    PROFILE_ZONE("RenderGraph::render");
+
+    if (compile())
+    {
+        buildAsyncComputeSections(context);
+        if (!transientLifetimes.empty())
+        {
+            validateTransientLifetimes();
+        }
+    }
+
+    size_t sectionIndex = 0;
+    for (size_t i = 0; i < schedule.size(); i++)
     {
-        renderpass->render(context);
+        const bool inSection = sectionIndex < asyncComputeSections.size();
+        if (inSection && asyncComputeSections[sectionIndex].begin == i)
+        {
+            // The handed back resources have to be acquired before they can go to the compute queue again
+            waitAsyncComputeSection(context, nullptr);
+            beginAsyncComputeSection(context, asyncComputeSections[sectionIndex]);
+        }
+        else if (pendingAsyncComputeSection != nullptr)
+        {
+            for (auto& transition : pendingAsyncComputeSection->sharedResources)
+            {
+                if (usesResource(schedule[i], getResource(transition)))
+                {
+                    waitAsyncComputeSection(context, schedule[i]);
+                    break;
+                }
+            }
+        }
+
+        discardTransientTextures(i);
+        schedule[i]->render(context);
+
+        if (inSection && asyncComputeSections[sectionIndex].end == i + 1)
+        {
+            endAsyncComputeSection(context, asyncComputeSections[sectionIndex]);
+            sectionIndex++;
+        }
     }
     return true;
 }
@@ -111,6 +787,9 @@ bool RenderGraph::render(rhi::Context* context)
 bool RenderGraph::renderSurface(rhi::Context* context)
 {
     ASSERT(surfaceRenderpass != nullptr);
+    // Waits without a use of the results as well, the frame has to include the compute work
+    waitAsyncComputeSection(context, surfaceRenderpass);
+    discardTransientTextures(schedule.size());
     surfaceRenderpass->render(context);
     return true;
 }
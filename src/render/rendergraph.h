@@ -1,16 +1,16 @@
 #pragma once
 
+#include <set>
 #include <vector>
 #include <string>
-
-namespace rhi
-{
-class Context;
-}
+#include "rhi/context.h"
+#include "rhi/transition.h"
 
 namespace render
 {
 class Renderpass;
+
+// Orders and records the registered passes from the usages they declare with addUsage
 class RenderGraph
 {
 public:
@@ -24,6 +24,19 @@ public:
 
     void registerSurfaceRenderpass(Renderpass* renderpass);
 
+    // Keeps the passes writing the resource alive even if no pass reads it in the frame
+    void exportResource(rhi::Texture* texture);
+
+    void exportResource(rhi::StorageBuffer* storageBuffer);
+
+    // Rebuilds the schedule if passes or their usages changed since the last call, returns whether it did
+    bool compile();
+
+    // Transient textures are live from the first to the last pass that declares them, textures with
+    // disjoint ranges share memory. Must be called after all passes are registered and before the
+    // scene textures are built
+    void aliasTransientTextures(rhi::Context* context);
+
     void preBuild(rhi::Context* context);
 
     void build(rhi::Context* context);
@@ -33,8 +46,76 @@ public:
     bool renderSurface(rhi::Context* context);
 
     bool hasOffscreenRenderPass();
+
+    // Consecutive passes tagged for async compute go to the compute queue when the context has one.
+    // Must be set before build, comparing both settings shows what the overlap gains
+    void setAsyncCompute(bool enable) { enableAsyncCompute = enable; }
+
+    // Must be set before aliasTransientTextures, without it every transient texture keeps its own memory
+    void setTransientAliasing(bool enable) { enableTransientAliasing = enable; }
 private:
+    struct AsyncComputeSection
+    {
+        // Range of renderpasses
+        size_t begin;
+        size_t end;
+        std::vector<rhi::Transition> resources;
+        // Resources other passes use as well, they go back to the graphics queue after the section
+        std::vector<rhi::Transition> sharedResources;
+    };
+
+    // A pass that writes a resource feeds the passes using it afterwards. Passes feeding neither the
+    // surface pass nor an exported resource are culled, passes without usages are kept.
+    // Independent passes move so a pass doesn't directly follow the one it waits on, runs of passes
+    // of the same queue stay together
+    void buildSchedule();
+
+    // Contents no later pass uses aren't stored, and loads of transient textures nothing wrote yet
+    // are dropped. Attachments created without ops load an earlier write and clear otherwise
+    void inferAttachmentOps();
+
+    void inferAttachmentOps(size_t passIndex, rhi::Attachment* attachment);
+
+    // Resources go to the compute queue for a section and come back at the first pass using them,
+    // graphics passes that don't are recorded ahead of it and overlap the compute work
+    void buildAsyncComputeSections(rhi::Context* context);
+
+    void collectTransientLifetimes(std::vector<rhi::TransientTextureLifetime>* lifetimes);
+
+    // The schedule changed after the transient textures got their memory
+    void validateTransientLifetimes();
+
+    void beginAsyncComputeSection(rhi::Context* context, const AsyncComputeSection& section);
+
+    void endAsyncComputeSection(rhi::Context* context, const AsyncComputeSection& section);
+
+    // Makes the graphics queue wait for the last ended section before the consumer, a null consumer
+    // waits on everything
+    void waitAsyncComputeSection(rhi::Context* context, Renderpass* consumer);
+
+    // The memory of a transient texture holds another texture's data until its first pass of the frame
+    void discardTransientTextures(size_t passIndex);
+
     std::vector<Renderpass*> renderpasses;
     Renderpass* surfaceRenderpass;
+    std::set<const void*> exportedResources;
+
+    // Offscreen passes in execution order, the surface pass always runs after them
+    std::vector<Renderpass*> schedule;
+    // Bumped by registering passes and exports, together with the pass versions it identifies the topology
+    uint64_t topologyVersion;
+    uint64_t compiledTopologyVersion;
+
+    bool enableAsyncCompute;
+    std::vector<AsyncComputeSection> asyncComputeSections;
+    // Resources currently owned by the compute queue
+    std::set<const void*> computeResources;
+    // Ended section the graphics queue doesn't wait for yet, the passes before its first consumer overlap it
+    const AsyncComputeSection* pendingAsyncComputeSection;
+
+    bool enableTransientAliasing;
+    std::vector<rhi::TransientTextureLifetime> transientLifetimes;
+    // Transient textures by the pass that uses them first, the surface pass comes last
+    std::vector<std::vector<rhi::Texture*>> transientFirstUses;
 };
 }
\ No newline at end of file
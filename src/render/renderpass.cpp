@@ -1,6 +1,7 @@
 #include "render/renderpass.h"
 #include "platform/assetManager.h"
 #include "rhi/context.h"
+#include "rhi/pipeline.h"
 #include "rhi/rendertarget.h"
 #include "rhi/texture.h"
 
@@ -44,15 +45,14 @@ void Renderpass::build(rhi::Context* context)
 
 bool Renderpass::render(rhi::Context* context)
 {
-    for (auto& transition : beginTransitions)
-    {
-        renderTarget->addTransition(context , &transition);
-    }
+    // Barriers the pass waits on count towards its time
+    context->beginPassTiming(name);
 
-    if (!clearColorTextures.empty())
+    for (auto& usage : usages)
     {
-        renderTarget->flushTransition(context);
+        renderTarget->addTransition(context, &usage);
     }
+    renderTarget->flushTransition(context);
 
     for (auto& clearColorTexture : clearColorTextures)
     {
@@ -63,39 +63,37 @@ bool Renderpass::render(rhi::Context* context)
 
     renderTarget->begin(context);
 
+    // Objects are drawn in the subpass their pipeline was built for, in the order they were generated
+    uint32_t subpass = 0;
     for (auto& object : objects)
     {
+        rhi::PipelineState* pipelineState = object->getPipelineState();
+        const uint32_t objectSubpass = pipelineState != nullptr ? pipelineState->getSubpass() : 0;
+        ASSERT(objectSubpass >= subpass);
+        for (; subpass < objectSubpass; subpass++)
+        {
+            renderTarget->nextSubpass(context);
+        }
         object->draw(context);
     }
 
     renderTarget->end(context);
 
-    for (auto& transition : endTransitions)
-    {
-        renderTarget->addTransition(context, &transition);
-    }
+    context->endPassTiming();
 
     return true;
 }
 
-void Renderpass::addBeginTransition(rhi::Texture* texture, rhi::MemoryAccessFlags accessFlags)
-{
-    beginTransitions.push_back(rhi::Transition(texture, accessFlags));
-}
-
-void Renderpass::addBeginTransition(rhi::StorageBuffer* buffer, rhi::MemoryAccessFlags accessFlags)
+void Renderpass::addUsage(rhi::Texture* texture, rhi::ResourceUsage usage)
 {
-    beginTransitions.push_back(rhi::Transition(buffer, accessFlags));
+    usages.push_back(rhi::Transition(texture, usage));
+    topologyVersion++;
 }
 
-void Renderpass::addEndTransition(rhi::Texture* texture, rhi::MemoryAccessFlags accessFlags)
+void Renderpass::addUsage(rhi::StorageBuffer* buffer, rhi::ResourceUsage usage)
 {
-    endTransitions.push_back(rhi::Transition(texture, accessFlags));
-}
-
-void Renderpass::addEndTransition(rhi::StorageBuffer* buffer, rhi::MemoryAccessFlags accessFlags)
-{
-    endTransitions.push_back(rhi::Transition(buffer, accessFlags));
+    usages.push_back(rhi::Transition(buffer, usage));
+    topologyVersion++;
 }
 
 void Renderpass::addClearColorTexture(rhi::Texture* texture, glm::vec4 clearValue)
@@ -108,6 +106,12 @@ void Renderpass::setName(std::string name)
     this->name = name;
 }
 
+void Renderpass::setAsyncCompute(bool enable)
+{
+    asyncCompute = enable;
+    topologyVersion++;
+}
+
 rhi::RenderTarget* GraphicsRenderpass::initRenderTarget(rhi::Context* context, uint16_t width, uint16_t height)
 {
     renderTarget = context->createRenderTarget(rhi::RenderTargetType::Graphics, width, height);
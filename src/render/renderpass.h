@@ -33,27 +33,40 @@ public:
 
     virtual model::Object* generateObject(rhi::Context* context) = 0;
 
-    void addBeginTransition(rhi::Texture* texture, rhi::MemoryAccessFlags accessFlags);
+    // Declares how the pass uses a resource. Layouts and barriers are derived from the usages of all passes,
+    // the ones a pass needs go out in a single barrier before it begins.
+    void addUsage(rhi::Texture* texture, rhi::ResourceUsage usage);
 
-    void addBeginTransition(rhi::StorageBuffer* storageBuffer, rhi::MemoryAccessFlags accessFlags);
-
-    void addEndTransition(rhi::Texture* texture, rhi::MemoryAccessFlags accessFlags);
-
-    void addEndTransition(rhi::StorageBuffer* storageBuffer, rhi::MemoryAccessFlags accessFlags);
+    void addUsage(rhi::StorageBuffer* storageBuffer, rhi::ResourceUsage usage);
 
     void addClearColorTexture(rhi::Texture* texture, glm::vec4 clearValue);
 
     void setName(std::string name);
+
+    const std::string& getName() const { return name; }
+
+    // Only meant for compute passes, the compute queue can't record render passes. See RenderGraph
+    void setAsyncCompute(bool enable);
+
+    bool isAsyncCompute() const { return asyncCompute; }
+
+    // Changes whenever a usage or the queue of the pass changes, the render graph recompiles on it
+    uint64_t getTopologyVersion() const { return topologyVersion; }
+
+    const std::vector<rhi::Transition>& getUsages() const { return usages; }
+
+    rhi::RenderTarget* getRenderTarget() const { return renderTarget; }
 public:
     bool render(rhi::Context* context);
 
 private:
     std::string name;
-    std::vector<rhi::Transition> beginTransitions;
-    std::vector<rhi::Transition> endTransitions;
+    std::vector<rhi::Transition> usages;
     std::vector<std::pair<rhi::Texture*, glm::vec4>> clearColorTextures;
+    bool asyncCompute = false;
+    uint64_t topologyVersion = 0;
 protected:
-    rhi::RenderTarget* renderTarget;
+    rhi::RenderTarget* renderTarget = nullptr;
     std::vector<model::Object*> objects;
 };
 
@@ -13,6 +13,7 @@ class Buffer
 public:
     Buffer()
         : count(0)
+        , version(0)
     {
     }
 
@@ -22,6 +23,7 @@ public:
         size_t binarySize = size * (sizeof(T) / sizeof(uint8_t));
         memoryBuffer.set(binarySize, data);
         count = size;
+        version++;
     }
 
     util::MemoryBuffer* getBuffer() { return &memoryBuffer; }
@@ -31,9 +33,13 @@ public:
     size_t size() { return memoryBuffer.size(); }
 
     void clear() { memoryBuffer.clear(); }
+
+    // Bumped by every set, lets implementations skip uploading unchanged data
+    uint32_t getVersion() { return version; }
 protected:
 	util::MemoryBuffer memoryBuffer;
     size_t count;
+    uint32_t version;
 };
 
 class ScratchBuffer : public Descriptor
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+#include <vector>
 #include "platform/utils.h"
 #include "rhi/resources.h"
 
@@ -23,6 +25,122 @@ class DescriptorSetLayout;
 class Texture;
 class AccStructureManager;
 class BottomLevelAccStructure;
+class Transition;
+
+const uint32_t kDefaultFramesInFlight = 2;
+const uint32_t kMaxFramesInFlight = 3;
+// Upper bound of the bindless material texture array, the device limits may lower it
+const uint32_t kMaxBindlessTextures = 1024;
+// Bytes of push constants every device offers, larger blocks need getMaxPushConstantsSize
+const uint32_t kMinPushConstantsSize = 128;
+
+struct AsyncComputeStats
+{
+    uint32_t frameCount = 0;
+    // Summed over all measured frames
+    double computeTimeMs = 0.0;
+    // The part of the compute time the graphics queue was busy as well
+    double overlapTimeMs = 0.0;
+};
+
+// GPU time of a render graph pass over the last frames it ran in
+struct PassTimingStats
+{
+    std::string name;
+    uint32_t sampleCount = 0;
+    double minMs = 0.0;
+    double avgMs = 0.0;
+    double p95Ms = 0.0;
+};
+
+// Commands recorded and submitted in a frame, over every queue
+struct CommandStats
+{
+    uint32_t draws = 0;
+    uint32_t dispatches = 0;
+    uint32_t traceRays = 0;
+    uint32_t pipelineBinds = 0;
+    // Sets, a call binding several counts each of them
+    uint32_t descriptorSetBinds = 0;
+    uint32_t vertexBufferBinds = 0;
+    uint32_t indexBufferBinds = 0;
+    uint32_t pushConstants = 0;
+    // Barrier commands, and the image and buffer barriers they carry
+    uint32_t barriers = 0;
+    uint32_t imageBarriers = 0;
+    uint32_t bufferBarriers = 0;
+    uint32_t renderPasses = 0;
+    uint32_t submits = 0;
+    // Binds and dynamic states dropped because they were already set, not part of the counts above
+    uint32_t filteredPipelineBinds = 0;
+    uint32_t filteredDescriptorSetBinds = 0;
+    uint32_t filteredVertexBufferBinds = 0;
+    uint32_t filteredIndexBufferBinds = 0;
+    uint32_t filteredDynamicStates = 0;
+
+    void add(const CommandStats& other)
+    {
+        draws += other.draws;
+        dispatches += other.dispatches;
+        traceRays += other.traceRays;
+        pipelineBinds += other.pipelineBinds;
+        descriptorSetBinds += other.descriptorSetBinds;
+        vertexBufferBinds += other.vertexBufferBinds;
+        indexBufferBinds += other.indexBufferBinds;
+        pushConstants += other.pushConstants;
+        barriers += other.barriers;
+        imageBarriers += other.imageBarriers;
+        bufferBarriers += other.bufferBarriers;
+        renderPasses += other.renderPasses;
+        submits += other.submits;
+        filteredPipelineBinds += other.filteredPipelineBinds;
+        filteredDescriptorSetBinds += other.filteredDescriptorSetBinds;
+        filteredVertexBufferBinds += other.filteredVertexBufferBinds;
+        filteredIndexBufferBinds += other.filteredIndexBufferBinds;
+        filteredDynamicStates += other.filteredDynamicStates;
+    }
+};
+
+enum class MemoryCategory : uint8_t
+{
+    Geometry,
+    Uniform,
+    Storage,
+    Staging,
+    Texture,
+    RenderTarget,
+    Scratch,
+    AccelerationStructure,
+    Other,
+    Count
+};
+
+struct MemoryCategoryStats
+{
+    uint64_t currentBytes = 0;
+    uint64_t peakBytes = 0;
+    uint32_t allocationCount = 0;
+};
+
+struct MemoryBudgetStats
+{
+    MemoryCategoryStats categories[static_cast<size_t>(MemoryCategory::Count)];
+    // Sizes of the tracked resources over all categories
+    uint64_t currentBytes = 0;
+    uint64_t peakBytes = 0;
+    // Device local heaps as reported by the driver, only filled in when budgetAvailable is set
+    bool budgetAvailable = false;
+    uint64_t heapUsageBytes = 0;
+    uint64_t heapBudgetBytes = 0;
+};
+
+// Range of passes in render graph order that use a transient texture, both ends included
+struct TransientTextureLifetime
+{
+    Texture* texture = nullptr;
+    uint32_t firstPass = 0;
+    uint32_t lastPass = 0;
+};
 
 class Context
 {
@@ -41,6 +159,9 @@ public:
 
     virtual void wait() = 0;
 
+    // Submits the uploads recorded during a build phase as one batch
+    virtual void flushUploads() = 0;
+
     virtual void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) = 0;
 
     virtual void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t vertexOffset, uint32_t firstInstance) = 0;
@@ -48,6 +169,86 @@ public:
     virtual void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) = 0;
 
     virtual void dispatchIndirect(StorageBuffer* buffer) = 0;
+
+// Async compute
+public:
+    virtual bool hasAsyncCompute() = 0;
+
+    // Commands recorded until endAsyncCompute go to the compute queue. It waits for the graphics
+    // work recorded so far, and the resources are handed over from the graphics queue.
+    virtual void beginAsyncCompute(const std::vector<Transition>& ownershipTransfers) = 0;
+
+    // Submits the compute work and releases the resources back to the graphics queue. Graphics work
+    // recorded until waitAsyncCompute doesn't wait for it, so it overlaps the compute queue.
+    virtual void endAsyncCompute(const std::vector<Transition>& ownershipTransfers) = 0;
+
+    // Graphics work recorded afterwards waits for the compute work and the resources are handed back.
+    // The wait holds only the stages the consumer uses the resources at, all of them without a consumer.
+    virtual void waitAsyncCompute(const std::vector<Transition>& ownershipTransfers, RenderTarget* consumer,
+        const std::vector<Transition>& consumerUsages) = 0;
+
+    virtual AsyncComputeStats getAsyncComputeStats() = 0;
+
+// GPU timing
+public:
+    // Brackets the commands recorded until endPassTiming with timestamps, read back frames later
+    virtual void beginPassTiming(const std::string& name) = 0;
+
+    virtual void endPassTiming() = 0;
+
+    virtual std::vector<PassTimingStats> getPassTimingStats() = 0;
+
+    // Writes the passes of the last frames as Chrome trace events, viewable in chrome://tracing
+    virtual bool dumpPassTrace(const std::string& path) = 0;
+
+// Command counters
+public:
+    // Of the last presented frame. The Vulkan backend only counts when built with ENABLE_COMMAND_COUNTERS
+    virtual CommandStats getCommandStats() = 0;
+
+// Bindless
+public:
+    // Textures a partially bound array may hold, 0 when the device lacks descriptor indexing
+    virtual uint32_t getBindlessTextureCapacity() = 0;
+
+// Push constants
+public:
+    // At least kMinPushConstantsSize, ranges of a pipeline must end within it
+    virtual uint32_t getMaxPushConstantsSize() = 0;
+
+// Memory accounting
+public:
+    virtual MemoryBudgetStats getMemoryBudgetStats() = 0;
+
+    // Writes every tracked allocation with its category and owner as JSON
+    virtual bool dumpMemoryReport(const std::string& path) = 0;
+
+// Transient memory
+public:
+    // Textures whose pass ranges don't overlap share memory. Must be called before the textures are built
+    virtual void aliasTransientTextures(const std::vector<TransientTextureLifetime>& lifetimes) = 0;
+
+// Deferred destruction
+public:
+    // Runs the destruction once every frame recorded so far has finished on the GPU
+    virtual void deferDestruction(std::function<void(Context*)>&& destruction) = 0;
+
+    // Destroys and deletes the object without waiting for the device, it may still be in use by frames in flight
+    template<typename T>
+    void destroyDeferred(T* object)
+    {
+        if (object == nullptr)
+        {
+            return;
+        }
+
+        deferDestruction([object](Context* context)
+        {
+            object->destroy(context);
+            delete object;
+        });
+    }
+
 // Factory
 public:
     virtual RenderTarget* createRenderTarget(RenderTargetType type, uint16_t width, uint16_t height) = 0;
@@ -79,8 +280,15 @@ public:
 
     uint32_t getWidth() { return renderTargetWidth; }
     uint32_t getHeight() { return renderTargetHeight; }
+
+    // Must be set before init, clamped to [1, kMaxFramesInFlight]
+    void setFramesInFlight(uint32_t count) { framesInFlight = count == 0 ? 1 : (count > kMaxFramesInFlight ? kMaxFramesInFlight : count); }
+    uint32_t getFramesInFlight() { return framesInFlight; }
+    uint32_t getFrameIndex() { return frameIndex; }
 protected:
     uint32_t renderTargetWidth;
     uint32_t renderTargetHeight;
+    uint32_t framesInFlight = kDefaultFramesInFlight;
+    uint32_t frameIndex = 0;
 };
 }
\ No newline at end of file
@@ -7,9 +7,20 @@ DescriptorInfo::DescriptorInfo(ShaderStageFlags stage, DescriptorType type, Desc
 	: stage(stage)
 	, type(type)
 	, descriptor(descriptor)
+	, count(1)
 {
 }
 
+DescriptorInfo::DescriptorInfo(ShaderStageFlags stage, DescriptorType type, const std::vector<Descriptor*>& arrayDescriptors, uint32_t count)
+	: stage(stage)
+	, type(type)
+	, descriptor(nullptr)
+	, arrayDescriptors(arrayDescriptors)
+	, count(count)
+{
+	ASSERT(arrayDescriptors.size() <= count);
+}
+
 uint32_t DescriptorInfo::getStage()
 {
 	return stage;
@@ -25,8 +36,24 @@ Descriptor* DescriptorInfo::getDescriptor()
 	return descriptor;
 }
 
+bool DescriptorInfo::isArray()
+{
+	return descriptor == nullptr;
+}
+
+std::vector<Descriptor*>& DescriptorInfo::getArrayDescriptors()
+{
+	return arrayDescriptors;
+}
+
+uint32_t DescriptorInfo::getCount()
+{
+	return count;
+}
+
 DescriptorSet::DescriptorSet()
 	: binding(0)
+	, transient(false)
 {
 
 }
@@ -35,4 +62,14 @@ void DescriptorSet::registerDescriptor(ShaderStageFlags stage, DescriptorType ty
 {
 	descriptors.push_back(DescriptorInfo(stage, type, descriptor));
 }
+
+void DescriptorSet::registerDescriptorArray(ShaderStageFlags stage, DescriptorType type, const std::vector<Descriptor*>& descriptors, uint32_t count)
+{
+	this->descriptors.push_back(DescriptorInfo(stage, type, descriptors, count));
+}
+
+void DescriptorSet::setTransient()
+{
+	transient = true;
+}
 }
\ No newline at end of file
@@ -21,15 +21,26 @@ class DescriptorInfo
 public:
 	DescriptorInfo(ShaderStageFlags stage, DescriptorType type, Descriptor* descriptor);
 
+	// An array binding of count elements, the ones past the given descriptors stay unwritten
+	DescriptorInfo(ShaderStageFlags stage, DescriptorType type, const std::vector<Descriptor*>& arrayDescriptors, uint32_t count);
+
 	ShaderStageFlags getStage();
 
 	DescriptorType getType();
 
 	Descriptor* getDescriptor();
+
+	bool isArray();
+
+	std::vector<Descriptor*>& getArrayDescriptors();
+
+	uint32_t getCount();
 protected:
 	DescriptorType type;
 	ShaderStageFlags stage;
 	Descriptor* descriptor;
+	std::vector<Descriptor*> arrayDescriptors;
+	uint32_t count;
 };
 
 class DescriptorSet
@@ -45,6 +56,13 @@ public:
 
 	void registerDescriptor(ShaderStageFlags stage, DescriptorType type, Descriptor* descriptor);
 
+	// Partially bound, shaders must only index the elements that were given
+	void registerDescriptorArray(ShaderStageFlags stage, DescriptorType type, const std::vector<Descriptor*>& descriptors, uint32_t count);
+
+	// Must be called before build, the set is allocated and written again every frame it is bound,
+	// so the descriptors may change between frames. Sets with a per-frame descriptor become transient in build
+	void setTransient();
+
 	virtual void bind(Context* context, GraphicsPipeline* pipeline, uint32_t binding) = 0;
 
 	virtual void bind(Context* context, ComputePipeline* pipeline, uint32_t binding) = 0;
@@ -53,5 +71,6 @@ public:
 protected:
 	std::vector<DescriptorInfo> descriptors;
 	uint32_t binding;
+	bool transient;
 };
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "rhi/pipeline.h"
 #include "rhi/descriptor.h"
+#include <cstring>
 
 namespace rhi
 {
@@ -16,6 +17,7 @@ PipelineState::PipelineState(FrontFace frontFace
 	, tessellationPatchControl(tessellationPatchControl)
 	, topology(topology)
 	, depthStencilState(depthStencilState)
+	, subpass(0)
 {
 	for (auto& colorBlendMaskFlag : colorBlendMaskFlags)
 	{
@@ -58,6 +60,23 @@ PipelineState::DepthStencilState& PipelineState::getDepthStencilState()
 	return depthStencilState;
 }
 
+uint32_t PipelineState::getSubpass()
+{
+	return subpass;
+}
+
+void Pipeline::registerPushConstantRange(ShaderStageFlags stage, uint32_t offset, uint32_t size)
+{
+	// Offsets and sizes are in multiples of 4 bytes
+	ASSERT(size != 0 && offset % 4 == 0 && size % 4 == 0);
+	pushConstantRanges.push_back({ stage, offset, size });
+}
+
+std::vector<PushConstantRange>& Pipeline::getPushConstantRanges()
+{
+	return pushConstantRanges;
+}
+
 void ShaderModuleContainer::updateShaderCode(platform::AssetManager* assetManager, rhi::ShaderStage shaderStage, std::string path)
 {
 	util::MemoryBuffer shaderCode;
@@ -73,6 +92,46 @@ void ShaderModuleContainer::updateShaderCode(platform::AssetManager* assetManage
 	shader.code = std::move(shaderCode);
 }
 
+ShaderStageFlags ShaderModuleContainer::getPushConstantStages()
+{
+	const uint32_t kSpirvMagic = 0x07230203;
+	const uint32_t kSpirvHeaderWords = 5;
+	const uint32_t kOpVariable = 59;
+	const uint32_t kStorageClassPushConstant = 9;
+
+	ShaderStageFlags stages = 0;
+	for (auto& shader : shaders)
+	{
+		const size_t wordCount = shader.code.size() / sizeof(uint32_t);
+		std::vector<uint32_t> words(wordCount);
+		memcpy(words.data(), shader.code.data(), wordCount * sizeof(uint32_t));
+		if (wordCount < kSpirvHeaderWords || words[0] != kSpirvMagic)
+		{
+			continue;
+		}
+
+		// Every instruction starts with its word count in the high half and its opcode in the low half
+		for (size_t i = kSpirvHeaderWords; i < wordCount;)
+		{
+			const uint32_t instructionWords = words[i] >> 16;
+			const uint32_t opcode = words[i] & 0xFFFF;
+			if (instructionWords == 0 || i + instructionWords > wordCount)
+			{
+				break;
+			}
+
+			// OpVariable: result type, result id, storage class
+			if (opcode == kOpVariable && instructionWords >= 4 && words[i + 3] == kStorageClassPushConstant)
+			{
+				stages |= shader.shaderStage;
+				break;
+			}
+			i += instructionWords;
+		}
+	}
+	return stages;
+}
+
 void ShaderModuleContainer::init(platform::AssetManager* assetManager, std::string path)
 {
 	updateShaderCode(assetManager, rhi::ShaderStage::Vertex, path + "/vert.spv");
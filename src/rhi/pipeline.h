@@ -87,6 +87,7 @@ public:
 	std::vector<ColorBlendMaskFlags>& getColorBlendMasks();
 	Topology getTopology();
 	DepthStencilState& getDepthStencilState();
+	uint32_t getSubpass();
 
 	FrontFace frontFace;
 	CullMode cullMode;
@@ -95,6 +96,8 @@ public:
 	std::vector<ColorBlendMaskFlags> colorBlendMasks;
 	Topology topology;
 	DepthStencilState depthStencilState;
+	// Subpass of the render target the pipeline is used in
+	uint32_t subpass;
 };
 
 struct ShaderCode
@@ -116,10 +119,20 @@ public:
 
 	virtual void build(Context* context) = 0;
 
+	// Stages whose SPIR-V declares a push constant block, pipelines only need a range for those
+	ShaderStageFlags getPushConstantStages();
+
 protected:
 	std::vector<ShaderCode> shaders;
 };
 
+struct PushConstantRange
+{
+	ShaderStageFlags stage;
+	uint32_t offset;
+	uint32_t size;
+};
+
 class Pipeline
 {
 public:
@@ -127,6 +140,21 @@ public:
 
 	virtual void destroy(Context* context) = 0;
 
+	// Must be called before the pipeline is built, ranges of different stages may overlap
+	void registerPushConstantRange(ShaderStageFlags stage, uint32_t offset, uint32_t size);
+
+	std::vector<PushConstantRange>& getPushConstantRanges();
+
+	// Recorded with the commands, the values stay until the next push to the same bytes.
+	// The pipeline must be bound or share its layout with the bound one.
+	virtual void pushConstants(Context* context, ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data) = 0;
+
+	template<typename T>
+	void pushConstants(Context* context, ShaderStageFlags stage, const T& data, uint32_t offset = 0)
+	{
+		pushConstants(context, stage, offset, static_cast<uint32_t>(sizeof(T)), &data);
+	}
+
 	virtual void buildGraphics(Context* context, PipelineState& pipelineState, ShaderModuleContainer* shaderModule, VertexBuffer* vertexBuffer, std::vector<DescriptorSet*>& descriptorSet, RenderTarget* renderTarget) = 0;
 
 	virtual void buildRayTracing(Context* context, ShaderModuleContainer* shaderModule, DescriptorSet* descriptorSet) = 0;
@@ -134,6 +162,8 @@ public:
 	virtual void buildCompute(Context* context, ShaderModuleContainer* shaderModule, std::vector<DescriptorSet*>& descriptorSet) = 0;
 
 	virtual void bind(Context* context) = 0;
+protected:
+	std::vector<PushConstantRange> pushConstantRanges;
 };
 
 class GraphicsPipeline : public Pipeline
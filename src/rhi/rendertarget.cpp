@@ -14,7 +14,14 @@ Attachment::Attachment(Texture* texture, AttachmentOp loadOp, AttachmentOp store
     , subLoadOp(subLoadOp)
     , subStoreOp(subStoreOp)
     , clearValue(clearValue)
+    , inferredOps(false)
 {
 
 }
+
+Attachment::Attachment(Texture* texture, glm::vec4 clearValue)
+    : Attachment(texture, AttachmentOp::Clear, AttachmentOp::Store, AttachmentOp::Clear, AttachmentOp::Store, clearValue)
+{
+    inferredOps = true;
+}
 }
\ No newline at end of file
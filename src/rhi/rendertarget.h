@@ -21,12 +21,24 @@ class Attachment
 public:
     Attachment(Texture* texture, AttachmentOp loadOp, AttachmentOp storeOp, glm::vec4 clearValue);
     Attachment(Texture* texture, AttachmentOp loadOp, AttachmentOp storeOp, AttachmentOp subLoadOp, AttachmentOp subStoreOp, glm::vec4 clearValue);
+    // The render graph picks the ops from the other passes using the texture, see RenderGraph
+    Attachment(Texture* texture, glm::vec4 clearValue);
 
     AttachmentOp getLoadOp() { return loadOp; }
     AttachmentOp getStoreOp() { return storeOp; }
     AttachmentOp getSubLoadOp() { return subLoadOp; }
     AttachmentOp getSubStoreOp() { return subStoreOp; }
 
+    bool hasInferredOps() { return inferredOps; }
+
+    void setOps(AttachmentOp loadOp, AttachmentOp storeOp, AttachmentOp subLoadOp, AttachmentOp subStoreOp)
+    {
+        this->loadOp = loadOp;
+        this->storeOp = storeOp;
+        this->subLoadOp = subLoadOp;
+        this->subStoreOp = subStoreOp;
+    }
+
     Texture* getTexture() { return texture; }
     glm::vec4 getClearValue() { return clearValue; }
 private:
@@ -36,6 +48,7 @@ private:
     AttachmentOp subLoadOp;
     AttachmentOp subStoreOp;
     glm::vec4 clearValue;
+    bool inferredOps;
 };
 
 class Subpass
@@ -54,10 +67,16 @@ public:
 
     void setDepthStencilAttachment(uint8_t index)
     {
-        ASSERT(index == INVALID_ATTACHMENT_INDEX);
+        ASSERT(depthAttachment == INVALID_ATTACHMENT_INDEX);
         depthAttachment = index;
     }
 
+    // Read in the fragment shader with subpassLoad, written by an earlier subpass of the same render target
+    void addInputAttachment(uint8_t index)
+    {
+        inputAttachments.push_back(index);
+    }
+
     std::vector<uint8_t>& getColorAttachments() { return colorAttachments; }
     std::vector<uint8_t>& getInputAttachments() { return inputAttachments; }
 
@@ -65,7 +84,7 @@ public:
 protected:
     // resolve
     std::vector<uint8_t> colorAttachments;
-    std::vector<uint8_t> inputAttachments; // Don't use yet
+    std::vector<uint8_t> inputAttachments;
     uint8_t depthAttachment;
 };
 
@@ -119,8 +138,15 @@ public:
         subpasses.push_back(subpass);
         return static_cast<uint32_t>(subpasses.size() - 1);
     }
+
+    std::vector<Attachment*>& getColorAttachments() { return attachments; }
+
+    Attachment* getDepthStencilAttachment() { return depthStencilAttachment; }
+    uint32_t getSubpassCount() const { return static_cast<uint32_t>(subpasses.size()); }
 public:
     virtual bool begin(Context* context) = 0;
+    // Subpasses run in the order they were added, end moves through the ones left
+    virtual bool nextSubpass(Context* context) = 0;
     virtual bool end(Context* context) = 0;
 protected:
     std::vector<Attachment*>& getAttachments() { return attachments; }
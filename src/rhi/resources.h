@@ -44,6 +44,8 @@ enum class BufferType
     DeviceLocal,
     HostCoherent,
     HostCached,
+    // Written into the per frame uniform arena on update and bound with a dynamic offset
+    Dynamic,
 };
 
 enum class VertexType
@@ -135,6 +137,17 @@ enum MemoryAccess
 };
 typedef uint32_t MemoryAccessFlags;
 
+// How a render graph pass uses a resource, the backend derives layouts and barriers from it and the pass type
+enum class ResourceUsage : uint8_t
+{
+    Sampled,
+    StorageRead,
+    StorageWrite,
+    ColorAttachment,
+    DepthStencilAttachment,
+    IndirectArgument
+};
+
 enum class SampleMode : uint8_t
 {
     Nearest,
@@ -253,6 +266,14 @@ class Descriptor
 {
 public:
     virtual void* getDescriptorData(DescriptorType type) = 0;
+
+    // Descriptors backed by one resource per frame in flight
+    virtual bool isPerFrame() { return false; }
+
+    virtual void* getFrameDescriptorData(DescriptorType type, uint32_t frameIndex) { return getDescriptorData(type); }
+
+    // Offset passed when binding a set that holds the descriptor as a dynamic one
+    virtual uint32_t getDynamicOffset() { return 0; }
 };
 
 enum ShaderStage : uint16_t
@@ -109,6 +109,7 @@ Texture::Texture(Format format, uint32_t width, uint32_t height, uint32_t depth,
     , usage(usage)
     , samplerInfo(samplerInfo)
     , textureLoaded(false)
+    , transient(false)
 {
 
 }
@@ -116,6 +117,7 @@ Texture::Texture(Format format, uint32_t width, uint32_t height, uint32_t depth,
 void Texture::loadTexture(platform::AssetManager* assetManager, std::string path)
 {
     textureLoaded = true;
+    name = path;
     assetManager->readImage(path, &memoryBuffer, &width, &height, &mipLevels, mipOffsets);
 }
 
@@ -123,4 +125,15 @@ void Texture::setSamplerInfo(SamplerInfo info)
 {
     samplerInfo = info;
 }
+
+void Texture::setName(const std::string& name)
+{
+    this->name = name;
+}
+
+void Texture::setTransient(bool transient)
+{
+    ASSERT(!textureLoaded);
+    this->transient = transient;
+}
 }
\ No newline at end of file
@@ -76,9 +76,23 @@ public:
     virtual void clearColor(Context* context, float r, float g, float b, float a) = 0;
 
     virtual void CopyTo(Context* context, Texture* dstTexture, uint32_t srcMipLevel, uint32_t dstMipLevel) = 0;
+
+    // The memory may have been written through an aliased texture, the next transition starts from an undefined layout
+    virtual void discardContents() = 0;
 public:
     void setSamplerInfo(SamplerInfo info);
 
+    // Owner shown in the memory report, loadTexture sets it to the path
+    void setName(const std::string& name);
+
+    const std::string& getName() const { return name; }
+
+    // Transient textures are fully rewritten every frame before they are read, so the render graph
+    // may share their memory with other transient textures. Must be set before the graph is built
+    void setTransient(bool transient);
+
+    bool isTransient() const { return transient; }
+
 protected:
     Format format;
     uint32_t width;
@@ -92,5 +106,7 @@ protected:
     SamplerInfo samplerInfo;
     bool textureLoaded;
     std::vector<std::pair<uint32_t, size_t>> mipOffsets;
+    std::string name;
+    bool transient;
 };
 }
\ No newline at end of file
@@ -9,32 +9,31 @@ namespace rhi
 class Transition
 {
 public:
-    // TODO: make it use ImageLayout
-    Transition(Texture* texture, MemoryAccessFlags accessFlags)
-        : texture(texture)
+    Transition(Texture* texture, ResourceUsage usage)
+        : usage(usage)
+        , texture(texture)
         , buffer(nullptr)
-        , accessFlags(accessFlags)
     {
 
     }
 
-    Transition(StorageBuffer* buffer, MemoryAccessFlags accessFlags)
-            : texture(nullptr)
-            , buffer(buffer)
-            , accessFlags(accessFlags)
+    Transition(StorageBuffer* buffer, ResourceUsage usage)
+        : usage(usage)
+        , texture(nullptr)
+        , buffer(buffer)
     {
 
     }
 
-    Texture* getTexture() { return texture; }
+    Texture* getTexture() const { return texture; }
 
-    StorageBuffer* getBuffer() { return buffer; }
+    StorageBuffer* getBuffer() const { return buffer; }
 
-    MemoryAccessFlags getMemoryAccessFlags() { return accessFlags; }
+    ResourceUsage getUsage() const { return usage; }
 
 private:
-    MemoryAccessFlags accessFlags;
+    ResourceUsage usage;
     Texture* texture;
     StorageBuffer* buffer;
 };
-}
\ No newline at end of file
+}
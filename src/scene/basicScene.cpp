@@ -10,6 +10,29 @@
 
 namespace scene
 {
+namespace
+{
+// Push constants of shadows_unpack.comp, the blend factors are shared with the reprojection
+struct ShadowUnpackPushConstants
+{
+	float alpha;
+	float momentsAlpha;
+	int32_t gBufferMip;
+};
+
+// Push constants of shadows_denoise_atrous.comp
+struct ATrousPushConstants
+{
+	int32_t radius;
+	int32_t stepSize;
+	float phiVisibility;
+	float phiNormal;
+	float sigmaDepth;
+	int32_t gBufferMip;
+	float power;
+};
+}
+
 BasicScene::BasicScene()
 {
 	enableRayTracing = true;
@@ -19,7 +42,7 @@ BasicScene::BasicScene()
 render::Renderpass* BasicScene::initSurfaceRenderpass(rhi::Context* context, platform::AssetManager* assetManager, rhi::Texture* inputRenderTarget)
 {
 	auto renderpass = renderGraph->allocateRenderpass("Present", rhi::RenderTargetType::Surface);
-	renderpass->addBeginTransition(inputRenderTarget, rhi::MemoryAccess::Read);
+	renderpass->addUsage(inputRenderTarget, rhi::ResourceUsage::Sampled);
 	auto renderTarget = renderpass->initRenderTarget(context, context->getWidth(), context->getHeight());
 
 	rhi::Attachment* attachment = new rhi::Attachment(nullptr, rhi::AttachmentOp::Clear, rhi::AttachmentOp::Store, { 0.f, 0.f, 0.f, 1.f });
@@ -35,7 +58,7 @@ render::Renderpass* BasicScene::initSurfaceRenderpass(rhi::Context* context, pla
 	object->updateShaderCode(assetManager, rhi::ShaderStage::Vertex, "shaders/screen.vert.spv");
 	object->updateShaderCode(assetManager, rhi::ShaderStage::Fragment, "shaders/screen.frag.spv");
 	
-	object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer, rhi::ShaderStage::Vertex, sceneUniformBuffer);
+	object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer_Dynamic, rhi::ShaderStage::Vertex, sceneUniformBuffer);
 	object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Fragment, inputRenderTarget);
 	object->instantiate(context, glm::mat4(1.f));
 
@@ -64,10 +87,10 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 		shadowMapTexture = allocateSceneTexture(context, rhi::Format::D32_FLOAT_S8X24_UINT, shadowMapWidth, shadowMapHeight, rhi::ImageLayout::DepthStencilAttachment, rhi::ImageUsage::DEPTH_STENCIL_ATTACHMENT | rhi::ImageUsage::SAMPLED);
 
 		auto renderpass = renderGraph->allocateRenderpass("ShadowMap", rhi::RenderTargetType::Graphics);
-		renderpass->addBeginTransition(shadowMapTexture, rhi::MemoryAccess::Write);
+		renderpass->addUsage(shadowMapTexture, rhi::ResourceUsage::DepthStencilAttachment);
 
 		auto renderTarget = renderpass->initRenderTarget(context, shadowMapWidth, shadowMapHeight);
-		rhi::Attachment* attachmentDS = new rhi::Attachment(shadowMapTexture, rhi::AttachmentOp::Clear, rhi::AttachmentOp::Store, rhi::AttachmentOp::Clear, rhi::AttachmentOp::Store, { 1.f, 0.f, 0.f, 0.f });
+		rhi::Attachment* attachmentDS = new rhi::Attachment(shadowMapTexture, { 1.f, 0.f, 0.f, 0.f });
 		uint32_t indexDepthStencil = renderTarget->addDepthAttachment(attachmentDS);
 
 		rhi::Subpass* subpass = new rhi::Subpass();
@@ -88,40 +111,73 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 				| rhi::VertexChannel::Tangent | rhi::VertexChannel::Bitangent, rhi::MaterialFlag::BaseColorTexture);
 
 			sceneObject->updateShaderCode(assetManager, rhi::ShaderStage::Vertex, "shaders/shadowmap.vert.spv");
-			sceneObject->registerDescriptor(rhi::DescriptorType::Uniform_Buffer, rhi::ShaderStage::Vertex | rhi::ShaderStage::Fragment, sceneUniformBuffer);
+			sceneObject->registerDescriptor(rhi::DescriptorType::Uniform_Buffer_Dynamic, rhi::ShaderStage::Vertex | rhi::ShaderStage::Fragment, sceneUniformBuffer);
 
 			sceneObject->instantiate(context, glm::mat4(1.f));
 		}
 	}
 
+	// The lighting runs as a second subpass and reads the G-buffer from tile memory. The ray traced
+	// shadows sample the G-buffer between the G-buffer and the lighting, so they keep separate passes
+	const bool mergeDeferred = enableMergedDeferred && !enableRayTracing;
+
+	// Input attachments of the merged pass are never sampled, on tilers their memory is not even committed
+	const uint32_t gBufferUsage = mergeDeferred ?
+		rhi::ImageUsage::COLOR_ATTACHMENT | rhi::ImageUsage::INPUT_ATTACHMENT | rhi::ImageUsage::TRANSIENT_ATTACHMENT :
+		rhi::ImageUsage::COLOR_ATTACHMENT | rhi::ImageUsage::SAMPLED;
+	const uint32_t sceneDepthUsage = mergeDeferred ?
+		rhi::ImageUsage::DEPTH_STENCIL_ATTACHMENT | rhi::ImageUsage::INPUT_ATTACHMENT | rhi::ImageUsage::TRANSIENT_ATTACHMENT :
+		rhi::ImageUsage::DEPTH_STENCIL_ATTACHMENT | rhi::ImageUsage::SAMPLED;
+
 	// RGB: Albedo, A: Metallic
-	rhi::Texture* gBufferA = allocateSceneTexture(context, rhi::Format::R8G8B8A8_UNORM, width, height, rhi::ImageLayout::ColorAttachment, rhi::ImageUsage::COLOR_ATTACHMENT | rhi::ImageUsage::SAMPLED);
+	rhi::Texture* gBufferA = allocateSceneTexture(context, rhi::Format::R8G8B8A8_UNORM, width, height, rhi::ImageLayout::ColorAttachment, gBufferUsage);
 	// RG: Normal, BA: Motion Vector
-	rhi::Texture* gBufferB = allocateSceneTexture(context, rhi::Format::R16G16B16A16_FLOAT, width, height, rhi::ImageLayout::ColorAttachment, rhi::ImageUsage::COLOR_ATTACHMENT | rhi::ImageUsage::SAMPLED);
+	rhi::Texture* gBufferB = allocateSceneTexture(context, rhi::Format::R16G16B16A16_FLOAT, width, height, rhi::ImageLayout::ColorAttachment, gBufferUsage);
 	// R: Roughness, G: Curvature, B: Mesh ID, A: Linear Z
-	rhi::Texture* gBufferC = allocateSceneTexture(context, rhi::Format::R16G16B16A16_FLOAT, width, height, rhi::ImageLayout::ColorAttachment, rhi::ImageUsage::COLOR_ATTACHMENT | rhi::ImageUsage::SAMPLED);
+	rhi::Texture* gBufferC = allocateSceneTexture(context, rhi::Format::R16G16B16A16_FLOAT, width, height, rhi::ImageLayout::ColorAttachment, gBufferUsage);
 	// Depth
-	rhi::Texture* sceneDepth = allocateSceneTexture(context, rhi::Format::D32_FLOAT_S8X24_UINT, width, height, rhi::ImageLayout::DepthStencilAttachment, rhi::ImageUsage::DEPTH_STENCIL_ATTACHMENT | rhi::ImageUsage::SAMPLED);
+	rhi::Texture* sceneDepth = allocateSceneTexture(context, rhi::Format::D32_FLOAT_S8X24_UINT, width, height, rhi::ImageLayout::DepthStencilAttachment, sceneDepthUsage);
 
 	rhi::Texture* sceneColor = allocateSceneTexture(context, rhi::Format::R8G8B8A8_UNORM, width, height, rhi::ImageLayout::ColorAttachment, rhi::ImageUsage::COLOR_ATTACHMENT | rhi::ImageUsage::SAMPLED);
 
+	// Rewritten every frame, the render graph may share their memory
+	if (!mergeDeferred)
 	{
-		render::GraphicsRenderpass* renderpass = reinterpret_cast<render::GraphicsRenderpass*>(renderGraph->allocateRenderpass("GBuffer", rhi::RenderTargetType::Graphics));
-		renderpass->addBeginTransition(gBufferA, rhi::MemoryAccess::Write);
-		renderpass->addBeginTransition(gBufferB, rhi::MemoryAccess::Write);
-		renderpass->addBeginTransition(gBufferC, rhi::MemoryAccess::Write);
-		renderpass->addBeginTransition(sceneDepth, rhi::MemoryAccess::Write);
+		setTransientSceneTexture(gBufferA, "GBufferA");
+		setTransientSceneTexture(gBufferB, "GBufferB");
+		setTransientSceneTexture(gBufferC, "GBufferC");
+		setTransientSceneTexture(sceneDepth, "SceneDepth");
+	}
+	setTransientSceneTexture(sceneColor, "SceneColor");
+
+	{
+		render::GraphicsRenderpass* renderpass = reinterpret_cast<render::GraphicsRenderpass*>(renderGraph->allocateRenderpass(mergeDeferred ? "GBuffer + Deferred" : "GBuffer", rhi::RenderTargetType::Graphics));
+		renderpass->addUsage(gBufferA, rhi::ResourceUsage::ColorAttachment);
+		renderpass->addUsage(gBufferB, rhi::ResourceUsage::ColorAttachment);
+		renderpass->addUsage(gBufferC, rhi::ResourceUsage::ColorAttachment);
+		renderpass->addUsage(sceneDepth, rhi::ResourceUsage::DepthStencilAttachment);
+		if (mergeDeferred)
+		{
+			renderpass->addUsage(sceneColor, rhi::ResourceUsage::ColorAttachment);
+			renderpass->addUsage(shadowMapTexture, rhi::ResourceUsage::Sampled);
+		}
 
 		auto renderTarget = renderpass->initRenderTarget(context, width, height);
 
-		rhi::Attachment* attachmentA = new rhi::Attachment(gBufferA, rhi::AttachmentOp::Clear, rhi::AttachmentOp::Store, { 0.f, 0.f, 0.f, 1.f });
-		rhi::Attachment* attachmentB = new rhi::Attachment(gBufferB, rhi::AttachmentOp::Clear, rhi::AttachmentOp::Store, { 0.f, 0.f, 0.f, 1.f });
-		rhi::Attachment* attachmentC = new rhi::Attachment(gBufferC, rhi::AttachmentOp::Clear, rhi::AttachmentOp::Store, { 0.f, 0.f, 0.f, 1.f });
-		rhi::Attachment* attachmentDS = new rhi::Attachment(sceneDepth, rhi::AttachmentOp::Clear, rhi::AttachmentOp::Store, rhi::AttachmentOp::Clear, rhi::AttachmentOp::Store, { 1.f, 0.f, 0.f, 0.f });
+		rhi::Attachment* attachmentA = new rhi::Attachment(gBufferA, { 0.f, 0.f, 0.f, 1.f });
+		rhi::Attachment* attachmentB = new rhi::Attachment(gBufferB, { 0.f, 0.f, 0.f, 1.f });
+		rhi::Attachment* attachmentC = new rhi::Attachment(gBufferC, { 0.f, 0.f, 0.f, 1.f });
+		rhi::Attachment* attachmentDS = new rhi::Attachment(sceneDepth, { 1.f, 0.f, 0.f, 0.f });
 
 		uint32_t indexGBufferA = renderTarget->addColorAttachment(attachmentA);
 		uint32_t indexGBufferB = renderTarget->addColorAttachment(attachmentB);
 		uint32_t indexGBufferC = renderTarget->addColorAttachment(attachmentC);
+		// Color attachments have to come before the depth attachment
+		uint32_t indexSceneColor = rhi::INVALID_ATTACHMENT_INDEX;
+		if (mergeDeferred)
+		{
+			indexSceneColor = renderTarget->addColorAttachment(new rhi::Attachment(sceneColor, { 0.f, 0.f, 0.f, 1.f }));
+		}
 		uint32_t indexDepthStencil = renderTarget->addDepthAttachment(attachmentDS);
 
 		rhi::Subpass* subpass = new rhi::Subpass();
@@ -132,11 +188,23 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 
 		renderTarget->addSubpass(subpass);
 
+		if (mergeDeferred)
+		{
+			rhi::Subpass* deferredSubpass = new rhi::Subpass();
+			deferredSubpass->addColorAttachment(indexSceneColor);
+			deferredSubpass->addInputAttachment(indexGBufferA);
+			deferredSubpass->addInputAttachment(indexGBufferB);
+			deferredSubpass->addInputAttachment(indexGBufferC);
+			deferredSubpass->addInputAttachment(indexDepthStencil);
+
+			renderTarget->addSubpass(deferredSubpass);
+		}
+
 		{
 			model::Object* object = renderpass->generateObject(context);
 			object->loadGltfModel(context, assetManager, "models/sponza/", "sponza.gltf"
 				//, model::GltfLoadingFlag::FlipY | model::GltfLoadingFlag::PreTransformVertices
-				, model::GltfLoadingFlag::PreTransformVertices
+				, model::GltfLoadingFlag::PreTransformVertices | model::GltfLoadingFlag::BindlessMaterials
 				, rhi::VertexChannel::Position | rhi::VertexChannel::Uv | rhi::VertexChannel::Normal
 				| rhi::VertexChannel::Tangent | rhi::VertexChannel::Bitangent, rhi::MaterialFlag::BaseColorTexture);
 
@@ -147,14 +215,40 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 			pipelineState->colorBlendMasks.push_back(rhi::ColorBlendMask::COLOR_COMPONENT_ALL_BIT);
 			pipelineState->depthStencilState = rhi::PipelineState::DepthStencilState(true, true, rhi::CompareOp::LESS_OR_EQUAL);
 
-			object->updateShaderCode(assetManager, rhi::ShaderStage::Vertex, "shaders/gbuffer.vert.spv");
-			object->updateShaderCode(assetManager, rhi::ShaderStage::Fragment, "shaders/gbuffer.frag.spv");
-			object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer, rhi::ShaderStage::Vertex | rhi::ShaderStage::Fragment, sceneUniformBuffer);
+			if (object->hasBindlessMaterials())
+			{
+				object->updateShaderCode(assetManager, rhi::ShaderStage::Vertex, "shaders/gbuffer_bindless.vert.spv");
+				object->updateShaderCode(assetManager, rhi::ShaderStage::Fragment, "shaders/gbuffer_bindless.frag.spv");
+			}
+			else
+			{
+				object->updateShaderCode(assetManager, rhi::ShaderStage::Vertex, "shaders/gbuffer.vert.spv");
+				object->updateShaderCode(assetManager, rhi::ShaderStage::Fragment, "shaders/gbuffer.frag.spv");
+			}
+			object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer_Dynamic, rhi::ShaderStage::Vertex | rhi::ShaderStage::Fragment, sceneUniformBuffer);
 
 			object->instantiate(context, glm::mat4(1.f));
 
 			registerObject(context, object);
 		}
+
+		if (mergeDeferred)
+		{
+			model::Object* object = renderpass->generateObject(context);
+			object->loadPredefinedScreen(context);
+			object->getPipelineState()->subpass = 1;
+			object->updateShaderCode(assetManager, rhi::ShaderStage::Vertex, "shaders/screen.vert.spv");
+			object->updateShaderCode(assetManager, rhi::ShaderStage::Fragment, "shaders/deferred_subpass.frag.spv");
+
+			object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer_Dynamic, rhi::ShaderStage::Vertex | rhi::ShaderStage::Fragment, sceneUniformBuffer);
+			object->registerDescriptor(rhi::DescriptorType::Input_Attachment, rhi::ShaderStage::Fragment, gBufferA);
+			object->registerDescriptor(rhi::DescriptorType::Input_Attachment, rhi::ShaderStage::Fragment, gBufferB);
+			object->registerDescriptor(rhi::DescriptorType::Input_Attachment, rhi::ShaderStage::Fragment, gBufferC);
+			// Reads the depth only view, an input attachment can't have both aspects of D32_S8
+			object->registerDescriptor(rhi::DescriptorType::Input_Attachment, rhi::ShaderStage::Fragment, sceneDepth);
+			object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Fragment, shadowMapTexture);
+			object->instantiate(context, glm::mat4(1.f));
+		}
 	}
 
 	float scale = 0.5f;
@@ -168,6 +262,7 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 	uint32_t computeHeight = std::ceil(float(rayShadowHeight) / numTHreadY);
 
 	rhi::Texture* shadowRayqueryTarget = allocateSceneTexture(context, rhi::Format::R32_UINT, computeWidth, computeHeight, rhi::ImageLayout::ComputeShaderWrite, rhi::ImageUsage::STORAGE | rhi::ImageUsage::SAMPLED);
+	setTransientSceneTexture(shadowRayqueryTarget, "ShadowRayquery");
 	rhi::Texture* blueNoiseSobolTexture = allocateSceneTexture(context, rhi::Format::R8G8B8A8_UNORM, width, height, rhi::ImageLayout::ComputeShaderReadOnly, rhi::ImageUsage::SAMPLED | rhi::ImageUsage::TRANSFER_DST);
 	blueNoiseSobolTexture->loadTexture(assetManager, "textures/blue_noise/sobol_256_4d.png");
 	rhi::Texture* blueNoiseScrambleTexture = allocateSceneTexture(context, rhi::Format::R8G8B8A8_UNORM, width, height, rhi::ImageLayout::ComputeShaderReadOnly, rhi::ImageUsage::SAMPLED | rhi::ImageUsage::TRANSFER_DST);
@@ -176,19 +271,20 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 	if (enableRayTracing)
 	{
 		auto renderpass = renderGraph->allocateRenderpass("RayTracingShadow", rhi::RenderTargetType::Compute);
-		renderpass->addBeginTransition(shadowRayqueryTarget, rhi::MemoryAccess::General);
-		renderpass->addBeginTransition(gBufferA, rhi::MemoryAccess::Read);
-		renderpass->addBeginTransition(gBufferB, rhi::MemoryAccess::Read);
-		renderpass->addBeginTransition(gBufferC, rhi::MemoryAccess::Read);
-		renderpass->addBeginTransition(sceneDepth, rhi::MemoryAccess::Read);
-		renderpass->addBeginTransition(blueNoiseSobolTexture, rhi::MemoryAccess::Read);
-		renderpass->addBeginTransition(blueNoiseScrambleTexture, rhi::MemoryAccess::Read);
+		renderpass->setAsyncCompute(true);
+		renderpass->addUsage(shadowRayqueryTarget, rhi::ResourceUsage::StorageWrite);
+		renderpass->addUsage(gBufferA, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(gBufferB, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(gBufferC, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(sceneDepth, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(blueNoiseSobolTexture, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(blueNoiseScrambleTexture, rhi::ResourceUsage::Sampled);
 
 		renderpass->initRenderTarget(context, computeWidth, computeHeight);
 
 		model::ComputeObject* object = reinterpret_cast<model::ComputeObject*>(renderpass->generateObject(context));
 		object->updateShaderCode(assetManager, rhi::ShaderStage::Compute, "shaders/shadows/shadowsRayQuery.comp.spv");
-		object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer, rhi::ShaderStage::Compute, sceneUniformBuffer);
+		object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer_Dynamic, rhi::ShaderStage::Compute, sceneUniformBuffer);
 		object->registerDescriptor(rhi::DescriptorType::Acceleration_structure, rhi::ShaderStage::Compute, accStructureManager);
 		object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Compute, gBufferA);
 		object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Compute, gBufferB);
@@ -211,6 +307,10 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 		rayShadowWidth, rayShadowHeight, rhi::ImageLayout::ComputeShaderWrite,
 		rhi::ImageUsage::STORAGE | rhi::ImageUsage::SAMPLED | rhi::ImageUsage::TRANSFER_DST | rhi::ImageUsage::TRANSFER_SRC);
 
+	// The unpack pass writes both without reading the previous frame
+	setTransientSceneTexture(temporalAccumulationTarget, "TemporalAccumulation");
+	setTransientSceneTexture(temporalMomentsTarget, "TemporalMoments");
+
 	rhi::StorageBuffer* denoiseTileCoordsBuffer = allocateSceneStorageBuffer(context, 
 		sizeof(glm::ivec2) * computeWidth * computeHeight, rhi::BufferUsage::BUFFER_STORAGE_BUFFER);
 	rhi::StorageBuffer* denoiseDispatchArgsBuffer = allocateSceneStorageBuffer(context,
@@ -225,10 +325,11 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 		// reset args
 		{
 			auto renderpass = renderGraph->allocateRenderpass("Reset args", rhi::RenderTargetType::Compute);
-			renderpass->addBeginTransition(denoiseTileCoordsBuffer, rhi::MemoryAccess::Write);
-			renderpass->addBeginTransition(denoiseDispatchArgsBuffer, rhi::MemoryAccess::Write);
-			renderpass->addBeginTransition(shadowTileCoordsBuffer, rhi::MemoryAccess::Write);
-			renderpass->addBeginTransition(shadowDispatchArgsBuffer, rhi::MemoryAccess::Write);
+			renderpass->setAsyncCompute(true);
+			renderpass->addUsage(denoiseTileCoordsBuffer, rhi::ResourceUsage::StorageWrite);
+			renderpass->addUsage(denoiseDispatchArgsBuffer, rhi::ResourceUsage::StorageWrite);
+			renderpass->addUsage(shadowTileCoordsBuffer, rhi::ResourceUsage::StorageWrite);
+			renderpass->addUsage(shadowDispatchArgsBuffer, rhi::ResourceUsage::StorageWrite);
 
 			renderpass->initRenderTarget(context, computeWidth, computeHeight);
 
@@ -248,21 +349,22 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 			const int NUM_THREADS_Y = 8;
 
 			auto renderpass = renderGraph->allocateRenderpass("Shadow unpack", rhi::RenderTargetType::Compute);
-			renderpass->addBeginTransition(shadowRayqueryTarget, rhi::MemoryAccess::Read);
-			renderpass->addBeginTransition(sceneDepth, rhi::MemoryAccess::Read);
-			renderpass->addBeginTransition(temporalAccumulationTarget, rhi::MemoryAccess::General);
-			renderpass->addBeginTransition(temporalMomentsTarget, rhi::MemoryAccess::General);
+			renderpass->setAsyncCompute(true);
+			renderpass->addUsage(shadowRayqueryTarget, rhi::ResourceUsage::Sampled);
+			renderpass->addUsage(sceneDepth, rhi::ResourceUsage::Sampled);
+			renderpass->addUsage(temporalAccumulationTarget, rhi::ResourceUsage::StorageWrite);
+			renderpass->addUsage(temporalMomentsTarget, rhi::ResourceUsage::StorageWrite);
 
-			renderpass->addBeginTransition(denoiseTileCoordsBuffer, rhi::MemoryAccess::Write);
-			renderpass->addBeginTransition(denoiseDispatchArgsBuffer, rhi::MemoryAccess::Write);
-			renderpass->addBeginTransition(shadowTileCoordsBuffer, rhi::MemoryAccess::Write);
-			renderpass->addBeginTransition(shadowDispatchArgsBuffer, rhi::MemoryAccess::Write);
+			renderpass->addUsage(denoiseTileCoordsBuffer, rhi::ResourceUsage::StorageWrite);
+			renderpass->addUsage(denoiseDispatchArgsBuffer, rhi::ResourceUsage::StorageWrite);
+			renderpass->addUsage(shadowTileCoordsBuffer, rhi::ResourceUsage::StorageWrite);
+			renderpass->addUsage(shadowDispatchArgsBuffer, rhi::ResourceUsage::StorageWrite);
 
 			renderpass->initRenderTarget(context, computeWidth, computeHeight);
 
 			model::ComputeObject* object = reinterpret_cast<model::ComputeObject*>(renderpass->generateObject(context));
 			object->updateShaderCode(assetManager, rhi::ShaderStage::Compute, "shaders/shadows/shadows_unpack.comp.spv");
-            object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer, rhi::ShaderStage::Compute, sceneUniformBuffer);
+            object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer_Dynamic, rhi::ShaderStage::Compute, sceneUniformBuffer);
 			object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Compute, shadowRayqueryTarget);
 			object->registerDescriptor(rhi::DescriptorType::Storage_Image, rhi::ShaderStage::Compute, temporalAccumulationTarget);
 			object->registerDescriptor(rhi::DescriptorType::Storage_Image, rhi::ShaderStage::Compute, temporalMomentsTarget);
@@ -275,11 +377,12 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 
 			object->setGroupCount(std::ceil((float)rayShadowWidth / NUM_THREADS_X), std::ceil((float)rayShadowHeight / NUM_THREADS_Y), 1);
 
-			renderpass->addEndTransition(temporalAccumulationTarget, rhi::MemoryAccess::Read);
-			renderpass->addEndTransition(denoiseTileCoordsBuffer, rhi::MemoryAccess::Read);
-			renderpass->addEndTransition(denoiseDispatchArgsBuffer, rhi::MemoryAccess::Read | rhi::MemoryAccess::Indirect);
-			renderpass->addEndTransition(shadowTileCoordsBuffer, rhi::MemoryAccess::Read);
-			renderpass->addEndTransition(shadowDispatchArgsBuffer, rhi::MemoryAccess::Read | rhi::MemoryAccess::Indirect);
+			// The depth is read at full resolution, the shader scales the coordinates itself
+			ShadowUnpackPushConstants pushConstants = {};
+			pushConstants.alpha = 0.01f;
+			pushConstants.momentsAlpha = 0.2f;
+			pushConstants.gBufferMip = 0;
+			object->setPushConstants(pushConstants);
 		}
 
 		shadowMapTexture = temporalAccumulationTarget;
@@ -297,6 +400,9 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 			rayShadowWidth, rayShadowHeight, rhi::ImageLayout::ComputeShaderWrite,
 			rhi::ImageUsage::STORAGE | rhi::ImageUsage::SAMPLED | rhi::ImageUsage::TRANSFER_DST | rhi::ImageUsage::TRANSFER_SRC);
 
+		setTransientSceneTexture(aTrousFilterTarget1, "ATrousFilter1");
+		setTransientSceneTexture(aTrousFilterTarget2, "ATrousFilter2");
+
 		bool ping_pong = false;
 		std::vector<rhi::Texture*> aTrousFilterTarget =
 		{
@@ -310,13 +416,27 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 		for (int i = 0; i < filter_iterations; i++)
 		{
 			auto renderpass = renderGraph->allocateRenderpass("A trous filter iterations " + ('0' + (char)i), rhi::RenderTargetType::Compute);
+			renderpass->setAsyncCompute(true);
 			renderpass->initRenderTarget(context, rayShadowWidth, rayShadowHeight);
 
 			if (i != 0)
 			{
-				renderpass->addBeginTransition(aTrousFilterTarget[read_idx], rhi::MemoryAccess::Read);
+				renderpass->addUsage(aTrousFilterTarget[read_idx], rhi::ResourceUsage::Sampled);
 			}
-			renderpass->addBeginTransition(aTrousFilterTarget[write_idx], rhi::MemoryAccess::General);
+			else
+			{
+				// Keeps the unpack output alive up to here, the render graph only sees declared usages
+				renderpass->addUsage(temporalAccumulationTarget, rhi::ResourceUsage::Sampled);
+			}
+			renderpass->addUsage(aTrousFilterTarget[write_idx], rhi::ResourceUsage::StorageWrite);
+			renderpass->addUsage(gBufferA, rhi::ResourceUsage::Sampled);
+			renderpass->addUsage(gBufferB, rhi::ResourceUsage::Sampled);
+			renderpass->addUsage(gBufferC, rhi::ResourceUsage::Sampled);
+			renderpass->addUsage(sceneDepth, rhi::ResourceUsage::Sampled);
+			renderpass->addUsage(shadowTileCoordsBuffer, rhi::ResourceUsage::StorageRead);
+			renderpass->addUsage(denoiseTileCoordsBuffer, rhi::ResourceUsage::StorageRead);
+			renderpass->addUsage(shadowDispatchArgsBuffer, rhi::ResourceUsage::IndirectArgument);
+			renderpass->addUsage(denoiseDispatchArgsBuffer, rhi::ResourceUsage::IndirectArgument);
 
 			renderpass->addClearColorTexture(aTrousFilterTarget[write_idx], { 1.f, 1.f, 1.f, 1.f });
 
@@ -353,6 +473,17 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 				object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Compute, sceneDepth);
 				object->registerDescriptor(rhi::DescriptorType::Storage_Buffer, rhi::ShaderStage::Compute, denoiseTileCoordsBuffer);
 				object->setIndirect(denoiseDispatchArgsBuffer);
+
+				// The taps spread out with every iteration, the shader is the same for all of them
+				ATrousPushConstants pushConstants = {};
+				pushConstants.radius = 1;
+				pushConstants.stepSize = 1 << i;
+				pushConstants.phiVisibility = 10.0f;
+				pushConstants.phiNormal = 32.0f;
+				pushConstants.sigmaDepth = 1.0f;
+				pushConstants.gBufferMip = 0;
+				pushConstants.power = 1.2f;
+				object->setPushConstants(pushConstants);
 			}
 			shadowMapTexture = aTrousFilterTarget[write_idx];
 			std::swap(read_idx, write_idx);
@@ -362,6 +493,7 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 	rhi::Texture* upSampleTarget = allocateSceneTexture(context, rhi::Format::R16_FLOAT,
 		width, height, rhi::ImageLayout::ComputeShaderWrite,
 		rhi::ImageUsage::STORAGE | rhi::ImageUsage::SAMPLED | rhi::ImageUsage::TRANSFER_DST);
+	setTransientSceneTexture(upSampleTarget, "Upsample");
 
 	if (enableRayTracing && scale < 1.0f)
 	{
@@ -370,14 +502,19 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 		rhi::Texture* upSampleInput = shadowMapTexture;
 
 		auto renderpass = renderGraph->allocateRenderpass("Upsample", rhi::RenderTargetType::Compute);
-		renderpass->addBeginTransition(upSampleTarget, rhi::MemoryAccess::General);
-		renderpass->addBeginTransition(upSampleInput, rhi::MemoryAccess::Read);
+		renderpass->setAsyncCompute(true);
+		renderpass->addUsage(upSampleTarget, rhi::ResourceUsage::StorageWrite);
+		renderpass->addUsage(upSampleInput, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(gBufferA, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(gBufferB, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(gBufferC, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(sceneDepth, rhi::ResourceUsage::Sampled);
 
 		renderpass->initRenderTarget(context, width, height);
 
 		model::ComputeObject* object = reinterpret_cast<model::ComputeObject*>(renderpass->generateObject(context));
 		object->updateShaderCode(assetManager, rhi::ShaderStage::Compute, "shaders/shadows/shadows_upsample.comp.spv");
-        object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer, rhi::ShaderStage::Compute, sceneUniformBuffer);
+        object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer_Dynamic, rhi::ShaderStage::Compute, sceneUniformBuffer);
 		object->registerDescriptor(rhi::DescriptorType::Storage_Image, rhi::ShaderStage::Compute, upSampleTarget);
 		object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Compute, upSampleInput);
 		object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Compute, gBufferA);
@@ -391,18 +528,19 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 	}
 
 	// deferred pass
+	if (!mergeDeferred)
 	{
 		auto renderpass = renderGraph->allocateRenderpass("Deferred", rhi::RenderTargetType::Graphics);
-		renderpass->addBeginTransition(gBufferA, rhi::MemoryAccess::Read);
-		renderpass->addBeginTransition(gBufferB, rhi::MemoryAccess::Read);
-		renderpass->addBeginTransition(gBufferC, rhi::MemoryAccess::Read);
-		renderpass->addBeginTransition(sceneDepth, rhi::MemoryAccess::Read);
-		renderpass->addBeginTransition(sceneColor, rhi::MemoryAccess::Write);
-		renderpass->addBeginTransition(shadowMapTexture, rhi::MemoryAccess::Read);
+		renderpass->addUsage(gBufferA, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(gBufferB, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(gBufferC, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(sceneDepth, rhi::ResourceUsage::Sampled);
+		renderpass->addUsage(sceneColor, rhi::ResourceUsage::ColorAttachment);
+		renderpass->addUsage(shadowMapTexture, rhi::ResourceUsage::Sampled);
 
 		auto renderTarget = renderpass->initRenderTarget(context, width, height);
 
-		rhi::Attachment* attachment = new rhi::Attachment(sceneColor, rhi::AttachmentOp::Clear, rhi::AttachmentOp::Store, { 0.f, 0.f, 0.f, 1.f });
+		rhi::Attachment* attachment = new rhi::Attachment(sceneColor, { 0.f, 0.f, 0.f, 1.f });
 		uint32_t indexSceneColorAttachment = renderTarget->addColorAttachment(attachment);
 
 		rhi::Subpass* subpass = new rhi::Subpass();
@@ -422,7 +560,7 @@ void BasicScene::initSceneRenderGraph(rhi::Context* context, platform::AssetMana
 				object->updateShaderCode(assetManager, rhi::ShaderStage::Fragment, "shaders/deferred.frag.spv");
 			}
 			
-			object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer, rhi::ShaderStage::Vertex | rhi::ShaderStage::Fragment, sceneUniformBuffer);
+			object->registerDescriptor(rhi::DescriptorType::Uniform_Buffer_Dynamic, rhi::ShaderStage::Vertex | rhi::ShaderStage::Fragment, sceneUniformBuffer);
 			object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Fragment, gBufferA);
 			object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Fragment, gBufferB);
 			object->registerDescriptor(rhi::DescriptorType::Combined_Image_Sampler, rhi::ShaderStage::Fragment, gBufferC);
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <fstream>
+#include "scene/cameraPath.h"
+
+namespace scene
+{
+void CameraPath::addKeyframe(uint32_t frame, const glm::vec3& position, const glm::vec3& rotation)
+{
+	auto next = std::upper_bound(keyframes.begin(), keyframes.end(), frame,
+		[](uint32_t frame, const Keyframe& keyframe) { return frame < keyframe.frame; });
+	keyframes.insert(next, { frame, position, rotation });
+}
+
+void CameraPath::record(uint32_t frame, const SceneView& sceneView)
+{
+	addKeyframe(frame, sceneView.position, sceneView.rotation);
+}
+
+void CameraPath::apply(uint32_t frame, SceneView* sceneView) const
+{
+	if (keyframes.empty())
+	{
+		return;
+	}
+
+	auto next = std::upper_bound(keyframes.begin(), keyframes.end(), frame,
+		[](uint32_t frame, const Keyframe& keyframe) { return frame < keyframe.frame; });
+
+	if (next == keyframes.begin() || next == keyframes.end())
+	{
+		const Keyframe& keyframe = next == keyframes.begin() ? keyframes.front() : keyframes.back();
+		sceneView->setTranslation(keyframe.position);
+		sceneView->setRotation(keyframe.rotation);
+		return;
+	}
+
+	const Keyframe& begin = *(next - 1);
+	const Keyframe& end = *next;
+	const float t = static_cast<float>(frame - begin.frame) / static_cast<float>(end.frame - begin.frame);
+
+	sceneView->setTranslation(glm::mix(begin.position, end.position, t));
+	sceneView->setRotation(glm::mix(begin.rotation, end.rotation, t));
+}
+
+bool CameraPath::load(const std::string& path)
+{
+	std::ifstream file(path);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	keyframes.clear();
+
+	Keyframe keyframe;
+	while (file >> keyframe.frame
+		>> keyframe.position.x >> keyframe.position.y >> keyframe.position.z
+		>> keyframe.rotation.x >> keyframe.rotation.y >> keyframe.rotation.z)
+	{
+		addKeyframe(keyframe.frame, keyframe.position, keyframe.rotation);
+	}
+
+	LOGD("Loaded %zu camera keyframes from %s", keyframes.size(), path.c_str());
+	return !keyframes.empty();
+}
+
+bool CameraPath::save(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		LOGE("Failed to open %s for the camera path", path.c_str());
+		return false;
+	}
+
+	for (auto& keyframe : keyframes)
+	{
+		file << keyframe.frame << " "
+			<< keyframe.position.x << " " << keyframe.position.y << " " << keyframe.position.z << " "
+			<< keyframe.rotation.x << " " << keyframe.rotation.y << " " << keyframe.rotation.z << "\n";
+	}
+
+	return true;
+}
+}
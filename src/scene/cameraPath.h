@@ -0,0 +1,41 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "platform/utils.h"
+#include "scene/sceneView.h"
+
+namespace scene
+{
+// Camera positions and rotations keyed by frame, linearly interpolated in between. A path is
+// either scripted with addKeyframe, loaded from a file, or recorded from a SceneView driven by
+// input and saved, so a benchmark sees the same views on every run.
+class CameraPath
+{
+public:
+	void addKeyframe(uint32_t frame, const glm::vec3& position, const glm::vec3& rotation);
+
+	// Appends the current camera as the keyframe of the frame
+	void record(uint32_t frame, const SceneView& sceneView);
+
+	// Holds the first and last keyframes outside of the path
+	void apply(uint32_t frame, SceneView* sceneView) const;
+
+	bool empty() const { return keyframes.empty(); }
+
+	// One keyframe per line: frame, position xyz, rotation xyz
+	bool load(const std::string& path);
+
+	bool save(const std::string& path) const;
+private:
+	struct Keyframe
+	{
+		uint32_t frame;
+		glm::vec3 position;
+		glm::vec3 rotation;
+	};
+
+	// Sorted by frame
+	std::vector<Keyframe> keyframes;
+};
+}
@@ -1,4 +1,5 @@
 #include "platform/assetManager.h"
+#include "platform/profiler.h"
 #include "scene/scene.h"
 #include "render/rendergraph.h"
 #include "rhi/context.h"
@@ -19,6 +20,7 @@ Scene::Scene()
     , scratchBufferUsage()
     , accStructureManager(nullptr)
     , enableRayTracing(false)
+    , enableMergedDeferred(true)
     , enableScratchBuffer(false)
 {
 }
@@ -72,6 +74,9 @@ void Scene::preBuild(rhi::Context* context, platform::AssetManager* assetManager
 {
     sceneUniformBuffer->build(context);
 
+    // Transient textures get their memory placed by the render graph before they are built
+    renderGraph->aliasTransientTextures(context);
+
     for (auto& texture : sceneTextures)
     {
         texture->build(context);
@@ -88,6 +93,9 @@ void Scene::preBuild(rhi::Context* context, platform::AssetManager* assetManager
         indexScratchBuffer->build(context);
     }
     renderGraph->preBuild(context);
+
+    // Everything uploaded while building goes out in one submit
+    context->flushUploads();
 }
 
 void Scene::postBuild(rhi::Context* context, platform::AssetManager* assetManager)
@@ -105,6 +113,8 @@ void Scene::postBuild(rhi::Context* context, platform::AssetManager* assetManage
 
 void Scene::update(rhi::Context* context, platform::AssetManager* assetManager, Tick tick)
 {
+    PROFILE_ZONE("Scene::update");
+
     sceneView.update(tick);
 
     updateSceneObjects(context, tick);
@@ -191,6 +201,12 @@ rhi::Texture* Scene::allocateSceneTexture(rhi::Context* context, rhi::Format for
     return texture;
 }
 
+void Scene::setTransientSceneTexture(rhi::Texture* texture, const std::string& name)
+{
+    texture->setName(name);
+    texture->setTransient(true);
+}
+
 rhi::StorageBuffer* Scene::allocateSceneStorageBuffer(rhi::Context* context, uint32_t size, rhi::BufferUsageFlags usage)
 {
     rhi::StorageBuffer* storageBuffer = context->createStorageBuffer(rhi::BufferType::DeviceLocal, usage);
@@ -228,7 +244,7 @@ void Scene::initSceneUniformBuffers(rhi::Context* context)
     sceneUniformBufferObject.num_frames = 0;
     sceneUniformBufferObject.inverse_scale = 1;
 
-    sceneUniformBuffer = context->createUniformBuffer(rhi::BufferType::HostCoherent);
+    sceneUniformBuffer = context->createUniformBuffer(rhi::BufferType::Dynamic);
     sceneUniformBuffer->set<SceneUniformBufferObject>(1, &sceneUniformBufferObject);
 }
 
@@ -70,6 +70,11 @@ public:
     {
         return sceneView.getSceneViewInputAdapter();
     }
+
+    SceneView* getSceneView()
+    {
+        return &sceneView;
+    }
 public:
     virtual void updateSceneUniformBuffers(rhi::Context* context, Tick tick);
 
@@ -78,6 +83,9 @@ public:
     rhi::Texture* allocateSceneTexture(rhi::Context* context, rhi::Format format, uint32_t width, uint32_t height, uint32_t depth, uint32_t samples, uint32_t mipLevels, uint32_t layers,
                                        rhi::ImageLayout initialLayout, uint32_t usage);
 
+    // Only for textures every frame writes before reading them, see render::RenderGraph
+    void setTransientSceneTexture(rhi::Texture* texture, const std::string& name);
+
     rhi::StorageBuffer* allocateSceneStorageBuffer(rhi::Context* context, uint32_t size, rhi::BufferUsageFlags usage);
 
     void registerObject(rhi::Context* context, model::Object* object);
@@ -120,6 +128,9 @@ protected:
     rhi::UniformBuffer* sceneUniformBuffer;
 
     bool enableRayTracing;
+    // Lights the G-buffer in a second subpass of its render pass instead of a pass of its own.
+    // Has no effect with ray tracing, its shadows sample the G-buffer before the lighting
+    bool enableMergedDeferred;
     bool enableScratchBuffer;
     rhi::AccStructureManager* accStructureManager;
 };
@@ -1,4 +1,10 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
 #include "scene/transition.h"
+#include "platform/profiler.h"
+#include "scene/cameraPath.h"
 #include "scene/scene.h"
 #include "vulkan/context.h"
 #include "platform/assetManager.h"
@@ -14,8 +20,41 @@ namespace scene
 const uint64_t period = 30;
 //const uint64_t period = 600;
 
+namespace
+{
+double getElapsedMs(std::chrono::steady_clock::time_point begin)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// Nearest rank on sorted samples, like the GPU pass statistics
+double getPercentile(const std::vector<double>& sorted, double percentile)
+{
+	const size_t index = static_cast<size_t>(std::ceil(sorted.size() * percentile));
+	return sorted[std::max<size_t>(index, 1) - 1];
+}
+
+std::string escape(const std::string& name)
+{
+	std::string escaped;
+	for (char c : name)
+	{
+		if (c == '"' || c == '\\')
+		{
+			escaped.push_back('\\');
+		}
+		escaped.push_back(c);
+	}
+	return escaped;
+}
+}
+
 Transition::Transition()
 	: status(Status::Idle)
+	, sceneFrame(0)
+	, benchmark(false)
+	, warmupFrames(0)
+	, reportWritten(false)
 {
 }
 
@@ -32,12 +71,23 @@ void Transition::destroy(rhi::Context* context)
 {
 	if (status == Status::Running)
 	{
+		// Stopped by the platform, the scene still counts with the frames it ran
+		if (benchmark)
+		{
+			finishBenchmarkScene(context);
+		}
 		destroyScene(context);
 	}
 
-	for (auto scene : scenes)
+	if (benchmark && !reportWritten)
+	{
+		writeBenchmarkReport(context);
+	}
+
+	for (auto& entry : scenes)
 	{
-		delete scene;
+		delete entry.scene;
+		delete entry.cameraPath;
 	}
 	scenes.clear();
 }
@@ -52,55 +102,266 @@ bool Transition::update(rhi::Context* context, platform::AssetManager* assetMana
 
 	// just update
 	updateScene(context, assetManager, tick);
-	
+
+	if (sceneIterator->submitCount != 0 && sceneFrame >= sceneIterator->submitCount)
+	{
+		nextScene(context, assetManager);
+	}
+
 	return true;
 }
 
-void Transition::registerScene(Scene* scene, const size_t submitCount)
+void Transition::registerScene(Scene* scene, const size_t submitCount, CameraPath* cameraPath)
+{
+	scenes.push_back({ scene, submitCount, cameraPath, cameraPath != nullptr && cameraPath->empty() });
+}
+
+void Transition::enableBenchmark(uint32_t warmupFrames, const std::string& reportPath)
 {
-	scenes.push_back(scene);
+	benchmark = true;
+	this->warmupFrames = warmupFrames;
+	this->reportPath = reportPath;
 }
 
 void Transition::nextScene(rhi::Context* context, platform::AssetManager* assetManager)
 {
+	if (benchmark)
+	{
+		finishBenchmarkScene(context);
+	}
+
 	destroyScene(context);
-	
+
 	sceneIterator++;
 
 	if (sceneIterator != scenes.end())
 	{
+		PROFILE_BEGIN_PHASE("Scene load");
 		initScene(context, assetManager);
+		PROFILE_END_PHASE();
 	}
 	else
 	{
 		status = Status::Idle;
+
+		if (benchmark)
+		{
+			writeBenchmarkReport(context);
+		}
 	}
 }
 
 void Transition::initScene(rhi::Context* context, platform::AssetManager* assetManager)
 {
-	Scene* scene = *sceneIterator;
+	const auto begin = std::chrono::steady_clock::now();
+
+	Scene* scene = sceneIterator->scene;
 	scene->init(context, assetManager);
 
+	if (benchmark)
+	{
+		// The uploads of the load are part of it
+		context->flushUploads();
+
+		BenchmarkResult& result = results.emplace_back();
+		result.sceneIndex = static_cast<size_t>(sceneIterator - scenes.begin());
+		result.loadTimeMs = getElapsedMs(begin);
+		result.frameTimes.reserve(sceneIterator->submitCount);
+		sampleMemory(context, &result);
+
+		LOGD("Benchmark scene %zu loaded in %.3f ms", result.sceneIndex, result.loadTimeMs);
+	}
+
+	sceneFrame = 0;
 	status = Status::Begin;
 }
 
 void Transition::updateScene(rhi::Context* context, platform::AssetManager* assetManager, Tick tick)
 {
-	Scene* scene = *sceneIterator;
+	Scene* scene = sceneIterator->scene;
+	CameraPath* cameraPath = sceneIterator->cameraPath;
+
+	if (benchmark)
+	{
+		// Animations depend on the frame of the scene only, not on how long loading took
+		tick = sceneFrame;
+
+		if (cameraPath != nullptr && !sceneIterator->recordCamera)
+		{
+			cameraPath->apply(sceneFrame, scene->getSceneView());
+		}
+	}
+
+	const auto begin = std::chrono::steady_clock::now();
+
 	scene->update(context, assetManager, tick);
 
 	scene->flush(context, assetManager, tick);
 
+	const double frameTimeMs = getElapsedMs(begin);
+
+	if (benchmark && cameraPath != nullptr && sceneIterator->recordCamera)
+	{
+		cameraPath->record(sceneFrame, *scene->getSceneView());
+	}
+
+	if (benchmark && sceneFrame >= warmupFrames)
+	{
+		BenchmarkResult& result = results.back();
+		result.frameTimes.push_back(frameTimeMs);
+		result.commands.add(context->getCommandStats());
+		sampleMemory(context, &result);
+	}
+
+	sceneFrame++;
 	status = Status::Running;
 }
 
 void Transition::destroyScene(rhi::Context* context)
-{	
-	Scene* scene = *sceneIterator;
+{
+	Scene* scene = sceneIterator->scene;
 	scene->idle(context);
 	scene->destroy(context);
 
 	status = Status::End;
 }
-}
\ No newline at end of file
+
+void Transition::sampleMemory(rhi::Context* context, BenchmarkResult* result)
+{
+	// The tracker's peak covers every scene so far, the current size is sampled per scene instead
+	rhi::MemoryBudgetStats stats = context->getMemoryBudgetStats();
+	result->peakMemoryBytes = std::max(result->peakMemoryBytes, stats.currentBytes);
+	if (stats.budgetAvailable)
+	{
+		result->peakHeapUsageBytes = std::max(result->peakHeapUsageBytes, stats.heapUsageBytes);
+	}
+}
+
+void Transition::finishBenchmarkScene(rhi::Context* context)
+{
+	BenchmarkResult& result = results.back();
+
+	// Over the last frames each pass ran in, which are all in this scene when it ran long enough
+	for (auto& passStats : context->getPassTimingStats())
+	{
+		result.passNames.push_back(passStats.name);
+		result.passAvgMs.push_back(passStats.avgMs);
+		result.passP95Ms.push_back(passStats.p95Ms);
+	}
+
+	if (sceneIterator->recordCamera)
+	{
+		sceneIterator->cameraPath->save(getCameraPathFile(result.sceneIndex));
+	}
+
+	if (result.frameTimes.empty())
+	{
+		LOGE("Benchmark scene %zu ended within its %u warm-up frames", result.sceneIndex, warmupFrames);
+		return;
+	}
+
+	std::vector<double> sorted = result.frameTimes;
+	std::sort(sorted.begin(), sorted.end());
+	LOGD("Benchmark scene %zu: %zu frames, p50 %.3f ms, p95 %.3f ms, p99 %.3f ms", result.sceneIndex, sorted.size(),
+		getPercentile(sorted, 0.5), getPercentile(sorted, 0.95), getPercentile(sorted, 0.99));
+}
+
+bool Transition::writeBenchmarkReport(rhi::Context* context)
+{
+	reportWritten = true;
+
+	std::ofstream file(reportPath);
+	if (!file.is_open())
+	{
+		LOGE("Failed to open %s for the benchmark report", reportPath.c_str());
+		return false;
+	}
+
+	file << "{\n";
+	file << "  \"gpu\": \"" << escape(context->getGpuName()) << "\",\n";
+	file << "  \"width\": " << context->getWidth() << ",\n";
+	file << "  \"height\": " << context->getHeight() << ",\n";
+	file << "  \"warmupFrames\": " << warmupFrames << ",\n";
+	file << "  \"scenes\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+
+		std::vector<double> sorted = result.frameTimes;
+		std::sort(sorted.begin(), sorted.end());
+
+		double total = 0.0;
+		for (double frameTime : sorted)
+		{
+			total += frameTime;
+		}
+
+		file << "    {\n";
+		file << "      \"scene\": " << result.sceneIndex << ",\n";
+		file << "      \"loadTimeMs\": " << result.loadTimeMs << ",\n";
+		file << "      \"frames\": " << sorted.size() << ",\n";
+		if (!sorted.empty())
+		{
+			file << "      \"frameTimeMs\": { "
+				<< "\"min\": " << sorted.front() << ", "
+				<< "\"avg\": " << total / sorted.size() << ", "
+				<< "\"p50\": " << getPercentile(sorted, 0.5) << ", "
+				<< "\"p95\": " << getPercentile(sorted, 0.95) << ", "
+				<< "\"p99\": " << getPercentile(sorted, 0.99) << ", "
+				<< "\"max\": " << sorted.back() << " },\n";
+		}
+		if (!sorted.empty())
+		{
+			const rhi::CommandStats& commands = result.commands;
+			const double frames = static_cast<double>(sorted.size());
+			file << "      \"commandsPerFrame\": { "
+				<< "\"draws\": " << commands.draws / frames << ", "
+				<< "\"dispatches\": " << commands.dispatches / frames << ", "
+				<< "\"traceRays\": " << commands.traceRays / frames << ", "
+				<< "\"pipelineBinds\": " << commands.pipelineBinds / frames << ", "
+				<< "\"descriptorSetBinds\": " << commands.descriptorSetBinds / frames << ", "
+				<< "\"vertexBufferBinds\": " << commands.vertexBufferBinds / frames << ", "
+				<< "\"indexBufferBinds\": " << commands.indexBufferBinds / frames << ", "
+				<< "\"pushConstants\": " << commands.pushConstants / frames << ", "
+				<< "\"barriers\": " << commands.barriers / frames << ", "
+				<< "\"imageBarriers\": " << commands.imageBarriers / frames << ", "
+				<< "\"bufferBarriers\": " << commands.bufferBarriers / frames << ", "
+				<< "\"renderPasses\": " << commands.renderPasses / frames << ", "
+				<< "\"submits\": " << commands.submits / frames << ", "
+				<< "\"filteredPipelineBinds\": " << commands.filteredPipelineBinds / frames << ", "
+				<< "\"filteredDescriptorSetBinds\": " << commands.filteredDescriptorSetBinds / frames << ", "
+				<< "\"filteredVertexBufferBinds\": " << commands.filteredVertexBufferBinds / frames << ", "
+				<< "\"filteredIndexBufferBinds\": " << commands.filteredIndexBufferBinds / frames << ", "
+				<< "\"filteredDynamicStates\": " << commands.filteredDynamicStates / frames << " },\n";
+		}
+		file << "      \"peakMemoryBytes\": " << result.peakMemoryBytes << ",\n";
+		file << "      \"peakHeapUsageBytes\": " << result.peakHeapUsageBytes << ",\n";
+		file << "      \"passes\": [\n";
+		for (size_t pass = 0; pass < result.passNames.size(); pass++)
+		{
+			file << "        { \"name\": \"" << escape(result.passNames[pass]) << "\", "
+				<< "\"avgMs\": " << result.passAvgMs[pass] << ", "
+				<< "\"p95Ms\": " << result.passP95Ms[pass] << " }"
+				<< (pass + 1 < result.passNames.size() ? ",\n" : "\n");
+		}
+		file << "      ]\n";
+		file << "    }" << (i + 1 < results.size() ? ",\n" : "\n");
+	}
+	file << "  ]\n";
+	file << "}\n";
+
+	LOGD("Benchmark report of %zu scenes written to %s", results.size(), reportPath.c_str());
+	return true;
+}
+
+std::string Transition::getCameraPathFile(size_t sceneIndex) const
+{
+	std::string base = reportPath;
+	const size_t extension = base.rfind(".json");
+	if (extension != std::string::npos)
+	{
+		base.erase(extension);
+	}
+	return base + "_camera" + std::to_string(sceneIndex) + ".txt";
+}
+}
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <string>
 #include <vector>
 #include "platform/utils.h"
+#include "rhi/context.h"
 
 namespace platform
 {
@@ -17,6 +19,7 @@ namespace scene
 {
 class Scene;
 class Metric;
+class CameraPath;
 
 enum class Status
 {
@@ -26,6 +29,9 @@ enum class Status
 	End
 };
 
+// Runs the registered scenes one after another. With a benchmark enabled every scene is fed the
+// frame index as its tick and the camera of its path, the frames after the warm-up are timed and
+// a JSON report with the results of all scenes is written once the last one is done.
 class Transition
 {
 public:
@@ -37,7 +43,11 @@ public:
 
 	bool update(rhi::Context* context, platform::AssetManager* assetManager, Tick tick);
 
-	void registerScene(Scene* scene, const size_t submitCount);
+	// A submit count of 0 runs the scene until the platform stops. The transition owns the camera
+	// path, an empty one records the camera of the scene and is saved next to the report.
+	void registerScene(Scene* scene, const size_t submitCount, CameraPath* cameraPath = nullptr);
+
+	void enableBenchmark(uint32_t warmupFrames, const std::string& reportPath);
 
 	void nextScene(rhi::Context* context, platform::AssetManager* assetManager);
 
@@ -47,8 +57,46 @@ public:
 
 	void destroyScene(rhi::Context* context);
 private:
-	std::vector<Scene*> scenes;
-	std::vector<Scene*>::iterator sceneIterator;
+	struct SceneEntry
+	{
+		Scene* scene;
+		size_t submitCount;
+		CameraPath* cameraPath;
+		bool recordCamera;
+	};
+
+	struct BenchmarkResult
+	{
+		size_t sceneIndex = 0;
+		double loadTimeMs = 0.0;
+		// Frames after the warm-up, in milliseconds
+		std::vector<double> frameTimes;
+		uint64_t peakMemoryBytes = 0;
+		uint64_t peakHeapUsageBytes = 0;
+		// Summed over the timed frames
+		rhi::CommandStats commands;
+		std::vector<std::string> passNames;
+		std::vector<double> passAvgMs;
+		std::vector<double> passP95Ms;
+	};
+
+	void sampleMemory(rhi::Context* context, BenchmarkResult* result);
+
+	void finishBenchmarkScene(rhi::Context* context);
+
+	bool writeBenchmarkReport(rhi::Context* context);
+
+	std::string getCameraPathFile(size_t sceneIndex) const;
+
+	std::vector<SceneEntry> scenes;
+	std::vector<SceneEntry>::iterator sceneIterator;
 	Status status;
+	uint32_t sceneFrame;
+
+	bool benchmark;
+	uint32_t warmupFrames;
+	std::string reportPath;
+	std::vector<BenchmarkResult> results;
+	bool reportWritten;
 };
-}
\ No newline at end of file
+}
@@ -58,10 +58,12 @@ void AccStructureManager::buildBottomLevelAccStructure(rhi::Context* rhiContext)
 	VkBufferUsageFlags scratchBufferUsage = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR |
 		VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 	blasScratchBuffer = BufferFactory::createBuffer(rhi::BufferType::DeviceLocal, scratchBufferUsage, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, blasScratchBufferSize); // memprop
+	blasScratchBuffer->setMemoryOwner(rhi::MemoryCategory::Scratch, "BLAS scratch");
 	blasScratchBuffer->initBuffer(context, scratchBufferUsage);
 
 	VkBufferUsageFlags accBufferUsage = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR;
 	blasBuffer = BufferFactory::createBuffer(rhi::BufferType::DeviceLocal, accBufferUsage, 0, blasSize); // memprop
+	blasBuffer->setMemoryOwner(rhi::MemoryCategory::AccelerationStructure, "BLAS");
 	blasBuffer->initBuffer(context, accBufferUsage); // VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT
 
 	size_t blasScratchOffset = 0;
@@ -88,6 +90,7 @@ void AccStructureManager::buildTopLevelAccStructure(rhi::Context* rhiContext)
 
 	VkBufferUsageFlags instanceBufferUsage = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
 	instanceBuffer = BufferFactory::createBuffer(rhi::BufferType::DeviceLocal, instanceBufferUsage, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, sizeof(VkAccelerationStructureInstanceKHR) * accStructureInstances.size()); // memprop
+	instanceBuffer->setMemoryOwner(rhi::MemoryCategory::AccelerationStructure, "TLAS instances");
 	instanceBuffer->init(context, accStructureInstances.data());
 
 	topLevelAccStructure = new TopLevelAccStructure();
@@ -95,10 +98,12 @@ void AccStructureManager::buildTopLevelAccStructure(rhi::Context* rhiContext)
 
 	VkBufferUsageFlags scratchBufferUsage = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
 	tlasScratchBuffer = BufferFactory::createBuffer(rhi::BufferType::DeviceLocal, scratchBufferUsage, VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT, topLevelAccStructure->getScratchSize()); // memprop
+	tlasScratchBuffer->setMemoryOwner(rhi::MemoryCategory::Scratch, "TLAS scratch");
 	tlasScratchBuffer->initBuffer(context, scratchBufferUsage);
 
 	VkBufferUsageFlags accBufferUsage = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR;
 	tlasBuffer = BufferFactory::createBuffer(rhi::BufferType::DeviceLocal, accBufferUsage, 0, topLevelAccStructure->getAccStructureSize()); // memprop
+	tlasBuffer->setMemoryOwner(rhi::MemoryCategory::AccelerationStructure, "TLAS");
 	tlasBuffer->initBuffer(context, accBufferUsage);
 
 	topLevelAccStructure->build(context, tlasScratchBuffer, tlasBuffer);
@@ -108,13 +113,20 @@ void AccStructureManager::postBuild(rhi::Context* rhiContext)
 {
 	Context* context = reinterpret_cast<Context*>(rhiContext);
 
-	context->wait();
-	tlasScratchBuffer->destroy(context);
-	delete tlasScratchBuffer;
-	tlasScratchBuffer = nullptr;
+	// The builds may still be running, the scratch buffers go once the frame has finished
+	Buffer* tlasScratch = tlasScratchBuffer;
+	Buffer* blasScratch = blasScratchBuffer;
+	context->deferDestruction([tlasScratch, blasScratch](rhi::Context* rhiContext)
+	{
+		Context* context = reinterpret_cast<Context*>(rhiContext);
 
-	blasScratchBuffer->destroy(context);
-	delete blasScratchBuffer;
+		tlasScratch->destroy(context);
+		delete tlasScratch;
+
+		blasScratch->destroy(context);
+		delete blasScratch;
+	});
+	tlasScratchBuffer = nullptr;
 	blasScratchBuffer = nullptr;
 }
 
@@ -1,44 +1,60 @@
 #include "vulkan//buffer.h"
 #include "vulkan/resources.h"
+#include "vulkan/uploadBatcher.h"
+#include "vulkan/memoryTracker.h"
 
 namespace vk
 {
-const VkFlags kStagingBufferUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
 const VkFlags kHostVisibleMemoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
-const VkFlags kHostCachedMemoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+// Cached memory is preferred by the readback usage, not every device exposes it
+const VkFlags kHostCachedMemoryProperty = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
 
 Buffer* BufferFactory::createBuffer(rhi::BufferType bufferType, const VkBufferUsageFlags usage, const VkMemoryAllocateFlags allocateFlags, const size_t size)
 {
+	Buffer* buffer = nullptr;
 	switch (bufferType)
 	{
 	case rhi::BufferType::DeviceLocal:
-		return new DeviceLocalBuffer(usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocateFlags, size);
+		buffer = new DeviceLocalBuffer(usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, allocateFlags, size);
+		break;
 	case rhi::BufferType::HostCached:
-		return new HostCachedBuffer(usage, kHostCachedMemoryProperty, allocateFlags, size);
+		buffer = new HostCachedBuffer(usage, kHostCachedMemoryProperty, allocateFlags, size);
+		break;
 	case rhi::BufferType::HostCoherent:
-		return new HostSharedBuffer(usage, kHostVisibleMemoryProperty, allocateFlags, size);
+		// Buffers only copied from stay out of device local memory, anything the GPU reads may go there
+		buffer = new HostSharedBuffer(usage, kHostVisibleMemoryProperty,
+			usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT ? MemoryUsage::Staging : MemoryUsage::Upload, allocateFlags, size);
+		break;
 	default:
 		UNREACHABLE();
 		return nullptr;
 	}
+
+	// Callers that know better, like the acceleration structures, override the category
+	buffer->setMemoryOwner(MemoryTracker::getBufferCategory(usage), "");
+	return buffer;
 }
 
-Buffer::Buffer(const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryProperty, const VkMemoryAllocateFlags allocateFlags, const size_t size)
+Buffer::Buffer(const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryProperty, const MemoryUsage memoryUsage, const VkMemoryAllocateFlags allocateFlags, const size_t size)
 	: usage(usage)
 	, memoryProperty(memoryProperty)
+	, memoryUsage(memoryUsage)
 	, allocateFlags(allocateFlags)
 	, size(size)	
+	, memoryCategory(rhi::MemoryCategory::Other)
+	, memoryTrackingId(0)
 {
 }
 
 void Buffer::destroy(Context* context)
 {
+	MemoryAllocator* memoryAllocator = context->getMemoryAllocator();
+
 	buffer.destroy(context->getDevice());
-	memory.destroy(context->getDevice());
+	memoryAllocator->free(context->getDevice(), allocation);
 
-	// TODO:
-	stagingBuffer.destroy(context->getDevice());
-	stagingMemory.destroy(context->getDevice());
+	context->getMemoryTracker()->untrack(memoryTrackingId);
+	memoryTrackingId = 0;
 }
 
 void Buffer::initBuffer(Context* context, const VkBufferUsageFlags usage)
@@ -59,83 +75,43 @@ void Buffer::initBuffer(Context* context, const VkBufferUsageFlags usage)
 	VkMemoryRequirements memRequirements;
 	buffer.getMemoryRequirements(context->getDevice(), &memRequirements);
 
-	VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo = {};
-	memoryAllocateFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
-	memoryAllocateFlagsInfo.flags = allocateFlags;
-
-	VkMemoryPropertyFlags allocatedMemoryProperty = memoryProperty;
-
-	VkMemoryAllocateInfo memoryAllocateInfo = {};
-	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memoryAllocateInfo.pNext = &memoryAllocateFlagsInfo;
-	memoryAllocateInfo.allocationSize = memRequirements.size;
-	memoryAllocateInfo.memoryTypeIndex = getMemoryTypeIndex(context->getPhysicalDevice(), memRequirements.memoryTypeBits, memoryProperty);
+	if (!context->getMemoryAllocator()->allocate(context->getDevice(), memRequirements, memoryProperty, memoryUsage, allocateFlags, ResourceType::Linear, &allocation))
+	{
+		LOGE("Failed to allocate buffer memory of %zu bytes", size);
+		return;
+	}
+	VKCALL(buffer.bindMemory(context->getDevice(), allocation.memory, allocation.offset));
 
-	VKCALL(memory.allocate(context->getDevice(), memoryAllocateInfo));
-	VKCALL(buffer.bindMemory(context->getDevice(), memory));
+	memoryTrackingId = context->getMemoryTracker()->track(memoryCategory, memoryOwner, allocation.size);
 }
 
-void Buffer::initStagingBuffer(Context* context)
+void Buffer::setMemoryOwner(rhi::MemoryCategory category, const std::string& owner)
 {
-	uint32_t queueFamilyIndices[] = { context->getQueueFamilyIndex() };
-
-	VkBufferCreateInfo bufferCreateInfo = {};
-	bufferCreateInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-	bufferCreateInfo.pNext = nullptr;
-	bufferCreateInfo.queueFamilyIndexCount = 1;
-	bufferCreateInfo.pQueueFamilyIndices = queueFamilyIndices;
-	bufferCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	bufferCreateInfo.size = static_cast<VkDeviceSize>(size);
-	bufferCreateInfo.usage = kStagingBufferUsage;
-
-	stagingBuffer.init(context->getDevice(), bufferCreateInfo);
-
-	VkMemoryRequirements memRequirements;
-	stagingBuffer.getMemoryRequirements(context->getDevice(), &memRequirements);
-
-	VkMemoryAllocateInfo memoryAllocateInfo = {};
-	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memoryAllocateInfo.pNext = nullptr;
-	memoryAllocateInfo.allocationSize = memRequirements.size;
-	memoryAllocateInfo.memoryTypeIndex = getMemoryTypeIndex(context->getPhysicalDevice(), memRequirements.memoryTypeBits, kHostVisibleMemoryProperty);
-
-	VKCALL(stagingMemory.allocate(context->getDevice(), memoryAllocateInfo));
-	VKCALL(stagingBuffer.bindMemory(context->getDevice(), stagingMemory));
+	ASSERT(!allocation.valid());
+	memoryCategory = category;
+	memoryOwner = owner;
 }
 
+// Host visible blocks are persistently mapped by the allocator
 void* Buffer::mapMemory(Context* context, size_t size)
 {
-	uint8_t* data = nullptr;
-	VKCALL(memory.map(context->getDevice(), 0, size, 0, &data));
-
-	return data;
+	ASSERT(allocation.mapped);
+	return allocation.mapped;
 }
 
 void Buffer::mapMemory(Context* context, size_t size, const void* mapData)
 {
 	invalidateMemory(context, size);
 
-	uint8_t* data = nullptr;
-	VKCALL(memory.map(context->getDevice(), 0, size, 0, &data));
-	memcpy(data, mapData, size);
-	memory.unmap(context->getDevice());	
+	ASSERT(allocation.mapped);
+	memcpy(allocation.mapped, mapData, size);
 
-	flushMemory(context);
+	flushMemory(context, size);
 }
 
 void Buffer::unmapMemory(Context* context, size_t size)
 {
-	memory.unmap(context->getDevice());
-
-	flushMemory(context);
-}
-
-void Buffer::mapStagingMemory(Context* context, size_t size, const void* mapData)
-{
-	uint8_t* data = nullptr;
-	VKCALL(stagingMemory.map(context->getDevice(), 0, size, 0, &data));
-	memcpy(data, mapData, size);
-	stagingMemory.unmap(context->getDevice());
+	flushMemory(context, size);
 }
 
 void Buffer::Copy(Context* context, VkBuffer srcBuffer, VkDeviceSize offset, VkDeviceSize size)
@@ -145,9 +121,9 @@ void Buffer::Copy(Context* context, VkBuffer srcBuffer, VkDeviceSize offset, VkD
 	copyRegion.dstOffset = offset;
 	copyRegion.size = size;
 
+	// Submitted with the rest of the upload batch
 	CommandBuffer* commandBuffer = context->getUploadCommandBuffer();
 	commandBuffer->copyBuffer(srcBuffer, buffer.getHandle(), copyRegion);
-	context->submitUploadCommandBuffer();
 }
 
 void Buffer::Copy(Context* context, VkBuffer srcBuffer, VkDeviceSize size)
@@ -155,23 +131,6 @@ void Buffer::Copy(Context* context, VkBuffer srcBuffer, VkDeviceSize size)
 	Copy(context, srcBuffer, 0, size);
 }
 
-uint32_t Buffer::getMemoryTypeIndex(VkPhysicalDevice physicalDevice, const uint32_t memoryTypeBits, const VkMemoryPropertyFlags memoryProperty)
-{
-	VkPhysicalDeviceMemoryProperties memProperties;
-	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-
-	for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-	{
-		if ((memoryTypeBits & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & memoryProperty) == memoryProperty)
-		{
-			return i;
-		}
-	}
-
-	UNREACHABLE();
-	return 0;
-}
-
 VkBuffer Buffer::getBuffer()
 {
 	return buffer.getHandle();
@@ -179,7 +138,12 @@ VkBuffer Buffer::getBuffer()
 
 VkDeviceMemory Buffer::getDeviceMemory()
 {
-	return memory.getHandle();
+	return allocation.memory;
+}
+
+VkDeviceSize Buffer::getMemoryOffset()
+{
+	return allocation.offset;
 }
 
 VkDeviceSize Buffer::getDeviceAddress(VkDevice device)
@@ -243,26 +207,44 @@ uint64_t ScratchBuffer::getDeviceAddress(rhi::Context* rhiContext)
 }
 
 DeviceLocalBuffer::DeviceLocalBuffer(const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryProperty, const VkMemoryAllocateFlags allocateFlags, const size_t size)
-	: Buffer(usage, memoryProperty, allocateFlags, size)
+	: Buffer(usage, memoryProperty, MemoryUsage::GpuOnly, allocateFlags, size)
 {
 
 }
 
 void DeviceLocalBuffer::init(Context* context, const void* data)
 {
-	uint32_t queueFamilyIndices[] = { context->getQueueFamilyIndex() };
+	MemoryAllocator* memoryAllocator = context->getMemoryAllocator();
 
-	VkDeviceSize bufferSize = static_cast<VkDeviceSize>(size);
+	// With resizable BAR or unified memory the initial data is written in place instead of staged and copied
+	if (data != nullptr && memoryAllocator->hasHostVisibleDeviceHeap())
+	{
+		memoryUsage = MemoryUsage::Upload;
+	}
 
 	initBuffer(context, usage | VK_BUFFER_USAGE_TRANSFER_DST_BIT);
-	initStagingBuffer(context);
-	mapStagingMemory(context, size, data);
 
-	Copy(context, stagingBuffer.getHandle(), bufferSize);
+	if (data == nullptr)
+	{
+		return;
+	}
+
+	if (allocation.mapped != nullptr)
+	{
+		memcpy(allocation.mapped, data, size);
+		if (!memoryAllocator->isHostCoherent(allocation))
+		{
+			memoryAllocator->flush(context->getDevice(), allocation, size);
+		}
+	}
+	else
+	{
+		context->getUploadBatcher()->copyBuffer(context, data, static_cast<VkDeviceSize>(size), buffer.getHandle(), 0);
+	}
 }
 
-HostSharedBuffer::HostSharedBuffer(const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryProperty, const VkMemoryAllocateFlags allocateFlags, const size_t size)
-	: Buffer(usage, memoryProperty, allocateFlags, size)
+HostSharedBuffer::HostSharedBuffer(const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryProperty, const MemoryUsage memoryUsage, const VkMemoryAllocateFlags allocateFlags, const size_t size)
+	: Buffer(usage, memoryProperty, memoryUsage, allocateFlags, size)
 {
 
 }
@@ -277,47 +259,27 @@ void HostSharedBuffer::init(Context* context, const void* data)
 }
 
 HostCachedBuffer::HostCachedBuffer(const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryProperty, const VkMemoryAllocateFlags allocateFlags, const size_t size)
-	: HostSharedBuffer(usage, memoryProperty, allocateFlags, size)
+	: HostSharedBuffer(usage, memoryProperty, MemoryUsage::Readback, allocateFlags, size)
 {
 
 }
 
 void* HostCachedBuffer::mapMemory(Context* context, size_t size)
 {
-	VkMappedMemoryRange range = {};
-	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-	range.pNext = nullptr;
-	range.offset = 0;
-	range.size = size;
-	range.memory = memory.getHandle();
-	memory.invalidate(context->getDevice(), range);
-
-	uint8_t* data = nullptr;
-	VKCALL(memory.map(context->getDevice(), 0, size, 0, &data));
-
-	return data;
+	context->getMemoryAllocator()->invalidate(context->getDevice(), allocation, size);
+
+	ASSERT(allocation.mapped);
+	return allocation.mapped;
 }
 
 void HostCachedBuffer::invalidateMemory(Context* context, size_t size)
 {
-	VkMappedMemoryRange range = {};
-	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-	range.pNext = nullptr;
-	range.offset = 0;
-	range.size = size;
-	range.memory = memory.getHandle();
-	memory.invalidate(context->getDevice(), range);
+	context->getMemoryAllocator()->invalidate(context->getDevice(), allocation, size);
 }
 
 void HostCachedBuffer::flushMemory(Context* context, VkDeviceSize size)
 {
-	VkMappedMemoryRange range = {};
-	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-	range.pNext = nullptr;
-	range.offset = 0;
-	range.size = size;
-	range.memory = memory.getHandle();
-	memory.flush(context->getDevice(), range);
+	context->getMemoryAllocator()->flush(context->getDevice(), allocation, size);
 }
 
 }
\ No newline at end of file
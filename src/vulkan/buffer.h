@@ -3,6 +3,7 @@
 #include "platform/memorybuffer.h"
 #include "vulkan/context.h"
 #include "vulkan/commandBuffer.h"
+#include "vulkan/memoryAllocator.h"
 #include "vulkan/vk_wrapper.h"
 #include "rhi/buffer.h"
 
@@ -12,7 +13,7 @@ class Context;
 class Buffer
 {
 public:
-	Buffer(const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryProperty, const VkMemoryAllocateFlags allocateFlags, const size_t size);
+	Buffer(const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryProperty, const MemoryUsage memoryUsage, const VkMemoryAllocateFlags allocateFlags, const size_t size);
 
 	virtual ~Buffer() = default;
 
@@ -22,8 +23,6 @@ public:
 
 	void initBuffer(Context* context, const VkBufferUsageFlags usage);
 
-	void initStagingBuffer(Context* context);
-
 	void mapMemory(Context* context, size_t size, const void* mapData);
 
 	virtual void* mapMemory(Context* context, size_t size);
@@ -34,29 +33,33 @@ public:
 
 	virtual void flushMemory(Context* context, size_t size = VK_WHOLE_SIZE) {}
 
-	void mapStagingMemory(Context* context, size_t size, const void* mapData);
-
 	void Copy(Context* context, VkBuffer srcBuffer, VkDeviceSize size);
 
 	void Copy(Context* context, VkBuffer srcBuffer, VkDeviceSize offset, VkDeviceSize size);
 
-	uint32_t getMemoryTypeIndex(VkPhysicalDevice physicalDevice, const uint32_t memoryTypeBits, const VkMemoryPropertyFlags memoryProperty);
+	// Must be set before the memory is allocated
+	void setMemoryOwner(rhi::MemoryCategory category, const std::string& owner);
 public:
 	VkBuffer getBuffer();
 
 	VkDeviceMemory getDeviceMemory();
 
+	VkDeviceSize getMemoryOffset();
+
 	VkDeviceSize getDeviceAddress(VkDevice device);
 protected:
 	VkBufferUsageFlags usage;
 	VkMemoryPropertyFlags memoryProperty;
+	MemoryUsage memoryUsage;
 	VkMemoryAllocateFlags allocateFlags;
 	size_t size;
 
 	handle::Buffer buffer;
-	handle::Buffer stagingBuffer;
-	handle::DeviceMemory memory;
-	handle::DeviceMemory stagingMemory;
+	Allocation allocation;
+
+	rhi::MemoryCategory memoryCategory;
+	std::string memoryOwner;
+	uint32_t memoryTrackingId;
 };
 
 class DeviceLocalBuffer : public Buffer
@@ -69,7 +72,7 @@ public:
 class HostSharedBuffer : public Buffer
 {
 public:
-	HostSharedBuffer(const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryProperty, const VkMemoryAllocateFlags allocateFlags, const size_t size);
+	HostSharedBuffer(const VkBufferUsageFlags usage, const VkMemoryPropertyFlags memoryProperty, const MemoryUsage memoryUsage, const VkMemoryAllocateFlags allocateFlags, const size_t size);
 	void init(Context* context, const void* data) override;
 };
 
@@ -137,7 +140,6 @@ private:
 	bool suballocated; // TODO
 	rhi::BufferType bufferType;
 	vk::Buffer* buffer;
-	vk::Buffer* stagingBuffer;
 	size_t offset;
 	VkVertexInputBindingDescription vertexInputBindingDescription;
 	std::vector<VkVertexInputAttributeDescription> vertexInputAttributeDescriptions;	
@@ -165,7 +167,6 @@ private:
 	bool built;
 	bool suballocated;
 	vk::Buffer* buffer;
-	vk::Buffer* stagingBuffer;
 	size_t offset;
 	VkIndexType indexType;	
 };
@@ -194,14 +195,27 @@ public:
 	void bind(rhi::Context* context) override final;
 
 	void* getDescriptorData(rhi::DescriptorType type) override final;
+
+	bool isPerFrame() override final;
+
+	void* getFrameDescriptorData(rhi::DescriptorType type, uint32_t frameIndex) override final;
+
+	uint32_t getDynamicOffset() override final;
 private:
 	virtual VkBuffer getHandle();
 
 	virtual size_t getSize();
 private:
 	rhi::BufferType bufferType;
-	vk::Buffer* buffer;
+	// Host visible uniform buffers keep one copy per frame in flight, update writes the current frame's copy
+	std::vector<vk::Buffer*> buffers;
 	VkDescriptorBufferInfo descriptorBufferInfo;
+
+	// Dynamic uniform buffers live in the uniform arena, update writes a new block unless it is
+	// already there for this frame
+	uint32_t dynamicOffset;
+	uint64_t writtenFrameSerial;
+	uint32_t writtenVersion;
 };
 
 class StorageBuffer : public rhi::StorageBuffer
@@ -219,7 +233,9 @@ public:
 
 	void* getDescriptorData(rhi::DescriptorType type) override final;
 
-	Transition* getTransition(rhi::MemoryAccessFlags accessFlags);
+	// Returns the barrier the access needs against the previous ones, or nullptr when there is no hazard.
+	// Reads after the same write share it, a write waits for the last write and every read since.
+	Transition* updateAccessAndBarrier(VkPipelineStageFlags stageFlags, VkAccessFlags accessFlags);
 
 	VkBuffer getHandle();
 
@@ -228,8 +244,10 @@ private:
 	rhi::BufferType bufferType;
 	vk::Buffer* buffer;
 	VkDescriptorBufferInfo descriptorBufferInfo;
-	VkAccessFlags currentAccessFlags;
-	VkPipelineStageFlags currentPipelineFlags;
+	VkPipelineStageFlags writeStageFlags;
+	VkAccessFlags writeAccessFlags;
+	VkPipelineStageFlags readStageFlags;
+	VkAccessFlags readAccessFlags;
 	VkBufferUsageFlags usageFlags;
 };
 }
\ No newline at end of file
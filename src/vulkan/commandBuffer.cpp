@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "vulkan/commandBuffer.h"
 #include "vulkan/transition.h"
 
@@ -5,6 +6,7 @@ namespace vk
 {
 CommandBuffer::CommandBuffer()
     : transition(nullptr)
+    , supportedStages(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)
 {
 
 }
@@ -35,20 +37,22 @@ void CommandBuffer::destroy(VkDevice device, VkCommandPool commandPool)
 
 bool CommandBuffer::reset(VkDevice device, const bool bWait)
 {
-    if (fence.getStatus(device) == VK_SUCCESS)
-    {
-        commandBuffer.reset();
-        fence.reset(device);
-        delete transition;
-        transition = nullptr;
-        return true;
-    }
-    else if (bWait)
+    if (fence.getStatus(device) != VK_SUCCESS)
     {
+        if (!bWait)
+        {
+            return false;
+        }
         LOGD("Wait fence");
         VKCALL(fence.wait(device, UINT64_MAX));
     }
-    return false;
+
+    commandBuffer.reset();
+    fence.reset(device);
+    resetBoundState();
+    delete transition;
+    transition = nullptr;
+    return true;
 }
 
 VkCommandBuffer CommandBuffer::getHandle() { return commandBuffer.getHandle(); }
@@ -78,6 +82,11 @@ void CommandBuffer::flushTransitions()
         return;
     }
 
+    if (supportedStages != VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)
+    {
+        transition->restrictToStages(supportedStages);
+    }
+
     if (transition->build())
     {
         auto memoryBarriers = transition->getMemoryBarriers();
@@ -106,6 +115,7 @@ VkResult CommandBuffer::begin()
     commandBufferBeginInfo.flags = 0;
     commandBufferBeginInfo.pInheritanceInfo = nullptr;
 
+    resetBoundState();
     return commandBuffer.begin(commandBufferBeginInfo);
 }
 VkResult CommandBuffer::end()
@@ -113,4 +123,51 @@ VkResult CommandBuffer::end()
     flushTransitions();
     return commandBuffer.end();
 }
+
+void CommandBuffer::resetBoundState()
+{
+    boundState = BoundState();
+}
+
+bool CommandBuffer::trackDescriptorSets(VkPipelineBindPoint pipelineBindPoint,
+                                        VkPipelineLayout pipelineLayout,
+                                        uint32_t firstSet,
+                                        uint32_t descriptorSetCount,
+                                        const VkDescriptorSet* pDescriptorSets,
+                                        uint32_t dynamicOffsetCount,
+                                        const uint32_t* pDynamicOffsets)
+{
+    BoundDescriptorSet* boundSets = boundState.descriptorSets[getBindPointIndex(pipelineBindPoint)];
+
+    // The dynamic offsets of several sets can't be told apart without their layouts, only single sets are filtered
+    if (descriptorSetCount == 1 && firstSet < kMaxTrackedDescriptorSets)
+    {
+        const BoundDescriptorSet& boundSet = boundSets[firstSet];
+        if (boundSet.descriptorSet == pDescriptorSets[0] && boundSet.pipelineLayout == pipelineLayout &&
+            boundSet.dynamicOffsets.size() == dynamicOffsetCount &&
+            std::equal(boundSet.dynamicOffsets.begin(), boundSet.dynamicOffsets.end(), pDynamicOffsets))
+        {
+            return false;
+        }
+    }
+
+    // A bind may disturb the sets bound with another layout, whichever set numbers they are at.
+    // Layouts come from the layout cache, so compatible layouts are mostly the same handle.
+    for (uint32_t set = 0; set < kMaxTrackedDescriptorSets; set++)
+    {
+        BoundDescriptorSet& boundSet = boundSets[set];
+        const bool bound = set >= firstSet && set - firstSet < descriptorSetCount;
+        if (bound && descriptorSetCount == 1)
+        {
+            boundSet.descriptorSet = pDescriptorSets[0];
+            boundSet.pipelineLayout = pipelineLayout;
+            boundSet.dynamicOffsets.assign(pDynamicOffsets, pDynamicOffsets + dynamicOffsetCount);
+        }
+        else if (bound || boundSet.pipelineLayout != pipelineLayout)
+        {
+            boundSet = BoundDescriptorSet();
+        }
+    }
+    return true;
+}
 }
\ No newline at end of file
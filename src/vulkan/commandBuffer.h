@@ -1,10 +1,15 @@
 #pragma once
 
+#include <vector>
 #include "vulkan/vk_wrapper.h"
 #include "vulkan/extension.h"
+#include "vulkan/commandCounters.h"
 
 namespace vk
 {
+// Descriptor set slots tracked per bind point, binds past it are always recorded
+const uint32_t kMaxTrackedDescriptorSets = 8;
+
 class Transition;
 class CommandBuffer
 {
@@ -23,6 +28,10 @@ public:
     void addTransition(Transition* newTransition);
     
     void flushTransitions();
+
+    // Barriers recorded into command buffers of a compute only queue drop the stages it can't execute
+    void setSupportedStages(VkPipelineStageFlags stages) { supportedStages = stages; }
+
     VkResult begin();
     VkResult end();
 public:
@@ -31,6 +40,13 @@ public:
         ASSERT(commandBuffer.valid());
         flushTransitions();
         vkCmdBeginRenderPass(commandBuffer.getHandle(), &beginInfo, subpassContents);
+        COUNT_COMMAND(renderPasses, 1);
+    }
+
+    inline void nextSubpass(VkSubpassContents subpassContents)
+    {
+        ASSERT(commandBuffer.valid());
+        vkCmdNextSubpass(commandBuffer.getHandle(), subpassContents);
     }
 
     inline void endRenderPass()
@@ -39,36 +55,83 @@ public:
         vkCmdEndRenderPass(commandBuffer.getHandle());
     }
 
+    // Binds that leave the state of the command buffer as it is are dropped, see BoundState
     inline void bindPipeline(VkPipelineBindPoint pipelineBindPoint, VkPipeline pipeline)
     {
         ASSERT(commandBuffer.valid());
+        VkPipeline& boundPipeline = boundState.pipelines[getBindPointIndex(pipelineBindPoint)];
+        if (boundPipeline == pipeline)
+        {
+            COUNT_COMMAND(filteredPipelineBinds, 1);
+            return;
+        }
+        boundPipeline = pipeline;
         vkCmdBindPipeline(commandBuffer.getHandle(), pipelineBindPoint, pipeline);
+        COUNT_COMMAND(pipelineBinds, 1);
     }
 
     inline void setViewport(const VkViewport& viewport)
     {
         ASSERT(commandBuffer.valid());
+        const VkViewport& boundViewport = boundState.viewport;
+        if (boundState.viewportValid &&
+            boundViewport.x == viewport.x && boundViewport.y == viewport.y &&
+            boundViewport.width == viewport.width && boundViewport.height == viewport.height &&
+            boundViewport.minDepth == viewport.minDepth && boundViewport.maxDepth == viewport.maxDepth)
+        {
+            COUNT_COMMAND(filteredDynamicStates, 1);
+            return;
+        }
+        boundState.viewport = viewport;
+        boundState.viewportValid = true;
         vkCmdSetViewport(commandBuffer.getHandle(), 0, 1, &viewport);
     }
 
     inline void setScissor(const VkRect2D& scissor)
     {
         ASSERT(commandBuffer.valid());
+        const VkRect2D& boundScissor = boundState.scissor;
+        if (boundState.scissorValid &&
+            boundScissor.offset.x == scissor.offset.x && boundScissor.offset.y == scissor.offset.y &&
+            boundScissor.extent.width == scissor.extent.width && boundScissor.extent.height == scissor.extent.height)
+        {
+            COUNT_COMMAND(filteredDynamicStates, 1);
+            return;
+        }
+        boundState.scissor = scissor;
+        boundState.scissorValid = true;
         vkCmdSetScissor(commandBuffer.getHandle(), 0, 1, &scissor);
     }
 
     inline void bindVertexBuffers(VkBuffer buffer, VkDeviceSize offset)
     {
         ASSERT(commandBuffer.valid());
+        if (boundState.vertexBuffer == buffer && boundState.vertexBufferOffset == offset)
+        {
+            COUNT_COMMAND(filteredVertexBufferBinds, 1);
+            return;
+        }
+        boundState.vertexBuffer = buffer;
+        boundState.vertexBufferOffset = offset;
         VkBuffer buffers[] = { buffer };
         VkDeviceSize offsets[] = { offset };
         vkCmdBindVertexBuffers(commandBuffer.getHandle(), 0, 1, buffers, offsets);
+        COUNT_COMMAND(vertexBufferBinds, 1);
     }
 
     inline void bindIndexBuffers(VkBuffer buffer, VkDeviceSize offset, VkIndexType indexType)
     {
         ASSERT(commandBuffer.valid());
+        if (boundState.indexBuffer == buffer && boundState.indexBufferOffset == offset && boundState.indexType == indexType)
+        {
+            COUNT_COMMAND(filteredIndexBufferBinds, 1);
+            return;
+        }
+        boundState.indexBuffer = buffer;
+        boundState.indexBufferOffset = offset;
+        boundState.indexType = indexType;
         vkCmdBindIndexBuffer(commandBuffer.getHandle(), buffer, offset, indexType);
+        COUNT_COMMAND(indexBufferBinds, 1);
     }
 
     inline void bindDescriptorSets(VkPipelineBindPoint pipelineBindPoint,
@@ -80,31 +143,48 @@ public:
                                    const uint32_t* pDynamicOffsets)
     {
         ASSERT(commandBuffer.valid());
+        if (!trackDescriptorSets(pipelineBindPoint, pipelineLayout, firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets))
+        {
+            COUNT_COMMAND(filteredDescriptorSetBinds, descriptorSetCount);
+            return;
+        }
         vkCmdBindDescriptorSets(commandBuffer.getHandle(), pipelineBindPoint, pipelineLayout, firstSet, descriptorSetCount, pDescriptorSets, dynamicOffsetCount, pDynamicOffsets);
+        COUNT_COMMAND(descriptorSetBinds, descriptorSetCount);
+    }
+
+    inline void pushConstants(VkPipelineLayout pipelineLayout, VkShaderStageFlags stageFlags, uint32_t offset, uint32_t size, const void* values)
+    {
+        ASSERT(commandBuffer.valid());
+        vkCmdPushConstants(commandBuffer.getHandle(), pipelineLayout, stageFlags, offset, size, values);
+        COUNT_COMMAND(pushConstants, 1);
     }
 
     inline void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
     {
         ASSERT(commandBuffer.valid());
         vkCmdDraw(commandBuffer.getHandle(), vertexCount, instanceCount, firstVertex, firstInstance);
+        COUNT_COMMAND(draws, 1);
     }
 
     inline void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t vertexOffset, uint32_t firstInstance)
     {
         ASSERT(commandBuffer.valid());
         vkCmdDrawIndexed(commandBuffer.getHandle(), indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+        COUNT_COMMAND(draws, 1);
     }
 
     inline void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
     {
         ASSERT(commandBuffer.valid());
         vkCmdDispatch(commandBuffer.getHandle(), groupCountX, groupCountY, groupCountZ);
+        COUNT_COMMAND(dispatches, 1);
     }
 
     inline void dispatchIndirect(VkBuffer buffer, size_t offset)
     {
         ASSERT(commandBuffer.valid());
         vkCmdDispatchIndirect(commandBuffer.getHandle(), buffer, offset);
+        COUNT_COMMAND(dispatches, 1);
     }
 
     inline void setShadingRate(uint32_t width, uint32_t height)
@@ -134,6 +214,21 @@ public:
         vkCmdPipelineBarrier(commandBuffer.getHandle(), srcStageMask, dstStageMask, dependencyFlags, memoryBarrierCount,
             memoryBarriers, bufferMemoryBarrierCount, bufferMemoryBarriers,
             imageMemoryBarrierCount, imageMemoryBarriers);
+        COUNT_COMMAND(barriers, 1);
+        COUNT_COMMAND(imageBarriers, imageMemoryBarrierCount);
+        COUNT_COMMAND(bufferBarriers, bufferMemoryBarrierCount);
+    }
+
+    inline void resetQueryPool(VkQueryPool queryPool, uint32_t firstQuery, uint32_t queryCount)
+    {
+        ASSERT(commandBuffer.valid());
+        vkCmdResetQueryPool(commandBuffer.getHandle(), queryPool, firstQuery, queryCount);
+    }
+
+    inline void writeTimestamp(VkPipelineStageFlagBits pipelineStage, VkQueryPool queryPool, uint32_t query)
+    {
+        ASSERT(commandBuffer.valid());
+        vkCmdWriteTimestamp(commandBuffer.getHandle(), pipelineStage, queryPool, query);
     }
 
     inline void clearColorImage(VkImage image, VkImageLayout imageLayout, const VkClearColorValue& color, const VkImageSubresourceRange& ranges)
@@ -160,6 +255,12 @@ public:
         vkCmdCopyBufferToImage(commandBuffer.getHandle(), srcBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copyRegion);
     }
 
+    inline void copyImageToBuffer(VkImage srcImage, VkBuffer dstBuffer, const VkBufferImageCopy& copyRegion)
+    {
+        ASSERT(commandBuffer.valid());
+        vkCmdCopyImageToBuffer(commandBuffer.getHandle(), srcImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, dstBuffer, 1, &copyRegion);
+    }
+
     inline void buildAccelerationStructures(uint32_t count,
         const VkAccelerationStructureBuildGeometryInfoKHR* accelerationStructureBuildGeometryInfo,
         const VkAccelerationStructureBuildRangeInfoKHR* const* buildRangeInfos)
@@ -185,11 +286,58 @@ public:
             width,
             height,
             depth);
+        COUNT_COMMAND(traceRays, 1);
     }
 
 private:
+    // Graphics, compute and ray tracing
+    static const uint32_t kBindPointCount = 3;
+
+    static inline uint32_t getBindPointIndex(VkPipelineBindPoint pipelineBindPoint)
+    {
+        return pipelineBindPoint == VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR ? 2 : static_cast<uint32_t>(pipelineBindPoint);
+    }
+
+    // Returns false when the sets are already bound with the same layout and dynamic offsets
+    bool trackDescriptorSets(VkPipelineBindPoint pipelineBindPoint,
+                             VkPipelineLayout pipelineLayout,
+                             uint32_t firstSet,
+                             uint32_t descriptorSetCount,
+                             const VkDescriptorSet* pDescriptorSets,
+                             uint32_t dynamicOffsetCount,
+                             const uint32_t* pDynamicOffsets);
+
+    void resetBoundState();
+
+    struct BoundDescriptorSet
+    {
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        std::vector<uint32_t> dynamicOffsets;
+    };
+
+    // What the recorded commands left bound, undefined again when the command buffer begins.
+    // Render passes don't reset it, and every graphics pipeline has a dynamic viewport and scissor,
+    // so binding another pipeline keeps them as well.
+    struct BoundState
+    {
+        VkPipeline pipelines[kBindPointCount] = {};
+        BoundDescriptorSet descriptorSets[kBindPointCount][kMaxTrackedDescriptorSets];
+        VkBuffer vertexBuffer = VK_NULL_HANDLE;
+        VkDeviceSize vertexBufferOffset = 0;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        VkDeviceSize indexBufferOffset = 0;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT16;
+        VkViewport viewport = {};
+        bool viewportValid = false;
+        VkRect2D scissor = {};
+        bool scissorValid = false;
+    };
+
 	handle::CommandBuffer commandBuffer;
     handle::Fence fence;
     Transition* transition;
+    VkPipelineStageFlags supportedStages;
+    BoundState boundState;
 };
 }
\ No newline at end of file
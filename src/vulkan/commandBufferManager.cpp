@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "vulkan/commandBufferManager.h"
 
 namespace vk
@@ -5,10 +6,15 @@ namespace vk
 CommandBufferManager::CommandBufferManager()
     : uploadCommandBuffer(nullptr)
     , activeCommandBuffer(nullptr)
+    , uploadWaitSemaphore(VK_NULL_HANDLE)
+    , uploadWaitValue(0)
+    , activeWait()
+    , activeSignal()
+    , supportedStages(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT)
 {
 }
 
-bool CommandBufferManager::init(VkDevice device, uint32_t queueFamilyIndex)
+bool CommandBufferManager::init(VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight)
 {
     VkCommandPoolCreateInfo commandPoolCreateInfo = {};
     commandPoolCreateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
@@ -17,6 +23,17 @@ bool CommandBufferManager::init(VkDevice device, uint32_t queueFamilyIndex)
     VKCALL(commandPool.init(device, commandPoolCreateInfo));
 
     allocateCommandBuffers(device);
+
+    // Frame fences start signaled so the first frames do not wait
+    VkFenceCreateInfo fenceCreateInfo = {};
+    fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    frameFences.resize(framesInFlight);
+    for (auto& frameFence : frameFences)
+    {
+        VKCALL(frameFence.init(device, fenceCreateInfo));
+    }
     return true;
 }
 
@@ -41,6 +58,12 @@ void CommandBufferManager::destory(VkDevice device)
         delete commandBuffer;
     }
 
+    for (auto& frameFence : frameFences)
+    {
+        frameFence.destroy(device);
+    }
+    frameFences.clear();
+
     commandPool.destroy(device);
 }
 
@@ -50,6 +73,7 @@ void CommandBufferManager::allocateCommandBuffers(VkDevice device)
     {
         CommandBuffer* commandBuffer = new CommandBuffer();
         commandBuffer->init(device, commandPool.getHandle());
+        commandBuffer->setSupportedStages(supportedStages);
         readyCommandBuffers.push(commandBuffer);
     }
 }
@@ -112,7 +136,9 @@ void CommandBufferManager::submitActiveCommandBuffer(VkDevice device, Queue* que
         submitUploadCommandBuffer(device, queue);
     }
     activeCommandBuffer->end();
-    queue->submit(activeCommandBuffer, waitSemaphores, signalSemaphores);
+    queue->submit(activeCommandBuffer, waitSemaphores, signalSemaphores, activeWait, activeSignal);
+    activeWait = TimelinePoint();
+    activeSignal = TimelinePoint();
     resetCommandBuffers(device);
     submitCommandBuffers.push(activeCommandBuffer);
     activeCommandBuffer = nullptr;
@@ -122,12 +148,50 @@ void CommandBufferManager::submitUploadCommandBuffer(VkDevice device, Queue* que
 {
     ASSERT(uploadCommandBuffer);
     uploadCommandBuffer->end();
-    queue->submit(uploadCommandBuffer);
+    if (uploadWaitSemaphore != VK_NULL_HANDLE)
+    {
+        queue->submit(uploadCommandBuffer, uploadWaitSemaphore, uploadWaitValue, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_NULL_HANDLE, 0);
+        uploadWaitSemaphore = VK_NULL_HANDLE;
+    }
+    else
+    {
+        queue->submit(uploadCommandBuffer);
+    }
+    recycleUploadCommandBuffer(device);
+}
+
+void CommandBufferManager::recycleUploadCommandBuffer(VkDevice device)
+{
+    ASSERT(uploadCommandBuffer);
     resetCommandBuffers(device);
     submitCommandBuffers.push(uploadCommandBuffer);
     uploadCommandBuffer = nullptr;
 }
 
+void CommandBufferManager::setUploadWait(VkSemaphore semaphore, uint64_t value)
+{
+    uploadWaitSemaphore = semaphore;
+    uploadWaitValue = std::max(uploadWaitValue, value);
+}
+
+void CommandBufferManager::setActiveWait(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags stage)
+{
+    activeWait.semaphore = semaphore;
+    activeWait.value = std::max(activeWait.value, value);
+    activeWait.stage |= stage;
+}
+
+void CommandBufferManager::setActiveSignal(VkSemaphore semaphore, uint64_t value)
+{
+    activeSignal.semaphore = semaphore;
+    activeSignal.value = value;
+}
+
+void CommandBufferManager::setSupportedStages(VkPipelineStageFlags stages)
+{
+    supportedStages = stages;
+}
+
 void CommandBufferManager::resetCommandBuffers(VkDevice device, bool bIdle)
 {
     while (!submitCommandBuffers.empty())
@@ -147,4 +211,22 @@ void CommandBufferManager::resetCommandBuffers(VkDevice device, bool bIdle)
         }
     }
 }
+
+void CommandBufferManager::beginFrame(VkDevice device, uint32_t frameIndex)
+{
+    ASSERT(frameIndex < frameFences.size());
+    auto& frameFence = frameFences[frameIndex];
+
+    VKCALL(frameFence.wait(device, UINT64_MAX));
+    VKCALL(frameFence.reset(device));
+
+    // Everything submitted before this frame's fence is finished, recycle it
+    resetCommandBuffers(device);
+}
+
+void CommandBufferManager::endFrame(VkDevice device, Queue* queue, uint32_t frameIndex)
+{
+    ASSERT(frameIndex < frameFences.size());
+    queue->signal(frameFences[frameIndex].getHandle());
+}
 }
\ No newline at end of file
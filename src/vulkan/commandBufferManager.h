@@ -1,20 +1,21 @@
 #pragma once
 
 #include <queue>
+#include <vector>
 #include "vulkan/commandBuffer.h"
 #include "vulkan/queue.h"
 #include "vulkan/vk_wrapper.h"
 
 namespace vk
 {
-const uint32_t kMaxInFlightCommandBuffers = 5;
+const uint32_t kMaxInFlightCommandBuffers = 16;
 
 class CommandBufferManager
 {
 public:
     CommandBufferManager();
 
-    bool init(VkDevice device, uint32_t queueFamilyIndex);
+    bool init(VkDevice device, uint32_t queueFamilyIndex, uint32_t framesInFlight);
 
     void destory(VkDevice device);
 
@@ -32,8 +33,31 @@ public:
 
     void submitUploadCommandBuffer(VkDevice device, Queue* queue);
 
+    // For upload command buffers the caller ended and submitted itself
+    void recycleUploadCommandBuffer(VkDevice device);
+
+    bool hasUploadCommandBuffer() const { return uploadCommandBuffer != nullptr; }
+
+    bool hasActiveCommandBuffer() const { return activeCommandBuffer != nullptr; }
+
+    // The next upload submit waits for the timeline semaphore to reach the value
+    void setUploadWait(VkSemaphore semaphore, uint64_t value);
+
+    // The next active submit waits for, or signals, the timeline semaphore value
+    void setActiveWait(VkSemaphore semaphore, uint64_t value, VkPipelineStageFlags stage);
+
+    void setActiveSignal(VkSemaphore semaphore, uint64_t value);
+
+    // Applied to every command buffer, for managers of compute only queues. Must be set before init
+    void setSupportedStages(VkPipelineStageFlags stages);
+
     void resetCommandBuffers(VkDevice device, bool bIdle = false);
 
+    // Blocks until the GPU has finished the last frame recorded with this frame index
+    void beginFrame(VkDevice device, uint32_t frameIndex);
+
+    void endFrame(VkDevice device, Queue* queue, uint32_t frameIndex);
+
 private:
     const uint32_t DEFAULT_NUM_COMMAND_BUFFER = 10;
 
@@ -42,5 +66,11 @@ private:
     CommandBuffer* activeCommandBuffer;
     std::queue<CommandBuffer*> submitCommandBuffers;
     std::queue<CommandBuffer*> readyCommandBuffers;
+    std::vector<handle::Fence> frameFences;
+    VkSemaphore uploadWaitSemaphore;
+    uint64_t uploadWaitValue;
+    TimelinePoint activeWait;
+    TimelinePoint activeSignal;
+    VkPipelineStageFlags supportedStages;
 };
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#include "vulkan/commandCounters.h"
+
+#if ENABLE_COMMAND_COUNTERS
+
+namespace vk
+{
+CommandCounters* CommandCounters::get()
+{
+	static CommandCounters commandCounters;
+	return &commandCounters;
+}
+
+CommandCounters::CommandCounters()
+	: intervalFrames(0)
+{
+
+}
+
+void CommandCounters::endFrame()
+{
+	lastFrame = current;
+	current = rhi::CommandStats();
+
+	interval.add(lastFrame);
+	intervalFrames++;
+
+	if (intervalFrames == kCommandSummaryInterval)
+	{
+		log();
+		interval = rhi::CommandStats();
+		intervalFrames = 0;
+	}
+}
+
+void CommandCounters::log() const
+{
+	const double frames = static_cast<double>(intervalFrames);
+
+	LOGD("Commands per frame on average over %u frames", intervalFrames);
+	LOGD("  draws %.1f, dispatches %.1f, trace rays %.1f", interval.draws / frames, interval.dispatches / frames, interval.traceRays / frames);
+	LOGD("  pipeline binds %.1f, descriptor set binds %.1f", interval.pipelineBinds / frames, interval.descriptorSetBinds / frames);
+	LOGD("  vertex buffer binds %.1f, index buffer binds %.1f, push constants %.1f", interval.vertexBufferBinds / frames, interval.indexBufferBinds / frames,
+		interval.pushConstants / frames);
+	LOGD("  barriers %.1f with %.1f image and %.1f buffer barriers", interval.barriers / frames, interval.imageBarriers / frames, interval.bufferBarriers / frames);
+	LOGD("  render passes %.1f, submits %.1f", interval.renderPasses / frames, interval.submits / frames);
+	LOGD("  filtered pipeline binds %.1f, descriptor set binds %.1f, vertex buffer binds %.1f, index buffer binds %.1f, dynamic states %.1f",
+		interval.filteredPipelineBinds / frames, interval.filteredDescriptorSetBinds / frames, interval.filteredVertexBufferBinds / frames,
+		interval.filteredIndexBufferBinds / frames, interval.filteredDynamicStates / frames);
+}
+}
+
+#endif // ENABLE_COMMAND_COUNTERS
@@ -0,0 +1,49 @@
+#pragma once
+
+// Per-frame counts of the commands recorded into any command buffer and of the queue submits,
+// compiled in with ENABLE_COMMAND_COUNTERS. Without it COUNT_COMMAND expands to nothing.
+//
+//   COUNT_COMMAND(draws, 1);    adds to a counter of the frame being recorded
+
+#if ENABLE_COMMAND_COUNTERS
+
+#include "rhi/context.h"
+
+namespace vk
+{
+// Frames between two summaries in the log
+const uint32_t kCommandSummaryInterval = 600;
+
+// Command buffers are only recorded on the render thread, so the counters are plain integers
+class CommandCounters
+{
+public:
+	static CommandCounters* get();
+
+	rhi::CommandStats& getCurrent() { return current; }
+
+	// Commands recorded from here on count towards the next frame
+	void endFrame();
+
+	const rhi::CommandStats& getLastFrame() const { return lastFrame; }
+
+private:
+	CommandCounters();
+
+	void log() const;
+
+	rhi::CommandStats current;
+	rhi::CommandStats lastFrame;
+	// Summed over the frames since the last summary
+	rhi::CommandStats interval;
+	uint32_t intervalFrames;
+};
+}
+
+#define COUNT_COMMAND(counter, count) vk::CommandCounters::get()->getCurrent().counter += (count)
+
+#else
+
+#define COUNT_COMMAND(counter, count)
+
+#endif // ENABLE_COMMAND_COUNTERS
@@ -1,15 +1,29 @@
+#include <algorithm>
 #include <cstring>
 #include <string>
 #include <vector>
 
+#include "platform/profiler.h"
 #include "platform/window.h"
 #include "vulkan/context.h"
 #include "vulkan/debug.h"
 #include "vulkan/surface.h"
 #include "vulkan/commandBufferManager.h"
+#include "vulkan/commandCounters.h"
 #include "vulkan/queue.h"
 #include "vulkan/extension.h"
 #include "vulkan/buffer.h"
+#include "vulkan/memoryAllocator.h"
+#include "vulkan/uploadBatcher.h"
+#include "vulkan/uniformArena.h"
+#include "vulkan/layoutCache.h"
+#include "vulkan/memoryTracker.h"
+#include "vulkan/destructionQueue.h"
+#include "vulkan/overlapProfiler.h"
+#include "vulkan/passProfiler.h"
+#include "vulkan/texture.h"
+#include "vulkan/rendertarget.h"
+#include "rhi/transition.h"
 
 namespace vk
 {
@@ -18,6 +32,26 @@ Context::Context()
     , commandBufferManager(nullptr)
     , queue(nullptr)
     , descriptorPool(nullptr)
+    , layoutCache(nullptr)
+    , memoryAllocator(nullptr)
+    , uploadBatcher(nullptr)
+    , uniformArena(nullptr)
+    , memoryTracker(nullptr)
+    , destructionQueue(nullptr)
+    , transferQueueFamilyIndex(0)
+    , transferQueue(nullptr)
+    , transferCommandBufferManager(nullptr)
+    , transferTimelineValue(0)
+    , computeQueueFamilyIndex(0)
+    , computeQueue(nullptr)
+    , computeCommandBufferManager(nullptr)
+    , graphicsTimelineValue(0)
+    , computeTimelineValue(0)
+    , asyncComputeActive(false)
+    , asyncComputeWaitPending(false)
+    , overlapProfiler(nullptr)
+    , passProfiler(nullptr)
+    , bindlessTextureCapacity(0)
     , queueFamilyIndex(0)
     , physicalDeviceProperties()
     , physicalDeviceFeatures2()
@@ -58,12 +92,60 @@ bool Context::init(platform::Window* window)
         descriptorPool = new DescriptorPool();
     }
 
+    if (layoutCache == nullptr)
+    {
+        layoutCache = new LayoutCache();
+    }
+
+    if (memoryAllocator == nullptr)
+    {
+        memoryAllocator = new MemoryAllocator();
+    }
+
+    if (memoryTracker == nullptr)
+    {
+        memoryTracker = new MemoryTracker();
+    }
+
+    if (destructionQueue == nullptr)
+    {
+        destructionQueue = new DestructionQueue();
+    }
+    destructionQueue->init(framesInFlight);
+
     initPhysicalDevice();
     surface->initSurface(instance.getHandle(), window);
     initLogicalDevice();
-    surface->initSwapchain(physicalDevice.getHandle(), device.getHandle());
+    memoryAllocator->init(physicalDevice.getHandle(), physicalDeviceProperties);
+    if (surface->validSurface())
+    {
+        surface->initSwapchain(physicalDevice.getHandle(), device.getHandle(), framesInFlight);
+    }
+    else
+    {
+        // Headless, the frames go to offscreen images instead of a presentable swapchain
+        surface->initOffscreenSwapchain(this, framesInFlight);
+    }
+
+    descriptorPool->init(device.getHandle(), framesInFlight);
+
+    if (uploadBatcher == nullptr)
+    {
+        uploadBatcher = new UploadBatcher();
+    }
+    uploadBatcher->init(this);
 
-    descriptorPool->init(device.getHandle());
+    if (uniformArena == nullptr)
+    {
+        uniformArena = new UniformArena();
+    }
+    uniformArena->init(this, framesInFlight);
+
+    if (passProfiler == nullptr && supportsTimestamps(queueFamilyIndex))
+    {
+        passProfiler = new PassProfiler();
+        passProfiler->init(device.getHandle(), framesInFlight, physicalDeviceProperties.limits.timestampPeriod);
+    }
 
     renderTargetWidth = surface->getSurfaceSize().width;
     renderTargetHeight = surface->getSurfaceSize().height;
@@ -73,7 +155,38 @@ bool Context::init(platform::Window* window)
 
 bool Context::terminate()
 {
+    if (uploadBatcher != nullptr)
+    {
+        uploadBatcher->destroy(this);
+        delete uploadBatcher;
+        uploadBatcher = nullptr;
+    }
+
     queue->waitIdle();
+    destroyTransferQueue();
+    destroyComputeQueue();
+    surface->destroyOffscreenSwapchain(this);
+
+    if (passProfiler != nullptr)
+    {
+        passProfiler->destroy(device.getHandle());
+        delete passProfiler;
+        passProfiler = nullptr;
+    }
+
+    if (destructionQueue != nullptr)
+    {
+        destructionQueue->destroy();
+        delete destructionQueue;
+        destructionQueue = nullptr;
+    }
+
+    if (uniformArena != nullptr)
+    {
+        uniformArena->destroy(this);
+        delete uniformArena;
+        uniformArena = nullptr;
+    }
 
     if (descriptorPool != nullptr)
     {
@@ -82,6 +195,28 @@ bool Context::terminate()
         descriptorPool = nullptr;
     }
 
+    if (layoutCache != nullptr)
+    {
+        layoutCache->destroy(device.getHandle());
+        delete layoutCache;
+        layoutCache = nullptr;
+    }
+
+    if (memoryTracker != nullptr)
+    {
+        memoryTracker->destroy();
+        delete memoryTracker;
+        memoryTracker = nullptr;
+    }
+
+    if (memoryAllocator != nullptr)
+    {
+        memoryAllocator->logStats();
+        memoryAllocator->destroy(device.getHandle());
+        delete memoryAllocator;
+        memoryAllocator = nullptr;
+    }
+
     if (queue != nullptr)
     {
         queue->destroy(device.getHandle());
@@ -286,10 +421,45 @@ bool Context::initPhysicalDevice()
 bool Context::initLogicalDevice()
 {
     uint32_t graphicsQueueIndex = 0;
+    uint32_t transferQueueIndex = 0;
+    uint32_t computeQueueIndex = 0;
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos{};
     queueCreateInfos.push_back(getQueueCreateInfo(VK_QUEUE_GRAPHICS_BIT, &graphicsQueueIndex));
 
+    VkDeviceQueueCreateInfo transferQueueCreateInfo = getQueueCreateInfo(VK_QUEUE_TRANSFER_BIT, &transferQueueIndex);
+    if (transferQueueIndex != graphicsQueueIndex)
+    {
+        queueCreateInfos.push_back(transferQueueCreateInfo);
+    }
+
+    // Async compute prefers a compute family without graphics, otherwise a second queue of the graphics family
+    bool enableAsyncCompute = true;
+    uint32_t computeQueueInFamily = 0;
+    VkDeviceQueueCreateInfo computeQueueCreateInfo = getQueueCreateInfo(VK_QUEUE_COMPUTE_BIT, &computeQueueIndex);
+    if (computeQueueIndex == graphicsQueueIndex)
+    {
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.getHandle(), &queueFamilyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.getHandle(), &queueFamilyCount, queueFamilyProperties.data());
+
+        enableAsyncCompute = queueFamilyProperties[graphicsQueueIndex].queueCount > 1;
+        if (enableAsyncCompute)
+        {
+            queueCreateInfos[0].queueCount = 2;
+            computeQueueInFamily = 1;
+        }
+    }
+    else if (computeQueueIndex != transferQueueIndex)
+    {
+        queueCreateInfos.push_back(computeQueueCreateInfo);
+    }
+    else
+    {
+        enableAsyncCompute = false;
+    }
+
     // Get list of supported extensions
     uint32_t extensionCount = 0;
     std::vector<VkExtensionProperties> supportedExtensions;
@@ -319,13 +489,23 @@ bool Context::initLogicalDevice()
     deviceExtensions.push_back(ExtensionFactory::createDeviceExtension(ExtensionName::DeviceAddressExtension));
     deviceExtensions.push_back(ExtensionFactory::createDeviceExtension(ExtensionName::DeferredHostOperationsExtension));
     deviceExtensions.push_back(ExtensionFactory::createDeviceExtension(ExtensionName::RayQuery));
-    deviceExtensions.push_back(ExtensionFactory::createDeviceExtension(ExtensionName::DescriptorIndexing));
     deviceExtensions.push_back(ExtensionFactory::createDeviceExtension(ExtensionName::Spirv_1_4));
 
+    DescriptorIndexingExtension* descriptorIndexingExtension =
+        static_cast<DescriptorIndexingExtension*>(ExtensionFactory::createDeviceExtension(ExtensionName::DescriptorIndexing));
+    deviceExtensions.push_back(descriptorIndexingExtension);
+
+    DeviceExtension* timelineSemaphoreExtension = ExtensionFactory::createDeviceExtension(ExtensionName::TimelineSemaphore);
+    deviceExtensions.push_back(timelineSemaphoreExtension);
+
+    DeviceExtension* memoryBudgetExtension = ExtensionFactory::createDeviceExtension(ExtensionName::MemoryBudget);
+    deviceExtensions.push_back(memoryBudgetExtension);
+
     for (auto& deviceExtension : deviceExtensions)
     {
         deviceExtension->check(supportedExtensions);
         deviceExtension->add(requestedExtensions);
+        deviceExtension->query(physicalDevice.getHandle());
         deviceExtension->feature(nextFeatureChain);
         deviceExtension->property(devicePropertyMap, nextPropertyChain);
     }
@@ -342,10 +522,36 @@ bool Context::initLogicalDevice()
 
     physicalDevice.getProperties2(&physicalDeviceProperties2);
 
+    memoryTracker->init(physicalDevice.getHandle(), memoryBudgetExtension->isSupported());
+
+    // Without every feature the objects fall back to a material set per draw
+    if (descriptorIndexingExtension->supportsBindlessTextures())
+    {
+        // Combined image samplers count against both limits, a quarter is left to the other sets of a pipeline
+        const VkPhysicalDeviceLimits& limits = physicalDeviceProperties.limits;
+        const uint32_t stageLimit = std::min(limits.maxPerStageDescriptorSampledImages, limits.maxPerStageDescriptorSamplers);
+        bindlessTextureCapacity = std::min(rhi::kMaxBindlessTextures, stageLimit - stageLimit / 4);
+        LOGD("Bindless textures: %u", bindlessTextureCapacity);
+    }
+    else
+    {
+        LOGD("Bindless textures unsupported, using per draw material sets");
+    }
+
     queueFamilyIndex = graphicsQueueIndex;
-    commandBufferManager->init(device.getHandle(), graphicsQueueIndex);
+    commandBufferManager->init(device.getHandle(), graphicsQueueIndex, framesInFlight);
     queue->init(device.getHandle(), graphicsQueueIndex);
 
+    if (transferQueueIndex != graphicsQueueIndex && timelineSemaphoreExtension->isSupported())
+    {
+        initTransferQueue(transferQueueIndex);
+    }
+
+    if (enableAsyncCompute && timelineSemaphoreExtension->isSupported())
+    {
+        initComputeQueue(computeQueueIndex, computeQueueInFamily);
+    }
+
     LOGD("Done to create logical device");
 
     VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
@@ -355,21 +561,128 @@ bool Context::initLogicalDevice()
     return true;
 }
 
-VkDeviceQueueCreateInfo Context::getQueueCreateInfo(VkQueueFlags queueFlags, uint32_t* queueIndex, float queuePriority)
+VkDeviceQueueCreateInfo Context::getQueueCreateInfo(VkQueueFlags queueFlags, uint32_t* queueIndex)
 {
-    *queueIndex = getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT);
+    // Referenced by the create info until the device is created, covers two queues of a family
+    static const float kQueuePriorities[] = { 1.0f, 1.0f };
+
+    *queueIndex = getQueueFamilyIndex(static_cast<VkQueueFlagBits>(queueFlags));
     VkDeviceQueueCreateInfo queueCreateInfo = {};
     queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queueCreateInfo.queueFamilyIndex = *queueIndex;
     queueCreateInfo.queueCount = 1;
-    queueCreateInfo.pQueuePriorities = &queuePriority;
+    queueCreateInfo.pQueuePriorities = kQueuePriorities;
     
     return queueCreateInfo;
 }
 
+void Context::initTransferQueue(uint32_t transferQueueIndex)
+{
+    transferQueueFamilyIndex = transferQueueIndex;
+
+    transferQueue = new Queue();
+    transferQueue->init(device.getHandle(), transferQueueIndex);
+
+    transferCommandBufferManager = new CommandBufferManager();
+    transferCommandBufferManager->init(device.getHandle(), transferQueueIndex, 1);
+
+    initTimeline(&transferTimeline);
+    transferTimelineValue = 0;
+
+    LOGD("Transfer queue family %u", transferQueueIndex);
+}
+
+void Context::destroyTransferQueue()
+{
+    if (transferQueue == nullptr)
+    {
+        return;
+    }
+
+    transferQueue->waitIdle();
+    transferCommandBufferManager->destory(device.getHandle());
+    delete transferCommandBufferManager;
+    transferCommandBufferManager = nullptr;
+
+    transferQueue->destroy(device.getHandle());
+    delete transferQueue;
+    transferQueue = nullptr;
+
+    transferTimeline.destroy(device.getHandle());
+}
+
+void Context::initComputeQueue(uint32_t computeQueueFamily, uint32_t computeQueueIndex)
+{
+    computeQueueFamilyIndex = computeQueueFamily;
+
+    computeQueue = new Queue();
+    computeQueue->init(device.getHandle(), computeQueueFamily, computeQueueIndex);
+
+    computeCommandBufferManager = new CommandBufferManager();
+    if (computeQueueFamily != queueFamilyIndex)
+    {
+        computeCommandBufferManager->setSupportedStages(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT |
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT |
+            VK_PIPELINE_STAGE_HOST_BIT | VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    }
+    computeCommandBufferManager->init(device.getHandle(), computeQueueFamily, framesInFlight);
+
+    initTimeline(&graphicsTimeline);
+    initTimeline(&computeTimeline);
+    graphicsTimelineValue = 0;
+    computeTimelineValue = 0;
+
+    if (supportsTimestamps(queueFamilyIndex) && supportsTimestamps(computeQueueFamily))
+    {
+        overlapProfiler = new OverlapProfiler();
+        overlapProfiler->init(device.getHandle(), framesInFlight, physicalDeviceProperties.limits.timestampPeriod);
+    }
+
+    LOGD("Async compute queue family %u, queue %u", computeQueueFamily, computeQueueIndex);
+}
+
+void Context::destroyComputeQueue()
+{
+    if (computeQueue == nullptr)
+    {
+        return;
+    }
+
+    computeQueue->waitIdle();
+    if (overlapProfiler != nullptr)
+    {
+        overlapProfiler->destroy(device.getHandle());
+        delete overlapProfiler;
+        overlapProfiler = nullptr;
+    }
+
+    computeCommandBufferManager->destory(device.getHandle());
+    delete computeCommandBufferManager;
+    computeCommandBufferManager = nullptr;
+
+    computeQueue->destroy(device.getHandle());
+    delete computeQueue;
+    computeQueue = nullptr;
+
+    graphicsTimeline.destroy(device.getHandle());
+    computeTimeline.destroy(device.getHandle());
+}
+
+void Context::initTimeline(handle::Semaphore* timeline)
+{
+    VkSemaphoreTypeCreateInfo semaphoreTypeCreateInfo = {};
+    semaphoreTypeCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    semaphoreTypeCreateInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    semaphoreTypeCreateInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreCreateInfo = {};
+    semaphoreCreateInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+    VKCALL(timeline->init(device.getHandle(), semaphoreCreateInfo));
+}
+
 uint32_t Context::getQueueFamilyIndex(VkQueueFlagBits queueFlags) const
 {
-    ASSERT(surface->validSurface());
     ASSERT(physicalDevice.valid());
 
     std::vector<VkQueueFamilyProperties> queueFamilyProperties;
@@ -381,8 +694,9 @@ uint32_t Context::getQueueFamilyIndex(VkQueueFlagBits queueFlags) const
     vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.getHandle(), &queueFamilyCount,
                                              queueFamilyProperties.data());
 
+    // A headless surface has nothing to present to
     std::vector<VkBool32> supportsPresent(queueFamilyCount);
-    for (uint32_t i = 0; i < queueFamilyCount; i++)
+    for (uint32_t i = 0; i < queueFamilyCount && surface->validSurface(); i++)
     {
         vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice.getHandle(), i, surface->getSurface(), &supportsPresent[i]);
     }
@@ -430,30 +744,98 @@ uint32_t Context::getQueueFamilyIndex(VkQueueFlagBits queueFlags) const
     throw std::runtime_error("Could not find a matching queue family index");
 }
 
+bool Context::supportsTimestamps(uint32_t queueFamily) const
+{
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.getHandle(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice.getHandle(), &queueFamilyCount, queueFamilyProperties.data());
+
+    return queueFamily < queueFamilyCount && queueFamilyProperties[queueFamily].timestampValidBits != 0;
+}
+
 uint32_t Context::getNextImageIndex()
 {
-    surface->acquireNextImage(device.getHandle(), commandBufferManager, queue);
+    surface->acquireNextImage(device.getHandle(), frameIndex);
     return surface->getCurrentImageIdex();
 }
 
 bool Context::present()
 {
-    VKCALL(surface->present(device.getHandle(), commandBufferManager, queue));
-    queue->waitIdle();
+    PROFILE_ZONE("Context::present");
+    ASSERT(!asyncComputeActive);
+    // The frame fence has to cover the compute work even if no pass consumed it
+    if (asyncComputeWaitPending)
+    {
+        commandBufferManager->setActiveWait(computeTimeline.getHandle(), computeTimelineValue, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        asyncComputeWaitPending = false;
+    }
+    uploadBatcher->flush(this);
+    if (overlapProfiler != nullptr)
+    {
+        overlapProfiler->endGraphics(getActiveCommandBuffer(), frameIndex);
+    }
+    VKCALL(surface->present(device.getHandle(), commandBufferManager, queue, frameIndex));
+    commandBufferManager->endFrame(device.getHandle(), queue, frameIndex);
+#if ENABLE_COMMAND_COUNTERS
+    CommandCounters::get()->endFrame();
+#endif
+
+    // Only wait for the frame that last used the next frame index, the CPU records
+    // ahead while the GPU works on the others
+    frameIndex = (frameIndex + 1) % framesInFlight;
+    commandBufferManager->beginFrame(device.getHandle(), frameIndex);
+    destructionQueue->retire(frameIndex);
+    descriptorPool->beginFrame(device.getHandle(), frameIndex);
+    uniformArena->beginFrame(frameIndex);
+    memoryTracker->update();
+    surface->resolveReadback(this, frameIndex);
+    if (overlapProfiler != nullptr)
+    {
+        overlapProfiler->resolve(device.getHandle(), frameIndex);
+    }
+    if (passProfiler != nullptr)
+    {
+        passProfiler->resolve(device.getHandle(), frameIndex);
+    }
     return true;
 }
 
 bool Context::submit()
 {
+    ASSERT(!asyncComputeActive);
+    uploadBatcher->flush(this);
+    if (overlapProfiler != nullptr)
+    {
+        overlapProfiler->endGraphics(getActiveCommandBuffer(), frameIndex);
+    }
     commandBufferManager->submitActiveCommandBuffer(device.getHandle(), queue);
-    queue->waitIdle();
     return true;
 }
 
 void Context::wait()
 {
+    uploadBatcher->flush(this);
+    if (commandBufferManager->hasUploadCommandBuffer())
+    {
+        commandBufferManager->submitUploadCommandBuffer(device.getHandle(), queue);
+    }
+    if (transferQueue != nullptr)
+    {
+        transferQueue->waitIdle();
+    }
+    if (computeQueue != nullptr)
+    {
+        computeQueue->waitIdle();
+    }
     queue->waitIdle();
     commandBufferManager->resetCommandBuffers(device.getHandle(), true);
+    destructionQueue->retireAll();
+}
+
+void Context::flushUploads()
+{
+    uploadBatcher->flush(this);
 }
 
 void Context::draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance)
@@ -479,8 +861,357 @@ void Context::dispatchIndirect(rhi::StorageBuffer* rhiBuffer)
 
 CommandBuffer* Context::getActiveCommandBuffer()
 {
+    if (asyncComputeActive)
+    {
+        return computeCommandBufferManager->getActiveCommandBuffer(device.getHandle());
+    }
+
     ASSERT(commandBufferManager);
-    return commandBufferManager->getActiveCommandBuffer(device.getHandle());
+    const bool beginCommandBuffer = !commandBufferManager->hasActiveCommandBuffer();
+    CommandBuffer* commandBuffer = commandBufferManager->getActiveCommandBuffer(device.getHandle());
+    if (beginCommandBuffer && overlapProfiler != nullptr)
+    {
+        overlapProfiler->beginGraphics(commandBuffer, frameIndex);
+    }
+    return commandBuffer;
+}
+
+void Context::beginAsyncCompute(const std::vector<rhi::Transition>& ownershipTransfers)
+{
+    // Without a compute queue the passes simply stay on the graphics queue
+    if (computeQueue == nullptr)
+    {
+        return;
+    }
+    ASSERT(!asyncComputeActive);
+
+    CommandBuffer* graphicsCommandBuffer = getActiveCommandBuffer();
+    graphicsCommandBuffer->flushTransitions();
+    transferOwnership(graphicsCommandBuffer, ownershipTransfers, queueFamilyIndex, computeQueueFamilyIndex, true, 0);
+    if (overlapProfiler != nullptr)
+    {
+        overlapProfiler->endGraphics(graphicsCommandBuffer, frameIndex);
+    }
+
+    uploadBatcher->flush(this);
+    graphicsTimelineValue++;
+    commandBufferManager->setActiveSignal(graphicsTimeline.getHandle(), graphicsTimelineValue);
+    commandBufferManager->submitActiveCommandBuffer(device.getHandle(), queue);
+
+    // The compute queue only runs dispatches and copies, holding those is enough
+    const VkPipelineStageFlags computeWaitStages = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+    asyncComputeActive = true;
+    computeCommandBufferManager->setActiveWait(graphicsTimeline.getHandle(), graphicsTimelineValue, computeWaitStages);
+
+    CommandBuffer* computeCommandBuffer = getActiveCommandBuffer();
+    if (overlapProfiler != nullptr)
+    {
+        overlapProfiler->beginCompute(computeCommandBuffer, frameIndex);
+    }
+    transferOwnership(computeCommandBuffer, ownershipTransfers, queueFamilyIndex, computeQueueFamilyIndex, false, computeWaitStages);
+}
+
+void Context::endAsyncCompute(const std::vector<rhi::Transition>& ownershipTransfers)
+{
+    if (!asyncComputeActive)
+    {
+        return;
+    }
+
+    CommandBuffer* computeCommandBuffer = getActiveCommandBuffer();
+    computeCommandBuffer->flushTransitions();
+    transferOwnership(computeCommandBuffer, ownershipTransfers, computeQueueFamilyIndex, queueFamilyIndex, true, 0);
+    if (overlapProfiler != nullptr)
+    {
+        overlapProfiler->endCompute(computeCommandBuffer, frameIndex);
+    }
+
+    computeTimelineValue++;
+    computeCommandBufferManager->setActiveSignal(computeTimeline.getHandle(), computeTimelineValue);
+    computeCommandBufferManager->submitActiveCommandBuffer(device.getHandle(), computeQueue);
+
+    asyncComputeActive = false;
+    asyncComputeWaitPending = true;
+}
+
+void Context::waitAsyncCompute(const std::vector<rhi::Transition>& ownershipTransfers, rhi::RenderTarget* consumer,
+    const std::vector<rhi::Transition>& consumerUsages)
+{
+    if (!asyncComputeWaitPending)
+    {
+        return;
+    }
+    ASSERT(!asyncComputeActive);
+    asyncComputeWaitPending = false;
+
+    VkPipelineStageFlags waitStages = consumer != nullptr ? 0 : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    for (auto& usage : consumerUsages)
+    {
+        waitStages |= reinterpret_cast<RenderTarget*>(consumer)->getStageFlags(usage.getUsage());
+    }
+    if (waitStages == 0)
+    {
+        waitStages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    }
+
+    // The graphics work recorded since the section ended doesn't use its results, it goes out without the wait
+    if (commandBufferManager->hasActiveCommandBuffer())
+    {
+        submit();
+    }
+
+    commandBufferManager->setActiveWait(computeTimeline.getHandle(), computeTimelineValue, waitStages);
+    transferOwnership(getActiveCommandBuffer(), ownershipTransfers, computeQueueFamilyIndex, queueFamilyIndex, false, waitStages);
+}
+
+void Context::transferOwnership(CommandBuffer* commandBuffer, const std::vector<rhi::Transition>& ownershipTransfers,
+    uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex, bool release, VkPipelineStageFlags waitStages)
+{
+    // Queues of the same family share ownership, the semaphores are enough
+    if (srcQueueFamilyIndex == dstQueueFamilyIndex)
+    {
+        return;
+    }
+
+    std::vector<VkImageMemoryBarrier> imageMemoryBarriers;
+    std::vector<VkBufferMemoryBarrier> bufferMemoryBarriers;
+
+    const VkAccessFlags srcAccessMask = release ? VK_ACCESS_MEMORY_WRITE_BIT : 0;
+    const VkAccessFlags dstAccessMask = release ? 0 : VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    for (auto& ownershipTransfer : ownershipTransfers)
+    {
+        if (rhi::Texture* rhiTexture = ownershipTransfer.getTexture())
+        {
+            Texture* texture = reinterpret_cast<Texture*>(rhiTexture);
+
+            // Undefined contents don't need to survive the transfer
+            if (texture->getImageLayout() == ImageLayout::Undefined)
+            {
+                continue;
+            }
+
+            VkImageMemoryBarrier imageMemoryBarrier = {};
+            imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            imageMemoryBarrier.srcAccessMask = srcAccessMask;
+            imageMemoryBarrier.dstAccessMask = dstAccessMask;
+            imageMemoryBarrier.oldLayout = texture->getVkImageLayout();
+            imageMemoryBarrier.newLayout = texture->getVkImageLayout();
+            imageMemoryBarrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+            imageMemoryBarrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+            imageMemoryBarrier.image = texture->getImage();
+            imageMemoryBarrier.subresourceRange = texture->getSubresourceRange();
+            imageMemoryBarriers.push_back(imageMemoryBarrier);
+        }
+
+        if (rhi::StorageBuffer* rhiStorageBuffer = ownershipTransfer.getBuffer())
+        {
+            StorageBuffer* buffer = reinterpret_cast<StorageBuffer*>(rhiStorageBuffer);
+
+            VkBufferMemoryBarrier bufferMemoryBarrier = {};
+            bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            bufferMemoryBarrier.srcAccessMask = srcAccessMask;
+            bufferMemoryBarrier.dstAccessMask = dstAccessMask;
+            bufferMemoryBarrier.srcQueueFamilyIndex = srcQueueFamilyIndex;
+            bufferMemoryBarrier.dstQueueFamilyIndex = dstQueueFamilyIndex;
+            bufferMemoryBarrier.buffer = buffer->getHandle();
+            bufferMemoryBarrier.offset = 0;
+            bufferMemoryBarrier.size = VK_WHOLE_SIZE;
+            bufferMemoryBarriers.push_back(bufferMemoryBarrier);
+        }
+    }
+
+    if (imageMemoryBarriers.empty() && bufferMemoryBarriers.empty())
+    {
+        return;
+    }
+
+    // The acquire half chains with the semaphore wait, the barriers of the passes that follow chain with it
+    commandBuffer->pipelineBarrier(release ? VK_PIPELINE_STAGE_ALL_COMMANDS_BIT : waitStages,
+        release ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        0, nullptr,
+        static_cast<uint32_t>(bufferMemoryBarriers.size()), bufferMemoryBarriers.data(),
+        static_cast<uint32_t>(imageMemoryBarriers.size()), imageMemoryBarriers.data());
+}
+
+rhi::AsyncComputeStats Context::getAsyncComputeStats()
+{
+    return overlapProfiler != nullptr ? overlapProfiler->getStats() : rhi::AsyncComputeStats();
+}
+
+void Context::beginPassTiming(const std::string& name)
+{
+    // The overlap profiler only exists when the compute queue family supports timestamps
+    if (passProfiler == nullptr || (asyncComputeActive && overlapProfiler == nullptr))
+    {
+        return;
+    }
+    passProfiler->beginPass(getActiveCommandBuffer(), frameIndex, name, asyncComputeActive ? 1 : 0);
+}
+
+void Context::endPassTiming()
+{
+    if (passProfiler != nullptr)
+    {
+        passProfiler->endPass(getActiveCommandBuffer(), frameIndex);
+    }
+}
+
+std::vector<rhi::PassTimingStats> Context::getPassTimingStats()
+{
+    return passProfiler != nullptr ? passProfiler->getStats() : std::vector<rhi::PassTimingStats>();
+}
+
+bool Context::dumpPassTrace(const std::string& path)
+{
+    if (passProfiler == nullptr)
+    {
+        LOGE("GPU timestamps are not supported, no pass trace to write");
+        return false;
+    }
+    return passProfiler->writeTrace(path);
+}
+
+rhi::CommandStats Context::getCommandStats()
+{
+#if ENABLE_COMMAND_COUNTERS
+    return CommandCounters::get()->getLastFrame();
+#else
+    return rhi::CommandStats();
+#endif
+}
+
+rhi::MemoryBudgetStats Context::getMemoryBudgetStats()
+{
+    return memoryTracker->getStats();
+}
+
+bool Context::dumpMemoryReport(const std::string& path)
+{
+    return memoryTracker->writeJson(path);
+}
+
+void Context::aliasTransientTextures(const std::vector<rhi::TransientTextureLifetime>& lifetimes)
+{
+    struct TransientTexture
+    {
+        Texture* texture;
+        VkMemoryRequirements memoryRequirements;
+        uint32_t firstPass;
+        uint32_t lastPass;
+    };
+
+    struct AliasingBlock
+    {
+        std::vector<TransientTexture*> textures;
+        VkMemoryRequirements memoryRequirements;
+    };
+
+    std::vector<TransientTexture> transientTextures;
+    transientTextures.reserve(lifetimes.size());
+    for (auto& lifetime : lifetimes)
+    {
+        Texture* texture = reinterpret_cast<Texture*>(lifetime.texture);
+        texture->createAliasedImage(this);
+
+        auto& transientTexture = transientTextures.emplace_back();
+        transientTexture.texture = texture;
+        transientTexture.memoryRequirements = texture->getMemoryRequirements(device.getHandle());
+        transientTexture.firstPass = lifetime.firstPass;
+        transientTexture.lastPass = lifetime.lastPass;
+    }
+
+    // Largest first, a block is as large as its first texture and the smaller ones fill it up
+    std::sort(transientTextures.begin(), transientTextures.end(), [](const TransientTexture& a, const TransientTexture& b)
+    {
+        return a.memoryRequirements.size > b.memoryRequirements.size;
+    });
+
+    std::vector<AliasingBlock> blocks;
+    VkDeviceSize separateSize = 0;
+    for (auto& transientTexture : transientTextures)
+    {
+        const VkMemoryRequirements& memoryRequirements = transientTexture.memoryRequirements;
+        separateSize += memoryRequirements.size;
+
+        AliasingBlock* target = nullptr;
+        for (auto& block : blocks)
+        {
+            if ((block.memoryRequirements.memoryTypeBits & memoryRequirements.memoryTypeBits) == 0)
+            {
+                continue;
+            }
+
+            bool overlaps = false;
+            for (auto& other : block.textures)
+            {
+                overlaps |= transientTexture.firstPass <= other->lastPass && other->firstPass <= transientTexture.lastPass;
+            }
+
+            if (!overlaps)
+            {
+                target = &block;
+                break;
+            }
+        }
+
+        if (target == nullptr)
+        {
+            target = &blocks.emplace_back();
+            target->memoryRequirements = memoryRequirements;
+        }
+
+        target->textures.push_back(&transientTexture);
+        target->memoryRequirements.size = std::max(target->memoryRequirements.size, memoryRequirements.size);
+        target->memoryRequirements.alignment = std::max(target->memoryRequirements.alignment, memoryRequirements.alignment);
+        target->memoryRequirements.memoryTypeBits &= memoryRequirements.memoryTypeBits;
+    }
+
+    VkDeviceSize aliasedSize = 0;
+    for (auto& block : blocks)
+    {
+        AliasedMemory* aliasedMemory = new AliasedMemory();
+        if (!memoryAllocator->allocate(device.getHandle(), block.memoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, MemoryUsage::GpuOnly,
+            0, ResourceType::Optimal, &aliasedMemory->allocation))
+        {
+            LOGE("Failed to allocate aliased memory, the transient textures get memory of their own");
+            delete aliasedMemory;
+
+            for (auto& transientTexture : block.textures)
+            {
+                transientTexture->texture->setMemoryOwner(transientTexture->texture->getName());
+                transientTexture->texture->bindMemory(this, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+            }
+            continue;
+        }
+
+        std::string owner = "Transient";
+        for (auto& transientTexture : block.textures)
+        {
+            owner += (transientTexture == block.textures.front() ? " " : ", ") + transientTexture->texture->getName();
+        }
+        aliasedMemory->memoryTrackingId = memoryTracker->track(rhi::MemoryCategory::RenderTarget, owner, aliasedMemory->allocation.size);
+        aliasedSize += aliasedMemory->allocation.size;
+
+        for (auto& transientTexture : block.textures)
+        {
+            transientTexture->texture->bindAliasedMemory(this, aliasedMemory);
+        }
+    }
+
+    LOGD("Transient textures: %zu textures in %zu blocks, %llu KB instead of %llu KB", transientTextures.size(), blocks.size(),
+        static_cast<unsigned long long>(aliasedSize / 1024), static_cast<unsigned long long>(separateSize / 1024));
+}
+
+void Context::deferDestruction(std::function<void(rhi::Context*)>&& destruction)
+{
+    // Commands recorded for the current frame index may still reference the resource, it goes
+    // once this frame index comes around again and its fence has been waited on
+    destructionQueue->push(frameIndex, [this, destruction = std::move(destruction)]()
+    {
+        destruction(this);
+    });
 }
 
 CommandBuffer* Context::getUploadCommandBuffer()
@@ -495,6 +1226,49 @@ void Context::submitUploadCommandBuffer()
     commandBufferManager->submitUploadCommandBuffer(device.getHandle(), queue);
 }
 
+CommandBuffer* Context::getTransferCommandBuffer()
+{
+    ASSERT(transferCommandBufferManager);
+    return transferCommandBufferManager->getUploadCommandBuffer(device.getHandle());
+}
+
+uint64_t Context::submitTransferCommandBuffer()
+{
+    ASSERT(transferCommandBufferManager);
+    CommandBuffer* commandBuffer = transferCommandBufferManager->getUploadCommandBuffer(device.getHandle());
+    commandBuffer->end();
+
+    transferTimelineValue++;
+    transferQueue->submit(commandBuffer, VK_NULL_HANDLE, 0, 0, transferTimeline.getHandle(), transferTimelineValue);
+    transferCommandBufferManager->recycleUploadCommandBuffer(device.getHandle());
+
+    return transferTimelineValue;
+}
+
+void Context::acquireTransfer(uint64_t timelineValue)
+{
+    commandBufferManager->setUploadWait(transferTimeline.getHandle(), timelineValue);
+}
+
+uint64_t Context::getCompletedTransferValue()
+{
+    uint64_t value = 0;
+    VKCALL(vkGetSemaphoreCounterValueKHR(device.getHandle(), transferTimeline.getHandle(), &value));
+    return value;
+}
+
+void Context::waitTransfer(uint64_t timelineValue)
+{
+    VkSemaphore semaphore = transferTimeline.getHandle();
+
+    VkSemaphoreWaitInfo semaphoreWaitInfo = {};
+    semaphoreWaitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    semaphoreWaitInfo.semaphoreCount = 1;
+    semaphoreWaitInfo.pSemaphores = &semaphore;
+    semaphoreWaitInfo.pValues = &timelineValue;
+    VKCALL(vkWaitSemaphoresKHR(device.getHandle(), &semaphoreWaitInfo, UINT64_MAX));
+}
+
 VkDevice Context::getDevice() { return device.getHandle(); }
 
 VkPhysicalDevice Context::getPhysicalDevice() { return physicalDevice.getHandle(); }
@@ -504,4 +1278,18 @@ Surface* Context::getSurface() { return surface; }
 CommandBufferManager* Context::getCommandBufferManager() { return commandBufferManager; }
 
 DescriptorPool* Context::getDescriptorPool() { return descriptorPool; }
+
+LayoutCache* Context::getLayoutCache() { return layoutCache; }
+
+MemoryAllocator* Context::getMemoryAllocator() { return memoryAllocator; }
+
+UploadBatcher* Context::getUploadBatcher() { return uploadBatcher; }
+
+UniformArena* Context::getUniformArena() { return uniformArena; }
+
+MemoryTracker* Context::getMemoryTracker() { return memoryTracker; }
+
+DestructionQueue* Context::getDestructionQueue() { return destructionQueue; }
+
+Queue* Context::getQueue() { return queue; }
 }
\ No newline at end of file
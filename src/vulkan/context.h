@@ -14,11 +14,19 @@ class Window;
 namespace vk
 {
 class DescriptorPool;
+class LayoutCache;
+class MemoryAllocator;
+class UploadBatcher;
+class UniformArena;
+class MemoryTracker;
+class DestructionQueue;
 class Surface;
 class CommandBuffer;
 class CommandBufferManager;
 class Queue;
 class DeviceExtension;
+class OverlapProfiler;
+class PassProfiler;
 
 class Context : public rhi::Context
 {
@@ -35,6 +43,8 @@ public:
 
     void wait() override;
 
+    void flushUploads() override;
+
     void draw(uint32_t vertexCount, uint32_t instanceCount, uint32_t firstVertex, uint32_t firstInstance) override;
 
     void drawIndexed(uint32_t indexCount, uint32_t instanceCount, uint32_t firstIndex, uint32_t vertexOffset, uint32_t firstInstance) override;
@@ -43,6 +53,39 @@ public:
 
     void dispatchIndirect(rhi::StorageBuffer* buffer) override;
 
+    inline bool hasAsyncCompute() override { return computeQueue != nullptr; }
+
+    void beginAsyncCompute(const std::vector<rhi::Transition>& ownershipTransfers) override;
+
+    void endAsyncCompute(const std::vector<rhi::Transition>& ownershipTransfers) override;
+
+    void waitAsyncCompute(const std::vector<rhi::Transition>& ownershipTransfers, rhi::RenderTarget* consumer,
+        const std::vector<rhi::Transition>& consumerUsages) override;
+
+    rhi::AsyncComputeStats getAsyncComputeStats() override;
+
+    void beginPassTiming(const std::string& name) override;
+
+    void endPassTiming() override;
+
+    std::vector<rhi::PassTimingStats> getPassTimingStats() override;
+
+    bool dumpPassTrace(const std::string& path) override;
+
+    rhi::CommandStats getCommandStats() override;
+
+    inline uint32_t getBindlessTextureCapacity() override { return bindlessTextureCapacity; }
+
+    inline uint32_t getMaxPushConstantsSize() override { return physicalDeviceProperties.limits.maxPushConstantsSize; }
+
+    rhi::MemoryBudgetStats getMemoryBudgetStats() override;
+
+    bool dumpMemoryReport(const std::string& path) override;
+
+    void aliasTransientTextures(const std::vector<rhi::TransientTextureLifetime>& lifetimes) override;
+
+    void deferDestruction(std::function<void(rhi::Context*)>&& destruction) override;
+
     inline const std::string& getGpuName() override { return gpuName; }
 
 // Factory
@@ -80,10 +123,27 @@ private:
 
     bool initLogicalDevice();
 
-    VkDeviceQueueCreateInfo getQueueCreateInfo(VkQueueFlags queueFlags, uint32_t* queueIndex, float queuePriority = 0);
+    VkDeviceQueueCreateInfo getQueueCreateInfo(VkQueueFlags queueFlags, uint32_t* queueIndex);
 
     uint32_t getQueueFamilyIndex(VkQueueFlagBits queueFlags) const;
 
+    bool supportsTimestamps(uint32_t queueFamily) const;
+
+    void initTransferQueue(uint32_t transferQueueIndex);
+
+    void destroyTransferQueue();
+
+    void initComputeQueue(uint32_t computeQueueFamily, uint32_t computeQueueIndex);
+
+    void destroyComputeQueue();
+
+    void initTimeline(handle::Semaphore* timeline);
+
+    // Queue family ownership barriers, the release half when recorded on the source queue. The acquire
+    // half starts at the stages the semaphore wait holds so it chains with it.
+    void transferOwnership(CommandBuffer* commandBuffer, const std::vector<rhi::Transition>& ownershipTransfers,
+        uint32_t srcQueueFamilyIndex, uint32_t dstQueueFamilyIndex, bool release, VkPipelineStageFlags waitStages);
+
 public:
     VkDevice getDevice();
 
@@ -95,6 +155,20 @@ public:
 
     DescriptorPool* getDescriptorPool();
 
+    LayoutCache* getLayoutCache();
+
+    MemoryAllocator* getMemoryAllocator();
+
+    UploadBatcher* getUploadBatcher();
+
+    UniformArena* getUniformArena();
+
+    MemoryTracker* getMemoryTracker();
+
+    DestructionQueue* getDestructionQueue();
+
+    Queue* getQueue();
+
 public:
     CommandBuffer* getActiveCommandBuffer();
 
@@ -102,6 +176,24 @@ public:
 
     void submitUploadCommandBuffer();
 
+// Transfer queue, only available when the device has a transfer only queue family and timeline semaphores
+public:
+    inline bool hasTransferQueue() { return transferQueue != nullptr; }
+
+    inline uint32_t getTransferQueueFamilyIndex() { return transferQueueFamilyIndex; }
+
+    CommandBuffer* getTransferCommandBuffer();
+
+    // Returns the timeline value signaled once the transfer work completes
+    uint64_t submitTransferCommandBuffer();
+
+    // Makes the next graphics upload submit wait on the transfer work
+    void acquireTransfer(uint64_t timelineValue);
+
+    uint64_t getCompletedTransferValue();
+
+    void waitTransfer(uint64_t timelineValue);
+
     uint32_t getNextImageIndex();
 
     inline uint32_t getQueueFamilyIndex() { return queueFamilyIndex; }
@@ -137,6 +229,32 @@ private:
     CommandBufferManager* commandBufferManager;
     Queue* queue;
     DescriptorPool* descriptorPool;
+    LayoutCache* layoutCache;
+    MemoryAllocator* memoryAllocator;
+    UploadBatcher* uploadBatcher;
+    UniformArena* uniformArena;
+    MemoryTracker* memoryTracker;
+    DestructionQueue* destructionQueue;
+
+    uint32_t transferQueueFamilyIndex;
+    Queue* transferQueue;
+    CommandBufferManager* transferCommandBufferManager;
+    handle::Semaphore transferTimeline;
+    uint64_t transferTimelineValue;
+
+    uint32_t computeQueueFamilyIndex;
+    Queue* computeQueue;
+    CommandBufferManager* computeCommandBufferManager;
+    handle::Semaphore graphicsTimeline;
+    uint64_t graphicsTimelineValue;
+    handle::Semaphore computeTimeline;
+    uint64_t computeTimelineValue;
+    bool asyncComputeActive;
+    // Compute work was submitted that no graphics submission waits for yet
+    bool asyncComputeWaitPending;
+    OverlapProfiler* overlapProfiler;
+    PassProfiler* passProfiler;
+    uint32_t bindlessTextureCapacity;
 
     std::vector<InstanceExtension*> instanceExtensions;
     std::vector<DeviceExtension*> deviceExtensions;
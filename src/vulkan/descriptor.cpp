@@ -6,6 +6,7 @@
 #include "vulkan/pipeline.h"
 #include "vulkan/commandBuffer.h"
 #include "vulkan/accelerationStructure.h"
+#include "vulkan/layoutCache.h"
 
 namespace vk
 {
@@ -14,53 +15,129 @@ void DescriptorSet::destroy(rhi::Context* rhiContext)
 {
 	Context* context = reinterpret_cast<Context*>(rhiContext);
 
-	descriptorSetLayout.destroy(context->getDevice());
+	// The layout belongs to the cache of the context, transient sets go with the reset of their pool
+	if (transient)
+	{
+		descriptorSets.clear();
+	}
+	else
+	{
+		context->getDescriptorPool()->free(context->getDevice(), descriptorSets);
+	}
+	descriptorSetLayout = VK_NULL_HANDLE;
 }
 
 void DescriptorSet::build(rhi::Context* rhiContext)
 {
 	Context* context = reinterpret_cast<Context*>(rhiContext);
 
-	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings;
+	descriptorSetLayoutBindings.clear();
 	size_t bufferInfoSize = 0;
 	size_t imageInfoSize = 0;
 
+	std::vector<VkDescriptorBindingFlags> descriptorBindingFlags;
+	bool partiallyBound = false;
+	size_t arrayImageInfoSize = 0;
+
 	uint32_t binding = 0;
+	dynamicDescriptors.clear();
 	for (auto& descriptor : descriptors)
 	{
+		if (descriptor.getType() == rhi::DescriptorType::Uniform_Buffer_Dynamic ||
+			descriptor.getType() == rhi::DescriptorType::Storage_Buffer_Dynamic)
+		{
+			dynamicDescriptors.push_back(descriptor.getDescriptor());
+		}
+
+		if (descriptor.isArray())
+		{
+			descriptorBindingFlags.push_back(VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT);
+			partiallyBound = true;
+			arrayImageInfoSize += descriptor.getArrayDescriptors().size();
+		}
+		else
+		{
+			descriptorBindingFlags.push_back(0);
+		}
+
 		descriptorSetLayoutBindings.push_back({
 			binding++,
 			convertToVkDescriptorType(descriptor.getType()),
-			1,
+			descriptor.getCount(),
 			convertToVkShaderStageFlag(descriptor.getStage()), nullptr });
 	}
 
-	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
-	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(descriptorSetLayoutBindings.size());
-	descriptorSetLayoutCreateInfo.pBindings = descriptorSetLayoutBindings.data();
-
-	VKCALL(descriptorSetLayout.init(context->getDevice(), descriptorSetLayoutCreateInfo));
+	if (!partiallyBound)
+	{
+		descriptorBindingFlags.clear();
+	}
 
-	const uint32_t descriptorSetCount = 1;
-	VkDescriptorSetLayout descriptorSetLayouts[descriptorSetCount] = { descriptorSetLayout.getHandle() };
-	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
-	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	descriptorSetAllocateInfo.descriptorSetCount = descriptorSetCount;
-	descriptorSetAllocateInfo.pSetLayouts = descriptorSetLayouts;
+	// Sets with the same bindings share the layout, e.g. the instance sets of every object
+	descriptorSetLayout = context->getLayoutCache()->getDescriptorSetLayout(context->getDevice(), descriptorSetLayoutBindings, descriptorBindingFlags);
 
-	descriptorSet = context->getDescriptorPool()->allocate(context->getDevice(), descriptorSetAllocateInfo);
 	writeDescriptorSets.reserve(descriptors.size());
+	// The writes point into it, it must not grow while a set is written
+	arrayImageInfos.reserve(arrayImageInfoSize);
 
+	// A descriptor with a buffer per frame in flight is written again for the frame the set is bound in
 	for (auto& descriptor : descriptors)
 	{
-		updateWriteDescriptorSet(descriptor);
-		auto& writeDS = writeDescriptorSets.back();
+		if (!descriptor.isArray() && descriptor.getDescriptor()->isPerFrame())
+		{
+			setTransient();
+		}
+	}
+
+	if (transient)
+	{
+		// Allocated from the pools of the frame when it is first bound in that frame
+		descriptorSets.assign(1, VK_NULL_HANDLE);
+		transientFrameSerial = UINT64_MAX;
+		return;
+	}
+
+	descriptorSets.resize(1);
+	descriptorSets[0] = context->getDescriptorPool()->allocate(context->getDevice(), descriptorSetLayout, descriptorSetLayoutBindings);
+	writeDescriptors(context, descriptorSets[0], 0);
+}
+
+void DescriptorSet::writeDescriptors(Context* context, VkDescriptorSet descriptorSet, uint32_t frameIndex)
+{
+	// Descriptor data is returned by pointer and reused per frame, so write each set before moving on
+	writeDescriptorSets.clear();
+	arrayImageInfos.clear();
+	for (uint32_t descriptorBinding = 0; descriptorBinding < descriptors.size(); descriptorBinding++)
+	{
+		updateWriteDescriptorSet(descriptors[descriptorBinding], descriptorSet, descriptorBinding, frameIndex);
 	}
 
 	vkUpdateDescriptorSets(context->getDevice(), static_cast<uint32_t>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
 }
 
+VkDescriptorSet& DescriptorSet::getFrameHandle(Context* context)
+{
+	ASSERT(!descriptorSets.empty());
+
+	DescriptorPool* descriptorPool = context->getDescriptorPool();
+	if (transient && transientFrameSerial != descriptorPool->getFrameSerial())
+	{
+		// The set of an earlier frame went with the reset of its pool
+		descriptorSets[0] = descriptorPool->allocateTransient(context->getDevice(), descriptorSetLayout, descriptorSetLayoutBindings);
+		transientFrameSerial = descriptorPool->getFrameSerial();
+		writeDescriptors(context, descriptorSets[0], context->getFrameIndex());
+	}
+	return getHandle(context->getFrameIndex());
+}
+
+void DescriptorSet::updateDynamicOffsets()
+{
+	dynamicOffsets.resize(dynamicDescriptors.size());
+	for (size_t i = 0; i < dynamicDescriptors.size(); i++)
+	{
+		dynamicOffsets[i] = dynamicDescriptors[i]->getDynamicOffset();
+	}
+}
+
 void DescriptorSet::bind(rhi::Context* rhiContext, rhi::GraphicsPipeline* rhiPipeline, uint32_t binding)
 {
 	Context* contextVk = reinterpret_cast<Context*>(rhiContext);
@@ -70,8 +147,10 @@ void DescriptorSet::bind(rhi::Context* rhiContext, rhi::GraphicsPipeline* rhiPip
 
 	VkPipelineBindPoint pipelineBindPoint = pipeline->getBindPoint();
 	VkPipelineLayout pipelineLayout = pipeline->getLayout();
+	updateDynamicOffsets();
 	commandBuffer->bindDescriptorSets(
-		pipelineBindPoint, pipelineLayout, binding, 1, &descriptorSet, 0, nullptr);
+		pipelineBindPoint, pipelineLayout, binding, 1, &getFrameHandle(contextVk),
+		static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
 }
 
 void DescriptorSet::bind(rhi::Context* rhiContext, rhi::ComputePipeline* rhiPipeline, uint32_t binding)
@@ -83,8 +162,10 @@ void DescriptorSet::bind(rhi::Context* rhiContext, rhi::ComputePipeline* rhiPipe
 
 	VkPipelineBindPoint pipelineBindPoint = pipeline->getBindPoint();
 	VkPipelineLayout pipelineLayout = pipeline->getLayout();
+	updateDynamicOffsets();
 	commandBuffer->bindDescriptorSets(
-		pipelineBindPoint, pipelineLayout, binding, 1, &descriptorSet, 0, nullptr);
+		pipelineBindPoint, pipelineLayout, binding, 1, &getFrameHandle(contextVk),
+		static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
 }
 
 void DescriptorSet::bind(rhi::Context* rhiContext, rhi::RayTracingPipeline* rhiPipeline, uint32_t binding)
@@ -96,12 +177,48 @@ void DescriptorSet::bind(rhi::Context* rhiContext, rhi::RayTracingPipeline* rhiP
 
 	VkPipelineBindPoint pipelineBindPoint = pipeline->getBindPoint();
 	VkPipelineLayout pipelineLayout = pipeline->getLayout();
+	updateDynamicOffsets();
 	commandBuffer->bindDescriptorSets(
-		pipelineBindPoint, pipelineLayout, binding, 1, &descriptorSet, 0, nullptr);
+		pipelineBindPoint, pipelineLayout, binding, 1, &getFrameHandle(contextVk),
+		static_cast<uint32_t>(dynamicOffsets.size()), dynamicOffsets.data());
+}
+
+void DescriptorSet::updateWriteDescriptorArray(rhi::DescriptorInfo& descriptorInfo, VkDescriptorSet descriptorSet, uint32_t binding, uint32_t frameIndex)
+{
+	rhi::DescriptorType descriptorType = descriptorInfo.getType();
+	ASSERT(descriptorType == rhi::DescriptorType::Combined_Image_Sampler || descriptorType == rhi::DescriptorType::Sampled_Image);
+
+	std::vector<rhi::Descriptor*>& arrayDescriptors = descriptorInfo.getArrayDescriptors();
+	if (arrayDescriptors.empty())
+	{
+		// Partially bound, nothing to write
+		return;
+	}
+
+	const size_t firstImageInfo = arrayImageInfos.size();
+	for (auto& descriptor : arrayDescriptors)
+	{
+		arrayImageInfos.push_back(*reinterpret_cast<VkDescriptorImageInfo*>(descriptor->getFrameDescriptorData(descriptorType, frameIndex)));
+	}
+
+	VkWriteDescriptorSet& writeDescriptorSet = writeDescriptorSets.emplace_back();
+	writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	writeDescriptorSet.dstSet = descriptorSet;
+	writeDescriptorSet.dstBinding = binding;
+	writeDescriptorSet.dstArrayElement = 0;
+	writeDescriptorSet.descriptorType = convertToVkDescriptorType(descriptorType);
+	writeDescriptorSet.descriptorCount = static_cast<uint32_t>(arrayDescriptors.size());
+	writeDescriptorSet.pImageInfo = &arrayImageInfos[firstImageInfo];
 }
 
-void DescriptorSet::updateWriteDescriptorSet(rhi::DescriptorInfo& descriptorInfo)
+void DescriptorSet::updateWriteDescriptorSet(rhi::DescriptorInfo& descriptorInfo, VkDescriptorSet descriptorSet, uint32_t binding, uint32_t frameIndex)
 {
+	if (descriptorInfo.isArray())
+	{
+		updateWriteDescriptorArray(descriptorInfo, descriptorSet, binding, frameIndex);
+		return;
+	}
+
 	rhi::DescriptorType descriptorType = descriptorInfo.getType();
 
 	switch (descriptorType)
@@ -111,7 +228,6 @@ void DescriptorSet::updateWriteDescriptorSet(rhi::DescriptorInfo& descriptorInfo
 	case rhi::DescriptorType::Sampled_Image:
 	case rhi::DescriptorType::Input_Attachment:
 	{
-		uint32_t binding = static_cast<uint32_t>(writeDescriptorSets.size());
 		VkWriteDescriptorSet& writeDescriptorSet = writeDescriptorSets.emplace_back();
 		writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		writeDescriptorSet.dstSet = descriptorSet;
@@ -119,12 +235,11 @@ void DescriptorSet::updateWriteDescriptorSet(rhi::DescriptorInfo& descriptorInfo
 		writeDescriptorSet.dstArrayElement = 0;
 		writeDescriptorSet.descriptorType = convertToVkDescriptorType(descriptorType);
 		writeDescriptorSet.descriptorCount = 1;
-		writeDescriptorSet.pImageInfo = reinterpret_cast<VkDescriptorImageInfo*>(descriptorInfo.getDescriptor()->getDescriptorData(descriptorType));
+		writeDescriptorSet.pImageInfo = reinterpret_cast<VkDescriptorImageInfo*>(descriptorInfo.getDescriptor()->getFrameDescriptorData(descriptorType, frameIndex));
 		break;
 	}
 	case rhi::DescriptorType::Storage_Image:
 	{
-		uint32_t binding = static_cast<uint32_t>(writeDescriptorSets.size());
 		VkWriteDescriptorSet& writeDescriptorSet = writeDescriptorSets.emplace_back();
 		writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		writeDescriptorSet.dstSet = descriptorSet;
@@ -132,7 +247,7 @@ void DescriptorSet::updateWriteDescriptorSet(rhi::DescriptorInfo& descriptorInfo
 		writeDescriptorSet.dstArrayElement = 0;
 		writeDescriptorSet.descriptorType = convertToVkDescriptorType(descriptorType);
 		writeDescriptorSet.descriptorCount = 1;
-		writeDescriptorSet.pImageInfo = reinterpret_cast<VkDescriptorImageInfo*>(descriptorInfo.getDescriptor()->getDescriptorData(descriptorType));
+		writeDescriptorSet.pImageInfo = reinterpret_cast<VkDescriptorImageInfo*>(descriptorInfo.getDescriptor()->getFrameDescriptorData(descriptorType, frameIndex));
 
 		break;
 	}
@@ -142,7 +257,6 @@ void DescriptorSet::updateWriteDescriptorSet(rhi::DescriptorInfo& descriptorInfo
 	case rhi::DescriptorType::Uniform_Buffer_Dynamic:
 	case rhi::DescriptorType::Storage_Buffer_Dynamic:
 	{
-		uint32_t binding = static_cast<uint32_t>(writeDescriptorSets.size());
 		VkWriteDescriptorSet& writeDescriptorSet = writeDescriptorSets.emplace_back();
 		writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		writeDescriptorSet.dstSet = descriptorSet;
@@ -150,13 +264,12 @@ void DescriptorSet::updateWriteDescriptorSet(rhi::DescriptorInfo& descriptorInfo
 		writeDescriptorSet.dstArrayElement = 0;
 		writeDescriptorSet.descriptorType = convertToVkDescriptorType(descriptorType);
 		writeDescriptorSet.descriptorCount = 1;
-		writeDescriptorSet.pBufferInfo = reinterpret_cast<VkDescriptorBufferInfo*>(descriptorInfo.getDescriptor()->getDescriptorData(descriptorType));
+		writeDescriptorSet.pBufferInfo = reinterpret_cast<VkDescriptorBufferInfo*>(descriptorInfo.getDescriptor()->getFrameDescriptorData(descriptorType, frameIndex));
 
 		break;
 	}
 	case rhi::DescriptorType::Storage_Buffer:
 	{
-		uint32_t binding = static_cast<uint32_t>(writeDescriptorSets.size());
 		VkWriteDescriptorSet& writeDescriptorSet = writeDescriptorSets.emplace_back();
 		writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		writeDescriptorSet.dstSet = descriptorSet;
@@ -164,16 +277,15 @@ void DescriptorSet::updateWriteDescriptorSet(rhi::DescriptorInfo& descriptorInfo
 		writeDescriptorSet.dstArrayElement = 0;
 		writeDescriptorSet.descriptorType = convertToVkDescriptorType(descriptorType);
 		writeDescriptorSet.descriptorCount = 1;
-		writeDescriptorSet.pBufferInfo = reinterpret_cast<VkDescriptorBufferInfo*>(descriptorInfo.getDescriptor()->getDescriptorData(descriptorType));
+		writeDescriptorSet.pBufferInfo = reinterpret_cast<VkDescriptorBufferInfo*>(descriptorInfo.getDescriptor()->getFrameDescriptorData(descriptorType, frameIndex));
 
 		break;
 	}
 	case rhi::DescriptorType::Acceleration_structure:
 	{
-		uint32_t binding = static_cast<uint32_t>(writeDescriptorSets.size());
 		VkWriteDescriptorSet& writeDescriptorSet = writeDescriptorSets.emplace_back();
 		writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		writeDescriptorSet.pNext = descriptorInfo.getDescriptor()->getDescriptorData(descriptorType);
+		writeDescriptorSet.pNext = descriptorInfo.getDescriptor()->getFrameDescriptorData(descriptorType, frameIndex);
 		writeDescriptorSet.dstSet = descriptorSet;
 		writeDescriptorSet.dstBinding = binding;
 		writeDescriptorSet.dstArrayElement = 0;
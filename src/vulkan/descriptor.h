@@ -27,14 +27,32 @@ public:
 
 	void bind(rhi::Context* context, rhi::RayTracingPipeline* pipeline, uint32_t binding) override;
 
-	void updateWriteDescriptorSet(rhi::DescriptorInfo& descriptor);
+	void updateWriteDescriptorSet(rhi::DescriptorInfo& descriptor, VkDescriptorSet descriptorSet, uint32_t binding, uint32_t frameIndex);
 
-	inline VkDescriptorSet& getHandle() { return descriptorSet; }
+	inline VkDescriptorSet& getHandle(uint32_t frameIndex = 0) { return descriptorSets[frameIndex % descriptorSets.size()]; }
 
-	inline VkDescriptorSetLayout getLayout() { return descriptorSetLayout.getHandle(); }
+	inline VkDescriptorSetLayout getLayout() { return descriptorSetLayout; }
 private:
-	VkDescriptorSet descriptorSet;
-	handle::DescriptorSetLayout descriptorSetLayout;
+	VkDescriptorSet& getFrameHandle(Context* context);
+
+	void writeDescriptors(Context* context, VkDescriptorSet descriptorSet, uint32_t frameIndex);
+
+	void updateWriteDescriptorArray(rhi::DescriptorInfo& descriptor, VkDescriptorSet descriptorSet, uint32_t binding, uint32_t frameIndex);
+
+	// Gathers the current offsets of the dynamic descriptors, in binding order
+	void updateDynamicOffsets();
+
+	// One set per frame in flight when any descriptor is per frame, otherwise a single set
+	std::vector<VkDescriptorSet> descriptorSets;
+	// Owned by the layout cache of the context
+	VkDescriptorSetLayout descriptorSetLayout = VK_NULL_HANDLE;
+	// Kept for the pools, which are sized by the bindings of the layout
+	std::vector<VkDescriptorSetLayoutBinding> descriptorSetLayoutBindings;
+	// Serial of the descriptor pool frame the transient set was allocated in
+	uint64_t transientFrameSerial = UINT64_MAX;
 	std::vector<VkWriteDescriptorSet> writeDescriptorSets;
+	std::vector<VkDescriptorImageInfo> arrayImageInfos;
+	std::vector<rhi::Descriptor*> dynamicDescriptors;
+	std::vector<uint32_t> dynamicOffsets;
 };
 }
\ No newline at end of file
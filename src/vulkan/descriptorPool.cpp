@@ -1,63 +1,294 @@
+#include <algorithm>
+#include <cstdlib>
 #include "vulkan/descriptorPool.h"
 
 namespace vk
 {
-void DescriptorPool::init(VkDevice device)
+namespace
 {
-	// TODO
-	std::vector<VkDescriptorPoolSize> descriptorPoolSizes;
+// Descriptors of a transient pool per set it holds, enough for the sets the passes bind
+const VkDescriptorPoolSize kTransientSetSizes[] =
+{
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 },
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 2 },
+	{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 2 },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2 },
+	{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1 },
+	{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1 },
+	{ VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 1 },
+};
+
+bool isPoolFull(VkResult result)
+{
+	return result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL;
+}
+
+// Descriptors of a single set of the bindings, one entry per type
+std::vector<VkDescriptorPoolSize> getSetSizes(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+	std::vector<VkDescriptorPoolSize> setSizes;
+	for (auto& binding : bindings)
+	{
+		auto found = std::find_if(setSizes.begin(), setSizes.end(),
+			[&binding](const VkDescriptorPoolSize& size) { return size.type == binding.descriptorType; });
+		if (found != setSizes.end())
+		{
+			found->descriptorCount += binding.descriptorCount;
+		}
+		else
+		{
+			setSizes.push_back({ binding.descriptorType, binding.descriptorCount });
+		}
+	}
+	return setSizes;
+}
+}
+
+DescriptorPool::DescriptorPool()
+	: poolCount(0)
+	, exhaustedCount(0)
+	, frameIndex(0)
+	, frameSerial(0)
+{
+
+}
+
+void DescriptorPool::init(VkDevice device, uint32_t framesInFlight)
+{
+	// Pools are created on demand, the first sets of a layout create its first pool
+	transientFrames.clear();
+	transientFrames.resize(framesInFlight);
+	frameIndex = 0;
+	frameSerial = 0;
+}
+
+void DescriptorPool::destroy(VkDevice device)
+{
+	LOGD("Descriptor pools: %u for %zu layouts, %u allocations found a pool exhausted", poolCount, layoutPools.size(), exhaustedCount);
+
+	// Destroying a pool frees its sets
+	for (auto& entry : layoutPools)
 	{
-		auto& descriptorPoolSize = descriptorPoolSizes.emplace_back();
-		descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		descriptorPoolSize.descriptorCount = 1000;
+		for (auto& pool : entry.second.pools)
+		{
+			pool->pool.destroy(device);
+		}
 	}
+	layoutPools.clear();
+	setPools.clear();
 
+	for (auto& frame : transientFrames)
 	{
-		auto& descriptorPoolSize = descriptorPoolSizes.emplace_back();
-		descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		descriptorPoolSize.descriptorCount = 1000;
+		for (auto& pool : frame.pools)
+		{
+			pool->destroy(device);
+		}
 	}
+	transientFrames.clear();
+
+	poolCount = 0;
+	exhaustedCount = 0;
+}
 
+void DescriptorPool::beginFrame(VkDevice device, uint32_t frameIndex)
+{
+	this->frameIndex = frameIndex;
+	frameSerial++;
+
+	TransientFrame& frame = transientFrames[frameIndex];
+	for (size_t i = 0; i < frame.pools.size() && i <= frame.currentPool; i++)
 	{
-		auto& descriptorPoolSize = descriptorPoolSizes.emplace_back();
-		descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-		descriptorPoolSize.descriptorCount = 1000;
+		VKCALL(frame.pools[i]->reset(device));
 	}
+	frame.currentPool = 0;
+}
 
+VkDescriptorSet DescriptorPool::allocate(VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+	LayoutPools& entry = layoutPools[layout];
+	if (entry.pools.empty())
 	{
-		auto& descriptorPoolSize = descriptorPoolSizes.emplace_back();
-		descriptorPoolSize.type = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
-		descriptorPoolSize.descriptorCount = 1000;
+		entry.setSizes = getSetSizes(bindings);
+		for (auto& binding : bindings)
+		{
+			entry.hasArrays |= binding.descriptorCount > 1;
+		}
 	}
-	
+
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptorSetAllocateInfo.descriptorSetCount = 1;
+	descriptorSetAllocateInfo.pSetLayouts = &layout;
+
+	// The newest pool is the most likely to have room, freed sets leave room in older ones
+	VkDescriptorSet descriptorSetOut = VK_NULL_HANDLE;
+	Pool* pool = nullptr;
+	for (auto it = entry.pools.rbegin(); it != entry.pools.rend() && descriptorSetOut == VK_NULL_HANDLE; it++)
+	{
+		Pool* candidate = it->get();
+		if (candidate->exhausted || candidate->liveSets == candidate->capacity)
+		{
+			continue;
+		}
+
+		descriptorSetAllocateInfo.descriptorPool = candidate->pool.getHandle();
+		VkResult result = candidate->pool.allocateDescriptorSets(device, descriptorSetAllocateInfo, &descriptorSetOut);
+		if (result == VK_SUCCESS)
+		{
+			pool = candidate;
+		}
+		else
+		{
+			ASSERT(isPoolFull(result));
+			candidate->exhausted = true;
+			exhaustedCount++;
+			descriptorSetOut = VK_NULL_HANDLE;
+		}
+	}
+
+	if (pool == nullptr)
+	{
+		pool = createPool(device, entry);
+		descriptorSetAllocateInfo.descriptorPool = pool->pool.getHandle();
+		VKCALL(pool->pool.allocateDescriptorSets(device, descriptorSetAllocateInfo, &descriptorSetOut));
+	}
+
+	ASSERT(descriptorSetOut != VK_NULL_HANDLE);
+
+	pool->liveSets++;
+	setPools[descriptorSetOut] = pool;
+	return descriptorSetOut;
+}
+
+VkDescriptorSet DescriptorPool::allocateTransient(VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+{
+	TransientFrame& frame = transientFrames[frameIndex];
+
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptorSetAllocateInfo.descriptorSetCount = 1;
+	descriptorSetAllocateInfo.pSetLayouts = &layout;
+
+	for (;;)
+	{
+		const bool newPool = frame.currentPool == frame.pools.size();
+		handle::DescriptorPool* pool = newPool ? createTransientPool(device, frame, bindings) : frame.pools[frame.currentPool].get();
+
+		VkDescriptorSet descriptorSetOut = VK_NULL_HANDLE;
+		descriptorSetAllocateInfo.descriptorPool = pool->getHandle();
+		VkResult result = pool->allocateDescriptorSets(device, descriptorSetAllocateInfo, &descriptorSetOut);
+		if (result == VK_SUCCESS)
+		{
+			return descriptorSetOut;
+		}
+
+		if (newPool)
+		{
+			// The new pool was sized for this set, only running out of device memory gets here
+			LOGE("Transient descriptor set allocation from a new pool failed: %d", result);
+			exit(1);
+		}
+
+		ASSERT(isPoolFull(result));
+		exhaustedCount++;
+		frame.currentPool++;
+	}
+}
+
+void DescriptorPool::free(VkDevice device, std::vector<VkDescriptorSet>& sets)
+{
+	for (auto& set : sets)
+	{
+		auto found = setPools.find(set);
+		if (found == setPools.end())
+		{
+			continue;
+		}
+
+		Pool* pool = found->second;
+		VKCALL(pool->pool.freeDescriptorSets(device, 1, &set));
+		pool->liveSets--;
+		pool->exhausted = false;
+		setPools.erase(found);
+	}
+	sets.clear();
+}
+
+DescriptorPool::Pool* DescriptorPool::createPool(VkDevice device, LayoutPools& entry)
+{
+	// Layouts with arrays, like the bindless textures, have few sets of many descriptors each
+	const uint32_t minSets = entry.hasArrays ? 1 : kMinDescriptorPoolSets;
+	const uint32_t capacity = entry.pools.empty() ? minSets :
+		std::min(entry.pools.back()->capacity * 2, kMaxDescriptorPoolSets);
+
+	std::vector<VkDescriptorPoolSize> descriptorPoolSizes = entry.setSizes;
+	for (auto& descriptorPoolSize : descriptorPoolSizes)
+	{
+		descriptorPoolSize.descriptorCount *= capacity;
+	}
+
+	if (descriptorPoolSizes.empty())
+	{
+		// Sets without bindings, a pool still needs a size
+		descriptorPoolSizes.push_back({ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 });
+	}
+
 	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
 	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	descriptorPoolCreateInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
 	descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
 	descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
-	descriptorPoolCreateInfo.maxSets = 5000;
+	descriptorPoolCreateInfo.maxSets = capacity;
 
-	VKCALL(descriptorPool.init(device, descriptorPoolCreateInfo));
-}
+	Pool* pool = entry.pools.emplace_back(std::make_unique<Pool>()).get();
+	VKCALL(pool->pool.init(device, descriptorPoolCreateInfo));
+	pool->capacity = capacity;
+	poolCount++;
 
-void DescriptorPool::destroy(VkDevice device)
-{
-	descriptorPool.freeDescriptorSets(device, static_cast<uint32_t>(descriptorSets.size()), descriptorSets.data());
-	descriptorSets.clear();
-	descriptorPool.destroy(device);
+	if (entry.pools.size() > 1)
+	{
+		LOGD("Descriptor pool %zu of a layout created for %u sets", entry.pools.size(), capacity);
+	}
+	return pool;
 }
 
-VkDescriptorSet DescriptorPool::allocate(VkDevice device, VkDescriptorSetAllocateInfo& allocateInfo)
+handle::DescriptorPool* DescriptorPool::createTransientPool(VkDevice device, TransientFrame& frame, const std::vector<VkDescriptorSetLayoutBinding>& bindings)
 {
-	ASSERT(descriptorPool.valid());
+	std::vector<VkDescriptorPoolSize> setSizes(std::begin(kTransientSetSizes), std::end(kTransientSetSizes));
 
-	VkDescriptorSet descriptorSetOut = descriptorSets.emplace_back();
-	allocateInfo.descriptorPool = descriptorPool.getHandle();
+	// A set needing more than the table gets a pool sized for it, the sets after it fit as well
+	for (auto& bindingSize : getSetSizes(bindings))
+	{
+		auto found = std::find_if(setSizes.begin(), setSizes.end(),
+			[&bindingSize](const VkDescriptorPoolSize& size) { return size.type == bindingSize.type; });
+		if (found == setSizes.end())
+		{
+			setSizes.push_back(bindingSize);
+		}
+		else if (found->descriptorCount < bindingSize.descriptorCount)
+		{
+			LOGD("Transient descriptor pool grown to %u descriptors of type %d per set", bindingSize.descriptorCount, bindingSize.type);
+			found->descriptorCount = bindingSize.descriptorCount;
+		}
+	}
 
-	VKCALL(descriptorPool.allocateDescriptorSets(device, allocateInfo, &descriptorSetOut));
+	std::vector<VkDescriptorPoolSize> descriptorPoolSizes;
+	for (auto& setSize : setSizes)
+	{
+		descriptorPoolSizes.push_back({ setSize.type, setSize.descriptorCount * kTransientDescriptorPoolSets });
+	}
 
-	ASSERT(descriptorSetOut != VK_NULL_HANDLE);
+	// Sets are never freed one by one, the pool is reset with its frame
+	VkDescriptorPoolCreateInfo descriptorPoolCreateInfo = {};
+	descriptorPoolCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(descriptorPoolSizes.size());
+	descriptorPoolCreateInfo.pPoolSizes = descriptorPoolSizes.data();
+	descriptorPoolCreateInfo.maxSets = kTransientDescriptorPoolSets;
 
-	return descriptorSetOut;
+	handle::DescriptorPool* pool = frame.pools.emplace_back(std::make_unique<handle::DescriptorPool>()).get();
+	VKCALL(pool->init(device, descriptorPoolCreateInfo));
+	poolCount++;
+	return pool;
+}
 }
-}
\ No newline at end of file
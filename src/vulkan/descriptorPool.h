@@ -1,21 +1,81 @@
 #pragma once
 
+#include <memory>
+#include <unordered_map>
 #include <vector>
 #include "vulkan/vk_wrapper.h"
 
 namespace vk
 {
+// Sets of the first pool of a layout, every further pool of it holds twice as many up to the maximum
+const uint32_t kMinDescriptorPoolSets = 16;
+const uint32_t kMaxDescriptorPoolSets = 1024;
+// Sets of a transient pool, a frame that needs more chains another pool
+const uint32_t kTransientDescriptorPoolSets = 256;
+
+// Allocates descriptor sets from pools sized for their layout. A layout gets a new pool whenever its
+// pools are full, so large scenes only cost more pools, and sets of one layout never fragment a pool.
+// Transient sets come from pools of the frame in flight that are reset as a whole once its fence
+// has signaled, instead of being freed one by one.
 class DescriptorPool
 {
 public:
-	void init(VkDevice device);
+	DescriptorPool();
+
+	void init(VkDevice device, uint32_t framesInFlight);
 
 	void destroy(VkDevice device);
 
-	VkDescriptorSet allocate(VkDevice device, VkDescriptorSetAllocateInfo& allocateInfo);
+	// Must be called once the frame fence of the frame index has signaled
+	void beginFrame(VkDevice device, uint32_t frameIndex);
+
+	VkDescriptorSet allocate(VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+	// Valid until the frame index comes around again
+	VkDescriptorSet allocateTransient(VkDevice device, VkDescriptorSetLayout layout, const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+	// The sets must no longer be in use by the GPU
+	void free(VkDevice device, std::vector<VkDescriptorSet>& sets);
+
+	// Bumped by beginFrame, a transient set allocated with an older serial is gone
+	uint64_t getFrameSerial() const { return frameSerial; }
 
 private:
-	handle::DescriptorPool descriptorPool;
-	std::vector<VkDescriptorSet> descriptorSets;
+	struct Pool
+	{
+		handle::DescriptorPool pool;
+		uint32_t capacity = 0;
+		uint32_t liveSets = 0;
+		// Set when an allocation failed below the capacity, cleared by the next free
+		bool exhausted = false;
+	};
+
+	struct LayoutPools
+	{
+		// Descriptors of a single set
+		std::vector<VkDescriptorPoolSize> setSizes;
+		bool hasArrays = false;
+		std::vector<std::unique_ptr<Pool>> pools;
+	};
+
+	struct TransientFrame
+	{
+		std::vector<std::unique_ptr<handle::DescriptorPool>> pools;
+		size_t currentPool = 0;
+	};
+
+	Pool* createPool(VkDevice device, LayoutPools& entry);
+
+	// Holds kTransientDescriptorPoolSets sets of the larger of the default sizes and the given bindings
+	handle::DescriptorPool* createTransientPool(VkDevice device, TransientFrame& frame, const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+
+	std::unordered_map<VkDescriptorSetLayout, LayoutPools> layoutPools;
+	std::unordered_map<VkDescriptorSet, Pool*> setPools;
+	uint32_t poolCount;
+	uint32_t exhaustedCount;
+
+	std::vector<TransientFrame> transientFrames;
+	uint32_t frameIndex;
+	uint64_t frameSerial;
 };
-}
\ No newline at end of file
+}
@@ -0,0 +1,66 @@
+#include "vulkan/destructionQueue.h"
+#include "platform/utils.h"
+
+namespace vk
+{
+DestructionQueue::DestructionQueue()
+	: retiredCount(0)
+{
+
+}
+
+void DestructionQueue::init(uint32_t framesInFlight)
+{
+	frames.resize(framesInFlight);
+}
+
+void DestructionQueue::destroy()
+{
+	retireAll();
+
+	LOGD("Destruction queue: %llu deferred destructions", static_cast<unsigned long long>(retiredCount));
+	frames.clear();
+}
+
+void DestructionQueue::push(uint32_t frameIndex, std::function<void()>&& destruction)
+{
+	ASSERT(frameIndex < frames.size());
+	frames[frameIndex].push_back(std::move(destruction));
+}
+
+void DestructionQueue::retire(uint32_t frameIndex)
+{
+	ASSERT(frameIndex < frames.size());
+
+	// A destruction may release other resources in turn and queue them, those go to the next round
+	std::vector<std::function<void()>> destructions;
+	destructions.swap(frames[frameIndex]);
+
+	for (auto& destruction : destructions)
+	{
+		destruction();
+	}
+	retiredCount += destructions.size();
+}
+
+void DestructionQueue::retireAll()
+{
+	while (getPendingCount() != 0)
+	{
+		for (uint32_t frameIndex = 0; frameIndex < frames.size(); frameIndex++)
+		{
+			retire(frameIndex);
+		}
+	}
+}
+
+size_t DestructionQueue::getPendingCount() const
+{
+	size_t count = 0;
+	for (auto& frame : frames)
+	{
+		count += frame.size();
+	}
+	return count;
+}
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace vk
+{
+// Holds resource destructions back until the GPU is done with them. A destruction is queued
+// under the frame index being recorded and runs once the fence of that frame has signaled again,
+// by then every frame that could still reference the resource has finished.
+class DestructionQueue
+{
+public:
+	DestructionQueue();
+
+	void init(uint32_t framesInFlight);
+
+	// Runs whatever is still queued, the device must be idle
+	void destroy();
+
+	void push(uint32_t frameIndex, std::function<void()>&& destruction);
+
+	// Must be called once the frame fence of the frame index has signaled
+	void retire(uint32_t frameIndex);
+
+	// Must only be called while the device is idle
+	void retireAll();
+
+	size_t getPendingCount() const;
+
+private:
+	std::vector<std::vector<std::function<void()>>> frames;
+	uint64_t retiredCount;
+};
+}
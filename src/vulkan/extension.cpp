@@ -38,6 +38,8 @@ InstanceExtension::InstanceExtension(const char* extensionName)
 
 // VK_KHR_get_physical_device_properties2
 PFN_vkGetPhysicalDeviceProperties2KHR vkGetPhysicalDeviceProperties2KHR;
+PFN_vkGetPhysicalDeviceMemoryProperties2KHR vkGetPhysicalDeviceMemoryProperties2KHR;
+PFN_vkGetPhysicalDeviceFeatures2KHR vkGetPhysicalDeviceFeatures2KHR;
 PhysicalDeviceProperties2Extension::PhysicalDeviceProperties2Extension()
     : InstanceExtension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)
 {
@@ -49,6 +51,8 @@ void PhysicalDeviceProperties2Extension::fetch(VkInstance instance)
     if (support)
     {
         GET_INSTANCE_PROC(instance, vkGetPhysicalDeviceProperties2KHR);
+        GET_INSTANCE_PROC(instance, vkGetPhysicalDeviceMemoryProperties2KHR);
+        GET_INSTANCE_PROC(instance, vkGetPhysicalDeviceFeatures2KHR);
     }
 }
 
@@ -91,6 +95,10 @@ DeviceExtension* ExtensionFactory::createDeviceExtension(ExtensionName extension
         return new DescriptorIndexingExtension();
     case ExtensionName::Spirv_1_4:
         return new Spirv_1_4_Extension();
+    case ExtensionName::TimelineSemaphore:
+        return new TimelineSemaphoreExtension();
+    case ExtensionName::MemoryBudget:
+        return new MemoryBudgetExtension();
     default:
         UNREACHABLE();
         return nullptr;
@@ -280,36 +288,41 @@ DescriptorIndexingExtension::DescriptorIndexingExtension()
     : DeviceExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)
     , descriptorIndexingFeatures()
     , descriptorIndexingProperties()
+    , bindlessTextures(false)
 {
 }
 
+void DescriptorIndexingExtension::query(VkPhysicalDevice physicalDevice)
+{
+    if (!support || vkGetPhysicalDeviceFeatures2KHR == nullptr)
+    {
+        return;
+    }
+
+    VkPhysicalDeviceDescriptorIndexingFeatures supportedFeatures = {};
+    supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+    VkPhysicalDeviceFeatures2 physicalDeviceFeatures2 = {};
+    physicalDeviceFeatures2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+    physicalDeviceFeatures2.pNext = &supportedFeatures;
+    vkGetPhysicalDeviceFeatures2KHR(physicalDevice, &physicalDeviceFeatures2);
+
+    // What the bindless material textures need, a partially bound array indexed per material.
+    // Enabling a feature the device lacks fails device creation, so only the supported ones are requested
+    descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = supportedFeatures.shaderSampledImageArrayNonUniformIndexing;
+    descriptorIndexingFeatures.descriptorBindingPartiallyBound = supportedFeatures.descriptorBindingPartiallyBound;
+    descriptorIndexingFeatures.runtimeDescriptorArray = supportedFeatures.runtimeDescriptorArray;
+
+    bindlessTextures = descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing &&
+        descriptorIndexingFeatures.descriptorBindingPartiallyBound &&
+        descriptorIndexingFeatures.runtimeDescriptorArray;
+}
+
 void DescriptorIndexingExtension::feature(void**& chain)
 {
     if (support)
     {
         descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
-        /*
-        descriptorIndexingFeatures.shaderInputAttachmentArrayDynamicIndexing = true;
-        descriptorIndexingFeatures.shaderUniformTexelBufferArrayDynamicIndexing = true;
-        descriptorIndexingFeatures.shaderStorageTexelBufferArrayDynamicIndexing = true;
-        descriptorIndexingFeatures.shaderUniformBufferArrayNonUniformIndexing = true;
-        descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = true;
-        descriptorIndexingFeatures.shaderStorageBufferArrayNonUniformIndexing = true;
-        descriptorIndexingFeatures.shaderStorageImageArrayNonUniformIndexing = true;
-        descriptorIndexingFeatures.shaderInputAttachmentArrayNonUniformIndexing = true;
-        descriptorIndexingFeatures.shaderUniformTexelBufferArrayNonUniformIndexing = true;
-        descriptorIndexingFeatures.shaderStorageTexelBufferArrayNonUniformIndexing = true;
-        descriptorIndexingFeatures.descriptorBindingUniformBufferUpdateAfterBind = true;
-        descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = true;
-        descriptorIndexingFeatures.descriptorBindingStorageImageUpdateAfterBind = true;
-        descriptorIndexingFeatures.descriptorBindingStorageBufferUpdateAfterBind = true;
-        descriptorIndexingFeatures.descriptorBindingUniformTexelBufferUpdateAfterBind = true;
-        descriptorIndexingFeatures.descriptorBindingStorageTexelBufferUpdateAfterBind = true;
-        descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = true;
-        descriptorIndexingFeatures.descriptorBindingPartiallyBound = true;
-        descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount = true;
-        descriptorIndexingFeatures.runtimeDescriptorArray = true;
-        */
         *chain = &descriptorIndexingFeatures;
         chain = &descriptorIndexingFeatures.pNext;
     }
@@ -331,5 +344,41 @@ Spirv_1_4_Extension::Spirv_1_4_Extension()
     : DeviceExtension(VK_KHR_SPIRV_1_4_EXTENSION_NAME)
 {
 
+}
+
+// VK_KHR_timeline_semaphore
+PFN_vkGetSemaphoreCounterValueKHR vkGetSemaphoreCounterValueKHR;
+PFN_vkWaitSemaphoresKHR vkWaitSemaphoresKHR;
+
+TimelineSemaphoreExtension::TimelineSemaphoreExtension()
+    : DeviceExtension(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME)
+    , timelineSemaphoreFeatures()
+{
+}
+
+void TimelineSemaphoreExtension::feature(void**& chain)
+{
+    if (support)
+    {
+        timelineSemaphoreFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+        timelineSemaphoreFeatures.timelineSemaphore = true;
+        *chain = &timelineSemaphoreFeatures;
+        chain = &timelineSemaphoreFeatures.pNext;
+    }
+}
+
+void TimelineSemaphoreExtension::fetch(VkDevice device)
+{
+    if (support)
+    {
+        GET_DEVICE_PROC(device, vkGetSemaphoreCounterValueKHR);
+        GET_DEVICE_PROC(device, vkWaitSemaphoresKHR);
+    }
+}
+
+// VK_EXT_memory_budget
+MemoryBudgetExtension::MemoryBudgetExtension()
+    : DeviceExtension(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)
+{
 }
 }
\ No newline at end of file
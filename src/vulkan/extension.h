@@ -17,7 +17,9 @@ enum class ExtensionName
     PhysicalDeviceProperties2Extension,
     RayQuery,
     DescriptorIndexing,
-    Spirv_1_4
+    Spirv_1_4,
+    TimelineSemaphore,
+    MemoryBudget
 
 };
 
@@ -31,6 +33,8 @@ public:
     void check(std::vector<VkExtensionProperties>& supportedExtensions);
 
     void add(std::vector<const char*>& requestedExtensions);
+
+    bool isSupported() const { return support; }
 private:
     const char* extensionName;
 protected:
@@ -47,6 +51,8 @@ public:
 
 // VK_KHR_get_physical_device_properties2
 extern PFN_vkGetPhysicalDeviceProperties2KHR vkGetPhysicalDeviceProperties2KHR;
+extern PFN_vkGetPhysicalDeviceMemoryProperties2KHR vkGetPhysicalDeviceMemoryProperties2KHR;
+extern PFN_vkGetPhysicalDeviceFeatures2KHR vkGetPhysicalDeviceFeatures2KHR;
 class PhysicalDeviceProperties2Extension : public InstanceExtension
 {
 public:
@@ -60,6 +66,9 @@ class DeviceExtension : public Extension
 public:
     DeviceExtension(const char* extensionName);
 
+    // Reads what the device supports before feature chains what gets enabled
+    virtual void query(VkPhysicalDevice physicalDevice) {}
+
     virtual void feature(void** &chain) {}
 
     virtual void fetch(VkDevice device) {}
@@ -178,12 +187,18 @@ class DescriptorIndexingExtension : public DeviceExtension
 public:
     DescriptorIndexingExtension();
 
+    void query(VkPhysicalDevice physicalDevice) override;
+
     void feature(void**& chain) override;
 
     void property(std::map<VkStructureType, void*>& propertyMap, void**& chain) override;
+
+    // Every feature the bindless material textures need is supported and enabled
+    bool supportsBindlessTextures() const { return bindlessTextures; }
 private:
     VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures;
     VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties;
+    bool bindlessTextures;
 };
 
 // VK_KHR_spirv_1_4
@@ -192,4 +207,27 @@ class Spirv_1_4_Extension : public DeviceExtension
 public:
     Spirv_1_4_Extension();
 };
+
+// VK_KHR_timeline_semaphore
+extern PFN_vkGetSemaphoreCounterValueKHR vkGetSemaphoreCounterValueKHR;
+extern PFN_vkWaitSemaphoresKHR vkWaitSemaphoresKHR;
+
+class TimelineSemaphoreExtension : public DeviceExtension
+{
+public:
+    TimelineSemaphoreExtension();
+
+    void feature(void**& chain) override;
+
+    void fetch(VkDevice device) override;
+private:
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures;
+};
+
+// VK_EXT_memory_budget, queried through vkGetPhysicalDeviceMemoryProperties2KHR
+class MemoryBudgetExtension : public DeviceExtension
+{
+public:
+    MemoryBudgetExtension();
+};
 }
\ No newline at end of file
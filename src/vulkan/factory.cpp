@@ -18,7 +18,7 @@ rhi::RenderTarget* Context::createRenderTarget(rhi::RenderTargetType type, uint1
         return new SurfaceRenderTarget(width, height);
     case rhi::RenderTargetType::Compute:
     case rhi::RenderTargetType::RayTracing:
-        return new NullRenderTarget(width, height);
+        return new NullRenderTarget(type, width, height);
     default:
         UNREACHABLE();
         return nullptr;
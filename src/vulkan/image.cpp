@@ -1,6 +1,7 @@
 #include "vulkan/context.h"
 #include "vulkan/image.h"
 #include "vulkan/transition.h"
+#include "vulkan/memoryTracker.h"
 
 namespace vk
 {
@@ -63,16 +64,38 @@ Image::Image()
     , format(VK_FORMAT_UNDEFINED)
     , subresourceRange({})
     , imageLayout(ImageLayout::Undefined)
+    , imageUsage(0)
+    , aliasedMemory(nullptr)
+    , aliasingBarrierPending(false)
+    , memoryTrackingId(0)
 {
 
 }
 
-void Image::destroy(VkDevice device)
+void Image::destroy(Context* context)
 {
-    memory.destroy(device);
+    VkDevice device = context->getDevice();
     sampler.destroy(device);
     destroyImageView(device);
     destroyImage(device);
+
+    if (aliasedMemory != nullptr)
+    {
+        if (--aliasedMemory->imageCount == 0)
+        {
+            context->getMemoryAllocator()->free(device, aliasedMemory->allocation);
+            context->getMemoryTracker()->untrack(aliasedMemory->memoryTrackingId);
+            delete aliasedMemory;
+        }
+        aliasedMemory = nullptr;
+        allocation = Allocation();
+        return;
+    }
+
+    context->getMemoryAllocator()->free(device, allocation);
+
+    context->getMemoryTracker()->untrack(memoryTrackingId);
+    memoryTrackingId = 0;
 }
 
 bool Image::createImageView(VkDevice device, VkFormat format, VkImageAspectFlags imageAspectFlags)
@@ -131,9 +154,26 @@ bool Image::createImage(Context* context,
                         VkExtent3D extent,
                         VkImageUsageFlags imageUsage,
                         VkMemoryPropertyFlags memoryProperty)
+{
+	if (!createImageHandle(context, format, mipLevels, layers, samples, extent, imageUsage))
+	{
+		return false;
+	}
+
+	return bindMemory(context, memoryProperty);
+}
+
+bool Image::createImageHandle(Context* context,
+                              VkFormat format,
+                              uint32_t mipLevels,
+                              uint32_t layers,
+                              uint32_t samples,
+                              VkExtent3D extent,
+                              VkImageUsageFlags imageUsage)
 {
 	this->format = format;
     this->samples = samples;
+	this->imageUsage = imageUsage;
 
 	// Create optimal tiled target image
 	VkImageCreateInfo imageCreateInfo = {};
@@ -152,36 +192,43 @@ bool Image::createImage(Context* context,
 
 	VKCALL(image.init(context->getDevice(), imageCreateInfo));
 
-	VkMemoryRequirements memRequirements;
-	image.getMemoryRequirements(context->getDevice(), &memRequirements);
+	return true;
+}
+
+bool Image::bindMemory(Context* context, VkMemoryPropertyFlags memoryProperty)
+{
+	VkMemoryRequirements memRequirements = getMemoryRequirements(context->getDevice());
+	const MemoryUsage memoryUsage = (imageUsage & VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0 ? MemoryUsage::LazilyAllocated : MemoryUsage::GpuOnly;
 
-	VkMemoryAllocateInfo memoryAllocateInfo = {};
-	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memoryAllocateInfo.pNext = nullptr;
-	memoryAllocateInfo.allocationSize = memRequirements.size;
-	memoryAllocateInfo.memoryTypeIndex = getMemoryTypeIndex(context->getPhysicalDevice(),memRequirements.memoryTypeBits, memoryProperty);
+	if (!context->getMemoryAllocator()->allocate(context->getDevice(), memRequirements, memoryProperty, memoryUsage, 0, ResourceType::Optimal, &allocation))
+	{
+		LOGE("Failed to allocate image memory");
+		return false;
+	}
+	VKCALL(image.bindMemory(context->getDevice(), allocation.memory, allocation.offset));
 
-	VKCALL(memory.allocate(context->getDevice(), memoryAllocateInfo));
-	VKCALL(image.bindMemory(context->getDevice(), memory));
+	memoryTrackingId = context->getMemoryTracker()->track(MemoryTracker::getImageCategory(imageUsage), memoryOwner, allocation.size);
 
 	return true;
 }
 
-uint32_t Image::getMemoryTypeIndex(VkPhysicalDevice physicalDevice, const uint32_t memoryTypeBits, const VkMemoryPropertyFlags memoryProperty)
+void Image::bindAliasedMemory(Context* context, AliasedMemory* aliasedMemory)
 {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+	ASSERT(image.valid() && aliasedMemory->allocation.valid());
 
-    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-    {
-        if ((memoryTypeBits & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & memoryProperty) == memoryProperty)
-        {
-            return i;
-        }
-    }
+	// The aliased memory is tracked once for all images bound to it
+	this->aliasedMemory = aliasedMemory;
+	aliasedMemory->imageCount++;
+	allocation = aliasedMemory->allocation;
+
+	VKCALL(image.bindMemory(context->getDevice(), allocation.memory, allocation.offset));
+}
 
-    UNREACHABLE();
-    return 0;
+VkMemoryRequirements Image::getMemoryRequirements(VkDevice device)
+{
+	VkMemoryRequirements memRequirements;
+	image.getMemoryRequirements(device, &memRequirements);
+	return memRequirements;
 }
 
 void Image::destroyImage(VkDevice device)
@@ -228,7 +275,29 @@ Transition* Image::updateImageLayoutAndBarrier(ImageLayout newLayout)
 	ImageLayout oldLayout = imageLayout;
 
 	imageLayout = newLayout;
-	return new Transition(oldLayout, newLayout, image.getHandle(), subresourceRange);
+	Transition* transition = new Transition(oldLayout, newLayout, image.getHandle(), subresourceRange);
+
+	if (aliasingBarrierPending)
+	{
+		transition->waitForAliasedWrites();
+		aliasingBarrierPending = false;
+	}
+	return transition;
+}
+
+Transition* Image::updateImageLayoutAndHazardBarrier(ImageLayout newLayout)
+{
+	if (newLayout == imageLayout && kImageMemoryBarrierData[newLayout].type == ResourceAccess::Write)
+	{
+		return new Transition(imageLayout, newLayout, image.getHandle(), subresourceRange);
+	}
+	return updateImageLayoutAndBarrier(newLayout);
+}
+
+void Image::discardContents()
+{
+	imageLayout = ImageLayout::Undefined;
+	aliasingBarrierPending = true;
 }
 
 VkImage Image::getImage()
@@ -1,29 +1,49 @@
 #pragma once
 
+#include <string>
 #include "vulkan/vk_wrapper.h"
+#include "vulkan/memoryAllocator.h"
 #include "vulkan/resources.h"
 #include "vulkan/transition.h"
 
 namespace vk
 {
 class Context;
+
+// Memory shared by transient images whose lifetimes don't overlap, freed with the last image bound to it
+struct AliasedMemory
+{
+	Allocation allocation;
+	uint32_t memoryTrackingId = 0;
+	uint32_t imageCount = 0;
+};
+
 class Image
 {
 public:
 	Image();
 
-	void destroy(VkDevice device);
+	void destroy(Context* context);
 
 	bool createImage(Context* context, VkFormat format, uint32_t mipLevels, uint32_t layers, uint32_t samples, VkExtent3D extent, VkImageUsageFlags imageUsage, VkMemoryPropertyFlags memoryProperty);
 
+	// Creates the image without memory, it has to be bound with bindMemory or bindAliasedMemory before use
+	bool createImageHandle(Context* context, VkFormat format, uint32_t mipLevels, uint32_t layers, uint32_t samples, VkExtent3D extent, VkImageUsageFlags imageUsage);
+
+	bool bindMemory(Context* context, VkMemoryPropertyFlags memoryProperty);
+
+	void bindAliasedMemory(Context* context, AliasedMemory* aliasedMemory);
+
+	VkMemoryRequirements getMemoryRequirements(VkDevice device);
+
+	bool isCreated() { return image.valid(); }
+
 	void destroyImage(VkDevice device);
 
 	void setHandle(VkImage inImage, VkFormat format, VkExtent2D extent);
 
 	void release();
 
-	uint32_t getMemoryTypeIndex(VkPhysicalDevice physicalDevice, const uint32_t memoryTypeBits, const VkMemoryPropertyFlags memoryProperty);
-
 	bool createImageView(VkDevice device, VkFormat format, VkImageAspectFlags aspectFlags);
 
 	bool createImageView(VkDevice device, VkFormat format, VkComponentMapping components, VkImageSubresourceRange subresourceRange, VkImageViewType viewType);
@@ -55,6 +75,15 @@ public:
 	void updateImageLayout(ImageLayout newImageLayout);
 
 	Transition* updateImageLayoutAndBarrier(ImageLayout newLayout);
+
+	// Like updateImageLayoutAndBarrier, but staying in a write layout still orders the writes with a memory barrier
+	Transition* updateImageLayoutAndHazardBarrier(ImageLayout newLayout);
+
+	// Another image may have written the aliased memory, the next barrier waits for it and drops the contents
+	void discardContents();
+
+	// Shows up in the memory report, must be set before createImage
+	void setMemoryOwner(const std::string& owner) { memoryOwner = owner; }
 public:
 	VkImage getImage();
 	  
@@ -81,12 +110,19 @@ protected:
 	handle::ImageView view;
 	handle::ImageView readView;
 	handle::Sampler sampler;
-	handle::DeviceMemory memory;	
+	Allocation allocation;
 	VkImageSubresourceRange subresourceRange;
 
 	VkFormat format;
 	uint32_t samples;
 	VkExtent3D extent;
 	ImageLayout imageLayout;
+	VkImageUsageFlags imageUsage;
+
+	AliasedMemory* aliasedMemory;
+	bool aliasingBarrierPending;
+
+	std::string memoryOwner;
+	uint32_t memoryTrackingId;
 };
 }
\ No newline at end of file
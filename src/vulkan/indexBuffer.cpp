@@ -1,12 +1,12 @@
 #include "rhi/context.h"
 #include "vulkan/context.h"
 #include "vulkan/buffer.h"
+#include "vulkan/uploadBatcher.h"
 
 namespace vk
 {
 IndexBuffer::IndexBuffer(rhi::IndexSize indexSize)
 	: buffer(nullptr)
-	, stagingBuffer(nullptr)
 	, suballocated(false)
 	, offset(0)
 	, built(false)
@@ -34,13 +34,6 @@ void IndexBuffer::destroy(rhi::Context* context)
 		buffer = nullptr;
 	}
 
-	if (stagingBuffer != nullptr)
-	{
-		stagingBuffer->destroy(contextVk);
-		delete stagingBuffer;
-		stagingBuffer = nullptr;
-	}
-
 	rhi::IndexBuffer::destroy(context);
 }
 
@@ -61,9 +54,7 @@ void IndexBuffer::build(rhi::Context* rhiContext)
 
 		ScratchBuffer* scratchBuffer = reinterpret_cast<ScratchBuffer*>(subAllocateInfo->buffer);
 		buffer = scratchBuffer->getBuffer();
-		stagingBuffer = BufferFactory::createBuffer(rhi::BufferType::HostCoherent, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 0, bufferSize);
-		stagingBuffer->init(context, indices.data());
-		buffer->Copy(context, stagingBuffer->getBuffer(), subAllocateInfo->offset, bufferSize);
+		context->getUploadBatcher()->copyBuffer(context, indices.data(), bufferSize, buffer->getBuffer(), subAllocateInfo->offset);
 	}
 	else
 	{
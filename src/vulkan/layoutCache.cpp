@@ -0,0 +1,171 @@
+#include <functional>
+#include "vulkan/layoutCache.h"
+
+namespace vk
+{
+namespace
+{
+void hashCombine(size_t& seed, size_t value)
+{
+	seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+}
+
+bool LayoutCache::DescriptorSetLayoutKey::operator==(const DescriptorSetLayoutKey& other) const
+{
+	if (bindings.size() != other.bindings.size() || bindingFlags != other.bindingFlags)
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < bindings.size(); i++)
+	{
+		const VkDescriptorSetLayoutBinding& a = bindings[i];
+		const VkDescriptorSetLayoutBinding& b = other.bindings[i];
+		if (a.binding != b.binding || a.descriptorType != b.descriptorType ||
+			a.descriptorCount != b.descriptorCount || a.stageFlags != b.stageFlags)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t LayoutCache::DescriptorSetLayoutKeyHash::operator()(const DescriptorSetLayoutKey& key) const
+{
+	size_t seed = key.bindings.size();
+	for (auto& binding : key.bindings)
+	{
+		hashCombine(seed, binding.binding);
+		hashCombine(seed, binding.descriptorType);
+		hashCombine(seed, binding.descriptorCount);
+		hashCombine(seed, binding.stageFlags);
+	}
+	for (auto& flags : key.bindingFlags)
+	{
+		hashCombine(seed, flags);
+	}
+	return seed;
+}
+
+bool LayoutCache::PipelineLayoutKey::operator==(const PipelineLayoutKey& other) const
+{
+	if (setLayouts != other.setLayouts || pushConstantRanges.size() != other.pushConstantRanges.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < pushConstantRanges.size(); i++)
+	{
+		const VkPushConstantRange& a = pushConstantRanges[i];
+		const VkPushConstantRange& b = other.pushConstantRanges[i];
+		if (a.stageFlags != b.stageFlags || a.offset != b.offset || a.size != b.size)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t LayoutCache::PipelineLayoutKeyHash::operator()(const PipelineLayoutKey& key) const
+{
+	size_t seed = key.setLayouts.size();
+	for (auto& setLayout : key.setLayouts)
+	{
+		hashCombine(seed, std::hash<VkDescriptorSetLayout>()(setLayout));
+	}
+	for (auto& pushConstantRange : key.pushConstantRanges)
+	{
+		hashCombine(seed, pushConstantRange.stageFlags);
+		hashCombine(seed, pushConstantRange.offset);
+		hashCombine(seed, pushConstantRange.size);
+	}
+	return seed;
+}
+
+LayoutCache::LayoutCache()
+	: descriptorSetLayoutRequests(0)
+	, pipelineLayoutRequests(0)
+{
+
+}
+
+void LayoutCache::destroy(VkDevice device)
+{
+	LOGD("Layout cache: %zu descriptor set layouts for %u sets, %zu pipeline layouts for %u pipelines",
+		descriptorSetLayouts.size(), descriptorSetLayoutRequests, pipelineLayouts.size(), pipelineLayoutRequests);
+
+	// Pipeline layouts first, they were created from the set layouts
+	for (auto& entry : pipelineLayouts)
+	{
+		entry.second.destroy(device);
+	}
+	pipelineLayouts.clear();
+
+	for (auto& entry : descriptorSetLayouts)
+	{
+		entry.second.destroy(device);
+	}
+	descriptorSetLayouts.clear();
+
+	descriptorSetLayoutRequests = 0;
+	pipelineLayoutRequests = 0;
+}
+
+VkDescriptorSetLayout LayoutCache::getDescriptorSetLayout(VkDevice device, const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+	const std::vector<VkDescriptorBindingFlags>& bindingFlags)
+{
+	ASSERT(bindingFlags.empty() || bindingFlags.size() == bindings.size());
+	descriptorSetLayoutRequests++;
+
+	DescriptorSetLayoutKey key = { bindings, bindingFlags };
+	auto found = descriptorSetLayouts.find(key);
+	if (found != descriptorSetLayouts.end())
+	{
+		return found->second.getHandle();
+	}
+
+	VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo = {};
+	descriptorSetLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+	descriptorSetLayoutCreateInfo.pBindings = bindings.data();
+
+	// Only chained when there are flags, layouts without them stay valid on devices lacking descriptor indexing
+	VkDescriptorSetLayoutBindingFlagsCreateInfo descriptorSetLayoutBindingFlagsCreateInfo = {};
+	if (!bindingFlags.empty())
+	{
+		descriptorSetLayoutBindingFlagsCreateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+		descriptorSetLayoutBindingFlagsCreateInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+		descriptorSetLayoutBindingFlagsCreateInfo.pBindingFlags = bindingFlags.data();
+		descriptorSetLayoutCreateInfo.pNext = &descriptorSetLayoutBindingFlagsCreateInfo;
+	}
+
+	handle::DescriptorSetLayout& descriptorSetLayout = descriptorSetLayouts[key];
+	VKCALL(descriptorSetLayout.init(device, descriptorSetLayoutCreateInfo));
+	return descriptorSetLayout.getHandle();
+}
+
+VkPipelineLayout LayoutCache::getPipelineLayout(VkDevice device, const std::vector<VkDescriptorSetLayout>& setLayouts,
+	const std::vector<VkPushConstantRange>& pushConstantRanges)
+{
+	pipelineLayoutRequests++;
+
+	PipelineLayoutKey key = { setLayouts, pushConstantRanges };
+	auto found = pipelineLayouts.find(key);
+	if (found != pipelineLayouts.end())
+	{
+		return found->second.getHandle();
+	}
+
+	VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+	pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutCreateInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+	pipelineLayoutCreateInfo.pPushConstantRanges = pushConstantRanges.data();
+	pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
+
+	handle::PipelineLayout& pipelineLayout = pipelineLayouts[key];
+	VKCALL(pipelineLayout.init(device, pipelineLayoutCreateInfo));
+	return pipelineLayout.getHandle();
+}
+}
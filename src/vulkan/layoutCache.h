@@ -0,0 +1,60 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+#include "vulkan/vk_wrapper.h"
+
+namespace vk
+{
+// Descriptor set layouts and pipeline layouts shared by every set and pipeline that describes the same one.
+// Sets and pipelines don't own them, they live until the device is destroyed. Identical pipeline layouts
+// are also compatible, sets bound for one pipeline stay valid after binding another with the same layout.
+class LayoutCache
+{
+public:
+	LayoutCache();
+
+	void destroy(VkDevice device);
+
+	// Bindings without immutable samplers, binding flags are either empty or one per binding
+	VkDescriptorSetLayout getDescriptorSetLayout(VkDevice device, const std::vector<VkDescriptorSetLayoutBinding>& bindings,
+		const std::vector<VkDescriptorBindingFlags>& bindingFlags);
+
+	VkPipelineLayout getPipelineLayout(VkDevice device, const std::vector<VkDescriptorSetLayout>& setLayouts,
+		const std::vector<VkPushConstantRange>& pushConstantRanges);
+
+private:
+	struct DescriptorSetLayoutKey
+	{
+		std::vector<VkDescriptorSetLayoutBinding> bindings;
+		std::vector<VkDescriptorBindingFlags> bindingFlags;
+
+		bool operator==(const DescriptorSetLayoutKey& other) const;
+	};
+
+	struct DescriptorSetLayoutKeyHash
+	{
+		size_t operator()(const DescriptorSetLayoutKey& key) const;
+	};
+
+	struct PipelineLayoutKey
+	{
+		std::vector<VkDescriptorSetLayout> setLayouts;
+		std::vector<VkPushConstantRange> pushConstantRanges;
+
+		bool operator==(const PipelineLayoutKey& other) const;
+	};
+
+	struct PipelineLayoutKeyHash
+	{
+		size_t operator()(const PipelineLayoutKey& key) const;
+	};
+
+	std::unordered_map<DescriptorSetLayoutKey, handle::DescriptorSetLayout, DescriptorSetLayoutKeyHash> descriptorSetLayouts;
+	std::unordered_map<PipelineLayoutKey, handle::PipelineLayout, PipelineLayoutKeyHash> pipelineLayouts;
+
+	// Requests since init, compared with the layouts created when the cache is destroyed
+	uint32_t descriptorSetLayoutRequests;
+	uint32_t pipelineLayoutRequests;
+};
+}
@@ -0,0 +1,20 @@
+#include "platform/linux/window.h"
+#include "vulkan/surface.h"
+#include "vulkan/vk_headers.h"
+
+namespace vk
+{
+bool Surface::initSurface(VkInstance instance, platform::Window* window)
+{
+    platform::HeadlessWindow* platformWindow = reinterpret_cast<platform::HeadlessWindow*>(window);
+
+    // No window system, the surface stays null and the context renders to an offscreen swapchain
+    surface = VK_NULL_HANDLE;
+    readbackInterval = platformWindow->getReadbackInterval();
+    readbackDirectory = platformWindow->getReadbackDirectory();
+
+    updateSurfaceSize(platformWindow->getWidth(), platformWindow->getHeight());
+
+    return true;
+}
+}
@@ -0,0 +1,535 @@
+#include <algorithm>
+#include <iterator>
+#include "vulkan/memoryAllocator.h"
+
+namespace vk
+{
+inline bool onSamePage(VkDeviceSize lhs, VkDeviceSize rhs, VkDeviceSize pageSize)
+{
+	return (lhs / pageSize) == (rhs / pageSize);
+}
+
+float MemoryStats::getFragmentation() const
+{
+	const VkDeviceSize freeBytes = blockBytes - usedBytes;
+	if (freeBytes == 0)
+	{
+		return 0.f;
+	}
+	return 1.f - static_cast<float>(largestFreeRegion) / static_cast<float>(freeBytes);
+}
+
+void MemoryStats::merge(const MemoryStats& other)
+{
+	blockCount += other.blockCount;
+	allocationCount += other.allocationCount;
+	freeRegionCount += other.freeRegionCount;
+	blockBytes += other.blockBytes;
+	usedBytes += other.usedBytes;
+	largestFreeRegion = std::max(largestFreeRegion, other.largestFreeRegion);
+}
+
+MemoryBlock::MemoryBlock(uint32_t memoryTypeIndex, VkDeviceSize size, VkMemoryAllocateFlags allocateFlags, bool dedicated)
+	: memoryTypeIndex(memoryTypeIndex)
+	, size(size)
+	, allocateFlags(allocateFlags)
+	, dedicated(dedicated)
+	, mapped(nullptr)
+	, allocationCount(0)
+{
+	regions.push_back(Region{ 0, size, ResourceType::Free });
+}
+
+VkResult MemoryBlock::init(VkDevice device, bool hostVisible)
+{
+	VkMemoryAllocateFlagsInfo memoryAllocateFlagsInfo = {};
+	memoryAllocateFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+	memoryAllocateFlagsInfo.flags = allocateFlags;
+
+	VkMemoryAllocateInfo memoryAllocateInfo = {};
+	memoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	memoryAllocateInfo.pNext = &memoryAllocateFlagsInfo;
+	memoryAllocateInfo.allocationSize = size;
+	memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+
+	VkResult result = memory.allocate(device, memoryAllocateInfo);
+	if (result != VK_SUCCESS)
+	{
+		return result;
+	}
+
+	// Host visible blocks stay mapped for their whole lifetime, sub-allocations only offset into it
+	if (hostVisible)
+	{
+		result = memory.map(device, 0, VK_WHOLE_SIZE, 0, &mapped);
+	}
+
+	return result;
+}
+
+void MemoryBlock::destroy(VkDevice device)
+{
+	if (mapped != nullptr)
+	{
+		memory.unmap(device);
+		mapped = nullptr;
+	}
+	memory.destroy(device);
+	regions.clear();
+}
+
+bool MemoryBlock::conflicts(ResourceType lhs, ResourceType rhs) const
+{
+	return lhs != ResourceType::Free && rhs != ResourceType::Free && lhs != rhs;
+}
+
+bool MemoryBlock::allocate(VkDeviceSize allocationSize, VkDeviceSize alignment, VkDeviceSize granularity, ResourceType type, Allocation* allocation)
+{
+	ASSERT(type != ResourceType::Free);
+
+	// Best fit over the free regions
+	auto bestRegion = regions.end();
+	VkDeviceSize bestOffset = 0;
+	VkDeviceSize bestRemain = size;
+
+	for (auto region = regions.begin(); region != regions.end(); region++)
+	{
+		if (region->type != ResourceType::Free || region->size < allocationSize)
+		{
+			continue;
+		}
+
+		VkDeviceSize offset = Util::align(region->offset, alignment);
+
+		if (region != regions.begin())
+		{
+			auto prevRegion = std::prev(region);
+			if (conflicts(prevRegion->type, type) && onSamePage(prevRegion->offset + prevRegion->size - 1, offset, granularity))
+			{
+				offset = Util::align(offset, granularity);
+			}
+		}
+
+		const VkDeviceSize end = offset + allocationSize;
+		if (end > region->offset + region->size)
+		{
+			continue;
+		}
+
+		auto nextRegion = std::next(region);
+		if (nextRegion != regions.end() && conflicts(nextRegion->type, type) && onSamePage(end - 1, nextRegion->offset, granularity))
+		{
+			continue;
+		}
+
+		const VkDeviceSize remain = region->size - allocationSize;
+		if (bestRegion == regions.end() || remain < bestRemain)
+		{
+			bestRegion = region;
+			bestOffset = offset;
+			bestRemain = remain;
+		}
+	}
+
+	if (bestRegion == regions.end())
+	{
+		return false;
+	}
+
+	const VkDeviceSize freeEnd = bestRegion->offset + bestRegion->size;
+
+	if (bestOffset > bestRegion->offset)
+	{
+		regions.insert(bestRegion, Region{ bestRegion->offset, bestOffset - bestRegion->offset, ResourceType::Free });
+	}
+
+	bestRegion->offset = bestOffset;
+	bestRegion->size = allocationSize;
+	bestRegion->type = type;
+
+	if (bestOffset + allocationSize < freeEnd)
+	{
+		regions.insert(std::next(bestRegion), Region{ bestOffset + allocationSize, freeEnd - bestOffset - allocationSize, ResourceType::Free });
+	}
+
+	allocationCount++;
+
+	allocation->block = this;
+	allocation->memory = memory.getHandle();
+	allocation->offset = bestOffset;
+	allocation->size = allocationSize;
+	allocation->memoryTypeIndex = memoryTypeIndex;
+	allocation->mapped = mapped != nullptr ? mapped + bestOffset : nullptr;
+
+	return true;
+}
+
+void MemoryBlock::free(const Allocation& allocation)
+{
+	ASSERT(allocation.block == this);
+
+	auto region = std::find_if(regions.begin(), regions.end(), [&allocation](const Region& candidate) {
+		return candidate.offset == allocation.offset && candidate.type != ResourceType::Free;
+	});
+
+	if (region == regions.end())
+	{
+		LOGE("Unknown allocation at offset %llu", static_cast<unsigned long long>(allocation.offset));
+		return;
+	}
+
+	region->type = ResourceType::Free;
+	allocationCount--;
+
+	// Coalesce with free neighbours
+	auto nextRegion = std::next(region);
+	if (nextRegion != regions.end() && nextRegion->type == ResourceType::Free)
+	{
+		region->size += nextRegion->size;
+		regions.erase(nextRegion);
+	}
+
+	if (region != regions.begin())
+	{
+		auto prevRegion = std::prev(region);
+		if (prevRegion->type == ResourceType::Free)
+		{
+			prevRegion->size += region->size;
+			regions.erase(region);
+		}
+	}
+}
+
+void MemoryBlock::getStats(MemoryStats* stats) const
+{
+	stats->blockCount++;
+	stats->blockBytes += size;
+	stats->allocationCount += allocationCount;
+
+	for (auto& region : regions)
+	{
+		if (region.type == ResourceType::Free)
+		{
+			stats->freeRegionCount++;
+			stats->largestFreeRegion = std::max(stats->largestFreeRegion, region.size);
+		}
+		else
+		{
+			stats->usedBytes += region.size;
+		}
+	}
+}
+
+MemoryAllocator::MemoryAllocator()
+	: memoryProperties()
+	, bufferImageGranularity(1)
+	, nonCoherentAtomSize(1)
+	, maxMemoryAllocationCount(0)
+	, deviceAllocationCount(0)
+	, hostVisibleDeviceHeap(false)
+{
+}
+
+void MemoryAllocator::init(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceProperties& physicalDeviceProperties)
+{
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+	bufferImageGranularity = std::max<VkDeviceSize>(physicalDeviceProperties.limits.bufferImageGranularity, 1);
+	nonCoherentAtomSize = std::max<VkDeviceSize>(physicalDeviceProperties.limits.nonCoherentAtomSize, 1);
+	maxMemoryAllocationCount = physicalDeviceProperties.limits.maxMemoryAllocationCount;
+
+	// Without resizable BAR the host visible part of video memory is a 256MB window, too small to place resources in
+	const VkMemoryPropertyFlags hostVisibleDevice = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		if ((memoryProperties.memoryTypes[i].propertyFlags & hostVisibleDevice) == hostVisibleDevice && isLargeHeap(i))
+		{
+			hostVisibleDeviceHeap = true;
+		}
+	}
+
+	LOGD("Memory types %u, heaps %u, bufferImageGranularity %llu, host visible device heap %s",
+		memoryProperties.memoryTypeCount, memoryProperties.memoryHeapCount, static_cast<unsigned long long>(bufferImageGranularity),
+		hostVisibleDeviceHeap ? "yes" : "no");
+}
+
+void MemoryAllocator::destroy(VkDevice device)
+{
+	for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < VK_MAX_MEMORY_TYPES; memoryTypeIndex++)
+	{
+		for (auto& block : blocks[memoryTypeIndex])
+		{
+			if (!block->empty())
+			{
+				LOGE("Memory type %u: block is destroyed with live allocations", memoryTypeIndex);
+			}
+			block->destroy(device);
+			delete block;
+		}
+		blocks[memoryTypeIndex].clear();
+	}
+	deviceAllocationCount = 0;
+}
+
+bool MemoryAllocator::allocate(VkDevice device, const VkMemoryRequirements& memoryRequirements, VkMemoryPropertyFlags memoryProperty, MemoryUsage memoryUsage,
+	VkMemoryAllocateFlags allocateFlags, ResourceType type, Allocation* allocation)
+{
+	const uint32_t memoryTypeIndex = getMemoryTypeIndex(memoryRequirements.memoryTypeBits, memoryProperty, memoryUsage);
+	const VkDeviceSize blockSize = getBlockSize(memoryTypeIndex);
+	const VkDeviceSize alignment = std::max<VkDeviceSize>(memoryRequirements.alignment, 1);
+	// Lazily allocated memory is committed per allocation, sharing a block would defeat it
+	const bool dedicated = memoryRequirements.size > blockSize / 2 || memoryUsage == MemoryUsage::LazilyAllocated;
+
+	auto& memoryTypeBlocks = blocks[memoryTypeIndex];
+
+	if (!dedicated)
+	{
+		for (auto& block : memoryTypeBlocks)
+		{
+			if (block->isDedicated() || block->getAllocateFlags() != allocateFlags)
+			{
+				continue;
+			}
+
+			if (block->allocate(memoryRequirements.size, alignment, bufferImageGranularity, type, allocation))
+			{
+				return true;
+			}
+		}
+	}
+
+	if (maxMemoryAllocationCount != 0 && deviceAllocationCount >= maxMemoryAllocationCount)
+	{
+		LOGE("Exceeded maxMemoryAllocationCount %u", maxMemoryAllocationCount);
+		return false;
+	}
+
+	const bool hostVisible = (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+
+	MemoryBlock* block = new MemoryBlock(memoryTypeIndex, dedicated ? memoryRequirements.size : blockSize, allocateFlags, dedicated);
+	VkResult result = block->init(device, hostVisible);
+	if (result != VK_SUCCESS)
+	{
+		LOGE("Failed to allocate memory block of %llu bytes (%d)", static_cast<unsigned long long>(block->getSize()), result);
+		block->destroy(device);
+		delete block;
+		return false;
+	}
+
+	memoryTypeBlocks.push_back(block);
+	deviceAllocationCount++;
+
+	bool allocated = block->allocate(memoryRequirements.size, alignment, bufferImageGranularity, type, allocation);
+	ASSERT(allocated);
+
+	return allocated;
+}
+
+void MemoryAllocator::free(VkDevice device, Allocation& allocation)
+{
+	if (!allocation.valid())
+	{
+		return;
+	}
+
+	MemoryBlock* block = allocation.block;
+	ASSERT(block);
+	block->free(allocation);
+
+	auto& memoryTypeBlocks = blocks[allocation.memoryTypeIndex];
+
+	if (block->empty())
+	{
+		// Keep one shared block around per memory type to avoid thrashing vkAllocateMemory
+		const bool lastSharedBlock = !block->isDedicated() &&
+			std::count_if(memoryTypeBlocks.begin(), memoryTypeBlocks.end(), [](MemoryBlock* candidate) { return !candidate->isDedicated(); }) == 1;
+
+		if (!lastSharedBlock)
+		{
+			memoryTypeBlocks.erase(std::find(memoryTypeBlocks.begin(), memoryTypeBlocks.end(), block));
+			block->destroy(device);
+			delete block;
+			deviceAllocationCount--;
+		}
+	}
+
+	allocation = Allocation();
+}
+
+VkMappedMemoryRange MemoryAllocator::getMappedMemoryRange(const Allocation& allocation, VkDeviceSize size) const
+{
+	ASSERT(allocation.valid());
+
+	if (size == VK_WHOLE_SIZE)
+	{
+		size = allocation.size;
+	}
+
+	// Non-coherent ranges have to be aligned to nonCoherentAtomSize
+	const VkDeviceSize begin = (allocation.offset / nonCoherentAtomSize) * nonCoherentAtomSize;
+	const VkDeviceSize end = Util::align(allocation.offset + size, nonCoherentAtomSize);
+
+	VkMappedMemoryRange range = {};
+	range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+	range.pNext = nullptr;
+	range.memory = allocation.memory;
+	range.offset = begin;
+	range.size = end >= allocation.block->getSize() ? VK_WHOLE_SIZE : end - begin;
+
+	return range;
+}
+
+void MemoryAllocator::flush(VkDevice device, const Allocation& allocation, VkDeviceSize size)
+{
+	VkMappedMemoryRange range = getMappedMemoryRange(allocation, size);
+	VKCALL(vkFlushMappedMemoryRanges(device, 1, &range));
+}
+
+void MemoryAllocator::invalidate(VkDevice device, const Allocation& allocation, VkDeviceSize size)
+{
+	VkMappedMemoryRange range = getMappedMemoryRange(allocation, size);
+	VKCALL(vkInvalidateMappedMemoryRanges(device, 1, &range));
+}
+
+uint32_t MemoryAllocator::getMemoryTypeIndex(const uint32_t memoryTypeBits, const VkMemoryPropertyFlags memoryProperty, MemoryUsage memoryUsage) const
+{
+	uint32_t bestMemoryTypeIndex = VK_MAX_MEMORY_TYPES;
+	int bestScore = 0;
+
+	for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++)
+	{
+		const VkMemoryPropertyFlags propertyFlags = memoryProperties.memoryTypes[i].propertyFlags;
+		if (!(memoryTypeBits & (1 << i)) || (propertyFlags & memoryProperty) != memoryProperty)
+		{
+			continue;
+		}
+
+		// Ties keep the lowest index, drivers list their preferred types first
+		const int score = getMemoryTypeScore(i, memoryUsage);
+		if (bestMemoryTypeIndex == VK_MAX_MEMORY_TYPES || score > bestScore)
+		{
+			bestMemoryTypeIndex = i;
+			bestScore = score;
+		}
+	}
+
+	if (bestMemoryTypeIndex == VK_MAX_MEMORY_TYPES)
+	{
+		UNREACHABLE();
+		return 0;
+	}
+	return bestMemoryTypeIndex;
+}
+
+int MemoryAllocator::getMemoryTypeScore(uint32_t memoryTypeIndex, MemoryUsage memoryUsage) const
+{
+	const VkMemoryPropertyFlags propertyFlags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+	const bool deviceLocal = (propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0;
+	const bool hostVisible = (propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+	const bool hostCached = (propertyFlags & VK_MEMORY_PROPERTY_HOST_CACHED_BIT) != 0;
+
+	int score = 0;
+	switch (memoryUsage)
+	{
+	case MemoryUsage::GpuOnly:
+		score += deviceLocal ? 4 : 0;
+		score -= hostVisible && !isLargeHeap(memoryTypeIndex) ? 2 : 0;
+		break;
+	case MemoryUsage::Upload:
+		if (deviceLocal && hostVisible)
+		{
+			score += isLargeHeap(memoryTypeIndex) ? 4 : -1;
+		}
+		break;
+	case MemoryUsage::Staging:
+		// Uncached write combined memory is the fastest to write sequentially
+		score -= deviceLocal && !isLargeHeap(memoryTypeIndex) ? 2 : 0;
+		score -= hostCached ? 1 : 0;
+		break;
+	case MemoryUsage::Readback:
+		// Reading uncached memory goes over the bus for every access
+		score += hostCached ? 4 : 0;
+		score -= deviceLocal && !hostCached ? 1 : 0;
+		break;
+	case MemoryUsage::LazilyAllocated:
+		score += deviceLocal ? 4 : 0;
+		break;
+	}
+
+	if (propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT)
+	{
+		score += memoryUsage == MemoryUsage::LazilyAllocated ? 8 : -8;
+	}
+	return score;
+}
+
+bool MemoryAllocator::isLargeHeap(uint32_t memoryTypeIndex) const
+{
+	const uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+	return memoryProperties.memoryHeaps[heapIndex].size > kSmallHeapMaxSize;
+}
+
+bool MemoryAllocator::isHostCoherent(const Allocation& allocation) const
+{
+	ASSERT(allocation.valid());
+	return (memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+}
+
+VkDeviceSize MemoryAllocator::getBlockSize(uint32_t memoryTypeIndex) const
+{
+	const uint32_t heapIndex = memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+	const VkDeviceSize heapSize = memoryProperties.memoryHeaps[heapIndex].size;
+
+	// Small heaps (e.g. the 256MB BAR window) must not be eaten by a few blocks
+	if (heapSize <= kSmallHeapMaxSize)
+	{
+		return std::min(kDefaultMemoryBlockSize, Util::align(heapSize / 8, 32));
+	}
+	return kDefaultMemoryBlockSize;
+}
+
+MemoryStats MemoryAllocator::getStats() const
+{
+	MemoryStats stats;
+	for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < memoryProperties.memoryTypeCount; memoryTypeIndex++)
+	{
+		stats.merge(getStats(memoryTypeIndex));
+	}
+	return stats;
+}
+
+MemoryStats MemoryAllocator::getStats(uint32_t memoryTypeIndex) const
+{
+	ASSERT(memoryTypeIndex < VK_MAX_MEMORY_TYPES);
+
+	MemoryStats stats;
+	for (auto& block : blocks[memoryTypeIndex])
+	{
+		block->getStats(&stats);
+	}
+	return stats;
+}
+
+void MemoryAllocator::logStats() const
+{
+	for (uint32_t memoryTypeIndex = 0; memoryTypeIndex < memoryProperties.memoryTypeCount; memoryTypeIndex++)
+	{
+		if (blocks[memoryTypeIndex].empty())
+		{
+			continue;
+		}
+
+		MemoryStats stats = getStats(memoryTypeIndex);
+		LOGD("Memory type %u (flags 0x%x): %u blocks, %u allocations, %llu / %llu bytes used, %u free regions, fragmentation %.2f",
+			memoryTypeIndex, memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags,
+			stats.blockCount, stats.allocationCount,
+			static_cast<unsigned long long>(stats.usedBytes), static_cast<unsigned long long>(stats.blockBytes),
+			stats.freeRegionCount, stats.getFragmentation());
+	}
+
+	MemoryStats total = getStats();
+	LOGD("Memory total: %u device allocations, %u sub-allocations, %llu / %llu bytes used",
+		deviceAllocationCount, total.allocationCount,
+		static_cast<unsigned long long>(total.usedBytes), static_cast<unsigned long long>(total.blockBytes));
+}
+}
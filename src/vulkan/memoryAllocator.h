@@ -0,0 +1,159 @@
+#pragma once
+
+#include <list>
+#include <vector>
+#include "vulkan/vk_wrapper.h"
+
+namespace vk
+{
+const VkDeviceSize kDefaultMemoryBlockSize = 64 * 1024 * 1024;
+const VkDeviceSize kSmallHeapMaxSize = 1024 * 1024 * 1024;
+
+class MemoryBlock;
+
+// Linear (buffers) and optimal tiled (images) resources must not share a
+// bufferImageGranularity page
+enum class ResourceType
+{
+	Free,
+	Linear,
+	Optimal
+};
+
+// Ranks the memory types that have the required property flags
+enum class MemoryUsage
+{
+	// Only accessed by the GPU, host visible types are avoided to leave the BAR window alone
+	GpuOnly,
+	// Written by the host and read by the GPU, goes to device local memory when it is host visible and large
+	Upload,
+	// Written by the host and only read by transfers
+	Staging,
+	// Written by the GPU and read back by the host, prefers cached memory
+	Readback,
+	// Transient attachments that never leave tile memory, backed lazily where the device supports it
+	LazilyAllocated
+};
+
+struct Allocation
+{
+	MemoryBlock* block = nullptr;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+	VkDeviceSize size = 0;
+	uint32_t memoryTypeIndex = 0;
+	uint8_t* mapped = nullptr;
+
+	bool valid() const { return memory != VK_NULL_HANDLE; }
+};
+
+struct MemoryStats
+{
+	uint32_t blockCount = 0;
+	uint32_t allocationCount = 0;
+	uint32_t freeRegionCount = 0;
+	VkDeviceSize blockBytes = 0;
+	VkDeviceSize usedBytes = 0;
+	VkDeviceSize largestFreeRegion = 0;
+
+	// 0 when all free space is contiguous, close to 1 when it is scattered
+	float getFragmentation() const;
+
+	void merge(const MemoryStats& other);
+};
+
+class MemoryBlock
+{
+public:
+	MemoryBlock(uint32_t memoryTypeIndex, VkDeviceSize size, VkMemoryAllocateFlags allocateFlags, bool dedicated);
+
+	VkResult init(VkDevice device, bool hostVisible);
+
+	void destroy(VkDevice device);
+
+	bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize granularity, ResourceType type, Allocation* allocation);
+
+	void free(const Allocation& allocation);
+
+	bool empty() const { return allocationCount == 0; }
+
+	bool isDedicated() const { return dedicated; }
+
+	VkDeviceSize getSize() const { return size; }
+
+	VkMemoryAllocateFlags getAllocateFlags() const { return allocateFlags; }
+
+	void getStats(MemoryStats* stats) const;
+
+private:
+	struct Region
+	{
+		VkDeviceSize offset;
+		VkDeviceSize size;
+		ResourceType type;
+	};
+
+	bool conflicts(ResourceType lhs, ResourceType rhs) const;
+
+	handle::DeviceMemory memory;
+	uint32_t memoryTypeIndex;
+	VkDeviceSize size;
+	VkMemoryAllocateFlags allocateFlags;
+	bool dedicated;
+	uint8_t* mapped;
+	uint32_t allocationCount;
+	std::list<Region> regions; // sorted by offset, covers the whole block
+};
+
+class MemoryAllocator
+{
+public:
+	MemoryAllocator();
+
+	void init(VkPhysicalDevice physicalDevice, const VkPhysicalDeviceProperties& physicalDeviceProperties);
+
+	void destroy(VkDevice device);
+
+	bool allocate(VkDevice device, const VkMemoryRequirements& memoryRequirements, VkMemoryPropertyFlags memoryProperty, MemoryUsage memoryUsage,
+		VkMemoryAllocateFlags allocateFlags, ResourceType type, Allocation* allocation);
+
+	void free(VkDevice device, Allocation& allocation);
+
+	void flush(VkDevice device, const Allocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE);
+
+	void invalidate(VkDevice device, const Allocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE);
+
+	uint32_t getMemoryTypeIndex(const uint32_t memoryTypeBits, const VkMemoryPropertyFlags memoryProperty, MemoryUsage memoryUsage) const;
+
+	// True with resizable BAR or unified memory, device local memory can then be written directly by the host
+	bool hasHostVisibleDeviceHeap() const { return hostVisibleDeviceHeap; }
+
+	bool isHostCoherent(const Allocation& allocation) const;
+
+	const VkPhysicalDeviceMemoryProperties& getMemoryProperties() const { return memoryProperties; }
+
+public:
+	MemoryStats getStats() const;
+
+	MemoryStats getStats(uint32_t memoryTypeIndex) const;
+
+	void logStats() const;
+
+private:
+	VkDeviceSize getBlockSize(uint32_t memoryTypeIndex) const;
+
+	int getMemoryTypeScore(uint32_t memoryTypeIndex, MemoryUsage memoryUsage) const;
+
+	bool isLargeHeap(uint32_t memoryTypeIndex) const;
+
+	VkMappedMemoryRange getMappedMemoryRange(const Allocation& allocation, VkDeviceSize size) const;
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	VkDeviceSize bufferImageGranularity;
+	VkDeviceSize nonCoherentAtomSize;
+	uint32_t maxMemoryAllocationCount;
+	uint32_t deviceAllocationCount;
+	bool hostVisibleDeviceHeap;
+	std::vector<MemoryBlock*> blocks[VK_MAX_MEMORY_TYPES];
+};
+}
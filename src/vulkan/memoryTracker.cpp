@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <fstream>
+#include "vulkan/memoryTracker.h"
+#include "vulkan/extension.h"
+
+namespace vk
+{
+MemoryTracker::MemoryTracker()
+	: physicalDevice(VK_NULL_HANDLE)
+	, budgetSupported(false)
+	, frameCount(0)
+	, nextId(1)
+	, stats()
+{
+
+}
+
+void MemoryTracker::init(VkPhysicalDevice physicalDevice, bool budgetSupported)
+{
+	this->physicalDevice = physicalDevice;
+	this->budgetSupported = budgetSupported && vkGetPhysicalDeviceMemoryProperties2KHR != nullptr;
+
+	pollBudget();
+	LOGD("Memory budget %s", this->budgetSupported ? "available" : "not available");
+}
+
+void MemoryTracker::destroy()
+{
+	log();
+
+	if (!entries.empty())
+	{
+		LOGE("Memory tracker: %zu allocations are still alive", entries.size());
+	}
+	entries.clear();
+}
+
+uint32_t MemoryTracker::track(rhi::MemoryCategory category, const std::string& owner, VkDeviceSize size)
+{
+	const uint32_t id = nextId++;
+	entries[id] = { category, owner, size };
+
+	rhi::MemoryCategoryStats& categoryStats = stats.categories[static_cast<size_t>(category)];
+	categoryStats.currentBytes += size;
+	categoryStats.peakBytes = std::max(categoryStats.peakBytes, categoryStats.currentBytes);
+	categoryStats.allocationCount++;
+
+	stats.currentBytes += size;
+	stats.peakBytes = std::max(stats.peakBytes, stats.currentBytes);
+	return id;
+}
+
+void MemoryTracker::untrack(uint32_t id)
+{
+	auto entry = entries.find(id);
+	if (entry == entries.end())
+	{
+		return;
+	}
+
+	rhi::MemoryCategoryStats& categoryStats = stats.categories[static_cast<size_t>(entry->second.category)];
+	categoryStats.currentBytes -= entry->second.size;
+	categoryStats.allocationCount--;
+	stats.currentBytes -= entry->second.size;
+
+	entries.erase(entry);
+}
+
+void MemoryTracker::update()
+{
+	frameCount++;
+
+	if (frameCount % kMemoryBudgetPollInterval == 0)
+	{
+		pollBudget();
+	}
+
+	if (frameCount % kMemoryLogInterval == 0)
+	{
+		log();
+	}
+}
+
+void MemoryTracker::pollBudget()
+{
+	if (!budgetSupported)
+	{
+		return;
+	}
+
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT memoryBudgetProperties = {};
+	memoryBudgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+	VkPhysicalDeviceMemoryProperties2 memoryProperties2 = {};
+	memoryProperties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	memoryProperties2.pNext = &memoryBudgetProperties;
+	vkGetPhysicalDeviceMemoryProperties2KHR(physicalDevice, &memoryProperties2);
+
+	stats.budgetAvailable = true;
+	stats.heapUsageBytes = 0;
+	stats.heapBudgetBytes = 0;
+
+	const VkPhysicalDeviceMemoryProperties& memoryProperties = memoryProperties2.memoryProperties;
+	for (uint32_t heapIndex = 0; heapIndex < memoryProperties.memoryHeapCount; heapIndex++)
+	{
+		if (memoryProperties.memoryHeaps[heapIndex].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			stats.heapUsageBytes += memoryBudgetProperties.heapUsage[heapIndex];
+			stats.heapBudgetBytes += memoryBudgetProperties.heapBudget[heapIndex];
+		}
+	}
+}
+
+bool MemoryTracker::writeJson(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		LOGE("Failed to open %s for the memory report", path.c_str());
+		return false;
+	}
+
+	file << "{\n";
+	file << "  \"currentBytes\": " << stats.currentBytes << ",\n";
+	file << "  \"peakBytes\": " << stats.peakBytes << ",\n";
+	if (stats.budgetAvailable)
+	{
+		file << "  \"heapUsageBytes\": " << stats.heapUsageBytes << ",\n";
+		file << "  \"heapBudgetBytes\": " << stats.heapBudgetBytes << ",\n";
+	}
+
+	file << "  \"categories\": {\n";
+	for (size_t i = 0; i < static_cast<size_t>(rhi::MemoryCategory::Count); i++)
+	{
+		const rhi::MemoryCategoryStats& categoryStats = stats.categories[i];
+		file << "    \"" << getCategoryName(static_cast<rhi::MemoryCategory>(i)) << "\": { "
+			<< "\"currentBytes\": " << categoryStats.currentBytes << ", "
+			<< "\"peakBytes\": " << categoryStats.peakBytes << ", "
+			<< "\"allocationCount\": " << categoryStats.allocationCount << " }"
+			<< (i + 1 < static_cast<size_t>(rhi::MemoryCategory::Count) ? ",\n" : "\n");
+	}
+	file << "  },\n";
+
+	// Owners are asset paths or fixed names, only quotes and backslashes need escaping
+	file << "  \"allocations\": [\n";
+	size_t index = 0;
+	for (auto& entry : entries)
+	{
+		std::string owner;
+		for (char c : entry.second.owner)
+		{
+			if (c == '"' || c == '\\')
+			{
+				owner.push_back('\\');
+			}
+			owner.push_back(c);
+		}
+
+		file << "    { \"category\": \"" << getCategoryName(entry.second.category) << "\", "
+			<< "\"owner\": \"" << owner << "\", "
+			<< "\"bytes\": " << entry.second.size << " }"
+			<< (++index < entries.size() ? ",\n" : "\n");
+	}
+	file << "  ]\n";
+	file << "}\n";
+
+	return true;
+}
+
+void MemoryTracker::log() const
+{
+	LOGD("Memory: %llu KB in use, peak %llu KB",
+		static_cast<unsigned long long>(stats.currentBytes / 1024), static_cast<unsigned long long>(stats.peakBytes / 1024));
+
+	for (size_t i = 0; i < static_cast<size_t>(rhi::MemoryCategory::Count); i++)
+	{
+		const rhi::MemoryCategoryStats& categoryStats = stats.categories[i];
+		if (categoryStats.peakBytes == 0)
+		{
+			continue;
+		}
+
+		LOGD("  %s: %u allocations, %llu KB, peak %llu KB", getCategoryName(static_cast<rhi::MemoryCategory>(i)), categoryStats.allocationCount,
+			static_cast<unsigned long long>(categoryStats.currentBytes / 1024), static_cast<unsigned long long>(categoryStats.peakBytes / 1024));
+	}
+
+	if (stats.budgetAvailable)
+	{
+		LOGD("  Device local heaps: %llu MB used of %llu MB budget",
+			static_cast<unsigned long long>(stats.heapUsageBytes / (1024 * 1024)), static_cast<unsigned long long>(stats.heapBudgetBytes / (1024 * 1024)));
+	}
+}
+
+const char* MemoryTracker::getCategoryName(rhi::MemoryCategory category)
+{
+	switch (category)
+	{
+	case rhi::MemoryCategory::Geometry:
+		return "Geometry";
+	case rhi::MemoryCategory::Uniform:
+		return "Uniform";
+	case rhi::MemoryCategory::Storage:
+		return "Storage";
+	case rhi::MemoryCategory::Staging:
+		return "Staging";
+	case rhi::MemoryCategory::Texture:
+		return "Texture";
+	case rhi::MemoryCategory::RenderTarget:
+		return "RenderTarget";
+	case rhi::MemoryCategory::Scratch:
+		return "Scratch";
+	case rhi::MemoryCategory::AccelerationStructure:
+		return "AccelerationStructure";
+	default:
+		return "Other";
+	}
+}
+
+rhi::MemoryCategory MemoryTracker::getBufferCategory(VkBufferUsageFlags usage)
+{
+	if (usage & VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR)
+	{
+		return rhi::MemoryCategory::AccelerationStructure;
+	}
+	if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+	{
+		return rhi::MemoryCategory::Geometry;
+	}
+	if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+	{
+		return rhi::MemoryCategory::Uniform;
+	}
+	if (usage & VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+	{
+		return rhi::MemoryCategory::Storage;
+	}
+	if (usage == VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+	{
+		return rhi::MemoryCategory::Staging;
+	}
+	return rhi::MemoryCategory::Other;
+}
+
+rhi::MemoryCategory MemoryTracker::getImageCategory(VkImageUsageFlags usage)
+{
+	const VkImageUsageFlags attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+		VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+	return (usage & attachmentUsage) ? rhi::MemoryCategory::RenderTarget : rhi::MemoryCategory::Texture;
+}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include "rhi/context.h"
+#include "vulkan/vk_wrapper.h"
+
+namespace vk
+{
+const uint32_t kMemoryBudgetPollInterval = 60;
+const uint32_t kMemoryLogInterval = 1800;
+
+// Accounts the memory of buffers and images by category and owner. The tracked sizes are what the
+// resources asked for, the driver's view of the device local heaps is polled from
+// VK_EXT_memory_budget next to it and includes allocator blocks and everything else.
+class MemoryTracker
+{
+public:
+	MemoryTracker();
+
+	void init(VkPhysicalDevice physicalDevice, bool budgetSupported);
+
+	void destroy();
+
+	// Returns the id to untrack the allocation with
+	uint32_t track(rhi::MemoryCategory category, const std::string& owner, VkDeviceSize size);
+
+	void untrack(uint32_t id);
+
+	// Called once per frame, polls the budget and logs the stats now and then
+	void update();
+
+	const rhi::MemoryBudgetStats& getStats() const { return stats; }
+
+	bool writeJson(const std::string& path) const;
+
+	void log() const;
+
+	static const char* getCategoryName(rhi::MemoryCategory category);
+
+	static rhi::MemoryCategory getBufferCategory(VkBufferUsageFlags usage);
+
+	static rhi::MemoryCategory getImageCategory(VkImageUsageFlags usage);
+
+private:
+	struct Entry
+	{
+		rhi::MemoryCategory category;
+		std::string owner;
+		VkDeviceSize size;
+	};
+
+	void pollBudget();
+
+	VkPhysicalDevice physicalDevice;
+	bool budgetSupported;
+	uint32_t frameCount;
+	uint32_t nextId;
+	std::unordered_map<uint32_t, Entry> entries;
+	rhi::MemoryBudgetStats stats;
+};
+}
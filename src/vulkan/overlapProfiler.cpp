@@ -0,0 +1,154 @@
+#include <algorithm>
+#include "vulkan/overlapProfiler.h"
+#include "vulkan/commandBuffer.h"
+
+namespace vk
+{
+OverlapProfiler::OverlapProfiler()
+	: timestampPeriod(1.0f)
+	, hasPendingCompute(false)
+	, pendingCompute()
+	, stats()
+{
+
+}
+
+bool OverlapProfiler::init(VkDevice device, uint32_t framesInFlight, float timestampPeriod)
+{
+	this->timestampPeriod = timestampPeriod;
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = framesInFlight * kQueriesPerFrame;
+	VKCALL(queryPool.init(device, queryPoolCreateInfo));
+
+	frames.resize(framesInFlight);
+	for (auto& frame : frames)
+	{
+		frame = Frame();
+	}
+	return true;
+}
+
+void OverlapProfiler::destroy(VkDevice device)
+{
+	if (stats.frameCount != 0)
+	{
+		LOGD("Async compute: %u frames, %.3f ms compute per frame, %.3f ms of it overlapped with graphics",
+			stats.frameCount, stats.computeTimeMs / stats.frameCount, stats.overlapTimeMs / stats.frameCount);
+	}
+
+	queryPool.destroy(device);
+	frames.clear();
+}
+
+void OverlapProfiler::beginGraphics(CommandBuffer* commandBuffer, uint32_t frameIndex)
+{
+	Frame& frame = frames[frameIndex];
+	const uint32_t firstQuery = getFirstQuery(frameIndex);
+
+	// The first graphics command buffer of a frame runs before anything else of it, so it resets the queries
+	if (frame.graphicsQueryCount == 0 && !frame.computeBegun)
+	{
+		commandBuffer->resetQueryPool(queryPool.getHandle(), firstQuery, kQueriesPerFrame);
+	}
+
+	if (frame.graphicsOpen || frame.graphicsQueryCount == kMaxGraphicsIntervals)
+	{
+		return;
+	}
+
+	commandBuffer->writeTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool.getHandle(), firstQuery + 2 + frame.graphicsQueryCount * 2);
+	frame.graphicsOpen = true;
+}
+
+void OverlapProfiler::endGraphics(CommandBuffer* commandBuffer, uint32_t frameIndex)
+{
+	Frame& frame = frames[frameIndex];
+	if (!frame.graphicsOpen)
+	{
+		return;
+	}
+
+	commandBuffer->writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool.getHandle(), getFirstQuery(frameIndex) + 3 + frame.graphicsQueryCount * 2);
+	frame.graphicsQueryCount++;
+	frame.graphicsOpen = false;
+}
+
+void OverlapProfiler::beginCompute(CommandBuffer* commandBuffer, uint32_t frameIndex)
+{
+	// Only the first async compute section of a frame is measured
+	Frame& frame = frames[frameIndex];
+	if (frame.computeBegun || frame.graphicsQueryCount == 0)
+	{
+		return;
+	}
+
+	commandBuffer->writeTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool.getHandle(), getFirstQuery(frameIndex));
+	frame.computeBegun = true;
+}
+
+void OverlapProfiler::endCompute(CommandBuffer* commandBuffer, uint32_t frameIndex)
+{
+	Frame& frame = frames[frameIndex];
+	if (!frame.computeBegun || frame.computeEnded)
+	{
+		return;
+	}
+
+	commandBuffer->writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool.getHandle(), getFirstQuery(frameIndex) + 1);
+	frame.computeEnded = true;
+}
+
+void OverlapProfiler::resolve(VkDevice device, uint32_t frameIndex)
+{
+	Frame& frame = frames[frameIndex];
+	const uint32_t firstQuery = getFirstQuery(frameIndex);
+
+	std::vector<Interval> graphics(frame.graphicsQueryCount);
+	if (!graphics.empty())
+	{
+		VKCALL(queryPool.getResults(device, firstQuery + 2, frame.graphicsQueryCount * 2, graphics.size() * sizeof(Interval),
+			graphics.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT));
+	}
+
+	// The compute work of the previous frame may also have overlapped with this frame's graphics work
+	if (hasPendingCompute)
+	{
+		stats.overlapTimeMs += toMilliseconds(getOverlap(pendingCompute, graphics));
+		hasPendingCompute = false;
+	}
+
+	if (frame.computeEnded)
+	{
+		Interval compute;
+		VKCALL(queryPool.getResults(device, firstQuery, 2, sizeof(Interval), &compute, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT));
+
+		stats.frameCount++;
+		stats.computeTimeMs += toMilliseconds(compute.end - compute.begin);
+		stats.overlapTimeMs += toMilliseconds(getOverlap(compute, graphics));
+
+		pendingCompute = compute;
+		hasPendingCompute = true;
+	}
+
+	frame = Frame();
+}
+
+uint64_t OverlapProfiler::getOverlap(const Interval& compute, const std::vector<Interval>& graphics) const
+{
+	// Graphics submits of one queue execute in order and don't overlap each other
+	uint64_t overlap = 0;
+	for (auto& interval : graphics)
+	{
+		const uint64_t begin = std::max(compute.begin, interval.begin);
+		const uint64_t end = std::min(compute.end, interval.end);
+		if (end > begin)
+		{
+			overlap += end - begin;
+		}
+	}
+	return overlap;
+}
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <vector>
+#include "rhi/context.h"
+#include "vulkan/vk_wrapper.h"
+
+namespace vk
+{
+const uint32_t kMaxGraphicsIntervals = 4;
+
+class CommandBuffer;
+
+// Measures how much of the async compute work ran while the graphics queue was busy as well.
+// Every graphics submit of a frame is bracketed by timestamps, and so is the compute work. Once a
+// frame is finished its compute interval is intersected with the graphics intervals of that frame
+// and of the next one, which is where the overlap with the following frame shows up.
+class OverlapProfiler
+{
+public:
+	OverlapProfiler();
+
+	bool init(VkDevice device, uint32_t framesInFlight, float timestampPeriod);
+
+	void destroy(VkDevice device);
+
+	void beginGraphics(CommandBuffer* commandBuffer, uint32_t frameIndex);
+
+	void endGraphics(CommandBuffer* commandBuffer, uint32_t frameIndex);
+
+	bool isGraphicsOpen(uint32_t frameIndex) const { return frames[frameIndex].graphicsOpen; }
+
+	void beginCompute(CommandBuffer* commandBuffer, uint32_t frameIndex);
+
+	void endCompute(CommandBuffer* commandBuffer, uint32_t frameIndex);
+
+	// Must be called once the frame fence of the frame index has signaled
+	void resolve(VkDevice device, uint32_t frameIndex);
+
+	const rhi::AsyncComputeStats& getStats() const { return stats; }
+
+private:
+	struct Interval
+	{
+		uint64_t begin;
+		uint64_t end;
+	};
+
+	struct Frame
+	{
+		uint32_t graphicsQueryCount;
+		bool graphicsOpen;
+		bool computeBegun;
+		bool computeEnded;
+	};
+
+	uint32_t getFirstQuery(uint32_t frameIndex) const { return frameIndex * kQueriesPerFrame; }
+
+	uint64_t getOverlap(const Interval& compute, const std::vector<Interval>& graphics) const;
+
+	double toMilliseconds(uint64_t ticks) const { return static_cast<double>(ticks) * timestampPeriod / 1000000.0; }
+
+	// Compute begin, compute end, then a begin and end query per graphics interval
+	static const uint32_t kQueriesPerFrame = 2 + kMaxGraphicsIntervals * 2;
+
+	handle::QueryPool queryPool;
+	std::vector<Frame> frames;
+	float timestampPeriod;
+
+	bool hasPendingCompute;
+	Interval pendingCompute;
+
+	rhi::AsyncComputeStats stats;
+};
+}
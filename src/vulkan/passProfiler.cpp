@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include "vulkan/passProfiler.h"
+#include "vulkan/commandBuffer.h"
+
+namespace vk
+{
+PassProfiler::PassProfiler()
+	: timestampPeriod(1.0f)
+	, resolvedFrameCount(0)
+{
+
+}
+
+bool PassProfiler::init(VkDevice device, uint32_t framesInFlight, float timestampPeriod)
+{
+	this->timestampPeriod = timestampPeriod;
+
+	VkQueryPoolCreateInfo queryPoolCreateInfo = {};
+	queryPoolCreateInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolCreateInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolCreateInfo.queryCount = framesInFlight * kQueriesPerFrame;
+	VKCALL(queryPool.init(device, queryPoolCreateInfo));
+
+	frames.clear();
+	frames.resize(framesInFlight);
+	return true;
+}
+
+void PassProfiler::destroy(VkDevice device)
+{
+	if (resolvedFrameCount != 0)
+	{
+		log();
+	}
+
+	queryPool.destroy(device);
+	frames.clear();
+	histories.clear();
+	events.clear();
+}
+
+void PassProfiler::beginPass(CommandBuffer* commandBuffer, uint32_t frameIndex, const std::string& name, uint32_t queue)
+{
+	Frame& frame = frames[frameIndex];
+	if (frame.passOpen || frame.passes.size() == kMaxTimedPassesPerFrame)
+	{
+		return;
+	}
+
+	const uint32_t firstQuery = getFirstQuery(frameIndex);
+
+	// The first pass of a frame runs before any other pass of it, so it resets the queries
+	if (frame.passes.empty())
+	{
+		commandBuffer->resetQueryPool(queryPool.getHandle(), firstQuery, kQueriesPerFrame);
+	}
+
+	commandBuffer->writeTimestamp(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool.getHandle(), firstQuery + static_cast<uint32_t>(frame.passes.size()) * 2);
+	frame.passes.push_back({ name, queue });
+	frame.passOpen = true;
+}
+
+void PassProfiler::endPass(CommandBuffer* commandBuffer, uint32_t frameIndex)
+{
+	Frame& frame = frames[frameIndex];
+	if (!frame.passOpen)
+	{
+		return;
+	}
+
+	const uint32_t query = getFirstQuery(frameIndex) + static_cast<uint32_t>(frame.passes.size()) * 2 - 1;
+	commandBuffer->writeTimestamp(VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool.getHandle(), query);
+	frame.passOpen = false;
+}
+
+void PassProfiler::resolve(VkDevice device, uint32_t frameIndex)
+{
+	Frame& frame = frames[frameIndex];
+	ASSERT(!frame.passOpen);
+
+	if (frame.passes.empty())
+	{
+		return;
+	}
+
+	// The fence has signaled, every query of the frame is available and nothing waits here
+	std::vector<uint64_t> timestamps(frame.passes.size() * 2);
+	VKCALL(queryPool.getResults(device, getFirstQuery(frameIndex), static_cast<uint32_t>(timestamps.size()), timestamps.size() * sizeof(uint64_t),
+		timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT));
+
+	for (size_t i = 0; i < frame.passes.size(); i++)
+	{
+		const uint64_t begin = timestamps[i * 2];
+		const uint64_t end = std::max(timestamps[i * 2 + 1], begin);
+
+		History& history = histories[frame.passes[i].name];
+		if (history.samples.size() < kPassTimingWindow)
+		{
+			history.samples.push_back(toMilliseconds(end - begin));
+		}
+		else
+		{
+			history.samples[history.next] = toMilliseconds(end - begin);
+		}
+		history.next = (history.next + 1) % kPassTimingWindow;
+
+		events.push_back({ frame.passes[i].name, frame.passes[i].queue, resolvedFrameCount, begin, end });
+	}
+
+	resolvedFrameCount++;
+	while (!events.empty() && events.front().frame + kPassTraceFrames < resolvedFrameCount)
+	{
+		events.pop_front();
+	}
+
+	if (resolvedFrameCount % kPassSummaryInterval == 0)
+	{
+		log();
+	}
+
+	frame = Frame();
+}
+
+std::vector<rhi::PassTimingStats> PassProfiler::getStats() const
+{
+	std::vector<rhi::PassTimingStats> stats;
+	stats.reserve(histories.size());
+
+	for (auto& entry : histories)
+	{
+		const History& history = entry.second;
+		if (history.samples.empty())
+		{
+			continue;
+		}
+
+		std::vector<double> samples = history.samples;
+		std::sort(samples.begin(), samples.end());
+
+		rhi::PassTimingStats& passStats = stats.emplace_back();
+		passStats.name = entry.first;
+		passStats.sampleCount = static_cast<uint32_t>(samples.size());
+		passStats.minMs = samples.front();
+		for (double sample : samples)
+		{
+			passStats.avgMs += sample;
+		}
+		passStats.avgMs /= samples.size();
+
+		const size_t p95Index = static_cast<size_t>(std::ceil(samples.size() * 0.95)) - 1;
+		passStats.p95Ms = samples[p95Index];
+	}
+	return stats;
+}
+
+bool PassProfiler::writeTrace(const std::string& path) const
+{
+	std::ofstream file(path);
+	if (!file.is_open())
+	{
+		LOGE("Failed to open %s for the pass trace", path.c_str());
+		return false;
+	}
+
+	// Timestamps of the queues share one time domain, the trace starts at the oldest pass kept
+	uint64_t origin = UINT64_MAX;
+	for (auto& event : events)
+	{
+		origin = std::min(origin, event.begin);
+	}
+
+	file << "{\n";
+	file << "  \"displayTimeUnit\": \"ms\",\n";
+	file << "  \"traceEvents\": [\n";
+	file << "    { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 0, \"args\": { \"name\": \"Graphics queue\" } },\n";
+	file << "    { \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, \"tid\": 1, \"args\": { \"name\": \"Async compute queue\" } }"
+		<< (events.empty() ? "\n" : ",\n");
+
+	// Pass names are fixed identifiers, only quotes and backslashes need escaping
+	size_t index = 0;
+	for (auto& event : events)
+	{
+		std::string name;
+		for (char c : event.name)
+		{
+			if (c == '"' || c == '\\')
+			{
+				name.push_back('\\');
+			}
+			name.push_back(c);
+		}
+
+		file << "    { \"name\": \"" << name << "\", \"cat\": \"gpu\", \"ph\": \"X\", "
+			<< "\"pid\": 0, \"tid\": " << event.queue << ", "
+			<< "\"ts\": " << toMilliseconds(event.begin - origin) * 1000.0 << ", "
+			<< "\"dur\": " << toMilliseconds(event.end - event.begin) * 1000.0 << ", "
+			<< "\"args\": { \"frame\": " << event.frame << " } }"
+			<< (++index < events.size() ? ",\n" : "\n");
+	}
+	file << "  ]\n";
+	file << "}\n";
+
+	return true;
+}
+
+void PassProfiler::log() const
+{
+	LOGD("GPU pass timings over the last %u frames", kPassTimingWindow);
+	for (auto& passStats : getStats())
+	{
+		LOGD("  %-24s min %.3f ms, avg %.3f ms, p95 %.3f ms", passStats.name.c_str(), passStats.minMs, passStats.avgMs, passStats.p95Ms);
+	}
+}
+}
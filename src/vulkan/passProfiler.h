@@ -0,0 +1,91 @@
+#pragma once
+
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+#include "rhi/context.h"
+#include "vulkan/vk_wrapper.h"
+
+namespace vk
+{
+const uint32_t kMaxTimedPassesPerFrame = 32;
+// Samples per pass the rolling statistics are computed over
+const uint32_t kPassTimingWindow = 128;
+// Frames kept for the trace export
+const uint32_t kPassTraceFrames = 64;
+// Resolved frames between two summaries in the log
+const uint32_t kPassSummaryInterval = 600;
+
+class CommandBuffer;
+
+// Times every render graph pass on the GPU. Each pass is bracketed by a pair of timestamps in
+// the query range of its frame, which is read back once the frame fence has signaled, so the
+// results come in framesInFlight frames later without stalling.
+class PassProfiler
+{
+public:
+	PassProfiler();
+
+	bool init(VkDevice device, uint32_t framesInFlight, float timestampPeriod);
+
+	void destroy(VkDevice device);
+
+	// Queue 0 is the graphics queue and 1 the async compute queue, they become threads in the trace
+	void beginPass(CommandBuffer* commandBuffer, uint32_t frameIndex, const std::string& name, uint32_t queue);
+
+	void endPass(CommandBuffer* commandBuffer, uint32_t frameIndex);
+
+	// Must be called once the frame fence of the frame index has signaled
+	void resolve(VkDevice device, uint32_t frameIndex);
+
+	std::vector<rhi::PassTimingStats> getStats() const;
+
+	bool writeTrace(const std::string& path) const;
+
+	void log() const;
+
+private:
+	struct Pass
+	{
+		std::string name;
+		uint32_t queue;
+	};
+
+	struct Frame
+	{
+		std::vector<Pass> passes;
+		bool passOpen = false;
+	};
+
+	struct Event
+	{
+		std::string name;
+		uint32_t queue;
+		uint64_t frame;
+		uint64_t begin;
+		uint64_t end;
+	};
+
+	// Ring of the last durations of a pass
+	struct History
+	{
+		std::vector<double> samples;
+		uint32_t next = 0;
+	};
+
+	uint32_t getFirstQuery(uint32_t frameIndex) const { return frameIndex * kQueriesPerFrame; }
+
+	double toMilliseconds(uint64_t ticks) const { return static_cast<double>(ticks) * timestampPeriod / 1000000.0; }
+
+	static const uint32_t kQueriesPerFrame = kMaxTimedPassesPerFrame * 2;
+
+	handle::QueryPool queryPool;
+	std::vector<Frame> frames;
+	float timestampPeriod;
+
+	std::map<std::string, History> histories;
+	std::deque<Event> events;
+	uint64_t resolvedFrameCount;
+};
+}
@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include "rhi/context.h"
 #include "vulkan/commandBuffer.h"
 #include "vulkan/pipeline.h"
@@ -5,9 +6,31 @@
 #include "vulkan/rendertarget.h"
 #include "vulkan/descriptor.h"
 #include "vulkan/extension.h"
+#include "vulkan/layoutCache.h"
 
 namespace vk
 {
+namespace
+{
+std::vector<VkPushConstantRange> convertToVkPushConstantRanges(Context* context, const std::vector<rhi::PushConstantRange>& pushConstantRanges)
+{
+    std::vector<VkPushConstantRange> vkPushConstantRanges;
+    const uint32_t maxPushConstantsSize = context->getMaxPushConstantsSize();
+    for (auto& pushConstantRange : pushConstantRanges)
+    {
+        if (pushConstantRange.offset + pushConstantRange.size > maxPushConstantsSize)
+        {
+            // A pipeline without its layout would still get its descriptor sets bound and its draws recorded
+            LOGE("Push constant range [%u, %u) exceeds maxPushConstantsSize %u",
+                pushConstantRange.offset, pushConstantRange.offset + pushConstantRange.size, maxPushConstantsSize);
+            exit(1);
+        }
+        vkPushConstantRanges.push_back({ convertToVkShaderStageFlag(pushConstantRange.stage), pushConstantRange.offset, pushConstantRange.size });
+    }
+    return vkPushConstantRanges;
+}
+}
+
 void ShaderModuleContainer::destroy(rhi::Context* rhiContext)
 {
     Context* context = reinterpret_cast<Context*>(rhiContext);
@@ -43,19 +66,20 @@ void ShaderModuleContainer::build(rhi::Context* rhiContext)
 }
 
 Pipeline::Pipeline(VkPipelineBindPoint pipelineBindPoint)
-    : pipelineBindPoint(pipelineBindPoint)
+    : pipelineLayout(VK_NULL_HANDLE)
+    , pipelineBindPoint(pipelineBindPoint)
 {
 }
 
 void Pipeline::destroy(Context* context)
 {
-    pipelineLayout.destroy(context->getDevice());
+    pipelineLayout = VK_NULL_HANDLE;
     pipeline.destroy(context->getDevice());
 }
 
 VkPipelineLayout Pipeline::getLayout()
 {
-    return pipelineLayout.getHandle();
+    return pipelineLayout;
 }
 
 VkPipeline Pipeline::getHandle()
@@ -68,6 +92,12 @@ VkPipelineBindPoint Pipeline::getBindPoint()
     return pipelineBindPoint;
 }
 
+void Pipeline::recordPushConstants(Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data)
+{
+    ASSERT(pipelineLayout != VK_NULL_HANDLE);
+    context->getActiveCommandBuffer()->pushConstants(pipelineLayout, convertToVkShaderStageFlag(stage), offset, size, data);
+}
+
 GraphicsPipeline::GraphicsPipeline()
     : vk::Pipeline(VK_PIPELINE_BIND_POINT_GRAPHICS)
 {
@@ -176,13 +206,7 @@ void GraphicsPipeline::buildGraphics(rhi::Context* rhiContext, rhi::PipelineStat
         setLayouts.push_back(reinterpret_cast<DescriptorSet*>(descriptorSet)->getLayout());
     }
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
-    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
-
-    VKCALL(pipelineLayout.init(context->getDevice(), pipelineLayoutInfo));
+    pipelineLayout = context->getLayoutCache()->getPipelineLayout(context->getDevice(), setLayouts, convertToVkPushConstantRanges(context, pushConstantRanges));
 
     VkGraphicsPipelineCreateInfo graphicsPipelineCreateInfo = {};
     graphicsPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -196,9 +220,9 @@ void GraphicsPipeline::buildGraphics(rhi::Context* rhiContext, rhi::PipelineStat
     graphicsPipelineCreateInfo.pMultisampleState = &multisampleState;
     graphicsPipelineCreateInfo.pColorBlendState = &colorBlendState;
     graphicsPipelineCreateInfo.pDynamicState = &dynamicState;
-    graphicsPipelineCreateInfo.layout = pipelineLayout.getHandle();
+    graphicsPipelineCreateInfo.layout = pipelineLayout;
     graphicsPipelineCreateInfo.renderPass = renderTarget->getRenderpass();
-    graphicsPipelineCreateInfo.subpass = 0;
+    graphicsPipelineCreateInfo.subpass = pipelineState.getSubpass();
     graphicsPipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
 
     VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilState = {};    
@@ -244,6 +268,11 @@ void GraphicsPipeline::bind(rhi::Context* context)
     commandBuffer->bindPipeline(VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.getHandle());
 }
 
+void GraphicsPipeline::pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data)
+{
+    recordPushConstants(reinterpret_cast<Context*>(context), stage, offset, size, data);
+}
+
 ComputePipeline::ComputePipeline()
     : vk::Pipeline(VK_PIPELINE_BIND_POINT_COMPUTE)
 {
@@ -267,19 +296,13 @@ void ComputePipeline::buildCompute(rhi::Context* rhiContext, rhi::ShaderModuleCo
         setLayouts.push_back(reinterpret_cast<DescriptorSet*>(descriptorSet)->getLayout());
     }
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutInfo.pushConstantRangeCount = 0;
-    pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
-    pipelineLayoutInfo.pSetLayouts = setLayouts.data();
-
-    VKCALL(pipelineLayout.init(context->getDevice(), pipelineLayoutInfo));
+    pipelineLayout = context->getLayoutCache()->getPipelineLayout(context->getDevice(), setLayouts, convertToVkPushConstantRanges(context, pushConstantRanges));
 
     auto& shaderStageInfos = shaderModule->getPipelineShaderStageCreateInfos();
 
     VkComputePipelineCreateInfo computePipelineCreateInfo = {};
     computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-    computePipelineCreateInfo.layout = pipelineLayout.getHandle();
+    computePipelineCreateInfo.layout = pipelineLayout;
     computePipelineCreateInfo.stage = shaderStageInfos[0];
 
     VKCALL(pipeline.initCompute(context->getDevice(), computePipelineCreateInfo, nullptr));
@@ -292,6 +315,11 @@ void ComputePipeline::bind(rhi::Context* rhiContext)
     commandBuffer->bindPipeline(pipelineBindPoint, pipeline.getHandle());
 }
 
+void ComputePipeline::pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data)
+{
+    recordPushConstants(reinterpret_cast<Context*>(context), stage, offset, size, data);
+}
+
 RayTracingPipeline::RayTracingPipeline()
     : vk::Pipeline(VK_PIPELINE_BIND_POINT_RAY_TRACING_KHR)
     , rayGenShaderBindingTable(nullptr)
@@ -389,13 +417,7 @@ void RayTracingPipeline::buildRayTracing(rhi::Context* rhiContext, rhi::ShaderMo
         setLayouts.push_back(reinterpret_cast<DescriptorSet*>(descriptorSet)->getLayout());
     }
 
-    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
-    pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-    pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-    pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
-    pipelineLayoutCreateInfo.pSetLayouts = setLayouts.data();
-
-    VKCALL(pipelineLayout.init(context->getDevice(), pipelineLayoutCreateInfo));
+    pipelineLayout = context->getLayoutCache()->getPipelineLayout(context->getDevice(), setLayouts, convertToVkPushConstantRanges(context, pushConstantRanges));
 
     VkRayTracingPipelineCreateInfoKHR rayTracingPipelineCreateInfo = {};
     rayTracingPipelineCreateInfo.sType = VK_STRUCTURE_TYPE_RAY_TRACING_PIPELINE_CREATE_INFO_KHR;
@@ -404,7 +426,7 @@ void RayTracingPipeline::buildRayTracing(rhi::Context* rhiContext, rhi::ShaderMo
     rayTracingPipelineCreateInfo.groupCount = static_cast<uint32_t>(shaderGroups.size());
     rayTracingPipelineCreateInfo.pGroups = shaderGroups.data();
     rayTracingPipelineCreateInfo.maxPipelineRayRecursionDepth = maxRecursion;
-    rayTracingPipelineCreateInfo.layout = pipelineLayout.getHandle();
+    rayTracingPipelineCreateInfo.layout = pipelineLayout;
 
     VKCALL(pipeline.initRayTracing(context->getDevice(), rayTracingPipelineCreateInfo, nullptr));
 
@@ -477,4 +499,9 @@ void RayTracingPipeline::bind(rhi::Context* rhiContext)//, rhi::DescriptorSet* r
         1);
 }
 
+void RayTracingPipeline::pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data)
+{
+    recordPushConstants(reinterpret_cast<Context*>(context), stage, offset, size, data);
+}
+
 } // namespace vk
\ No newline at end of file
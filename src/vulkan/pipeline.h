@@ -43,8 +43,11 @@ public:
 
     VkPipelineBindPoint getBindPoint();
 protected:
+    void recordPushConstants(Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data);
+
     handle::Pipeline pipeline;
-    handle::PipelineLayout pipelineLayout;
+    // Owned by the layout cache of the context, pipelines with the same sets share it
+    VkPipelineLayout pipelineLayout;
     VkPipelineBindPoint pipelineBindPoint;
 };
 
@@ -58,6 +61,8 @@ public:
     void buildGraphics(rhi::Context* context, rhi::PipelineState& pipelineState, rhi::ShaderModuleContainer* shaderModule, rhi::VertexBuffer* inVertexbuffer, std::vector<rhi::DescriptorSet*>& descriptorSets, rhi::RenderTarget* renderTarget) override;
 
     void bind(rhi::Context* context) override;
+
+    void pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data) override;
 };
 
 class ComputePipeline : public rhi::ComputePipeline, public Pipeline
@@ -70,6 +75,8 @@ public:
     void buildCompute(rhi::Context* context, rhi::ShaderModuleContainer* shaderModule, std::vector<rhi::DescriptorSet*>& descriptorSet) override;
 
     void bind(rhi::Context* context) override;
+
+    void pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data) override;
 };
 
 class RayTracingPipeline : public rhi::RayTracingPipeline, public Pipeline
@@ -82,6 +89,8 @@ public:
     void buildRayTracing(rhi::Context* context, rhi::ShaderModuleContainer* shaderModule, rhi::DescriptorSet* descriptorSet) override;
 
     void bind(rhi::Context* context) override;
+
+    void pushConstants(rhi::Context* context, rhi::ShaderStageFlags stage, uint32_t offset, uint32_t size, const void* data) override;
 private:
     std::vector<VkRayTracingShaderGroupCreateInfoKHR> shaderGroups;
 
@@ -4,9 +4,9 @@
 
 namespace vk
 {
-bool Queue::init(VkDevice device, uint32_t queueFamilyIndex)
+bool Queue::init(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex)
 {
-	queue.getDeviceQueue(device, queueFamilyIndex, 0);
+	queue.getDeviceQueue(device, queueFamilyIndex, queueIndex);
 	return true;
 }
 
@@ -17,34 +17,92 @@ void Queue::destroy(VkDevice device)
 
 bool Queue::submit(CommandBuffer* commandBuffer, std::vector<VkSemaphore>* waitSemaphores, std::vector<VkSemaphore>* signalSemaphores)
 {
-	const uint32_t commandBufferCount = 1;
-	VkCommandBuffer commandBuffers[commandBufferCount] = { commandBuffer->getHandle() };
+	return submit(commandBuffer, waitSemaphores, signalSemaphores, TimelinePoint(), TimelinePoint());
+}
 
-	VkSubmitInfo submitInfo = {};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.pNext = nullptr;
-	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = commandBuffers;
+bool Queue::submit(CommandBuffer* commandBuffer, VkSemaphore waitSemaphore, uint64_t waitValue, VkPipelineStageFlags waitStage,
+	VkSemaphore signalSemaphore, uint64_t signalValue)
+{
+	TimelinePoint timelineWait;
+	timelineWait.semaphore = waitSemaphore;
+	timelineWait.value = waitValue;
+	timelineWait.stage = waitStage;
+
+	TimelinePoint timelineSignal;
+	timelineSignal.semaphore = signalSemaphore;
+	timelineSignal.value = signalValue;
 
+	return submit(commandBuffer, nullptr, nullptr, timelineWait, timelineSignal);
+}
+
+bool Queue::submit(CommandBuffer* commandBuffer, std::vector<VkSemaphore>* waitSemaphores, std::vector<VkSemaphore>* signalSemaphores,
+	const TimelinePoint& timelineWait, const TimelinePoint& timelineSignal)
+{
+	VkCommandBuffer commandBufferHandle = commandBuffer->getHandle();
+
+	// Binary semaphores ignore their value, but the value arrays have to cover every semaphore
+	std::vector<VkSemaphore> submitWaitSemaphores;
+	std::vector<VkPipelineStageFlags> waitDstStages;
+	std::vector<uint64_t> waitValues;
 	if (waitSemaphores)
 	{
-		VkPipelineStageFlags waitDstStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores->size());
-		submitInfo.pWaitSemaphores = waitSemaphores->data();
-		submitInfo.pWaitDstStageMask = &waitDstStage;
+		submitWaitSemaphores = *waitSemaphores;
+		waitDstStages.resize(waitSemaphores->size(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		waitValues.resize(waitSemaphores->size(), 0);
+	}
+	if (timelineWait.semaphore != VK_NULL_HANDLE)
+	{
+		submitWaitSemaphores.push_back(timelineWait.semaphore);
+		waitDstStages.push_back(timelineWait.stage);
+		waitValues.push_back(timelineWait.value);
 	}
 
+	std::vector<VkSemaphore> submitSignalSemaphores;
+	std::vector<uint64_t> signalValues;
 	if (signalSemaphores)
 	{
-		submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores->size());
-		submitInfo.pSignalSemaphores = signalSemaphores->data();
+		submitSignalSemaphores = *signalSemaphores;
+		signalValues.resize(signalSemaphores->size(), 0);
+	}
+	if (timelineSignal.semaphore != VK_NULL_HANDLE)
+	{
+		submitSignalSemaphores.push_back(timelineSignal.semaphore);
+		signalValues.push_back(timelineSignal.value);
+	}
+
+	VkTimelineSemaphoreSubmitInfo timelineSubmitInfo = {};
+	timelineSubmitInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+	timelineSubmitInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+	timelineSubmitInfo.pWaitSemaphoreValues = waitValues.data();
+	timelineSubmitInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+	timelineSubmitInfo.pSignalSemaphoreValues = signalValues.data();
+
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBufferHandle;
+	submitInfo.waitSemaphoreCount = static_cast<uint32_t>(submitWaitSemaphores.size());
+	submitInfo.pWaitSemaphores = submitWaitSemaphores.data();
+	submitInfo.pWaitDstStageMask = waitDstStages.data();
+	submitInfo.signalSemaphoreCount = static_cast<uint32_t>(submitSignalSemaphores.size());
+	submitInfo.pSignalSemaphores = submitSignalSemaphores.data();
+
+	// The timeline info is only chained when a timeline semaphore takes part
+	if (timelineWait.semaphore != VK_NULL_HANDLE || timelineSignal.semaphore != VK_NULL_HANDLE)
+	{
+		submitInfo.pNext = &timelineSubmitInfo;
 	}
 
 	VKCALL(queue.submit(submitInfo, commandBuffer->getFence()));
+	COUNT_COMMAND(submits, 1);
 
 	return true;
 }
 
+void Queue::signal(VkFence fence)
+{
+	VKCALL(vkQueueSubmit(queue.getHandle(), 0, nullptr, fence));
+}
 
 VkResult Queue::present(VkSwapchainKHR swapchain, uint32_t imageIndex, std::vector<VkSemaphore>* waitSemaphores)
 {
@@ -6,15 +6,33 @@ namespace vk
 {
 class CommandBuffer;
 
+// Timeline semaphore wait or signal, a null semaphore means none
+struct TimelinePoint
+{
+	VkSemaphore semaphore = VK_NULL_HANDLE;
+	uint64_t value = 0;
+	VkPipelineStageFlags stage = 0;
+};
+
 class Queue
 {
 public:
-	bool init(VkDevice device, uint32_t queueFamilyIndex);
+	bool init(VkDevice device, uint32_t queueFamilyIndex, uint32_t queueIndex = 0);
 
 	void destroy(VkDevice device);
 
 	bool submit(CommandBuffer* commandBuffer, std::vector<VkSemaphore>* waitSemaphores = nullptr, std::vector<VkSemaphore>* signalSemaphores = nullptr);
 
+	// Timeline semaphore submit, a null semaphore skips the wait or the signal
+	bool submit(CommandBuffer* commandBuffer, VkSemaphore waitSemaphore, uint64_t waitValue, VkPipelineStageFlags waitStage,
+		VkSemaphore signalSemaphore, uint64_t signalValue);
+
+	// Binary semaphores together with a timeline wait and signal
+	bool submit(CommandBuffer* commandBuffer, std::vector<VkSemaphore>* waitSemaphores, std::vector<VkSemaphore>* signalSemaphores,
+		const TimelinePoint& timelineWait, const TimelinePoint& timelineSignal);
+
+	// Signals the fence once all previously submitted work has completed
+	void signal(VkFence fence);
 
 	VkResult present(VkSwapchainKHR swapchain, uint32_t imageIndex, std::vector<VkSemaphore>* waitSemaphores = nullptr);
 
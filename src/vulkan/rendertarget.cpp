@@ -1,3 +1,4 @@
+#include <algorithm>
 #include "rhi/context.h"
 #include "vulkan/rendertarget.h"
 #include "vulkan/commandBuffer.h"
@@ -22,7 +23,7 @@ SubpassDescription::~SubpassDescription()
     }
 }
 
-void SubpassDescription::init(rhi::Subpass* subpass, VkSubpassDescription* subpassDescription)
+void SubpassDescription::init(rhi::Subpass* subpass, uint8_t depthStencilAttachment, VkSubpassDescription* subpassDescription)
 {
     uint8_t depthAttachment = subpass->getDepthAttachment();
 
@@ -33,7 +34,7 @@ void SubpassDescription::init(rhi::Subpass* subpass, VkSubpassDescription* subpa
 
     for (auto& attachment : subpass->getInputAttachments())
     {
-        if (attachment != depthAttachment)
+        if (attachment != depthStencilAttachment)
         {
             inputAttachmentReferences.push_back({
                     attachment, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
@@ -91,8 +92,10 @@ VkRenderPass Renderpass::getRenderpass()
     return renderpass.getHandle();
 }
 
-RenderTarget::RenderTarget(uint16_t width, uint16_t height)
+RenderTarget::RenderTarget(uint16_t width, uint16_t height, rhi::RenderTargetType type)
     : rhi::RenderTarget(width, height)
+    , type(type)
+    , currentSubpass(0)
 {
 
 }
@@ -104,7 +107,7 @@ void RenderTarget::destroy(rhi::Context* context)
 
     for (auto& image : images)
     {
-        image->destroy(contextVk->getDevice());
+        image->destroy(contextVk);
     }
     framebuffer.destroy(contextVk->getDevice());
     renderpass.destroy(contextVk->getDevice());
@@ -118,11 +121,37 @@ void RenderTarget::buildRenderpass(rhi::Context* context, std::vector<VkAttachme
     std::vector<VkSubpassDependency> subpassDependencies;
     std::vector<SubpassDescription> subpassDescriptionDatas;
 
-    for (auto& subpass : subpasses)
+    // Subpass descriptions point into these, they must not move
+    subpassDescriptionDatas.reserve(subpasses.size());
+
+    // Color attachments are described first, the depth stencil attachment comes after them
+    const uint8_t depthAttachmentIndex = depthStencilAttachment != nullptr ?
+        static_cast<uint8_t>(attachments.size()) : rhi::INVALID_ATTACHMENT_INDEX;
+
+    for (uint32_t dstSubpass = 0; dstSubpass < subpasses.size(); dstSubpass++)
     {
+        rhi::Subpass* subpass = subpasses[dstSubpass];
         auto& subpassDescription = subpassDescriptions.emplace_back();
         auto& subpassDescriptionData = subpassDescriptionDatas.emplace_back();
-        subpassDescriptionData.init(subpass, &subpassDescription);
+        subpassDescriptionData.init(subpass, depthAttachmentIndex, &subpassDescription);
+
+        // Input attachments wait for the last earlier subpass that wrote them, by region so tiles stay on chip
+        for (auto& inputAttachment : subpass->getInputAttachments())
+        {
+            const bool depthStencil = inputAttachment == depthAttachmentIndex;
+            for (uint32_t srcSubpass = dstSubpass; srcSubpass-- > 0;)
+            {
+                std::vector<uint8_t>& colorAttachments = subpasses[srcSubpass]->getColorAttachments();
+                const bool written = depthStencil ?
+                    subpasses[srcSubpass]->getDepthAttachment() == inputAttachment :
+                    std::find(colorAttachments.begin(), colorAttachments.end(), inputAttachment) != colorAttachments.end();
+                if (written)
+                {
+                    addSubpassDependency(&subpassDependencies, srcSubpass, dstSubpass, depthStencil);
+                    break;
+                }
+            }
+        }
     }
 
     renderpass.init(contextVk->getDevice(), &attachmentDescriptions, &subpassDescriptions, &subpassDependencies);
@@ -157,46 +186,129 @@ void RenderTarget::prepareBegin(CommandBuffer* commandBuffer)
     }
 }
 
-ImageLayout getAttachmentImageLayout(VkFormat format, rhi::MemoryAccessFlags accessFlags)
+ImageLayout RenderTarget::getImageLayout(VkFormat format, rhi::ResourceUsage usage)
 {
-    VkImageAspectFlags aspectFlags = getImageAspectMask(format);
+    const bool isColor = (getImageAspectMask(format) & VK_IMAGE_ASPECT_COLOR_BIT) != 0;
 
-    // Color
-    if ((aspectFlags & VK_IMAGE_ASPECT_COLOR_BIT) != 0)
+    switch (usage)
     {
-        if (accessFlags & rhi::MemoryAccess::Read)
+    case rhi::ResourceUsage::Sampled:
+    case rhi::ResourceUsage::StorageRead:
+        if (!isColor)
         {
-            return ImageLayout::FragmentShaderReadOnly;
+            // Sampled depth keeps the depth stencil read only layout the descriptors are written with
+            return (type == rhi::RenderTargetType::Graphics || type == rhi::RenderTargetType::Surface) ?
+                ImageLayout::DSAttachmentReadAndFragmentShaderRead : ImageLayout::DSAttachmentReadAndAllShadersRead;
         }
-        if (accessFlags & rhi::MemoryAccess::Write)
+        switch (type)
         {
-            return ImageLayout::ColorAttachment;
+        case rhi::RenderTargetType::Compute:
+            return ImageLayout::ComputeShaderReadOnly;
+        case rhi::RenderTargetType::RayTracing:
+            return ImageLayout::ExternalShadersReadOnly;
+        default:
+            return ImageLayout::FragmentShaderReadOnly;
         }
-        if (accessFlags & rhi::MemoryAccess::General)
+    case rhi::ResourceUsage::StorageWrite:
+        switch (type)
         {
+        case rhi::RenderTargetType::Compute:
             return ImageLayout::ComputeShaderWrite;
+        case rhi::RenderTargetType::RayTracing:
+            return ImageLayout::ExternalShadersWrite;
+        default:
+            return ImageLayout::FragmentShaderWrite;
         }
-        
+    case rhi::ResourceUsage::ColorAttachment:
+        ASSERT(isColor);
+        return ImageLayout::ColorAttachment;
+    case rhi::ResourceUsage::DepthStencilAttachment:
+        ASSERT(!isColor);
+        return ImageLayout::DepthStencilAttachment;
+    default:
         UNREACHABLE();
+        return ImageLayout::Undefined;
     }
-    // Depth-Stencil
-    else
+}
+
+void RenderTarget::getBufferAccess(rhi::ResourceUsage usage, VkPipelineStageFlags* stageFlags, VkAccessFlags* accessFlags)
+{
+    switch (type)
     {
-        if (accessFlags & rhi::MemoryAccess::Read)
-        {
-            return ImageLayout::DepthStencilAttachmentReadOnly;
-        }
-        if (accessFlags & rhi::MemoryAccess::Write)
-        {
-            return ImageLayout::DepthStencilAttachment;
-        }
-        if (accessFlags & rhi::MemoryAccess::General)
+    case rhi::RenderTargetType::Compute:
+        *stageFlags = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+        break;
+    case rhi::RenderTargetType::RayTracing:
+        *stageFlags = VK_PIPELINE_STAGE_RAY_TRACING_SHADER_BIT_KHR;
+        break;
+    default:
+        *stageFlags = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        break;
+    }
+
+    switch (usage)
+    {
+    case rhi::ResourceUsage::Sampled:
+    case rhi::ResourceUsage::StorageRead:
+        *accessFlags = VK_ACCESS_SHADER_READ_BIT;
+        break;
+    case rhi::ResourceUsage::StorageWrite:
+        *accessFlags = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        break;
+    case rhi::ResourceUsage::IndirectArgument:
+        *stageFlags = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+        *accessFlags = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+        break;
+    default:
+        UNREACHABLE();
+        break;
+    }
+}
+
+VkPipelineStageFlags RenderTarget::getStageFlags(rhi::ResourceUsage usage)
+{
+    switch (usage)
+    {
+    case rhi::ResourceUsage::ColorAttachment:
+        return VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    case rhi::ResourceUsage::DepthStencilAttachment:
+        return VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    default:
+        break;
+    }
+
+    VkPipelineStageFlags stageFlags = 0;
+    VkAccessFlags accessFlags = 0;
+    getBufferAccess(usage, &stageFlags, &accessFlags);
+    return stageFlags;
+}
+
+void RenderTarget::addSubpassDependency(std::vector<VkSubpassDependency>* subpassDependencies, uint32_t srcSubpass, uint32_t dstSubpass, bool depthStencil)
+{
+    const VkPipelineStageFlags srcStageMask = depthStencil ?
+        VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    const VkAccessFlags srcAccessMask = depthStencil ?
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    for (auto& subpassDependency : *subpassDependencies)
+    {
+        if (subpassDependency.srcSubpass == srcSubpass && subpassDependency.dstSubpass == dstSubpass)
         {
-            return ImageLayout::ComputeShaderWrite;
+            subpassDependency.srcStageMask |= srcStageMask;
+            subpassDependency.srcAccessMask |= srcAccessMask;
+            return;
         }
-        
-        UNREACHABLE();
     }
+
+    VkSubpassDependency subpassDependency = {};
+    subpassDependency.srcSubpass = srcSubpass;
+    subpassDependency.dstSubpass = dstSubpass;
+    subpassDependency.srcStageMask = srcStageMask;
+    subpassDependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    subpassDependency.srcAccessMask = srcAccessMask;
+    subpassDependency.dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+    subpassDependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+    subpassDependencies->push_back(subpassDependency);
 }
 
 VkImageLayout getAttachmentVkImageLayout(VkFormat format)
@@ -216,19 +328,24 @@ VkImageLayout getAttachmentVkImageLayout(VkFormat format)
 void RenderTarget::addTransition(rhi::Context* context, rhi::Transition* transition)
 {
     Context* contextVk = reinterpret_cast<Context*>(context);
+    CommandBuffer* commandBuffer = contextVk->getActiveCommandBuffer();
     rhi::Texture* rhiTexture = transition->getTexture();
     rhi::StorageBuffer* rhiStorageBuffer = transition->getBuffer();
 
     if (rhiTexture)
-    {        
+    {
         Texture* texture = reinterpret_cast<Texture*>(rhiTexture);
-        ImageLayout imageLayout = getAttachmentImageLayout(texture->getFormat(), transition->getMemoryAccessFlags());
-        contextVk->getActiveCommandBuffer()->addTransition(texture->updateImageLayoutAndBarrier(imageLayout));
+        ImageLayout imageLayout = getImageLayout(texture->getFormat(), transition->getUsage());
+        commandBuffer->addTransition(texture->updateImageLayoutAndHazardBarrier(imageLayout));
     }
 
     if (rhiStorageBuffer)
     {
         StorageBuffer* buffer = reinterpret_cast<StorageBuffer*>(rhiStorageBuffer);
+        VkPipelineStageFlags stageFlags = 0;
+        VkAccessFlags accessFlags = 0;
+        getBufferAccess(transition->getUsage(), &stageFlags, &accessFlags);
+        commandBuffer->addTransition(buffer->updateAccessAndBarrier(stageFlags, accessFlags));
     }
 }
 
@@ -256,6 +373,7 @@ bool RenderTarget::begin(rhi::Context* context)
     renderpassBeginInfo.pClearValues = clearValues.data();
 
     commandBuffer->beginRenderPass(renderpassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    currentSubpass = 0;
 
     VkViewport viewport = {};
     viewport.x = static_cast<float>(renderArea.offset.x);
@@ -272,10 +390,23 @@ bool RenderTarget::begin(rhi::Context* context)
     return true;
 }
 
+bool RenderTarget::nextSubpass(rhi::Context* context)
+{
+    ASSERT(currentSubpass + 1 < subpasses.size());
+    Context* contextVk = reinterpret_cast<Context*>(context);
+    contextVk->getActiveCommandBuffer()->nextSubpass(VK_SUBPASS_CONTENTS_INLINE);
+    currentSubpass++;
+    return true;
+}
+
 bool RenderTarget::end(rhi::Context* context)
 {
     Context* contextVk = reinterpret_cast<Context*>(context);
     CommandBuffer* commandBuffer = contextVk->getActiveCommandBuffer();
+    while (currentSubpass + 1 < subpasses.size())
+    {
+        nextSubpass(context);
+    }
     commandBuffer->endRenderPass();
     return true;
 }
@@ -356,7 +487,7 @@ void RenderTarget::updateAttachmentDescriptions(Context* context,
 }
 
 SurfaceRenderTarget::SurfaceRenderTarget(uint16_t width, uint16_t height)
-    : RenderTarget(width, height)
+    : RenderTarget(width, height, rhi::RenderTargetType::Surface)
 {
 
 }
@@ -420,6 +551,7 @@ bool SurfaceRenderTarget::begin(rhi::Context* context)
     renderpassBeginInfo.pClearValues = clearValues.data();
 
     commandBuffer->beginRenderPass(renderpassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    currentSubpass = 0;
 
     VkViewport viewport = {};
     viewport.x = static_cast<float>(renderArea.offset.x);
@@ -435,8 +567,8 @@ bool SurfaceRenderTarget::begin(rhi::Context* context)
     return true;
 }
 
-NullRenderTarget::NullRenderTarget(uint16_t width, uint16_t height)
-    : RenderTarget(width, height)
+NullRenderTarget::NullRenderTarget(rhi::RenderTargetType type, uint16_t width, uint16_t height)
+    : RenderTarget(width, height, type)
 {
 
 }
@@ -459,6 +591,11 @@ bool NullRenderTarget::begin(rhi::Context* context)
     return true;
 }
 
+bool NullRenderTarget::nextSubpass(rhi::Context* context)
+{
+    return true;
+}
+
 bool NullRenderTarget::end(rhi::Context* context)
 {
     return true;
@@ -23,7 +23,7 @@ public:
 
     ~SubpassDescription();
 
-    void  init(rhi::Subpass* subpass, VkSubpassDescription* subpassDescription);
+    void  init(rhi::Subpass* subpass, uint8_t depthStencilAttachment, VkSubpassDescription* subpassDescription);
 private:
     
     std::vector<VkAttachmentReference> colorAttachmentReferences;
@@ -50,7 +50,7 @@ private:
 class RenderTarget : public rhi::RenderTarget
 {
 public:
-    RenderTarget(uint16_t width, uint16_t height);
+    RenderTarget(uint16_t width, uint16_t height, rhi::RenderTargetType type = rhi::RenderTargetType::Graphics);
 
     virtual void destroy(rhi::Context* context) override;
 
@@ -63,14 +63,25 @@ public:
 
     virtual bool begin(rhi::Context* context) override;
 
+    virtual bool nextSubpass(rhi::Context* context) override;
+
     virtual bool end(rhi::Context* context) override;
 
     void addTransition(rhi::Context* context, rhi::Transition* transition) override;
 
     void flushTransition(rhi::Context* context) override;
+
+    // Earliest stage the pass touches a resource at with the usage
+    VkPipelineStageFlags getStageFlags(rhi::ResourceUsage usage);
 public:
     VkRenderPass getRenderpass();
 protected:
+    ImageLayout getImageLayout(VkFormat format, rhi::ResourceUsage usage);
+
+    void getBufferAccess(rhi::ResourceUsage usage, VkPipelineStageFlags* stageFlags, VkAccessFlags* accessFlags);
+
+    void addSubpassDependency(std::vector<VkSubpassDependency>* subpassDependencies, uint32_t srcSubpass, uint32_t dstSubpass, bool depthStencil);
+
     void updateAttachmentDescriptions(Context* context,
                                       std::vector<VkAttachmentDescription>* attachmentDescriptions,
                                       std::vector<VkImageView>& attachmentViews);
@@ -80,6 +91,8 @@ protected:
     std::vector<vk::Image*> images;
     VkRect2D renderArea;
     std::vector<VkClearValue> clearValues;
+    rhi::RenderTargetType type;
+    uint32_t currentSubpass;
 };
 
 class SurfaceRenderTarget : public RenderTarget
@@ -103,7 +116,7 @@ private:
 class NullRenderTarget : public RenderTarget
 {
 public:
-    NullRenderTarget(uint16_t width, uint16_t height);
+    NullRenderTarget(rhi::RenderTargetType type, uint16_t width, uint16_t height);
 
     void destroy(rhi::Context* context) override;
 
@@ -111,6 +124,8 @@ public:
 
     bool begin(rhi::Context* context) override;
 
+    bool nextSubpass(rhi::Context* context) override;
+
     bool end(rhi::Context* context) override;
 };
 }
\ No newline at end of file
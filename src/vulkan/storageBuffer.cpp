@@ -10,8 +10,11 @@ namespace vk
 		: buffer(nullptr)
 		, bufferType(bufferType)
 		, descriptorBufferInfo()
-		, currentAccessFlags(VK_ACCESS_SHADER_READ_BIT) // TODO
-		, currentPipelineFlags(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT) // TODO
+		// The initial contents come from an upload
+		, writeStageFlags(VK_PIPELINE_STAGE_TRANSFER_BIT)
+		, writeAccessFlags(VK_ACCESS_TRANSFER_WRITE_BIT)
+		, readStageFlags(0)
+		, readAccessFlags(0)
 		, usageFlags(usageFlags)
 	{
 
@@ -63,37 +66,31 @@ namespace vk
 	VkBuffer StorageBuffer::getHandle() { return buffer->getBuffer(); }
 	size_t StorageBuffer::getSize() { return memoryBuffer.size(); }
 
-	Transition* StorageBuffer::getTransition(rhi::MemoryAccessFlags accessFlags)
+	Transition* StorageBuffer::updateAccessAndBarrier(VkPipelineStageFlags stageFlags, VkAccessFlags accessFlags)
 	{
-		VkAccessFlags srcAccessFlags =  currentAccessFlags;
-		VkPipelineStageFlags srcPipelineStageFlags = currentPipelineFlags;
+		const VkAccessFlags kWriteAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
 
-		VkAccessFlags dstAccessFlags = 0;
-		VkPipelineStageFlags dstPipelineStageFlags = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-
-		if (accessFlags & rhi::MemoryAccess::Read)
-		{
-			if (accessFlags & rhi::MemoryAccess::Indirect)
-			{
-				dstAccessFlags |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
-				dstPipelineStageFlags |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
-			}
-			else
-			{
-				dstAccessFlags |= VK_ACCESS_SHADER_READ_BIT;
-			}
-		}
-		else if (accessFlags & rhi::MemoryAccess::Write)
+		if ((accessFlags & kWriteAccessMask) == 0)
 		{
-			dstAccessFlags |= VK_ACCESS_SHADER_WRITE_BIT;
-			if (accessFlags & rhi::MemoryAccess::Indirect)
+			// Read after read, the last write was already made visible to these stages
+			if ((readStageFlags & stageFlags) == stageFlags && (readAccessFlags & accessFlags) == accessFlags)
 			{
-				dstPipelineStageFlags |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+				return nullptr;
 			}
+
+			readStageFlags |= stageFlags;
+			readAccessFlags |= accessFlags;
+			return new Transition(getHandle(), writeStageFlags, stageFlags, writeAccessFlags, accessFlags);
 		}
-		currentAccessFlags = dstAccessFlags;
-		currentPipelineFlags = dstPipelineStageFlags;
 
-		return new Transition(getHandle(), srcPipelineStageFlags, dstPipelineStageFlags, srcAccessFlags, dstAccessFlags);
+		// Write after read only needs an execution dependency, write after write a memory one as well
+		Transition* transition = new Transition(getHandle(), writeStageFlags | readStageFlags, stageFlags, writeAccessFlags, accessFlags);
+
+		writeStageFlags = stageFlags;
+		writeAccessFlags = accessFlags & kWriteAccessMask;
+		readStageFlags = 0;
+		readAccessFlags = 0;
+
+		return transition;
 	}
 }
\ No newline at end of file
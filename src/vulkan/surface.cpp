@@ -1,7 +1,10 @@
+#include <fstream>
 #include <vector>
 #include "platform/window.h"
 #include "vulkan/surface.h"
+#include "vulkan/buffer.h"
 #include "vulkan/commandBufferManager.h"
+#include "vulkan/context.h"
 #include "vulkan/queue.h"
 
 namespace vk
@@ -12,6 +15,9 @@ Surface::Surface()
     , swapchain(VK_NULL_HANDLE)
 	, currentImageIndex(0)
 	, imageCount(0)
+	, offscreen(false)
+	, readbackInterval(0)
+	, presentCount(0)
 {
 
 }
@@ -72,7 +78,7 @@ void Surface::selectSurfaceFormat(VkPhysicalDevice physicalDevice)
 	}
 }
 
-bool Surface::initSwapchain(VkPhysicalDevice physicalDevice, VkDevice device)
+bool Surface::initSwapchain(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t framesInFlight)
 {
 	// Store the current swap chain handle so we can use it later on to ease up recreation
 	VkSwapchainKHR oldSwapchain = swapchain;
@@ -172,7 +178,10 @@ bool Surface::initSwapchain(VkPhysicalDevice physicalDevice, VkDevice device)
 		// TODO:
 		for (auto& swapchainImage : swapchainImages)
 		{
-			swapchainImage->destroy(device);
+			// Presentable images are owned by the swapchain
+			swapchainImage->destroyImageView(device);
+			swapchainImage->release();
+			delete swapchainImage;
 		}
 		swapchainImages.clear();
 		vkDestroySwapchainKHR(device, oldSwapchain, nullptr);
@@ -195,7 +204,7 @@ bool Surface::initSwapchain(VkPhysicalDevice physicalDevice, VkDevice device)
 		swapchainImage->createImageView(device, surfaceFormat.format, getImageAspectMask(surfaceFormat.format));
 	}
 
-	acquireSemaphores.resize(imageCount);
+	acquireSemaphores.resize(framesInFlight);
 	presentSemaphores.resize(imageCount);
 
 	for (auto& semaphore : acquireSemaphores)
@@ -237,6 +246,117 @@ void Surface::destroySwapchain(VkDevice device)
 	}
 }
 
+bool Surface::initOffscreenSwapchain(Context* context, uint32_t framesInFlight)
+{
+	offscreen = true;
+	surfaceFormat.format = VK_FORMAT_R8G8B8A8_UNORM;
+	surfaceFormat.colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR;
+
+	// One image per frame in flight, the frame fence guards its reuse the way the acquire would
+	imageCount = framesInFlight;
+	currentImageIndex = 0;
+	swapchainImages.resize(imageCount);
+
+	for (auto& swapchainImage : swapchainImages)
+	{
+		swapchainImage = new vk::Image();
+		swapchainImage->setMemoryOwner("Offscreen swapchain");
+		swapchainImage->createImage(context, surfaceFormat.format, 1, 1, 1, { surfaceSize.width, surfaceSize.height, 1 },
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		swapchainImage->createImageView(context->getDevice(), surfaceFormat.format, getImageAspectMask(surfaceFormat.format));
+	}
+
+	if (readbackInterval != 0)
+	{
+		const size_t readbackSize = static_cast<size_t>(surfaceSize.width) * surfaceSize.height * 4;
+
+		readbackBuffers.resize(framesInFlight);
+		for (auto& readbackBuffer : readbackBuffers)
+		{
+			readbackBuffer = BufferFactory::createBuffer(rhi::BufferType::HostCached, VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, readbackSize);
+			readbackBuffer->setMemoryOwner(rhi::MemoryCategory::Staging, "Offscreen readback");
+			readbackBuffer->initBuffer(context, VK_BUFFER_USAGE_TRANSFER_DST_BIT);
+		}
+		pendingReadbacks.assign(framesInFlight, 0);
+
+		LOGD("Reading back every %u frames to %s", readbackInterval, readbackDirectory.c_str());
+	}
+
+	LOGD("Offscreen swapchain %ux%u with %u images", surfaceSize.width, surfaceSize.height, imageCount);
+	return true;
+}
+
+void Surface::destroyOffscreenSwapchain(Context* context)
+{
+	if (!offscreen)
+	{
+		return;
+	}
+
+	// The queue is idle, the frames still in flight can be written out
+	for (uint32_t i = 0; i < static_cast<uint32_t>(pendingReadbacks.size()); i++)
+	{
+		resolveReadback(context, i);
+	}
+	pendingReadbacks.clear();
+
+	for (auto& readbackBuffer : readbackBuffers)
+	{
+		readbackBuffer->destroy(context);
+		delete readbackBuffer;
+	}
+	readbackBuffers.clear();
+
+	for (auto& swapchainImage : swapchainImages)
+	{
+		swapchainImage->destroy(context);
+		delete swapchainImage;
+	}
+	swapchainImages.clear();
+	offscreen = false;
+}
+
+void Surface::resolveReadback(Context* context, uint32_t frameIndex)
+{
+	if (!offscreen || readbackInterval == 0 || pendingReadbacks[frameIndex] == 0)
+	{
+		return;
+	}
+
+	writeReadback(context, frameIndex);
+	pendingReadbacks[frameIndex] = 0;
+}
+
+void Surface::writeReadback(Context* context, uint32_t frameIndex)
+{
+	const size_t readbackSize = static_cast<size_t>(surfaceSize.width) * surfaceSize.height * 4;
+	const uint8_t* pixels = reinterpret_cast<const uint8_t*>(readbackBuffers[frameIndex]->mapMemory(context, readbackSize));
+
+	const std::string path = readbackDirectory + "/frame_" + std::to_string(pendingReadbacks[frameIndex]) + ".ppm";
+	std::ofstream file(path, std::ios::binary);
+	if (!file.is_open())
+	{
+		LOGE("Failed to open %s for the frame readback", path.c_str());
+		return;
+	}
+
+	// Binary PPM keeps the output readable without an image library, the alpha channel is dropped
+	file << "P6\n" << surfaceSize.width << " " << surfaceSize.height << "\n255\n";
+
+	std::vector<uint8_t> row(static_cast<size_t>(surfaceSize.width) * 3);
+	for (uint32_t y = 0; y < surfaceSize.height; y++)
+	{
+		const uint8_t* src = pixels + static_cast<size_t>(y) * surfaceSize.width * 4;
+		for (uint32_t x = 0; x < surfaceSize.width; x++)
+		{
+			row[x * 3 + 0] = src[x * 4 + 0];
+			row[x * 3 + 1] = src[x * 4 + 1];
+			row[x * 3 + 2] = src[x * 4 + 2];
+		}
+		file.write(reinterpret_cast<const char*>(row.data()), row.size());
+	}
+}
+
 bool Surface::validSurface() const { return surface != VK_NULL_HANDLE; }
 
 VkSurfaceKHR Surface::getSurface() { return surface; }
@@ -245,21 +365,58 @@ VkExtent2D Surface::getSurfaceSize() { return surfaceSize; }
 
 std::vector<vk::Image*>& Surface::getSwapchainImages() { return swapchainImages; }
 
-VkResult Surface::acquireNextImage(VkDevice device, CommandBufferManager* commandBufferManager, Queue* queue)
+VkResult Surface::acquireNextImage(VkDevice device, uint32_t frameIndex)
 {
-	VkSemaphore semaphore = acquireSemaphores[currentImageIndex].getHandle();
+	if (offscreen)
+	{
+		// Images are handed out in order by present
+		return VK_SUCCESS;
+	}
+
+	VkSemaphore semaphore = acquireSemaphores[frameIndex].getHandle();
 	VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, semaphore, VK_NULL_HANDLE, &currentImageIndex);
 	return result;
 }
 
 uint32_t Surface::getCurrentImageIdex() { return currentImageIndex; }
 
-VkResult Surface::present(VkDevice device, CommandBufferManager* commandBufferManager, Queue* queue)
+VkResult Surface::present(VkDevice device, CommandBufferManager* commandBufferManager, Queue* queue, uint32_t frameIndex)
 {
 	auto image = swapchainImages[currentImageIndex];
 	CommandBuffer* commandBuffer = commandBufferManager->getActiveCommandBuffer(device);
+
+	if (offscreen)
+	{
+		presentCount++;
+		if (readbackInterval != 0 && presentCount % readbackInterval == 0)
+		{
+			commandBuffer->addTransition(image->updateImageLayoutAndBarrier(ImageLayout::TransferSrc));
+			commandBuffer->flushTransitions();
+
+			VkBufferImageCopy copyRegion = {};
+			copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			copyRegion.imageSubresource.layerCount = 1;
+			copyRegion.imageExtent = { surfaceSize.width, surfaceSize.height, 1 };
+			commandBuffer->copyImageToBuffer(image->getImage(), readbackBuffers[frameIndex]->getBuffer(), copyRegion);
+
+			// The fence alone doesn't make the copy visible to the host
+			VkMemoryBarrier memoryBarrier = {};
+			memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			memoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+			commandBuffer->pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+				1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+			pendingReadbacks[frameIndex] = presentCount;
+		}
+
+		commandBufferManager->submitActiveCommandBuffer(device, queue);
+		setNextImageIndex();
+		return VK_SUCCESS;
+	}
+
 	commandBuffer->addTransition(image->updateImageLayoutAndBarrier(ImageLayout::Present));
-	std::vector<VkSemaphore> waitSemaphores = { acquireSemaphores[currentImageIndex].getHandle() };
+	std::vector<VkSemaphore> waitSemaphores = { acquireSemaphores[frameIndex].getHandle() };
 	std::vector<VkSemaphore> signalSemaphores = { presentSemaphores[currentImageIndex].getHandle() };
 	commandBufferManager->submitActiveCommandBuffer(device, queue, &waitSemaphores, &signalSemaphores);
 
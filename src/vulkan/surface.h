@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <vector>
 #include "vulkan/image.h"
 #include "vulkan/vk_wrapper.h"
@@ -11,6 +12,8 @@ class Window;
 
 namespace vk
 {
+class Buffer;
+class Context;
 class Image;
 class CommandBufferManager;
 class Queue;
@@ -26,9 +29,17 @@ public:
 
     void destroySurface(VkInstance instance);
 
-    bool initSwapchain(VkPhysicalDevice physicalDevice, VkDevice device);
+    bool initSwapchain(VkPhysicalDevice physicalDevice, VkDevice device, uint32_t framesInFlight);
 
     void destroySwapchain(VkDevice device);
+
+    // Without a window surface the swapchain is emulated with owned images, presenting only submits
+    bool initOffscreenSwapchain(Context* context, uint32_t framesInFlight);
+
+    void destroyOffscreenSwapchain(Context* context);
+
+    // Writes the frames read back by the frame index, must be called once its frame fence has signaled
+    void resolveReadback(Context* context, uint32_t frameIndex);
 public:
     bool validSurface() const;
 
@@ -38,18 +49,20 @@ public:
 
     std::vector<vk::Image*>& getSwapchainImages();
 
-    VkResult acquireNextImage(VkDevice device, CommandBufferManager* commandBufferManager, Queue* queue);
+    VkResult acquireNextImage(VkDevice device, uint32_t frameIndex);
 
     uint32_t getCurrentImageIdex();
 
     void setNextImageIndex() { currentImageIndex = (currentImageIndex + 1) % imageCount; }
 
-    VkResult present(VkDevice device, CommandBufferManager* commandBufferManager, Queue* queue);
+    VkResult present(VkDevice device, CommandBufferManager* commandBufferManager, Queue* queue, uint32_t frameIndex);
 private:
     void updateSurfaceSize(int width, int height);
 
     void selectSurfaceFormat(VkPhysicalDevice physicalDevice);
 
+    void writeReadback(Context* context, uint32_t frameIndex);
+
 public:
     VkSurfaceFormatKHR getSurfaceFormat();
 
@@ -66,7 +79,19 @@ private:
 
     uint32_t currentImageIndex;
     uint32_t imageCount;
+    // The image index is unknown until acquired, so acquire semaphores are per frame in flight
+    // and present semaphores are per swapchain image
     std::vector<handle::Semaphore> acquireSemaphores;
     std::vector<handle::Semaphore> presentSemaphores;
+
+    // Offscreen swapchain, every readbackInterval-th presented frame is copied to a per frame
+    // buffer and written to readbackDirectory as a PPM file, 0 disables the readback
+    bool offscreen;
+    uint32_t readbackInterval;
+    std::string readbackDirectory;
+    uint64_t presentCount;
+    std::vector<Buffer*> readbackBuffers;
+    // Presented frame number waiting in the buffer of a frame index, 0 if there is none
+    std::vector<uint64_t> pendingReadbacks;
 };
 }
\ No newline at end of file
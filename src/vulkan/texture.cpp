@@ -1,12 +1,13 @@
+#include "platform/profiler.h"
 #include "rhi/context.h"
 #include "vulkan/buffer.h"
 #include "vulkan/texture.h"
+#include "vulkan/uploadBatcher.h"
 
 namespace vk
 {
 Texture::Texture(Format format, uint32_t width, uint32_t height, ImageLayout initialLayout, uint32_t usage)
     : rhi::Texture(format, width, height, initialLayout, usage)
-    , buffer(nullptr)
     , descriptorImageInfo()
 {
 
@@ -14,7 +15,6 @@ Texture::Texture(Format format, uint32_t width, uint32_t height, ImageLayout ini
 
 Texture::Texture(Format format, uint32_t width, uint32_t height, uint32_t depth, uint32_t samples, uint32_t mipLevels, uint32_t layers, ImageLayout initialLayout, uint32_t usage)
     : rhi::Texture(format, width, height, depth, samples, mipLevels, layers, initialLayout, usage)
-    , buffer(nullptr)
     , descriptorImageInfo()
 {
 
@@ -23,22 +23,22 @@ Texture::Texture(Format format, uint32_t width, uint32_t height, uint32_t depth,
 void Texture::destroy(rhi::Context* context)
 {
     Context* contextVk = reinterpret_cast<Context*>(context);
-    Image::destroy(contextVk->getDevice());
-
-    if (buffer != nullptr)
-    {
-        buffer->destroy(contextVk);
-        delete buffer;
-        buffer = nullptr;
-    }
+    Image::destroy(contextVk);
 }
 
 void Texture::build(rhi::Context* rhiContext)
 {
+    PROFILE_ZONE("Texture::build");
+
     Context* context = reinterpret_cast<Context*>(rhiContext);
     VkFormat format = convertToVkFormat(rhi::Texture::format);
     VkExtent3D extent = { width, height, depth };
-    createImage(context, format, mipLevels, layers, rhi::Texture::samples, extent, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    // Transient textures were already created and bound to aliased memory by the render graph
+    if (!isCreated())
+    {
+        setMemoryOwner(name);
+        createImage(context, format, mipLevels, layers, rhi::Texture::samples, extent, usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    }
 
     VkComponentMapping components = {};
     VkImageSubresourceRange subresourceRange = {};
@@ -61,20 +61,13 @@ void Texture::build(rhi::Context* rhiContext)
 
     createImageView(context->getDevice(), format, components, subresourceRange, getImageViewType(width, height, depth));
 
-    CommandBuffer* commandBuffer = context->getUploadCommandBuffer();
-
     if (textureLoaded)
     {
         ASSERT(memoryBuffer.size() != 0);
-        buffer = BufferFactory::createBuffer(rhi::BufferType::HostCoherent, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 0, memoryBuffer.size());
-        buffer->init(context, memoryBuffer.data());
-
-        commandBuffer->addTransition(updateImageLayoutAndBarrier(ImageLayout::TransferDst));
-        commandBuffer->flushTransitions();
-
+        std::vector<VkBufferImageCopy> regions;
         if (mipOffsets.empty())
         {
-            Copy(context, buffer->getBuffer(), extent);
+            regions.push_back(getCopyRegion(extent, 0, 0, 0));
         }
         else
         {
@@ -88,26 +81,44 @@ void Texture::build(rhi::Context* rhiContext)
                 copyExtent.height = extent.height >> mipLevel;
                 copyExtent.depth = extent.depth;
 
-                Copy(context, buffer->getBuffer(), copyExtent, mipLevel, 0, bufferOffset);
+                regions.push_back(getCopyRegion(copyExtent, mipLevel, 0, bufferOffset));
             }
         }
-        commandBuffer->addTransition(updateImageLayoutAndBarrier(ImageLayout::FragmentShaderReadOnly));
+        context->getUploadBatcher()->copyImage(context, this, memoryBuffer.data(), memoryBuffer.size(), regions, ImageLayout::FragmentShaderReadOnly);
     }
     else
     {        
+        CommandBuffer* commandBuffer = context->getUploadCommandBuffer();
         commandBuffer->addTransition(updateImageLayoutAndBarrier(initialLayout));
     }
 
-    context->submitUploadCommandBuffer();
     clear();
 }
 
+bool Texture::createAliasedImage(Context* context)
+{
+    VkFormat format = convertToVkFormat(rhi::Texture::format);
+    VkExtent3D extent = { width, height, depth };
+    return createImageHandle(context, format, mipLevels, layers, rhi::Texture::samples, extent, usage);
+}
+
+void Texture::discardContents()
+{
+    Image::discardContents();
+}
+
 void Texture::Copy(Context* context, VkBuffer srcBuffer, VkExtent3D extent)
 {
     Copy(context, srcBuffer, extent, 0, 0, 0);
 }
 
 void Texture::Copy(Context* context, VkBuffer srcBuffer, VkExtent3D extent, uint32_t mipLevel, uint32_t layer, size_t bufferOffset)
+{
+    CommandBuffer* commandBuffer = context->getUploadCommandBuffer();
+    commandBuffer->copyBufferToImage(srcBuffer, image.getHandle(), getCopyRegion(extent, mipLevel, layer, bufferOffset));
+}
+
+VkBufferImageCopy Texture::getCopyRegion(VkExtent3D extent, uint32_t mipLevel, uint32_t layer, size_t bufferOffset)
 {
     VkBufferImageCopy copyRegion = {};
     copyRegion.imageSubresource.aspectMask = subresourceRange.aspectMask;
@@ -119,8 +130,7 @@ void Texture::Copy(Context* context, VkBuffer srcBuffer, VkExtent3D extent, uint
     copyRegion.imageExtent = extent;
     copyRegion.bufferOffset = bufferOffset;
 
-    CommandBuffer* commandBuffer = context->getUploadCommandBuffer();
-    commandBuffer->copyBufferToImage(srcBuffer, image.getHandle(), copyRegion);
+    return copyRegion;
 }
 
 void* Texture::getDescriptorData(rhi::DescriptorType type)
@@ -137,6 +147,7 @@ void* Texture::getDescriptorData(rhi::DescriptorType type)
             VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
     }
 
+    // Samplers and input attachments read a depth stencil image through its depth only view
     descriptorImageInfo.imageView = getReadableImageView();
     descriptorImageInfo.sampler = getSampler();
 
@@ -35,14 +35,19 @@ public:
     void clearColor(rhi::Context* context, float r, float g, float b, float a) override;
 
     void CopyTo(rhi::Context* context, rhi::Texture* dstTexture, uint32_t srcMipLevel, uint32_t dstMipLevel) override;
+
+    void discardContents() override;
 public:
+    // Creates the image ahead of build so the context can place it into aliased memory
+    bool createAliasedImage(Context* context);
+
     void Copy(Context* context, VkBuffer srcBuffer, VkExtent3D extent);
 
     void Copy(Context* context, VkBuffer srcBuffer, VkExtent3D extent, uint32_t mipLevel, uint32_t layer, size_t bufferOffset);
 
-protected:
-    vk::Buffer* buffer;
+    VkBufferImageCopy getCopyRegion(VkExtent3D extent, uint32_t mipLevel, uint32_t layer, size_t bufferOffset);
 
+protected:
     VkDescriptorImageInfo descriptorImageInfo;
 };
 }
\ No newline at end of file
@@ -133,6 +133,55 @@ void Transition::mergeBufferBarrier(VkPipelineStageFlags srcStageMask,
     mBufferMemoryBarriers.push_back(bufferMemoryBarrier);
 }
 
+void Transition::restrictToStages(VkPipelineStageFlags supportedStages)
+{
+    const VkAccessFlags supportedAccess = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+        VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT |
+        VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+    const bool restrictSrc = (mSrcStageMask & ~supportedStages) != 0;
+    const bool restrictDst = (mDstStageMask & ~supportedStages) != 0;
+
+    // With no stage left the barrier still has to chain with the semaphore wait
+    const VkPipelineStageFlags supportedSrcStages = mSrcStageMask & supportedStages;
+    mSrcStageMask = supportedSrcStages != 0 ? supportedSrcStages : VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    if (restrictDst)
+    {
+        mDstStageMask = (mDstStageMask & supportedStages) | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    }
+
+    auto restrictAccess = [&](VkAccessFlags& srcAccess, VkAccessFlags& dstAccess)
+    {
+        if (restrictSrc)
+        {
+            srcAccess = supportedSrcStages != 0 ? (srcAccess & supportedAccess) : 0;
+        }
+        if (restrictDst && (dstAccess & ~supportedAccess) != 0)
+        {
+            dstAccess = (dstAccess & supportedAccess) | VK_ACCESS_SHADER_READ_BIT;
+        }
+    };
+
+    restrictAccess(mMemoryBarrierSrcAccess, mMemoryBarrierDstAccess);
+    for (auto& imageMemoryBarrier : mImageMemoryBarriers)
+    {
+        restrictAccess(imageMemoryBarrier.srcAccessMask, imageMemoryBarrier.dstAccessMask);
+    }
+    for (auto& bufferMemoryBarrier : mBufferMemoryBarriers)
+    {
+        restrictAccess(bufferMemoryBarrier.srcAccessMask, bufferMemoryBarrier.dstAccessMask);
+    }
+}
+
+void Transition::waitForAliasedWrites()
+{
+    mSrcStageMask |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    for (auto& imageMemoryBarrier : mImageMemoryBarriers)
+    {
+        imageMemoryBarrier.srcAccessMask |= VK_ACCESS_MEMORY_WRITE_BIT;
+    }
+}
+
 void Transition::reset()
 {
     mSrcStageMask = 0;
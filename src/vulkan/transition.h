@@ -60,6 +60,13 @@ public:
         VkPipelineStageFlags dstStageMask,
         const VkBufferMemoryBarrier& bufferMemoryBarrier);
 
+    // Drops the pipeline stages and accesses a queue can't execute. Writes of other queues were made
+    // visible by the semaphore the queue waited on, shader consumers become compute shader reads.
+    void restrictToStages(VkPipelineStageFlags supportedStages);
+
+    // Images that share memory with the ones in the barrier were written before, wait for every prior write
+    void waitForAliasedWrites();
+
     void reset();
 
 public:
@@ -0,0 +1,84 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "vulkan/uniformArena.h"
+#include "vulkan/buffer.h"
+#include "vulkan/context.h"
+
+namespace vk
+{
+UniformArena::UniformArena()
+	: buffer(nullptr)
+	, mapped(nullptr)
+	, alignment(0)
+	, frameSize(0)
+	, frameBegin(0)
+	, head(0)
+	, frameSerial(0)
+	, peakUsage(0)
+{
+
+}
+
+void UniformArena::init(Context* context, uint32_t framesInFlight, VkDeviceSize frameSize)
+{
+	alignment = std::max<VkDeviceSize>(context->getPhysicalDeviceProperties().limits.minUniformBufferOffsetAlignment, 16);
+	this->frameSize = Util::align(frameSize, alignment);
+
+	const size_t bufferSize = static_cast<size_t>(this->frameSize * framesInFlight);
+	buffer = BufferFactory::createBuffer(rhi::BufferType::HostCoherent, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 0, bufferSize);
+	buffer->setMemoryOwner(rhi::MemoryCategory::Uniform, "Uniform arena");
+	buffer->initBuffer(context, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+	mapped = reinterpret_cast<uint8_t*>(buffer->mapMemory(context, bufferSize));
+
+	beginFrame(0);
+}
+
+void UniformArena::destroy(Context* context)
+{
+	LOGD("Uniform arena: peak usage %llu KB of %llu KB per frame",
+		static_cast<unsigned long long>(peakUsage / 1024), static_cast<unsigned long long>(frameSize / 1024));
+
+	if (buffer != nullptr)
+	{
+		buffer->destroy(context);
+		delete buffer;
+		buffer = nullptr;
+	}
+	mapped = nullptr;
+}
+
+void UniformArena::beginFrame(uint32_t frameIndex)
+{
+	frameBegin = frameIndex * frameSize;
+	head = frameBegin;
+	frameSerial++;
+}
+
+uint32_t UniformArena::write(const void* data, VkDeviceSize size)
+{
+	ASSERT(mapped);
+
+	if (head + size > frameBegin + frameSize)
+	{
+		// Wrapping would overwrite blocks still bound this frame, and growing would leave every
+		// dynamic descriptor pointing at the old buffer, so the frame size has to be raised instead
+		LOGE("Uniform arena frame region of %llu KB exhausted, raise kUniformArenaFrameSize",
+			static_cast<unsigned long long>(frameSize / 1024));
+		exit(1);
+	}
+
+	const VkDeviceSize offset = head;
+	memcpy(mapped + offset, data, static_cast<size_t>(size));
+
+	head = Util::align(offset + size, alignment);
+	peakUsage = std::max(peakUsage, head - frameBegin);
+	return static_cast<uint32_t>(offset);
+}
+
+VkBuffer UniformArena::getBuffer()
+{
+	ASSERT(buffer);
+	return buffer->getBuffer();
+}
+}
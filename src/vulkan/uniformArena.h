@@ -0,0 +1,47 @@
+#pragma once
+
+#include "vulkan/vk_wrapper.h"
+
+namespace vk
+{
+const VkDeviceSize kUniformArenaFrameSize = 4 * 1024 * 1024;
+
+class Context;
+class Buffer;
+
+// Linear allocator for the uniform data of a frame. A single persistently mapped buffer holds one
+// region per frame in flight, and a region is rewound once its frame fence has signaled.
+// Dynamic uniform buffers write their blocks here and are bound with the returned offset, so
+// their descriptors all point at the same buffer and never need to be rewritten.
+class UniformArena
+{
+public:
+	UniformArena();
+
+	void init(Context* context, uint32_t framesInFlight, VkDeviceSize frameSize = kUniformArenaFrameSize);
+
+	void destroy(Context* context);
+
+	// Must be called once the frame fence of the frame index has signaled
+	void beginFrame(uint32_t frameIndex);
+
+	// Copies the block into the current frame region and returns its offset in the arena buffer.
+	// Running out of the region is fatal, the blocks written before it are never overwritten
+	uint32_t write(const void* data, VkDeviceSize size);
+
+	VkBuffer getBuffer();
+
+	// Advances every frame, blocks written with an older serial may already be overwritten
+	uint64_t getFrameSerial() const { return frameSerial; }
+
+private:
+	Buffer* buffer;
+	uint8_t* mapped;
+	VkDeviceSize alignment;
+	VkDeviceSize frameSize;
+	VkDeviceSize frameBegin;
+	VkDeviceSize head;
+	uint64_t frameSerial;
+	VkDeviceSize peakUsage;
+};
+}
@@ -1,13 +1,16 @@
 #include "rhi/context.h"
 #include "vulkan/buffer.h"
 #include "vulkan/context.h"
+#include "vulkan/uniformArena.h"
 
 namespace vk
 {
 UniformBuffer::UniformBuffer(rhi::BufferType bufferType)
-	: buffer(nullptr)
-	, bufferType(bufferType)
+	: bufferType(bufferType)
 	, descriptorBufferInfo()
+	, dynamicOffset(0)
+	, writtenFrameSerial(0)
+	, writtenVersion(0)
 {
 
 }
@@ -16,12 +19,12 @@ void UniformBuffer::destroy(rhi::Context* context)
 {
 	Context* contextVk = reinterpret_cast<Context*>(context);
 
-	if (buffer != nullptr)
+	for (auto& buffer : buffers)
 	{
 		buffer->destroy(contextVk);
 		delete buffer;
-		buffer = nullptr;
 	}
+	buffers.clear();
 }
 
 void UniformBuffer::build(rhi::Context* context)
@@ -29,15 +32,44 @@ void UniformBuffer::build(rhi::Context* context)
 	ASSERT(memoryBuffer.size() != 0);
 	Context* contextVk = reinterpret_cast<Context*>(context);
 
-	buffer = BufferFactory::createBuffer(bufferType, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 0, memoryBuffer.size());
-	buffer->init(contextVk, memoryBuffer.data());
+	if (bufferType == rhi::BufferType::Dynamic)
+	{
+		// Nothing to allocate, the first block makes the offset valid before any bind
+		descriptorBufferInfo.buffer = contextVk->getUniformArena()->getBuffer();
+		update(context);
+		return;
+	}
+
+	const uint32_t bufferCount = bufferType == rhi::BufferType::DeviceLocal ? 1 : contextVk->getFramesInFlight();
+
+	buffers.resize(bufferCount);
+	for (auto& buffer : buffers)
+	{
+		buffer = BufferFactory::createBuffer(bufferType, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 0, memoryBuffer.size());
+		buffer->init(contextVk, memoryBuffer.data());
+	}
 }
 
 void UniformBuffer::update(rhi::Context* context)
 {
-	ASSERT(buffer);
 	Context* contextVk = reinterpret_cast<Context*>(context);
 
+	if (bufferType == rhi::BufferType::Dynamic)
+	{
+		UniformArena* uniformArena = contextVk->getUniformArena();
+		if (writtenFrameSerial == uniformArena->getFrameSerial() && writtenVersion == version)
+		{
+			return;
+		}
+
+		dynamicOffset = uniformArena->write(memoryBuffer.data(), memoryBuffer.size());
+		writtenFrameSerial = uniformArena->getFrameSerial();
+		writtenVersion = version;
+		return;
+	}
+
+	ASSERT(!buffers.empty());
+	vk::Buffer* buffer = buffers[contextVk->getFrameIndex() % buffers.size()];
 	buffer->mapMemory(contextVk, memoryBuffer.size(), memoryBuffer.data());
 }
 
@@ -48,13 +80,29 @@ void UniformBuffer::bind(rhi::Context* context)
 
 void* UniformBuffer::getDescriptorData(rhi::DescriptorType type)
 {
-	descriptorBufferInfo.buffer = getHandle();
+	return getFrameDescriptorData(type, 0);
+}
+
+bool UniformBuffer::isPerFrame() { return buffers.size() > 1; }
+
+void* UniformBuffer::getFrameDescriptorData(rhi::DescriptorType type, uint32_t frameIndex)
+{
+	ASSERT((bufferType == rhi::BufferType::Dynamic) == (type == rhi::DescriptorType::Uniform_Buffer_Dynamic));
+
+	// Dynamic ones keep pointing at the arena buffer set in build
+	if (bufferType != rhi::BufferType::Dynamic)
+	{
+		ASSERT(!buffers.empty());
+		descriptorBufferInfo.buffer = buffers[frameIndex % buffers.size()]->getBuffer();
+	}
 	descriptorBufferInfo.offset = 0;
 	descriptorBufferInfo.range = getSize();
 
 	return &descriptorBufferInfo;
 }
 
-VkBuffer UniformBuffer::getHandle() { return buffer->getBuffer(); }
+uint32_t UniformBuffer::getDynamicOffset() { return dynamicOffset; }
+
+VkBuffer UniformBuffer::getHandle() { return buffers.empty() ? descriptorBufferInfo.buffer : buffers[0]->getBuffer(); }
 size_t UniformBuffer::getSize() { return memoryBuffer.size(); }
-}
\ No newline at end of file
+}
@@ -0,0 +1,348 @@
+#include <algorithm>
+#include <cstring>
+#include "vulkan/uploadBatcher.h"
+#include "vulkan/buffer.h"
+#include "vulkan/commandBufferManager.h"
+#include "vulkan/context.h"
+#include "vulkan/image.h"
+#include "vulkan/queue.h"
+
+namespace vk
+{
+UploadBatcher::UploadBatcher()
+	: stagingHeap(nullptr)
+	, mapped(nullptr)
+	, capacity(0)
+	, head(0)
+	, tail(0)
+	, pendingBegin(0)
+	, pendingSize(0)
+	, flushCount(0)
+	, peakUsage(0)
+	, usage(0)
+{
+
+}
+
+void UploadBatcher::init(Context* context, VkDeviceSize heapSize)
+{
+	capacity = heapSize;
+
+	stagingHeap = BufferFactory::createBuffer(rhi::BufferType::HostCoherent, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 0, static_cast<size_t>(capacity));
+	stagingHeap->setMemoryOwner(rhi::MemoryCategory::Staging, "Upload staging heap");
+	stagingHeap->initBuffer(context, VK_BUFFER_USAGE_TRANSFER_SRC_BIT);
+	mapped = reinterpret_cast<uint8_t*>(stagingHeap->mapMemory(context, static_cast<size_t>(capacity)));
+}
+
+void UploadBatcher::destroy(Context* context)
+{
+	flush(context);
+	while (!batches.empty())
+	{
+		retire(context, true);
+	}
+
+	for (auto& fence : freeFences)
+	{
+		fence.destroy(context->getDevice());
+	}
+	freeFences.clear();
+
+	LOGD("Upload batcher: %u flushes, peak staging usage %llu KB", flushCount, static_cast<unsigned long long>(peakUsage / 1024));
+
+	if (stagingHeap != nullptr)
+	{
+		stagingHeap->destroy(context);
+		delete stagingHeap;
+		stagingHeap = nullptr;
+	}
+	mapped = nullptr;
+}
+
+bool UploadBatcher::allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset)
+{
+	if (!hasData())
+	{
+		head = tail = 0;
+	}
+
+	const VkDeviceSize aligned = Util::align(head, alignment);
+
+	if (!hasData())
+	{
+		*offset = 0;
+	}
+	else if (head >= tail)
+	{
+		// Used range is [tail, head), try the end of the heap first and wrap around otherwise
+		if (aligned + size <= capacity)
+		{
+			*offset = aligned;
+		}
+		else if (size < tail)
+		{
+			*offset = 0;
+		}
+		else
+		{
+			return false;
+		}
+	}
+	else if (aligned + size < tail)
+	{
+		*offset = aligned;
+	}
+	else
+	{
+		return false;
+	}
+
+	if (pendingSize == 0)
+	{
+		pendingBegin = *offset;
+	}
+
+	head = *offset + size;
+	pendingSize += size;
+	usage += size;
+	peakUsage = std::max(peakUsage, usage);
+	return true;
+}
+
+bool UploadBatcher::stage(Context* context, const void* data, VkDeviceSize size, VkDeviceSize alignment, StagingRegion* region)
+{
+	ASSERT(stagingHeap);
+
+	if (size > capacity)
+	{
+		Buffer* buffer = BufferFactory::createBuffer(rhi::BufferType::HostCoherent, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 0, static_cast<size_t>(size));
+		buffer->init(context, data);
+		pendingBuffers.push_back(buffer);
+
+		region->buffer = buffer->getBuffer();
+		region->offset = 0;
+		return true;
+	}
+
+	VkDeviceSize offset = 0;
+	while (!allocate(size, alignment, &offset))
+	{
+		// The heap is full, send what is pending and recycle the oldest batch
+		flush(context);
+		if (!batches.empty())
+		{
+			retire(context, true);
+		}
+	}
+
+	memcpy(mapped + offset, data, static_cast<size_t>(size));
+
+	region->buffer = stagingHeap->getBuffer();
+	region->offset = offset;
+	return true;
+}
+
+void UploadBatcher::copyBuffer(Context* context, const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset)
+{
+	StagingRegion region;
+	stage(context, data, size, kStagingAlignment, &region);
+
+	VkBufferCopy copyRegion = {};
+	copyRegion.srcOffset = region.offset;
+	copyRegion.dstOffset = dstOffset;
+	copyRegion.size = size;
+
+	getCopyCommandBuffer(context)->copyBuffer(region.buffer, dstBuffer, copyRegion);
+	releaseOwnership(context, dstBuffer, dstOffset, size);
+}
+
+void UploadBatcher::copyImage(Context* context, Image* image, const void* data, VkDeviceSize size, std::vector<VkBufferImageCopy>& regions, ImageLayout finalLayout)
+{
+	// Staging may flush the pending batch, so do it before fetching the command buffer
+	StagingRegion region;
+	stage(context, data, size, kStagingAlignment, &region);
+
+	CommandBuffer* commandBuffer = getCopyCommandBuffer(context);
+	commandBuffer->addTransition(image->updateImageLayoutAndBarrier(ImageLayout::TransferDst));
+	commandBuffer->flushTransitions();
+
+	for (auto& copyRegion : regions)
+	{
+		copyRegion.bufferOffset += region.offset;
+		commandBuffer->copyBufferToImage(region.buffer, image->getImage(), copyRegion);
+	}
+
+	Transition* transition = image->updateImageLayoutAndBarrier(finalLayout);
+	if (!context->hasTransferQueue())
+	{
+		commandBuffer->addTransition(transition);
+		return;
+	}
+
+	// The layout change rides on the ownership transfer, the transfer queue can't reach shader stages
+	if (transition != nullptr)
+	{
+		for (auto& imageMemoryBarrier : *transition->getImageMemoryBarriers())
+		{
+			releaseOwnership(context, imageMemoryBarrier);
+		}
+		delete transition;
+	}
+}
+
+CommandBuffer* UploadBatcher::getCopyCommandBuffer(Context* context)
+{
+	return context->hasTransferQueue() ? context->getTransferCommandBuffer() : context->getUploadCommandBuffer();
+}
+
+void UploadBatcher::releaseOwnership(Context* context, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+{
+	if (!context->hasTransferQueue())
+	{
+		return;
+	}
+
+	VkBufferMemoryBarrier bufferMemoryBarrier = {};
+	bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	bufferMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	bufferMemoryBarrier.dstAccessMask = 0;
+	bufferMemoryBarrier.srcQueueFamilyIndex = context->getTransferQueueFamilyIndex();
+	bufferMemoryBarrier.dstQueueFamilyIndex = context->getQueueFamilyIndex();
+	bufferMemoryBarrier.buffer = buffer;
+	bufferMemoryBarrier.offset = offset;
+	bufferMemoryBarrier.size = size;
+	releaseBufferBarriers.push_back(bufferMemoryBarrier);
+
+	bufferMemoryBarrier.srcAccessMask = 0;
+	bufferMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+	acquireBufferBarriers.push_back(bufferMemoryBarrier);
+}
+
+void UploadBatcher::releaseOwnership(Context* context, const VkImageMemoryBarrier& imageMemoryBarrier)
+{
+	VkImageMemoryBarrier releaseBarrier = imageMemoryBarrier;
+	releaseBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	releaseBarrier.dstAccessMask = 0;
+	releaseBarrier.srcQueueFamilyIndex = context->getTransferQueueFamilyIndex();
+	releaseBarrier.dstQueueFamilyIndex = context->getQueueFamilyIndex();
+	releaseImageBarriers.push_back(releaseBarrier);
+
+	VkImageMemoryBarrier acquireBarrier = releaseBarrier;
+	acquireBarrier.srcAccessMask = 0;
+	acquireBarrier.dstAccessMask = imageMemoryBarrier.dstAccessMask;
+	acquireImageBarriers.push_back(acquireBarrier);
+}
+
+bool UploadBatcher::isComplete(Context* context, const Batch& batch)
+{
+	if (batch.timelineValue != 0)
+	{
+		return context->getCompletedTransferValue() >= batch.timelineValue;
+	}
+	return batch.fence.getStatus(context->getDevice()) == VK_SUCCESS;
+}
+
+void UploadBatcher::flush(Context* context)
+{
+	if (!hasPendingUploads())
+	{
+		return;
+	}
+
+	Batch& batch = batches.emplace_back();
+	batch.begin = pendingSize != 0 ? pendingBegin : head;
+	batch.size = pendingSize;
+	batch.timelineValue = 0;
+	batch.dedicatedBuffers.swap(pendingBuffers);
+
+	if (context->hasTransferQueue())
+	{
+		CommandBuffer* transferCommandBuffer = context->getTransferCommandBuffer();
+		transferCommandBuffer->pipelineBarrier(VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+			0, nullptr,
+			static_cast<uint32_t>(releaseBufferBarriers.size()), releaseBufferBarriers.data(),
+			static_cast<uint32_t>(releaseImageBarriers.size()), releaseImageBarriers.data());
+		batch.timelineValue = context->submitTransferCommandBuffer();
+
+		// Chained to the timeline wait of the next graphics upload submit, graphics work keeps running until then
+		CommandBuffer* uploadCommandBuffer = context->getUploadCommandBuffer();
+		uploadCommandBuffer->pipelineBarrier(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+			0, nullptr,
+			static_cast<uint32_t>(acquireBufferBarriers.size()), acquireBufferBarriers.data(),
+			static_cast<uint32_t>(acquireImageBarriers.size()), acquireImageBarriers.data());
+		context->acquireTransfer(batch.timelineValue);
+
+		releaseBufferBarriers.clear();
+		releaseImageBarriers.clear();
+		acquireBufferBarriers.clear();
+		acquireImageBarriers.clear();
+	}
+	else
+	{
+		context->submitUploadCommandBuffer();
+
+		if (freeFences.empty())
+		{
+			VkFenceCreateInfo fenceCreateInfo = {};
+			fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+			VKCALL(batch.fence.init(context->getDevice(), fenceCreateInfo));
+		}
+		else
+		{
+			batch.fence = std::move(freeFences.back());
+			freeFences.pop_back();
+		}
+		context->getQueue()->signal(batch.fence.getHandle());
+	}
+
+	pendingSize = 0;
+	flushCount++;
+
+	// Opportunistically recycle batches the GPU already finished
+	while (!batches.empty() && isComplete(context, batches.front()))
+	{
+		retire(context, false);
+	}
+}
+
+void UploadBatcher::retire(Context* context, bool wait)
+{
+	ASSERT(!batches.empty());
+	Batch& batch = batches.front();
+
+	if (batch.timelineValue != 0)
+	{
+		if (wait)
+		{
+			context->waitTransfer(batch.timelineValue);
+		}
+	}
+	else
+	{
+		if (wait)
+		{
+			VKCALL(batch.fence.wait(context->getDevice(), UINT64_MAX));
+		}
+		VKCALL(batch.fence.reset(context->getDevice()));
+		freeFences.push_back(std::move(batch.fence));
+	}
+
+	for (auto& buffer : batch.dedicatedBuffers)
+	{
+		buffer->destroy(context);
+		delete buffer;
+	}
+
+	usage -= batch.size;
+	batches.pop_front();
+
+	if (!batches.empty())
+	{
+		tail = batches.front().begin;
+	}
+	else
+	{
+		tail = pendingSize != 0 ? pendingBegin : head;
+	}
+}
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include "vulkan/vk_wrapper.h"
+#include "vulkan/resources.h"
+
+namespace vk
+{
+const VkDeviceSize kStagingHeapSize = 32 * 1024 * 1024;
+const VkDeviceSize kStagingAlignment = 16;
+
+class Context;
+class Buffer;
+class Image;
+class CommandBuffer;
+
+struct StagingRegion
+{
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceSize offset = 0;
+};
+
+// Collects the uploads of a build phase into the upload command buffer. Source data is staged
+// through a ring buffer that is recycled once the batch fence signals, and the whole batch
+// goes out in a single submit on flush.
+// When the context has a transfer queue the copies are recorded there instead. The batch signals
+// the transfer timeline, and ownership of the destinations is released to the graphics queue.
+// The acquire side goes into the graphics upload command buffer, which waits on the timeline.
+class UploadBatcher
+{
+public:
+	UploadBatcher();
+
+	void init(Context* context, VkDeviceSize heapSize = kStagingHeapSize);
+
+	void destroy(Context* context);
+
+	// Copies data into staging memory, the region stays valid until the batch is flushed and finished
+	bool stage(Context* context, const void* data, VkDeviceSize size, VkDeviceSize alignment, StagingRegion* region);
+
+	void copyBuffer(Context* context, const void* data, VkDeviceSize size, VkBuffer dstBuffer, VkDeviceSize dstOffset);
+
+	// Region buffer offsets are relative to data, the image ends up in finalLayout
+	void copyImage(Context* context, Image* image, const void* data, VkDeviceSize size, std::vector<VkBufferImageCopy>& regions, ImageLayout finalLayout);
+
+	void flush(Context* context);
+
+	bool hasPendingUploads() const { return pendingSize != 0 || !pendingBuffers.empty(); }
+
+private:
+	struct Batch
+	{
+		handle::Fence fence;
+		VkDeviceSize begin;
+		VkDeviceSize size;
+		uint64_t timelineValue;
+		std::vector<Buffer*> dedicatedBuffers;
+	};
+
+	CommandBuffer* getCopyCommandBuffer(Context* context);
+
+	void releaseOwnership(Context* context, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+
+	void releaseOwnership(Context* context, const VkImageMemoryBarrier& imageMemoryBarrier);
+
+	bool isComplete(Context* context, const Batch& batch);
+
+	bool allocate(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize* offset);
+
+	void retire(Context* context, bool wait);
+
+	bool hasData() const { return !batches.empty() || hasPendingUploads(); }
+
+	Buffer* stagingHeap;
+	uint8_t* mapped;
+	VkDeviceSize capacity;
+	VkDeviceSize head;
+	VkDeviceSize tail;
+
+	VkDeviceSize pendingBegin;
+	VkDeviceSize pendingSize;
+	// Uploads that do not fit into the heap get a staging buffer of their own
+	std::vector<Buffer*> pendingBuffers;
+
+	std::vector<VkBufferMemoryBarrier> releaseBufferBarriers;
+	std::vector<VkImageMemoryBarrier> releaseImageBarriers;
+	std::vector<VkBufferMemoryBarrier> acquireBufferBarriers;
+	std::vector<VkImageMemoryBarrier> acquireImageBarriers;
+
+	std::deque<Batch> batches;
+	std::vector<handle::Fence> freeFences;
+
+	uint32_t flushCount;
+	VkDeviceSize peakUsage;
+	VkDeviceSize usage;
+};
+}
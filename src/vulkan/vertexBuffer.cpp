@@ -1,12 +1,12 @@
 #include "rhi/context.h"
 #include "vulkan/buffer.h"
+#include "vulkan/uploadBatcher.h"
 #include "vulkan/resources.h"
 
 namespace vk
 {
 VertexBuffer::VertexBuffer()
 	: buffer(nullptr)
-	, stagingBuffer(nullptr)
 	, vertexInputBindingDescription()
 	, offset(0)
 	, suballocated(false)
@@ -26,13 +26,6 @@ void VertexBuffer::destroy(rhi::Context* context)
 		buffer = nullptr;
 	}
 
-	if (stagingBuffer != nullptr)
-	{
-		stagingBuffer->destroy(contextVk);
-		delete stagingBuffer;
-		stagingBuffer = nullptr;
-	}
-
 	rhi::VertexBuffer::destroy(context);
 }
 
@@ -67,9 +60,7 @@ void VertexBuffer::build(rhi::Context* rhiContext)
 
 		ScratchBuffer* scratchBuffer = reinterpret_cast<ScratchBuffer*>(subAllocateInfo->buffer);
 		buffer = scratchBuffer->getBuffer();
-		stagingBuffer = BufferFactory::createBuffer(rhi::BufferType::HostCoherent, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 0, bufferSize);
-		stagingBuffer->init(context, vertices.data());
-		buffer->Copy(context, stagingBuffer->getBuffer(), subAllocateInfo->offset, bufferSize);
+		context->getUploadBatcher()->copyBuffer(context, vertices.data(), bufferSize, buffer->getBuffer(), subAllocateInfo->offset);
 	}
 	else
 	{
@@ -178,6 +178,7 @@ public:
     VkResult freeDescriptorSets(VkDevice device,
                                 uint32_t descriptorSetCount,
                                 const VkDescriptorSet* pDescriptorSets);
+    VkResult reset(VkDevice device);
 };
 
 class DeviceMemory final : public WrappedObject<DeviceMemory, VkDeviceMemory>
@@ -201,6 +202,7 @@ public:
 
     VkResult init(VkDevice device, const VkBufferCreateInfo& createInfo);
     VkResult bindMemory(VkDevice device, const DeviceMemory& deviceMemory);
+    VkResult bindMemory(VkDevice device, VkDeviceMemory deviceMemory, VkDeviceSize offset);
     void getMemoryRequirements(VkDevice device, VkMemoryRequirements* VkMemoryRequirements);
 };
 
@@ -225,6 +227,7 @@ public:
     
     void getMemoryRequirements(VkDevice device, VkMemoryRequirements* pRequirementsOut) const;
     VkResult bindMemory(VkDevice device, const DeviceMemory& deviceMemory);
+    VkResult bindMemory(VkDevice device, VkDeviceMemory deviceMemory, VkDeviceSize offset);
 
     void getSubresourceLayout(VkDevice device,
                               VkImageAspectFlagBits aspectMask,
@@ -273,6 +276,17 @@ public:
     VkResult init(VkDevice device, const VkSemaphoreCreateInfo& createInfo);
 };
 
+class QueryPool final : public WrappedObject<QueryPool, VkQueryPool>
+{
+public:
+    QueryPool() = default;
+    void destroy(VkDevice device);
+
+    VkResult init(VkDevice device, const VkQueryPoolCreateInfo& createInfo);
+    VkResult getResults(VkDevice device, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void* data,
+        VkDeviceSize stride, VkQueryResultFlags flags) const;
+};
+
 class CommandBuffer final : public WrappedObject<CommandBuffer, VkCommandBuffer>
 {
 public:
@@ -681,6 +695,12 @@ inline VkResult DescriptorPool::freeDescriptorSets(VkDevice device,
     return vkFreeDescriptorSets(device, mHandle, descriptorSetCount, pDescriptorSets);
 }
 
+inline VkResult DescriptorPool::reset(VkDevice device)
+{
+    ASSERT(valid());
+    return vkResetDescriptorPool(device, mHandle, 0);
+}
+
 inline void DeviceMemory::destroy(VkDevice device)
 {
     if (valid())
@@ -743,6 +763,12 @@ inline VkResult Buffer::bindMemory(VkDevice device, const DeviceMemory& deviceMe
     return vkBindBufferMemory(device, mHandle, deviceMemory.getHandle(), 0);
 }
 
+inline VkResult Buffer::bindMemory(VkDevice device, VkDeviceMemory deviceMemory, VkDeviceSize offset)
+{
+    ASSERT(valid() && deviceMemory != VK_NULL_HANDLE);
+    return vkBindBufferMemory(device, mHandle, deviceMemory, offset);
+}
+
 inline void Buffer::getMemoryRequirements(VkDevice device, VkMemoryRequirements* pMemoryRequirementsOut)
 {
     ASSERT(valid());
@@ -802,6 +828,12 @@ inline VkResult Image::bindMemory(VkDevice device, const DeviceMemory& deviceMem
     return vkBindImageMemory(device, mHandle, deviceMemory.getHandle(), 0);
 }
 
+inline VkResult Image::bindMemory(VkDevice device, VkDeviceMemory deviceMemory, VkDeviceSize offset)
+{
+    ASSERT(valid() && deviceMemory != VK_NULL_HANDLE);
+    return vkBindImageMemory(device, mHandle, deviceMemory, offset);
+}
+
 inline void Image::getSubresourceLayout(VkDevice device,
                                         VkImageAspectFlagBits aspectMask,
                                         uint32_t mipLevel,
@@ -907,6 +939,28 @@ inline VkResult Semaphore::init(VkDevice device, const VkSemaphoreCreateInfo& cr
     return vkCreateSemaphore(device, &createInfo, nullptr, &mHandle);
 }
 
+inline void QueryPool::destroy(VkDevice device)
+{
+    if (valid())
+    {
+        vkDestroyQueryPool(device, mHandle, nullptr);
+        mHandle = VK_NULL_HANDLE;
+    }
+}
+
+inline VkResult QueryPool::init(VkDevice device, const VkQueryPoolCreateInfo& createInfo)
+{
+    ASSERT(!valid());
+    return vkCreateQueryPool(device, &createInfo, nullptr, &mHandle);
+}
+
+inline VkResult QueryPool::getResults(VkDevice device, uint32_t firstQuery, uint32_t queryCount, size_t dataSize, void* data,
+    VkDeviceSize stride, VkQueryResultFlags flags) const
+{
+    ASSERT(valid());
+    return vkGetQueryPoolResults(device, mHandle, firstQuery, queryCount, dataSize, data, stride, flags);
+}
+
 // Command buffer
 inline void CommandBuffer::free(VkDevice device, VkCommandPool commandPool)
 {